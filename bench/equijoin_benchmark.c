@@ -0,0 +1,1131 @@
+
+// =================================================================================================
+// Project:
+// Benchmark driver of the hash equijoin engines; built with "make benchmark".
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by this program with custom headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "data_structures_opencl.h"
+#include "table_utilities.h"
+#include "opencl_environment.h"
+#include "opencl_profiling.h"
+#include "equijoin_opencl.h"
+#include "equijoin_serial.h"
+#include "equijoin_aggregation.h"
+#include "equijoin_batch_queries.h"
+#include "equijoin_hot_customers.h"
+#include "equijoin_resident.h"
+#include "results_digest.h"
+#include "monotonic_clock.h"
+#include "equijoin_benchmark.h"
+
+// Names of the phases and engines, as shown to the user and written to the JSON report
+static const char* const BENCHMARK_PHASE_NAMES[NUM_BENCHMARK_PHASES] = {
+    "parse", "build", "upload", "probe", "readback", "write"
+};
+static const char* const BENCHMARK_ENGINE_NAMES[NUM_BENCHMARK_ENGINES] = {
+    "parse", "serial", "cpu-threads", "opencl", "cpu-aggregate", "opencl-aggregate", "cpu-batch", "opencl-batch",
+    "cpu-hot", "opencl-hot", "opencl-resident"
+};
+
+/*
+ * Everything given on the command-line.
+ *   - is_engine_selected --- whether to benchmark each engine
+ *   - rows, work_group_sizes, threads --- values swept (and how many of each there are); a row
+ *                                         count of 0 stands for every row of the purchases table
+ *   - num_warmup_iterations, num_repetitions --- iterations thrown away and measured of each benchmark
+ *   - report_file_location, customer_table_file_location, purchases_table_file_location --- files used
+ *   - is_write_measured --- whether engines write their results to disk in every repetition
+ *   - baseline_file_location --- baseline file medians are compared against (or recorded in); NULL if none
+ *   - dataset_name --- name the medians are found under in the baseline file
+ *   - is_baseline_recorded --- whether to record medians in the baseline file instead of comparing them
+ */
+struct Benchmark_Options {
+    bool is_engine_selected[NUM_BENCHMARK_ENGINES];
+    unsigned long rows[MAX_BENCHMARK_SWEEP_VALUES];
+    unsigned int num_rows_values;
+    unsigned long work_group_sizes[MAX_BENCHMARK_SWEEP_VALUES];
+    unsigned int num_work_group_sizes;
+    unsigned long threads[MAX_BENCHMARK_SWEEP_VALUES];
+    unsigned int num_threads_values;
+    unsigned int num_warmup_iterations;
+    unsigned int num_repetitions;
+    const char* report_file_location;
+    const char* customer_table_file_location;
+    const char* purchases_table_file_location;
+    bool is_write_measured;
+    const char* baseline_file_location;
+    const char* dataset_name;
+    bool is_baseline_recorded;
+};
+
+/*
+ * OpenCL objects shared by every OpenCL benchmark.
+ *   - context, queue, device --- default OpenCL device and its context and (profiling) queue
+ *   - program_string --- source of the OpenCL program file, compiled anew in every build phase
+ *   - kernel_variant --- probe kernel variant best suited to the device
+ *   - batch_program_cache --- programs compiled for the batch engine; compiled during warm-up
+ *   - is_aggregation_supported --- whether the device can run the aggregation kernels
+ */
+struct Benchmark_Opencl_Env {
+    cl_context context;
+    cl_command_queue queue;
+    cl_device_id device;
+    char* program_string;
+    struct Probe_Kernel_Variant kernel_variant;
+    struct Predicate_Program_Cache batch_program_cache;
+    bool is_aggregation_supported;
+};
+
+// File descriptor of the real standard output while engines are silenced
+static int saved_stdout_descriptor = -1;
+
+// =================================================================================================
+
+// Sends whatever engines print to BENCHMARK_SILENCED_OUTPUT_PATH until "restore_stdout" is called
+static void silence_stdout(void) {
+
+    fflush(stdout);
+    saved_stdout_descriptor = dup(STDOUT_FILENO);
+    assert(saved_stdout_descriptor >= 0);
+    int silenced_descriptor = open(BENCHMARK_SILENCED_OUTPUT_PATH, O_WRONLY);
+    assert(silenced_descriptor >= 0);
+    dup2(silenced_descriptor, STDOUT_FILENO);
+    close(silenced_descriptor);
+
+}
+
+static void restore_stdout(void) {
+
+    fflush(stdout);
+    dup2(saved_stdout_descriptor, STDOUT_FILENO);
+    close(saved_stdout_descriptor);
+    saved_stdout_descriptor = -1;
+
+}
+
+static int compare_doubles(const void* first_value, const void* second_value) {
+
+    const double first = *((const double*) first_value), second = *((const double*) second_value);
+    return (first > second) - (first < second);
+
+}
+
+void summarize_benchmark_samples(double* samples, unsigned int num_samples, struct Benchmark_Phase_Stats* stats) {
+
+    // No null pointers allowed
+    assert(samples != NULL);
+    assert(stats != NULL);
+    assert(num_samples >= 1);
+
+    qsort(samples, num_samples, sizeof(*samples), compare_doubles);
+    stats->min = samples[0];
+    stats->median = (num_samples % 2 == 1) ? samples[num_samples / 2] :
+                                             (samples[num_samples / 2 - 1] + samples[num_samples / 2]) / 2.0;
+    // Nearest rank: smallest sample with at least BENCHMARK_PERCENTILE percent of samples at or below it
+    unsigned int rank = (unsigned int) ceil(BENCHMARK_PERCENTILE / 100.0 * num_samples);
+    stats->percentile = samples[(rank > 0 ? rank : 1) - 1];
+
+    double sum = 0.0;
+    for (unsigned int sample_index = 0; sample_index < num_samples; ++sample_index) {
+        sum += samples[sample_index];
+    }
+    stats->mean = sum / num_samples;
+    double squared_deviations = 0.0;
+    for (unsigned int sample_index = 0; sample_index < num_samples; ++sample_index) {
+        squared_deviations += (samples[sample_index] - stats->mean) * (samples[sample_index] - stats->mean);
+    }
+    stats->stddev = (num_samples > 1) ? sqrt(squared_deviations / (num_samples - 1)) : 0.0;
+
+}
+
+// Device time in seconds spent by every command of "phase" recorded in "report"
+static double profiled_phase_seconds(const struct Opencl_Profiling_Report* report, enum Opencl_Profiling_Phase phase) {
+
+    double seconds = 0.0;
+    for (unsigned int command_index = 0; command_index < report->num_commands; ++command_index) {
+        if (report->commands[command_index].phase == phase) {
+            seconds += (report->commands[command_index].ended - report->commands[command_index].started) /
+                         PROFILING_NANOSECS_IN_SEC;
+        }
+    }
+    return seconds;
+
+}
+
+// Stores the upload, probe and readback phases of "report" in "phase_seconds"
+static void record_profiled_phases(const struct Opencl_Profiling_Report* report, double* phase_seconds) {
+
+    phase_seconds[BENCHMARK_PHASE_UPLOAD] = profiled_phase_seconds(report, PROFILING_PHASE_UPLOAD);
+    phase_seconds[BENCHMARK_PHASE_PROBE] = profiled_phase_seconds(report, PROFILING_PHASE_KERNEL);
+    phase_seconds[BENCHMARK_PHASE_READBACK] = profiled_phase_seconds(report, PROFILING_PHASE_READBACK);
+
+}
+
+// Engine named "engine_name", or NUM_BENCHMARK_ENGINES if there's no such engine
+static unsigned int benchmark_engine_by_name(const char* engine_name) {
+
+    unsigned int engine = 0;
+    while (engine < NUM_BENCHMARK_ENGINES && strcmp(engine_name, BENCHMARK_ENGINE_NAMES[engine]) != 0) {
+        ++engine;
+    }
+    return engine;
+
+}
+
+// Phase named "phase_name", or NUM_BENCHMARK_PHASES if there's no such phase
+static unsigned int benchmark_phase_by_name(const char* phase_name) {
+
+    unsigned int phase = 0;
+    while (phase < NUM_BENCHMARK_PHASES && strcmp(phase_name, BENCHMARK_PHASE_NAMES[phase]) != 0) {
+        ++phase;
+    }
+    return phase;
+
+}
+
+/*
+ * Parses "option_value" of "option_name" as a comma-separated list of unsigned numbers into
+ * "values", storing how many there are in "num_values"; exits if it can't be understood.
+ */
+static void parse_unsigned_list_option(const char* option_name, const char* option_value,
+                                         unsigned long* values, unsigned int* num_values) {
+
+    *num_values = 0;
+    const char* value_start = option_value;
+    while (true) {
+        char* value_end;
+        errno = 0;
+        unsigned long value = strtoul(value_start, &value_end, 10);
+        if (errno != 0 || value_end == value_start || *value_start == '-' ||
+            (*value_end != ',' && *value_end != '\0') || *num_values == MAX_BENCHMARK_SWEEP_VALUES) {
+            fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, option_value, option_name);
+            exit(EXIT_FAILURE);
+        }
+        values[(*num_values)++] = value;
+        if (*value_end == '\0') {
+            break;
+        }
+        value_start = value_end + 1;
+    }
+
+}
+
+// Parses a single unsigned number, like "parse_unsigned_list_option"
+static unsigned int parse_unsigned_option(const char* option_name, const char* option_value) {
+
+    unsigned long values[MAX_BENCHMARK_SWEEP_VALUES];
+    unsigned int num_values;
+    parse_unsigned_list_option(option_name, option_value, values, &num_values);
+    if (num_values != 1 || values[0] > MAX_BENCHMARK_REPETITIONS) {
+        fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, option_value, option_name);
+        exit(EXIT_FAILURE);
+    }
+    return (unsigned int) values[0];
+
+}
+
+static void parse_benchmark_options(int argc, char* argv[], struct Benchmark_Options* options) {
+
+    static const struct option long_options[] = {
+        {"engines", required_argument, NULL, 'e'},
+        {"rows", required_argument, NULL, 'r'},
+        {"work-group-sizes", required_argument, NULL, 'g'},
+        {"threads", required_argument, NULL, 't'},
+        {"warmup", required_argument, NULL, 'w'},
+        {"repetitions", required_argument, NULL, 'n'},
+        {"json", required_argument, NULL, 'j'},
+        {"customers", required_argument, NULL, 'c'},
+        {"purchases", required_argument, NULL, 'p'},
+        {"no-write", no_argument, NULL, 'W'},
+        {"baseline", required_argument, NULL, 'b'},
+        {"dataset", required_argument, NULL, 'd'},
+        {"record-baseline", no_argument, NULL, 'R'},
+        {NULL, 0, NULL, 0}
+    };
+
+    // Defaults: every engine on the whole purchases table, as "equijoin_gpu-vs-cpu" would run it
+    for (unsigned int engine = 0; engine < NUM_BENCHMARK_ENGINES; ++engine) {
+        options->is_engine_selected[engine] = true;
+    }
+    options->rows[0] = 0;
+    options->num_rows_values = 1;
+    options->work_group_sizes[0] = NUM_THREADS_IN_BLOCK;
+    options->num_work_group_sizes = 1;
+    options->threads[0] = 0;
+    options->num_threads_values = 1;
+    options->num_warmup_iterations = DEFAULT_BENCHMARK_WARMUP_ITERATIONS;
+    options->num_repetitions = DEFAULT_BENCHMARK_REPETITIONS;
+    options->report_file_location = BENCHMARK_REPORT_FILE_PATH;
+    options->customer_table_file_location = CUSTOMER_TABLE_FILE_PATH;
+    options->purchases_table_file_location = PURCHASES_TABLE_FILE_PATH;
+    options->is_write_measured = true;
+    options->baseline_file_location = NULL;
+    options->dataset_name = DEFAULT_BENCHMARK_DATASET_NAME;
+    options->is_baseline_recorded = false;
+
+    int option_index = 0;
+    int option_char;
+    while ((option_char = getopt_long(argc, argv, "", long_options, &option_index)) != -1) {
+        const char* option_name = long_options[option_index].name;
+        switch (option_char) {
+            case 'e': {
+                for (unsigned int engine = 0; engine < NUM_BENCHMARK_ENGINES; ++engine) {
+                    options->is_engine_selected[engine] = false;
+                }
+                char* engine_names = strdup(optarg);
+                assert(engine_names != NULL);
+                for (char* engine_name = strtok(engine_names, ","); engine_name != NULL;
+                     engine_name = strtok(NULL, ",")) {
+                    const unsigned int engine = benchmark_engine_by_name(engine_name);
+                    if (engine == NUM_BENCHMARK_ENGINES) {
+                        fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, engine_name, option_name);
+                        exit(EXIT_FAILURE);
+                    }
+                    options->is_engine_selected[engine] = true;
+                }
+                free(engine_names);
+                break;
+            }
+            case 'r':
+                parse_unsigned_list_option(option_name, optarg, options->rows, &(options->num_rows_values));
+                break;
+            case 'g':
+                parse_unsigned_list_option(option_name, optarg, options->work_group_sizes,
+                                             &(options->num_work_group_sizes));
+                for (unsigned int value_index = 0; value_index < options->num_work_group_sizes; ++value_index) {
+                    if (options->work_group_sizes[value_index] == 0 ||
+                        options->work_group_sizes[value_index] > MAX_BENCHMARK_WORK_GROUP_SIZE) {
+                        fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, optarg, option_name);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                break;
+            case 't':
+                parse_unsigned_list_option(option_name, optarg, options->threads, &(options->num_threads_values));
+                break;
+            case 'w':
+                options->num_warmup_iterations = parse_unsigned_option(option_name, optarg);
+                break;
+            case 'n':
+                options->num_repetitions = parse_unsigned_option(option_name, optarg);
+                if (options->num_repetitions == 0) {
+                    fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, optarg, option_name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'j':
+                options->report_file_location = optarg;
+                break;
+            case 'c':
+                options->customer_table_file_location = optarg;
+                break;
+            case 'p':
+                options->purchases_table_file_location = optarg;
+                break;
+            case 'W':
+                options->is_write_measured = false;
+                break;
+            case 'b':
+                options->baseline_file_location = optarg;
+                break;
+            case 'd':
+                // Dataset names are the first word of baseline file lines, so they can't be anything else
+                if (strlen(optarg) == 0 || strlen(optarg) >= MAX_BASELINE_DATASET_NAME_LEN ||
+                    strpbrk(optarg, " \t\n#") != NULL || strcmp(optarg, BASELINE_TOLERANCE_KEYWORD) == 0) {
+                    fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, optarg, option_name);
+                    exit(EXIT_FAILURE);
+                }
+                options->dataset_name = optarg;
+                break;
+            case 'R':
+                options->is_baseline_recorded = true;
+                break;
+            default:
+                fprintf(stderr, BENCHMARK_USAGE_MESSAGE, argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc || (options->is_baseline_recorded && options->baseline_file_location == NULL)) {
+        fprintf(stderr, BENCHMARK_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+}
+
+/*
+ * Returns a purchases table of exactly "num_rows" rows made of the rows of "purchases_table",
+ * repeated over and over if "num_rows" is more than it has; every customer ID stays valid.
+ */
+static struct Purchases_Table resize_purchases_table(const struct Purchases_Table* purchases_table,
+                                                       unsigned long num_rows) {
+
+    struct Purchases_Table resized_table = { malloc(num_rows * sizeof(*(purchases_table->table))), num_rows };
+    assert(resized_table.table != NULL);
+    for (unsigned long first_row = 0; first_row < num_rows; first_row += purchases_table->num_records) {
+        const unsigned long num_copied_rows = (num_rows - first_row < purchases_table->num_records) ?
+                                                 num_rows - first_row : purchases_table->num_records;
+        memcpy(&(resized_table.table[first_row]), purchases_table->table,
+                 num_copied_rows * sizeof(*(purchases_table->table)));
+    }
+    return resized_table;
+
+}
+
+// Runs one repetition of reading both input tables
+static void run_parse_repetition(const struct Benchmark_Options* options, double* phase_seconds) {
+
+    const double start_time = monotonic_clock_secs();
+    struct Hashed_Customer_Table* hashed_customer_table =
+                        read_hashed_customer_table_from_file(options->customer_table_file_location);
+    struct Purchases_Table* purchases_table = read_purchases_table_from_file(options->purchases_table_file_location);
+    phase_seconds[BENCHMARK_PHASE_PARSE] = monotonic_clock_secs() - start_time;
+
+    free(hashed_customer_table->table);
+    free(hashed_customer_table);
+    free(purchases_table->table);
+    free(purchases_table);
+
+}
+
+/*
+ * Compiles the OpenCL program for "kernel_variant", storing how long it took as the build phase;
+ * returns the program, to be released by the caller.
+ */
+static cl_program build_benchmark_program(struct Benchmark_Opencl_Env* opencl_env,
+                                            const struct Probe_Kernel_Variant* kernel_variant,
+                                              double* phase_seconds) {
+
+    const double start_time = monotonic_clock_secs();
+    cl_program program = build_opencl_program(opencl_env->context, opencl_env->device, opencl_env->program_string,
+                                                kernel_variant->compiler_options);
+    phase_seconds[BENCHMARK_PHASE_BUILD] = monotonic_clock_secs() - start_time;
+    return program;
+
+}
+
+// Writes "results_table" to disk, storing how long it took as the write phase
+static void write_benchmark_results(struct Joined_Results_Table* results_table, unsigned int num_threads,
+                                      const struct Benchmark_Options* options, double* phase_seconds) {
+
+    if (!options->is_write_measured) {
+        return;
+    }
+    const double start_time = monotonic_clock_secs();
+    write_results_table_to_csv_file_parallel(results_table, BENCHMARK_RESULTS_FILE_PATH, num_threads);
+    phase_seconds[BENCHMARK_PHASE_WRITE] = monotonic_clock_secs() - start_time;
+
+}
+
+/*
+ * Runs one repetition of the "opencl-resident" engine: creates a resident session for the customer
+ * table of "tables_list" (the build phase), streams its purchases table through it in batches of
+ * BENCHMARK_RESIDENT_BATCH_ROWS and twice as many rows in turn (device time of every batch summed up
+ * per phase), and checks the joined results against those of the serial engine.
+ */
+static void run_resident_repetition(struct List_Of_Tables tables_list, const struct Benchmark_Options* options,
+                                      double* phase_seconds) {
+
+    const double start_time = monotonic_clock_secs();
+    struct Resident_Probe_Session* session = create_resident_probe_session(tables_list.hashed_customer_table,
+                                                                              IS_CUSTOMER_ACTIVE);
+    phase_seconds[BENCHMARK_PHASE_BUILD] = monotonic_clock_secs() - start_time;
+
+    memset(tables_list.results_table->table, 0,
+             tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)));
+    phase_seconds[BENCHMARK_PHASE_UPLOAD] = 0.0;
+    phase_seconds[BENCHMARK_PHASE_PROBE] = 0.0;
+    phase_seconds[BENCHMARK_PHASE_READBACK] = 0.0;
+    // Each batch gets a report of its own, as a whole table's worth of batches wouldn't fit into one
+    struct Opencl_Profiling_Report batch_profiling_report;
+    unsigned long first_row = 0;
+    while (first_row < tables_list.purchases_table->num_records) {
+        const unsigned long batch_rows = (session->num_batches_probed % 2 == 0) ? BENCHMARK_RESIDENT_BATCH_ROWS :
+                                                                                   2 * BENCHMARK_RESIDENT_BATCH_ROWS;
+        const unsigned long remaining_rows = tables_list.purchases_table->num_records - first_row;
+        const unsigned long num_rows = (batch_rows < remaining_rows) ? batch_rows : remaining_rows;
+        struct Purchases_Table purchases_batch = { &(tables_list.purchases_table->table[first_row]), num_rows };
+        struct Joined_Results_Table results_batch = { &(tables_list.results_table->table[first_row]), num_rows };
+        reset_opencl_profiling_report(&batch_profiling_report);
+        probe_batch(session, &purchases_batch, &results_batch, &batch_profiling_report);
+        phase_seconds[BENCHMARK_PHASE_UPLOAD] += profiled_phase_seconds(&batch_profiling_report,
+                                                                          PROFILING_PHASE_UPLOAD);
+        phase_seconds[BENCHMARK_PHASE_PROBE] += profiled_phase_seconds(&batch_profiling_report,
+                                                                         PROFILING_PHASE_KERNEL);
+        phase_seconds[BENCHMARK_PHASE_READBACK] += profiled_phase_seconds(&batch_profiling_report,
+                                                                            PROFILING_PHASE_READBACK);
+        first_row += num_rows;
+    }
+    const unsigned long num_batches_probed = session->num_batches_probed;
+    destroy_resident_probe_session(session);
+
+    // Batches are probed exactly as a single table would be; nothing may differ from the serial results
+    struct Joined_Results_Table serial_results_table = {
+        calloc(tables_list.results_table->num_records, sizeof(*(tables_list.results_table->table))),
+        tables_list.results_table->num_records
+    };
+    assert(serial_results_table.table != NULL);
+    struct List_Of_Tables serial_tables_list = { tables_list.hashed_customer_table, tables_list.purchases_table,
+                                                 &serial_results_table };
+    serial_hash_equijoin_probe(serial_tables_list, IS_CUSTOMER_ACTIVE, NULL, NULL);
+    const bool are_results_equal =
+                compare_results_digests(compute_results_table_digest(tables_list.results_table, RESULTS_DIGEST_THREADS),
+                                          "resident results",
+                                          compute_results_table_digest(&serial_results_table, RESULTS_DIGEST_THREADS),
+                                          "serial results");
+    free(serial_results_table.table);
+    if (!are_results_equal) {
+        fprintf(stderr, BENCHMARK_RESIDENT_MISMATCH_MSG, num_batches_probed);
+        assert(false);
+    }
+
+    write_benchmark_results(tables_list.results_table, 0, options, phase_seconds);
+
+}
+
+/*
+ * Runs one repetition of "config" over "tables_list" (whose results table has room for every
+ * purchases table row), storing the seconds spent in each phase the engine has in "phase_seconds".
+ */
+static void run_engine_repetition(const struct Benchmark_Config* config, struct List_Of_Tables tables_list,
+                                    struct Benchmark_Opencl_Env* opencl_env, const struct Benchmark_Options* options,
+                                      double* phase_seconds) {
+
+    struct Probe_Kernel_Variant kernel_variant = opencl_env->kernel_variant;
+    kernel_variant.work_group_size = config->work_group_size;
+    struct Opencl_Profiling_Report profiling_report;
+    reset_opencl_profiling_report(&profiling_report);
+    double start_time;
+
+    // Both queries of the batch engines join every purchase, of active and of inactive customers
+    struct Batch_Query batch_queries[] = {
+        { CUSTOMER_ACTIVE_FLAG, { { { 0 } }, 0 }, PROJECT_ALL_COLUMNS },
+        { CUSTOMER_INACTIVE_FLAG, { { { 0 } }, 0 }, PROJECT_ALL_COLUMNS }
+    };
+    const unsigned int num_batch_queries = sizeof(batch_queries) / sizeof(batch_queries[0]);
+    struct Joined_Results_Table batch_query_results[sizeof(batch_queries) / sizeof(batch_queries[0])];
+    struct Aggregated_Results_Table aggregated_results;
+    struct Hot_Customer_Table hot_customer_table;
+
+    switch (config->engine) {
+
+        case BENCHMARK_ENGINE_PARSE:
+            run_parse_repetition(options, phase_seconds);
+            break;
+
+        case BENCHMARK_ENGINE_SERIAL:
+        case BENCHMARK_ENGINE_CPU_THREADS:
+            memset(tables_list.results_table->table, 0,
+                     tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)));
+            start_time = monotonic_clock_secs();
+            if (config->engine == BENCHMARK_ENGINE_SERIAL) {
+                serial_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, NULL, NULL);
+            } else {
+                threaded_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, NULL, config->num_threads);
+            }
+            phase_seconds[BENCHMARK_PHASE_PROBE] = monotonic_clock_secs() - start_time;
+            write_benchmark_results(tables_list.results_table, config->num_threads, options, phase_seconds);
+            break;
+
+        case BENCHMARK_ENGINE_CPU_HOT:
+            start_time = monotonic_clock_secs();
+            build_hot_customer_table(tables_list.hashed_customer_table, tables_list.purchases_table,
+                                       &hot_customer_table);
+            phase_seconds[BENCHMARK_PHASE_BUILD] = monotonic_clock_secs() - start_time;
+            memset(tables_list.results_table->table, 0,
+                     tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)));
+            start_time = monotonic_clock_secs();
+            hot_cached_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, NULL, &hot_customer_table);
+            phase_seconds[BENCHMARK_PHASE_PROBE] = monotonic_clock_secs() - start_time;
+            write_benchmark_results(tables_list.results_table, config->num_threads, options, phase_seconds);
+            break;
+
+        case BENCHMARK_ENGINE_OPENCL:
+        case BENCHMARK_ENGINE_OPENCL_HOT: {
+            cl_program program = build_benchmark_program(opencl_env, &kernel_variant, phase_seconds);
+            if (config->engine == BENCHMARK_ENGINE_OPENCL_HOT) {
+                // Sampling the hot customers counts towards the build phase, on top of compiling
+                start_time = monotonic_clock_secs();
+                build_hot_customer_table(tables_list.hashed_customer_table, tables_list.purchases_table,
+                                           &hot_customer_table);
+                phase_seconds[BENCHMARK_PHASE_BUILD] += monotonic_clock_secs() - start_time;
+                kernel_variant.hot_customer_table = &hot_customer_table;
+            }
+            cl_kernel kernel;
+            cl_mem hashed_customer_table_buffer, purchases_table_buffer, results_table_buffer;
+            struct Cl_Mem_Operands_List cl_mem_ops = {
+                &hashed_customer_table_buffer, &purchases_table_buffer, &results_table_buffer
+            };
+            memset(tables_list.results_table->table, 0,
+                     tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)));
+            load_tables_hash_equijoin_probe(&(opencl_env->context), &(opencl_env->queue), tables_list, cl_mem_ops,
+                                              &profiling_report);
+            opencl_hash_equijoin_probe(&(opencl_env->queue), &program, &kernel, tables_list, cl_mem_ops,
+                                         IS_CUSTOMER_ACTIVE, &kernel_variant, NULL, &profiling_report);
+            record_profiled_phases(&profiling_report, phase_seconds);
+            clReleaseKernel(kernel);
+            clReleaseMemObject(hashed_customer_table_buffer);
+            clReleaseMemObject(purchases_table_buffer);
+            clReleaseMemObject(results_table_buffer);
+            clReleaseProgram(program);
+            write_benchmark_results(tables_list.results_table, 0, options, phase_seconds);
+            break;
+        }
+
+        case BENCHMARK_ENGINE_CPU_AGGREGATE:
+            start_time = monotonic_clock_secs();
+            cpu_hash_equijoin_aggregate(tables_list, IS_CUSTOMER_ACTIVE, NULL, AGGREGATION_KEY_CUSTOMER_ID,
+                                          config->num_threads, &aggregated_results);
+            phase_seconds[BENCHMARK_PHASE_PROBE] = monotonic_clock_secs() - start_time;
+            if (options->is_write_measured) {
+                start_time = monotonic_clock_secs();
+                write_aggregated_results_to_csv_file(&aggregated_results, BENCHMARK_RESULTS_FILE_PATH);
+                phase_seconds[BENCHMARK_PHASE_WRITE] = monotonic_clock_secs() - start_time;
+            }
+            free(aggregated_results.table);
+            break;
+
+        case BENCHMARK_ENGINE_OPENCL_AGGREGATE: {
+            cl_program program = build_benchmark_program(opencl_env, &kernel_variant, phase_seconds);
+            opencl_hash_equijoin_aggregate(&(opencl_env->context), &(opencl_env->queue), &program, tables_list,
+                                             IS_CUSTOMER_ACTIVE, AGGREGATION_KEY_CUSTOMER_ID, &kernel_variant,
+                                             &profiling_report, &aggregated_results);
+            record_profiled_phases(&profiling_report, phase_seconds);
+            clReleaseProgram(program);
+            if (options->is_write_measured) {
+                start_time = monotonic_clock_secs();
+                write_aggregated_results_to_csv_file(&aggregated_results, BENCHMARK_RESULTS_FILE_PATH);
+                phase_seconds[BENCHMARK_PHASE_WRITE] = monotonic_clock_secs() - start_time;
+            }
+            free(aggregated_results.table);
+            break;
+        }
+
+        case BENCHMARK_ENGINE_CPU_BATCH:
+        case BENCHMARK_ENGINE_OPENCL_BATCH:
+            if (config->engine == BENCHMARK_ENGINE_CPU_BATCH) {
+                start_time = monotonic_clock_secs();
+                cpu_batch_hash_equijoin_probe(tables_list, batch_queries, num_batch_queries, batch_query_results);
+                phase_seconds[BENCHMARK_PHASE_PROBE] = monotonic_clock_secs() - start_time;
+            } else {
+                // The batch's program is compiled once, during warm-up, and cached from then on
+                opencl_batch_hash_equijoin_probe(&(opencl_env->context), &(opencl_env->queue),
+                                                   &(opencl_env->batch_program_cache), tables_list, batch_queries,
+                                                   num_batch_queries, &kernel_variant, &profiling_report,
+                                                   batch_query_results);
+                record_profiled_phases(&profiling_report, phase_seconds);
+            }
+            if (options->is_write_measured) {
+                char results_path[sizeof(BENCHMARK_BATCH_RESULTS_FILE_PATH_FORMAT) + 16];
+                start_time = monotonic_clock_secs();
+                for (unsigned int query_index = 0; query_index < num_batch_queries; ++query_index) {
+                    snprintf(results_path, sizeof(results_path), BENCHMARK_BATCH_RESULTS_FILE_PATH_FORMAT, query_index);
+                    write_batch_query_results_to_csv_file(&(batch_query_results[query_index]), query_index,
+                                                            batch_queries[query_index].projection, results_path);
+                }
+                phase_seconds[BENCHMARK_PHASE_WRITE] = monotonic_clock_secs() - start_time;
+            }
+            for (unsigned int query_index = 0; query_index < num_batch_queries; ++query_index) {
+                free_batch_query_results(&(batch_query_results[query_index]));
+            }
+            break;
+
+        case BENCHMARK_ENGINE_OPENCL_RESIDENT:
+            run_resident_repetition(tables_list, options, phase_seconds);
+            break;
+
+        default:
+            assert(false);
+
+    }
+
+}
+
+/*
+ * Runs "config" for the warm-up iterations and measured repetitions in "options" and summarizes
+ * each phase measured into "result".
+ */
+static void run_benchmark(const struct Benchmark_Config* config, struct List_Of_Tables tables_list,
+                            struct Benchmark_Opencl_Env* opencl_env, const struct Benchmark_Options* options,
+                              struct Benchmark_Result* result) {
+
+    fprintf(stderr, BENCHMARK_RUN_MSG, BENCHMARK_ENGINE_NAMES[config->engine], config->num_rows,
+              config->work_group_size, config->num_threads, options->num_warmup_iterations, options->num_repetitions);
+
+    double* samples = malloc(NUM_BENCHMARK_PHASES * options->num_repetitions * sizeof(*samples));
+    assert(samples != NULL);
+    double phase_seconds[NUM_BENCHMARK_PHASES];
+
+    for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+        result->is_phase_measured[phase] = false;
+    }
+    silence_stdout();
+    for (unsigned int iteration = 0; iteration < options->num_warmup_iterations + options->num_repetitions;
+                                                                                         ++iteration) {
+        // Phases an engine doesn't have stay negative
+        for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+            phase_seconds[phase] = -1.0;
+        }
+        run_engine_repetition(config, tables_list, opencl_env, options, phase_seconds);
+        if (iteration < options->num_warmup_iterations) {
+            continue;
+        }
+        const unsigned int repetition = iteration - options->num_warmup_iterations;
+        for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+            result->is_phase_measured[phase] = phase_seconds[phase] >= 0.0;
+            samples[phase * options->num_repetitions + repetition] = phase_seconds[phase];
+        }
+    }
+    restore_stdout();
+
+    result->config = *config;
+    result->num_repetitions = options->num_repetitions;
+    fprintf(stderr, BENCHMARK_PHASE_HEADER, "phase", "min", "median", "p95", "mean", "stddev");
+    for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+        if (!result->is_phase_measured[phase]) {
+            continue;
+        }
+        struct Benchmark_Phase_Stats* stats = &(result->stats[phase]);
+        summarize_benchmark_samples(&(samples[phase * options->num_repetitions]), options->num_repetitions, stats);
+        fprintf(stderr, BENCHMARK_PHASE_ROW_FORMAT, BENCHMARK_PHASE_NAMES[phase], stats->min, stats->median,
+                  stats->percentile, stats->mean, stats->stddev);
+    }
+    fprintf(stderr, "\n");
+    free(samples);
+
+}
+
+// Writes every benchmark result as a JSON document to "file_location"
+static void write_benchmark_report_to_json_file(const struct Benchmark_Result* results, unsigned int num_results,
+                                                  const struct Benchmark_Options* options, const char* device_name,
+                                                    const char* file_location) {
+
+    FILE* report_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (report_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    fprintf(stderr, BENCHMARK_REPORT_MSG, file_location);
+
+    fprintf(report_file, "{\n  \"device\": \"%s\",\n  \"warmup_iterations\": %u,\n  \"repetitions\": %u,\n"
+                           "  \"percentile\": %.1lf,\n  \"time_unit\": \"seconds\",\n  \"results\": [",
+              device_name, options->num_warmup_iterations, options->num_repetitions, BENCHMARK_PERCENTILE);
+    for (unsigned int result_index = 0; result_index < num_results; ++result_index) {
+        const struct Benchmark_Result* result = &(results[result_index]);
+        fprintf(report_file, "%s\n    {\"engine\": \"%s\", \"rows\": %lu, \"work_group_size\": %zu, \"threads\": %u,"
+                               " \"phases\": {", (result_index > 0) ? "," : "",
+                  BENCHMARK_ENGINE_NAMES[result->config.engine], result->config.num_rows,
+                  result->config.work_group_size, result->config.num_threads);
+        bool is_first_phase = true;
+        for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+            if (!result->is_phase_measured[phase]) {
+                continue;
+            }
+            const struct Benchmark_Phase_Stats* stats = &(result->stats[phase]);
+            fprintf(report_file, "%s\n      \"%s\": {\"min\": %.9lf, \"median\": %.9lf, \"p95\": %.9lf,"
+                                   " \"mean\": %.9lf, \"stddev\": %.9lf}", is_first_phase ? "" : ",",
+                      BENCHMARK_PHASE_NAMES[phase], stats->min, stats->median, stats->percentile, stats->mean,
+                      stats->stddev);
+            is_first_phase = false;
+        }
+        fprintf(report_file, "\n    }}");
+    }
+    fprintf(report_file, "\n  ]\n}\n");
+
+    // Done writing to file; close it
+    int func_status = fclose(report_file);
+    assert(func_status == 0);
+
+}
+
+/*
+ * Parameter details:
+ *   - line, line_number, file_location --- line of a baseline file, and where it comes from
+ *   - baseline --- baseline whose tolerances are set if "line" is a tolerance line; if NULL they're
+ *                  only checked
+ *   - dataset_name --- set to the dataset of the entry if "line" is an entry line (at least
+ *                      MAX_BASELINE_DATASET_NAME_LEN characters)
+ *   - entry --- set to the entry if "line" is an entry line
+ *
+ * Returns whether "line" is an entry line ("DATASET ENGINE ROWS WORK_GROUP_SIZE THREADS PHASE MEDIAN"),
+ * rather than a tolerance line ("tolerance PHASE PERCENT SECONDS"), a comment ("#...") or blank;
+ * exits if it's none of these.
+ */
+static bool parse_baseline_line(const char* line, unsigned int line_number, const char* file_location,
+                                  struct Benchmark_Baseline* baseline, char* dataset_name,
+                                    struct Benchmark_Baseline_Entry* entry) {
+
+    char first_word[MAX_BASELINE_DATASET_NAME_LEN];
+    if (sscanf(line, "%63s", first_word) != 1 || first_word[0] == '#') {
+        return false;
+    }
+
+    char engine_name[MAX_BASELINE_NAME_LEN], phase_name[MAX_BASELINE_NAME_LEN];
+    char trailing_char;
+    if (strcmp(first_word, BASELINE_TOLERANCE_KEYWORD) == 0) {
+        double tolerance_percent, tolerance_seconds;
+        if (sscanf(line, " " BASELINE_TOLERANCE_KEYWORD " %31s %lf %lf %c", phase_name, &tolerance_percent,
+                     &tolerance_seconds, &trailing_char) == 3 &&
+            benchmark_phase_by_name(phase_name) < NUM_BENCHMARK_PHASES &&
+            tolerance_percent >= 0.0 && tolerance_seconds >= 0.0) {
+            if (baseline != NULL) {
+                baseline->tolerance_percent[benchmark_phase_by_name(phase_name)] = tolerance_percent;
+                baseline->tolerance_seconds[benchmark_phase_by_name(phase_name)] = tolerance_seconds;
+            }
+            return false;
+        }
+    } else if (sscanf(line, "%63s %31s %lu %zu %u %31s %lf %c", dataset_name, engine_name, &(entry->config.num_rows),
+                        &(entry->config.work_group_size), &(entry->config.num_threads), phase_name,
+                          &(entry->median), &trailing_char) == 7 &&
+               benchmark_engine_by_name(engine_name) < NUM_BENCHMARK_ENGINES &&
+               benchmark_phase_by_name(phase_name) < NUM_BENCHMARK_PHASES && entry->median >= 0.0) {
+        entry->config.engine = (enum Benchmark_Engine) benchmark_engine_by_name(engine_name);
+        entry->phase = (enum Benchmark_Phase) benchmark_phase_by_name(phase_name);
+        entry->is_compared = false;
+        return true;
+    }
+
+    fprintf(stderr, BASELINE_INVALID_LINE_MESSAGE, line_number, file_location, line);
+    exit(EXIT_FAILURE);
+
+}
+
+// Opens "file_location" with "mode", exiting if it can't be unless "is_missing_file_allowed"
+static FILE* open_baseline_file(const char* file_location, const char* mode, bool is_missing_file_allowed) {
+
+    FILE* baseline_file = fopen(file_location, mode);
+    // Inform user if file didn't open correctly and abort program
+    if (baseline_file == NULL && !(is_missing_file_allowed && errno == ENOENT)) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    return baseline_file;
+
+}
+
+// Reads the tolerances and the entries of dataset "dataset_name" of baseline file "file_location"
+static void read_benchmark_baseline(const char* file_location, const char* dataset_name,
+                                      struct Benchmark_Baseline* baseline) {
+
+    for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+        baseline->tolerance_percent[phase] = DEFAULT_BASELINE_TOLERANCE_PERCENT;
+        baseline->tolerance_seconds[phase] = DEFAULT_BASELINE_TOLERANCE_SECONDS;
+    }
+    baseline->entries = NULL;
+    baseline->num_entries = 0;
+    unsigned int max_entries = 0;
+
+    FILE* baseline_file = open_baseline_file(file_location, "r", false);
+    char* line = NULL;
+    size_t line_buffer_size = 0;
+    for (unsigned int line_number = 1; getline(&line, &line_buffer_size, baseline_file) != -1; ++line_number) {
+        char entry_dataset_name[MAX_BASELINE_DATASET_NAME_LEN];
+        struct Benchmark_Baseline_Entry entry;
+        if (!parse_baseline_line(line, line_number, file_location, baseline, entry_dataset_name, &entry) ||
+            strcmp(entry_dataset_name, dataset_name) != 0) {
+            continue;
+        }
+        if (baseline->num_entries == max_entries) {
+            max_entries = (max_entries > 0) ? 2 * max_entries : NUM_BENCHMARK_ENGINES * NUM_BENCHMARK_PHASES;
+            baseline->entries = realloc(baseline->entries, max_entries * sizeof(*(baseline->entries)));
+            assert(baseline->entries != NULL);
+        }
+        baseline->entries[baseline->num_entries++] = entry;
+    }
+    free(line);
+    fclose(baseline_file);
+
+}
+
+static bool is_same_benchmark_config(const struct Benchmark_Config* first_config,
+                                       const struct Benchmark_Config* second_config) {
+
+    return first_config->engine == second_config->engine && first_config->num_rows == second_config->num_rows &&
+           first_config->work_group_size == second_config->work_group_size &&
+           first_config->num_threads == second_config->num_threads;
+
+}
+
+/*
+ * Prints out (to standard output) a row of the comparison table: "median" (of "phase" of "config")
+ * against "entry" and the "limit" it may not exceed; either may be missing (NULL, or negative).
+ */
+static void print_baseline_table_row(const char* dataset_name, const struct Benchmark_Config* config,
+                                       enum Benchmark_Phase phase, double median,
+                                         const struct Benchmark_Baseline_Entry* entry, double limit,
+                                           const char* status) {
+
+    char baseline_cell[32] = "-", median_cell[32] = "-", change_cell[32] = "-", limit_cell[32] = "-";
+    if (entry != NULL) {
+        snprintf(baseline_cell, sizeof(baseline_cell), "%.6lf", entry->median);
+    }
+    if (median >= 0.0) {
+        snprintf(median_cell, sizeof(median_cell), "%.6lf", median);
+    }
+    if (entry != NULL && median >= 0.0) {
+        snprintf(limit_cell, sizeof(limit_cell), "%.6lf", limit);
+        if (entry->median > 0.0) {
+            snprintf(change_cell, sizeof(change_cell), "%+.1lf%%", 100.0 * (median - entry->median) / entry->median);
+        }
+    }
+    printf(BASELINE_TABLE_ROW_FORMAT, dataset_name, BENCHMARK_ENGINE_NAMES[config->engine], config->num_rows,
+             config->work_group_size, config->num_threads, BENCHMARK_PHASE_NAMES[phase], baseline_cell, median_cell,
+             change_cell, limit_cell, status);
+
+}
+
+/*
+ * Compares the median of every phase of every one of "results" against "baseline", printing out a
+ * table with a row per phase (in the order benchmarks were run, then baseline entries nothing was
+ * compared against) so that tables of different runs can be diffed; returns how many regressed.
+ */
+static unsigned int compare_with_benchmark_baseline(const struct Benchmark_Result* results, unsigned int num_results,
+                                                      struct Benchmark_Baseline* baseline, const char* dataset_name) {
+
+    printf(BASELINE_TABLE_HEADER, "dataset", "engine", "rows", "wg", "threads", "phase", "baseline", "median",
+             "change", "limit", "status");
+    unsigned int num_regressions = 0;
+    for (unsigned int result_index = 0; result_index < num_results; ++result_index) {
+        const struct Benchmark_Result* result = &(results[result_index]);
+        for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+            if (!result->is_phase_measured[phase]) {
+                continue;
+            }
+            struct Benchmark_Baseline_Entry* entry = NULL;
+            for (unsigned int entry_index = 0; entry_index < baseline->num_entries && entry == NULL; ++entry_index) {
+                if (baseline->entries[entry_index].phase == phase &&
+                    is_same_benchmark_config(&(baseline->entries[entry_index].config), &(result->config))) {
+                    entry = &(baseline->entries[entry_index]);
+                }
+            }
+            const double median = result->stats[phase].median;
+            if (entry == NULL) {
+                print_baseline_table_row(dataset_name, &(result->config), (enum Benchmark_Phase) phase, median,
+                                           NULL, 0.0, "new");
+                continue;
+            }
+            entry->is_compared = true;
+
+            // Slower or faster by more than both tolerances
+            const double percent_margin = entry->median * baseline->tolerance_percent[phase] / 100.0;
+            const double margin = (percent_margin > baseline->tolerance_seconds[phase]) ?
+                                    percent_margin : baseline->tolerance_seconds[phase];
+            const char* status = "ok";
+            if (median > entry->median + margin) {
+                status = "REGRESSED";
+                ++num_regressions;
+            } else if (median < entry->median - margin) {
+                status = "faster";
+            }
+            print_baseline_table_row(dataset_name, &(result->config), (enum Benchmark_Phase) phase, median, entry,
+                                       entry->median + margin, status);
+        }
+    }
+
+    // Benchmarks in the baseline that weren't run this time (e.g. engines not selected or skipped)
+    for (unsigned int entry_index = 0; entry_index < baseline->num_entries; ++entry_index) {
+        const struct Benchmark_Baseline_Entry* entry = &(baseline->entries[entry_index]);
+        if (!entry->is_compared) {
+            print_baseline_table_row(dataset_name, &(entry->config), entry->phase, -1.0, entry, 0.0, "missing");
+        }
+    }
+    fflush(stdout);
+    return num_regressions;
+
+}
+
+/*
+ * Replaces the entries of dataset "dataset_name" of baseline file "file_location" (created if it
+ * doesn't exist) with the median of every phase of every one of "results"; every other line is
+ * kept as it is.
+ */
+static void record_benchmark_baseline(const struct Benchmark_Result* results, unsigned int num_results,
+                                        const char* file_location, const char* dataset_name) {
+
+    char* temporary_file_location = malloc(strlen(file_location) + strlen(BASELINE_TEMPORARY_FILE_SUFFIX) + 1);
+    assert(temporary_file_location != NULL);
+    sprintf(temporary_file_location, "%s%s", file_location, BASELINE_TEMPORARY_FILE_SUFFIX);
+    FILE* temporary_file = open_baseline_file(temporary_file_location, "w", false);
+
+    FILE* baseline_file = open_baseline_file(file_location, "r", true);
+    if (baseline_file != NULL) {
+        char* line = NULL;
+        size_t line_buffer_size = 0;
+        for (unsigned int line_number = 1; getline(&line, &line_buffer_size, baseline_file) != -1; ++line_number) {
+            char entry_dataset_name[MAX_BASELINE_DATASET_NAME_LEN];
+            struct Benchmark_Baseline_Entry entry;
+            if (!parse_baseline_line(line, line_number, file_location, NULL, entry_dataset_name, &entry) ||
+                strcmp(entry_dataset_name, dataset_name) != 0) {
+                fputs(line, temporary_file);
+            }
+        }
+        free(line);
+        fclose(baseline_file);
+    }
+
+    unsigned int num_entries = 0;
+    for (unsigned int result_index = 0; result_index < num_results; ++result_index) {
+        const struct Benchmark_Result* result = &(results[result_index]);
+        for (unsigned int phase = 0; phase < NUM_BENCHMARK_PHASES; ++phase) {
+            if (result->is_phase_measured[phase]) {
+                fprintf(temporary_file, "%s %s %lu %zu %u %s %.9lf\n", dataset_name,
+                          BENCHMARK_ENGINE_NAMES[result->config.engine], result->config.num_rows,
+                          result->config.work_group_size, result->config.num_threads, BENCHMARK_PHASE_NAMES[phase],
+                          result->stats[phase].median);
+                ++num_entries;
+            }
+        }
+    }
+
+    // Done writing to file; close it and put it in place of the old one
+    int func_status = fclose(temporary_file);
+    assert(func_status == 0);
+    func_status = rename(temporary_file_location, file_location);
+    assert(func_status == 0);
+    free(temporary_file_location);
+    fprintf(stderr, BASELINE_RECORDED_MSG, num_entries, dataset_name, file_location);
+
+}
+
+int main(int argc, char* argv[]) {
+
+    struct Benchmark_Options options;
+    parse_benchmark_options(argc, argv, &options);
+
+    silence_stdout();
+    struct Hashed_Customer_Table* hashed_customer_table =
+                        read_hashed_customer_table_from_file(options.customer_table_file_location);
+    struct Purchases_Table* purchases_table = read_purchases_table_from_file(options.purchases_table_file_location);
+
+    // Set up the default OpenCL device once; every OpenCL benchmark compiles its own program
+    struct Benchmark_Opencl_Env opencl_env;
+    cl_program default_program;
+    configure_opencl_env(&(opencl_env.context), &(opencl_env.queue), &default_program, &(opencl_env.kernel_variant));
+    clReleaseProgram(default_program);
+    cl_int func_error_code = clGetCommandQueueInfo(opencl_env.queue, CL_QUEUE_DEVICE, sizeof(opencl_env.device),
+                                                     &(opencl_env.device), NULL);
+    assert(func_error_code == CL_SUCCESS);
+    opencl_env.program_string = get_opencl_program_code(PROGRAM_FILE);
+    assert(opencl_env.program_string != NULL);
+    init_predicate_program_cache(&(opencl_env.batch_program_cache), opencl_env.context);
+    opencl_env.is_aggregation_supported = opencl_device_supports_aggregation(opencl_env.device);
+    char device_name[MAX_LEN] = { 0 };
+    clGetDeviceInfo(opencl_env.device, CL_DEVICE_NAME, sizeof(device_name) - 1, device_name, NULL);
+    restore_stdout();
+
+    // At most one result per combination of engine and swept parameters
+    const unsigned int max_results = NUM_BENCHMARK_ENGINES * options.num_rows_values *
+                                       (options.num_work_group_sizes + options.num_threads_values);
+    struct Benchmark_Result* results = malloc(max_results * sizeof(*results));
+    assert(results != NULL);
+    unsigned int num_results = 0;
+
+    if (options.is_engine_selected[BENCHMARK_ENGINE_PARSE]) {
+        struct Benchmark_Config config = { BENCHMARK_ENGINE_PARSE, purchases_table->num_records, 0, 0 };
+        struct List_Of_Tables no_tables = { NULL, NULL, NULL };
+        run_benchmark(&config, no_tables, &opencl_env, &options, &(results[num_results++]));
+    }
+
+    for (unsigned int rows_index = 0; rows_index < options.num_rows_values; ++rows_index) {
+
+        const unsigned long num_rows = (options.rows[rows_index] > 0) ? options.rows[rows_index] :
+                                                                        purchases_table->num_records;
+        struct Purchases_Table benchmarked_purchases = resize_purchases_table(purchases_table, num_rows);
+        struct Joined_Results_Table results_table = { calloc(num_rows, sizeof(*(results_table.table))), num_rows };
+        assert(results_table.table != NULL);
+        struct List_Of_Tables tables_list = { hashed_customer_table, &benchmarked_purchases, &results_table };
+
+        for (unsigned int engine = BENCHMARK_ENGINE_SERIAL; engine < NUM_BENCHMARK_ENGINES; ++engine) {
+            if (!options.is_engine_selected[engine]) {
+                continue;
+            }
+            if (engine == BENCHMARK_ENGINE_OPENCL_AGGREGATE && !opencl_env.is_aggregation_supported) {
+                fprintf(stderr, BENCHMARK_SKIPPED_MSG, BENCHMARK_ENGINE_NAMES[engine], AGGREGATION_REQUIRED_EXTENSION);
+                continue;
+            }
+            struct Benchmark_Config config = { (enum Benchmark_Engine) engine, num_rows, 0, 0 };
+            const bool is_opencl_engine = engine == BENCHMARK_ENGINE_OPENCL ||
+                                          engine == BENCHMARK_ENGINE_OPENCL_AGGREGATE ||
+                                          engine == BENCHMARK_ENGINE_OPENCL_BATCH ||
+                                          engine == BENCHMARK_ENGINE_OPENCL_HOT;
+            const bool is_threaded_engine = engine == BENCHMARK_ENGINE_CPU_THREADS ||
+                                            engine == BENCHMARK_ENGINE_CPU_AGGREGATE;
+            if (is_opencl_engine) {
+                // Sweep work-group sizes
+                for (unsigned int size_index = 0; size_index < options.num_work_group_sizes; ++size_index) {
+                    config.work_group_size = options.work_group_sizes[size_index];
+                    run_benchmark(&config, tables_list, &opencl_env, &options, &(results[num_results++]));
+                }
+            } else if (engine == BENCHMARK_ENGINE_OPENCL_RESIDENT) {
+                // Sessions always launch NUM_THREADS_IN_BLOCK work-items per work-group
+                config.work_group_size = NUM_THREADS_IN_BLOCK;
+                run_benchmark(&config, tables_list, &opencl_env, &options, &(results[num_results++]));
+            } else if (is_threaded_engine) {
+                // Sweep thread counts
+                for (unsigned int threads_index = 0; threads_index < options.num_threads_values; ++threads_index) {
+                    config.num_threads = resolve_num_threads((unsigned int) options.threads[threads_index]);
+                    run_benchmark(&config, tables_list, &opencl_env, &options, &(results[num_results++]));
+                }
+            } else {
+                // Single-threaded; results are still written with a single thread
+                config.num_threads = 1;
+                run_benchmark(&config, tables_list, &opencl_env, &options, &(results[num_results++]));
+            }
+        }
+
+        free(results_table.table);
+        free(benchmarked_purchases.table);
+
+    }
+
+    write_benchmark_report_to_json_file(results, num_results, &options, device_name, options.report_file_location);
+
+    unsigned int num_regressions = 0;
+    if (options.baseline_file_location != NULL && options.is_baseline_recorded) {
+        record_benchmark_baseline(results, num_results, options.baseline_file_location, options.dataset_name);
+    } else if (options.baseline_file_location != NULL) {
+        struct Benchmark_Baseline baseline;
+        read_benchmark_baseline(options.baseline_file_location, options.dataset_name, &baseline);
+        num_regressions = compare_with_benchmark_baseline(results, num_results, &baseline, options.dataset_name);
+        if (num_regressions > 0) {
+            fprintf(stderr, BASELINE_REGRESSIONS_MSG, num_regressions, options.dataset_name,
+                      options.baseline_file_location);
+        }
+        free(baseline.entries);
+    }
+
+    free(results);
+    release_predicate_program_cache(&(opencl_env.batch_program_cache));
+    free(opencl_env.program_string);
+    clReleaseCommandQueue(opencl_env.queue);
+    clReleaseContext(opencl_env.context);
+    free(hashed_customer_table->table);
+    free(hashed_customer_table);
+    free(purchases_table->table);
+    free(purchases_table);
+
+    return (num_regressions > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+}
+
+// =================================================================================================
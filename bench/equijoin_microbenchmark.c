@@ -0,0 +1,514 @@
+
+// =================================================================================================
+// Project:
+// Component microbenchmarks of the CSV row parsers, the customer table hashing, the serial probe
+// engine and the results CSV formatter; built with "make microbenchmark".
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by this program with custom headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <bsd/string.h>
+#include <errno.h>
+#include <assert.h>
+#include <getopt.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "data_structures_opencl.h"
+#include "table_utilities.h"
+#include "equijoin_serial.h"
+#include "monotonic_clock.h"
+#include "equijoin_microbenchmark.h"
+
+// First names of synthetic customers, all shorter than FIRST_NAME_MAX_LEN
+static const char* const MICROBENCHMARK_FIRST_NAMES[] = {
+    "James", "Mary", "Robert", "Patricia", "John", "Jennifer", "Michael", "Linda",
+    "David", "Elizabeth", "William", "Barbara", "Richard", "Susan", "Joseph", "Jessica"
+};
+#define NUM_MICROBENCHMARK_FIRST_NAMES (sizeof(MICROBENCHMARK_FIRST_NAMES) / sizeof(*MICROBENCHMARK_FIRST_NAMES))
+
+/*
+ * Everything given on the command-line.
+ *   - num_rows --- rows each component works on in every repetition
+ *   - num_repetitions --- repetitions timed of each component
+ *   - customer_rows --- customer table sizes (in rows) the probe is timed with, and how many there are;
+ *                       none given means one per cache level and one for main memory
+ */
+struct Microbenchmark_Options {
+    unsigned long num_rows;
+    unsigned int num_repetitions;
+    unsigned long customer_rows[MAX_MICROBENCHMARK_CUSTOMER_SIZES];
+    unsigned int num_customer_sizes;
+};
+
+/*
+ * Frequency of the cycle counter, and the memory level each customer table size fits in.
+ *   - counter_name --- what "read_cycle_counter" reads
+ *   - cycles_per_nanosec --- ticks of the cycle counter per nanosecond
+ *   - cache_bytes --- sizes of the L1 data, L2 and L3 caches
+ */
+struct Microbenchmark_Machine {
+    const char* counter_name;
+    double cycles_per_nanosec;
+    unsigned long cache_bytes[3];
+};
+
+uint64_t read_cycle_counter(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    // "lfence" waits for earlier instructions to finish, and keeps later ones from starting early
+    _mm_lfence();
+    const uint64_t cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+#else
+    return (uint64_t) monotonic_clock_nanosecs();
+#endif
+
+}
+
+// Finds how many times the cycle counter ticks per nanosecond, by busy-waiting on the monotonic clock
+static void calibrate_cycle_counter(struct Microbenchmark_Machine* machine) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    machine->counter_name = "time stamp counter";
+    const unsigned long start_nanosecs = monotonic_clock_nanosecs();
+    const uint64_t start_cycles = read_cycle_counter();
+    unsigned long end_nanosecs;
+    do {
+        end_nanosecs = monotonic_clock_nanosecs();
+    } while (end_nanosecs - start_nanosecs < MICROBENCHMARK_CALIBRATION_NANOSECS);
+    const uint64_t end_cycles = read_cycle_counter();
+    machine->cycles_per_nanosec = (double) (end_cycles - start_cycles) / (double) (end_nanosecs - start_nanosecs);
+#else
+    machine->counter_name = "monotonic clock";
+    machine->cycles_per_nanosec = 1.0;
+#endif
+
+}
+
+// Size of a cache reported by "sysconf", or "default_bytes" if the system doesn't report it
+static unsigned long cache_size_or_default(int sysconf_name, unsigned long default_bytes) {
+
+    const long cache_bytes = sysconf(sysconf_name);
+    return (cache_bytes > 0) ? (unsigned long) cache_bytes : default_bytes;
+
+}
+
+static void detect_cache_sizes(struct Microbenchmark_Machine* machine) {
+
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    machine->cache_bytes[0] = cache_size_or_default(_SC_LEVEL1_DCACHE_SIZE, MICROBENCHMARK_DEFAULT_L1D_BYTES);
+    machine->cache_bytes[1] = cache_size_or_default(_SC_LEVEL2_CACHE_SIZE, MICROBENCHMARK_DEFAULT_L2_BYTES);
+    machine->cache_bytes[2] = cache_size_or_default(_SC_LEVEL3_CACHE_SIZE, MICROBENCHMARK_DEFAULT_L3_BYTES);
+#else
+    machine->cache_bytes[0] = MICROBENCHMARK_DEFAULT_L1D_BYTES;
+    machine->cache_bytes[1] = MICROBENCHMARK_DEFAULT_L2_BYTES;
+    machine->cache_bytes[2] = MICROBENCHMARK_DEFAULT_L3_BYTES;
+#endif
+
+}
+
+// Name of the smallest level of the memory hierarchy "table_bytes" fits in
+static const char* memory_level_name(const struct Microbenchmark_Machine* machine, unsigned long table_bytes) {
+
+    static const char* const CACHE_LEVEL_NAMES[] = { "L1", "L2", "L3" };
+    for (unsigned int level = 0; level < 3; ++level) {
+        if (table_bytes <= machine->cache_bytes[level]) {
+            return CACHE_LEVEL_NAMES[level];
+        }
+    }
+    return "DRAM";
+
+}
+
+/*
+ * Parses "option_value" of "option_name" as a comma-separated list of at most "max_values"
+ * positive numbers into "values", storing how many there are in "num_values"; exits if it can't
+ * be understood.
+ */
+static void parse_unsigned_list_option(const char* option_name, const char* option_value, unsigned long* values,
+                                         unsigned int max_values, unsigned int* num_values) {
+
+    *num_values = 0;
+    const char* value_start = option_value;
+    while (true) {
+        char* value_end;
+        errno = 0;
+        unsigned long value = strtoul(value_start, &value_end, 10);
+        if (errno != 0 || value_end == value_start || *value_start == '-' || value == 0 ||
+            (*value_end != ',' && *value_end != '\0') || *num_values == max_values) {
+            fprintf(stderr, MICROBENCHMARK_INVALID_OPTION_MESSAGE, option_value, option_name);
+            exit(EXIT_FAILURE);
+        }
+        values[(*num_values)++] = value;
+        if (*value_end == '\0') {
+            break;
+        }
+        value_start = value_end + 1;
+    }
+
+}
+
+static void parse_microbenchmark_options(int argc, char* argv[], struct Microbenchmark_Options* options) {
+
+    static const struct option long_options[] = {
+        {"rows", required_argument, NULL, 'r'},
+        {"repetitions", required_argument, NULL, 'n'},
+        {"customer-rows", required_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0}
+    };
+
+    options->num_rows = DEFAULT_MICROBENCHMARK_ROWS;
+    options->num_repetitions = DEFAULT_MICROBENCHMARK_REPETITIONS;
+    options->num_customer_sizes = 0;
+
+    int option_index = 0;
+    int option_char;
+    unsigned long value;
+    unsigned int num_values;
+    while ((option_char = getopt_long(argc, argv, "", long_options, &option_index)) != -1) {
+        const char* option_name = long_options[option_index].name;
+        switch (option_char) {
+            case 'r':
+                parse_unsigned_list_option(option_name, optarg, &value, 1, &num_values);
+                options->num_rows = value;
+                break;
+            case 'n':
+                parse_unsigned_list_option(option_name, optarg, &value, 1, &num_values);
+                if (value > MAX_MICROBENCHMARK_REPETITIONS) {
+                    fprintf(stderr, MICROBENCHMARK_INVALID_OPTION_MESSAGE, optarg, option_name);
+                    exit(EXIT_FAILURE);
+                }
+                options->num_repetitions = (unsigned int) value;
+                break;
+            case 'c':
+                parse_unsigned_list_option(option_name, optarg, options->customer_rows,
+                                             MAX_MICROBENCHMARK_CUSTOMER_SIZES, &(options->num_customer_sizes));
+                break;
+            default:
+                fprintf(stderr, MICROBENCHMARK_USAGE_MESSAGE, argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        fprintf(stderr, MICROBENCHMARK_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+}
+
+// Next pseudo-random number of "state" ("splitmix64")
+static uint64_t next_random_number(uint64_t* state) {
+
+    uint64_t value = (*state += 0x9e3779b97f4a7c15ull);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+
+}
+
+/*
+ * Writes "num_rows" synthetic customer table lines (customer IDs 1 to "num_rows", in order, as in
+ * the customer table files) or purchases table lines (customer IDs up to "num_rows") into "lines",
+ * MICROBENCHMARK_MAX_CSV_LINE_LEN bytes apart; returns the number of characters of every line.
+ */
+static size_t generate_csv_lines(char* lines, unsigned long num_rows, bool is_customer_table) {
+
+    uint64_t random_state = MICROBENCHMARK_SEED;
+    size_t total_len = 0;
+    for (unsigned long row = 0; row < num_rows; ++row) {
+        char* line = lines + row * MICROBENCHMARK_MAX_CSV_LINE_LEN;
+        const uint64_t random_number = next_random_number(&random_state);
+        int line_len;
+        if (is_customer_table) {
+            line_len = snprintf(line, MICROBENCHMARK_MAX_CSV_LINE_LEN, "%lu,\"%s\",%c\n", row + 1,
+                                  MICROBENCHMARK_FIRST_NAMES[random_number % NUM_MICROBENCHMARK_FIRST_NAMES],
+                                  (random_number & 0x100) ? CUSTOMER_ACTIVE_FLAG : CUSTOMER_INACTIVE_FLAG);
+        } else {
+            line_len = snprintf(line, MICROBENCHMARK_MAX_CSV_LINE_LEN, "%lu,%lu,\"%013lu\",%lu\n",
+                                  1600000000000000000ul + (random_number >> 8),
+                                  (unsigned long) (random_number % num_rows) + 1,
+                                  (unsigned long) ((random_number >> 16) % 10000000000000ul),
+                                  (unsigned long) ((random_number >> 40) % 10000) + 1);
+        }
+        assert(line_len > 0 && line_len < MICROBENCHMARK_MAX_CSV_LINE_LEN);
+        total_len += (size_t) line_len;
+    }
+    return total_len;
+
+}
+
+/*
+ * Fills "hashed_customer_table" (which has room for "num_rows" rows) with customer IDs 1 to
+ * "num_rows", and "purchases_table" with purchases of random customers of those, without parsing.
+ */
+static void generate_probe_tables(struct Hashed_Customer_Table* hashed_customer_table, unsigned long num_customers,
+                                    struct Purchases_Table* purchases_table) {
+
+    uint64_t random_state = MICROBENCHMARK_SEED;
+    for (unsigned long row = 0; row < num_customers; ++row) {
+        const uint64_t random_number = next_random_number(&random_state);
+        struct Hashed_Customer_Table_Row* customer_row =
+                        &(hashed_customer_table->table[customer_id_to_row_index(row + 1)]);
+        customer_row->customer_id = row + 1;
+        strlcpy(customer_row->first_name, MICROBENCHMARK_FIRST_NAMES[random_number % NUM_MICROBENCHMARK_FIRST_NAMES],
+                  FIRST_NAME_MAX_LEN);
+        customer_row->active_customer = (random_number & 0x100) ? CUSTOMER_ACTIVE_FLAG : CUSTOMER_INACTIVE_FLAG;
+    }
+    hashed_customer_table->num_records = num_customers;
+
+    for (unsigned long row = 0; row < purchases_table->num_records; ++row) {
+        const uint64_t random_number = next_random_number(&random_state);
+        struct Purchases_Table_Row* purchase_row = &(purchases_table->table[row]);
+        purchase_row->time_of_purchase = 1600000000000000000ul + (random_number >> 8);
+        purchase_row->customer_id = (random_number % num_customers) + 1;
+        snprintf(purchase_row->ean13, EAN13_MAX_CHARS, "%013lu",
+                   (unsigned long) ((random_number >> 16) % 10000000000000ul));
+        purchase_row->quantity_purchased = ((random_number >> 40) % 10000) + 1;
+    }
+
+}
+
+static int compare_doubles(const void* first_value, const void* second_value) {
+
+    const double first = *((const double*) first_value), second = *((const double*) second_value);
+    return (first > second) - (first < second);
+
+}
+
+// Median of "samples" (which are sorted in place)
+static double median_of_samples(double* samples, unsigned int num_samples) {
+
+    qsort(samples, num_samples, sizeof(*samples), compare_doubles);
+    return (num_samples % 2 == 1) ? samples[num_samples / 2] :
+                                    (samples[num_samples / 2 - 1] + samples[num_samples / 2]) / 2.0;
+
+}
+
+/*
+ * Turns the cycles and nanoseconds every repetition of a component took to process "num_rows"
+ * rows of "bytes_per_row" bytes each into "result".
+ */
+static void summarize_microbenchmark(double* cycle_samples, double* nanosec_samples, unsigned int num_repetitions,
+                                       unsigned long num_rows, double bytes_per_row,
+                                       struct Microbenchmark_Result* result) {
+
+    result->cycles_per_row = median_of_samples(cycle_samples, num_repetitions) / num_rows;
+    result->nanosecs_per_row = median_of_samples(nanosec_samples, num_repetitions) / num_rows;
+    result->min_nanosecs_per_row = nanosec_samples[0] / num_rows;
+    result->bytes_per_row = bytes_per_row;
+    result->bytes_per_cycle = bytes_per_row / result->cycles_per_row;
+
+}
+
+static void print_microbenchmark_row(const char* component, const char* memory_level, unsigned long table_bytes,
+                                       const struct Microbenchmark_Result* result) {
+
+    char table_size[32];
+    snprintf(table_size, sizeof(table_size), "%.1lf KB", table_bytes / 1024.0);
+    printf(MICROBENCHMARK_ROW_FORMAT, component, memory_level, table_size, result->cycles_per_row,
+             result->nanosecs_per_row, result->min_nanosecs_per_row, result->bytes_per_row, result->bytes_per_cycle);
+
+}
+
+/*
+ * Components timed, each in a block of the same shape: anything the component modifies is reset
+ * before every repetition (outside of the timed region), and then every row is run through it
+ * once.  "start_cycles" and "start_nanosecs" MUST be set right before the rows are run through.
+ */
+#define START_MICROBENCHMARK_REPETITION() \
+            const unsigned long start_nanosecs = monotonic_clock_nanosecs(); \
+            const uint64_t start_cycles = read_cycle_counter()
+#define END_MICROBENCHMARK_REPETITION(repetition) \
+            cycle_samples[repetition] = (double) (read_cycle_counter() - start_cycles); \
+            nanosec_samples[repetition] = (double) (monotonic_clock_nanosecs() - start_nanosecs)
+
+int main(int argc, char* argv[]) {
+
+    struct Microbenchmark_Options options;
+    parse_microbenchmark_options(argc, argv, &options);
+    const unsigned long num_rows = options.num_rows;
+    const unsigned int num_repetitions = options.num_repetitions;
+
+    struct Microbenchmark_Machine machine;
+    calibrate_cycle_counter(&machine);
+    detect_cache_sizes(&machine);
+    if (options.num_customer_sizes == 0) {
+        // Half of every cache level (the other half is left to the purchases and results streamed through)
+        for (unsigned int level = 0; level < 3; ++level) {
+            options.customer_rows[level] = machine.cache_bytes[level] / 2 / sizeof(struct Hashed_Customer_Table_Row);
+        }
+        unsigned long dram_bytes = MICROBENCHMARK_DRAM_FACTOR * machine.cache_bytes[2];
+        if (dram_bytes < MICROBENCHMARK_MIN_DRAM_BYTES) {
+            dram_bytes = MICROBENCHMARK_MIN_DRAM_BYTES;
+        }
+        options.customer_rows[3] = dram_bytes / sizeof(struct Hashed_Customer_Table_Row);
+        options.num_customer_sizes = 4;
+    }
+
+    double* cycle_samples = malloc(num_repetitions * sizeof(*cycle_samples));
+    double* nanosec_samples = malloc(num_repetitions * sizeof(*nanosec_samples));
+    assert(cycle_samples != NULL && nanosec_samples != NULL);
+    struct Microbenchmark_Result result;
+
+    printf(MICROBENCHMARK_CLOCK_MSG, machine.counter_name, machine.cycles_per_nanosec, num_rows, num_repetitions);
+    printf(MICROBENCHMARK_HEADER, "component", "fits", "table size", "cycles/row", "ns/row", "min ns/row",
+             "bytes/row", "bytes/cycle");
+
+    /*
+     * CSV lines of either table, parsed from a working copy since the parsers modify lines; the
+     * customer table lines have customer IDs 1 to "num_rows", so that every line is stored.
+     */
+    const size_t lines_bytes = num_rows * MICROBENCHMARK_MAX_CSV_LINE_LEN;
+    char* customer_lines = malloc(lines_bytes);
+    char* purchases_lines = malloc(lines_bytes);
+    char* working_lines = malloc(lines_bytes);
+    assert(customer_lines != NULL && purchases_lines != NULL && working_lines != NULL);
+    const size_t customer_lines_len = generate_csv_lines(customer_lines, num_rows, true);
+    const size_t purchases_lines_len = generate_csv_lines(purchases_lines, num_rows, false);
+
+    // Parsing lines of the customer table into rows
+    struct Hashed_Customer_Table_Row customer_row;
+    for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+        memcpy(working_lines, customer_lines, lines_bytes);
+        START_MICROBENCHMARK_REPETITION();
+        for (unsigned long row = 0; row < num_rows; ++row) {
+            csv_file_line_to_customer_table_row(working_lines + row * MICROBENCHMARK_MAX_CSV_LINE_LEN, &customer_row);
+        }
+        END_MICROBENCHMARK_REPETITION(repetition);
+    }
+    summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows,
+                               (double) customer_lines_len / num_rows, &result);
+    print_microbenchmark_row("parse customer line", "-", customer_lines_len, &result);
+
+    // Parsing lines of the purchases table into rows
+    struct Purchases_Table_Row purchases_row;
+    for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+        memcpy(working_lines, purchases_lines, lines_bytes);
+        START_MICROBENCHMARK_REPETITION();
+        for (unsigned long row = 0; row < num_rows; ++row) {
+            csv_file_line_to_purchases_table_row(working_lines + row * MICROBENCHMARK_MAX_CSV_LINE_LEN, &purchases_row);
+        }
+        END_MICROBENCHMARK_REPETITION(repetition);
+    }
+    summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows,
+                               (double) purchases_lines_len / num_rows, &result);
+    print_microbenchmark_row("parse purchases line", "-", purchases_lines_len, &result);
+
+    // Parsing and hashing lines of the customer table into a table with room for all of them
+    struct Hashed_Customer_Table* hashed_customer_table = malloc(sizeof(*hashed_customer_table));
+    assert(hashed_customer_table != NULL);
+    hashed_customer_table->table = calloc(num_rows, sizeof(*(hashed_customer_table->table)));
+    assert(hashed_customer_table->table != NULL);
+    size_t current_table_row_count = num_rows;
+    for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+        memcpy(working_lines, customer_lines, lines_bytes);
+        hashed_customer_table->num_records = 0;
+        START_MICROBENCHMARK_REPETITION();
+        for (unsigned long row = 0; row < num_rows; ++row) {
+            hash_and_store_record_in_hashed_customer_table(working_lines + row * MICROBENCHMARK_MAX_CSV_LINE_LEN,
+                                                             &current_table_row_count, &hashed_customer_table);
+        }
+        END_MICROBENCHMARK_REPETITION(repetition);
+    }
+    const unsigned long hashed_customer_table_bytes = num_rows * sizeof(*(hashed_customer_table->table));
+    summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows,
+                               (double) customer_lines_len / num_rows, &result);
+    print_microbenchmark_row("hash and store customer", memory_level_name(&machine, hashed_customer_table_bytes),
+                               hashed_customer_table_bytes, &result);
+    free(hashed_customer_table->table);
+    free(hashed_customer_table);
+
+    // Parsing and appending lines of the purchases table to a table with room for all of them
+    struct Purchases_Table* purchases_table = malloc(sizeof(*purchases_table));
+    assert(purchases_table != NULL);
+    purchases_table->table = calloc(num_rows, sizeof(*(purchases_table->table)));
+    assert(purchases_table->table != NULL);
+    current_table_row_count = num_rows;
+    for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+        memcpy(working_lines, purchases_lines, lines_bytes);
+        purchases_table->num_records = 0;
+        START_MICROBENCHMARK_REPETITION();
+        for (unsigned long row = 0; row < num_rows; ++row) {
+            store_record_in_purchases_table(working_lines + row * MICROBENCHMARK_MAX_CSV_LINE_LEN,
+                                              &current_table_row_count, &purchases_table);
+        }
+        END_MICROBENCHMARK_REPETITION(repetition);
+    }
+    const unsigned long purchases_table_bytes = num_rows * sizeof(*(purchases_table->table));
+    summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows,
+                               (double) purchases_lines_len / num_rows, &result);
+    print_microbenchmark_row("store purchase", memory_level_name(&machine, purchases_table_bytes),
+                               purchases_table_bytes, &result);
+    free(customer_lines);
+    free(purchases_lines);
+    free(working_lines);
+
+    /*
+     * Probing customer tables of every size with the same number of purchases; every probed row
+     * reads a purchases table row and a customer table row and writes a results table row.
+     */
+    struct Joined_Results_Table* results_table = malloc(sizeof(*results_table));
+    assert(results_table != NULL);
+    results_table->table = calloc(num_rows, sizeof(*(results_table->table)));
+    assert(results_table->table != NULL);
+    results_table->num_records = num_rows;
+    const double probe_bytes_per_row = sizeof(struct Purchases_Table_Row) + sizeof(struct Hashed_Customer_Table_Row) +
+                                         sizeof(struct Joined_Results_Table_Row);
+    for (unsigned int size_index = 0; size_index < options.num_customer_sizes; ++size_index) {
+        const unsigned long num_customers = options.customer_rows[size_index];
+        struct Hashed_Customer_Table probed_customer_table;
+        probed_customer_table.table = calloc(num_customers, sizeof(*(probed_customer_table.table)));
+        assert(probed_customer_table.table != NULL);
+        generate_probe_tables(&probed_customer_table, num_customers, purchases_table);
+        struct List_Of_Tables tables_list = { &probed_customer_table, purchases_table, results_table };
+        for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+            START_MICROBENCHMARK_REPETITION();
+            serial_hash_equijoin_probe_rows(tables_list, CUSTOMER_ACTIVE_FLAG, NULL, 0, num_rows);
+            END_MICROBENCHMARK_REPETITION(repetition);
+        }
+        const unsigned long probed_customer_table_bytes = num_customers * sizeof(*(probed_customer_table.table));
+        summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows, probe_bytes_per_row,
+                                   &result);
+        print_microbenchmark_row("serial probe", memory_level_name(&machine, probed_customer_table_bytes),
+                                   probed_customer_table_bytes, &result);
+        free(probed_customer_table.table);
+    }
+
+    // Formatting the joined records of the last probe (a mix of joined and NULL rows) as CSV lines
+    char* csv_output = malloc(num_rows * MAX_JOINED_RESULT_ROW_CSV_LEN);
+    assert(csv_output != NULL);
+    size_t csv_output_len = 0;
+    for (unsigned int repetition = 0; repetition < num_repetitions; ++repetition) {
+        START_MICROBENCHMARK_REPETITION();
+        csv_output_len = format_results_table_rows_as_csv(results_table, 0, num_rows, csv_output);
+        END_MICROBENCHMARK_REPETITION(repetition);
+    }
+    summarize_microbenchmark(cycle_samples, nanosec_samples, num_repetitions, num_rows,
+                               (double) csv_output_len / num_rows, &result);
+    print_microbenchmark_row("format results csv", "-", csv_output_len, &result);
+    free(csv_output);
+
+    free(results_table->table);
+    free(results_table);
+    free(purchases_table->table);
+    free(purchases_table);
+    free(cycle_samples);
+    free(nanosec_samples);
+    return EXIT_SUCCESS;
+
+}
+// =================================================================================================
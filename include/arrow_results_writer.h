@@ -0,0 +1,48 @@
+
+/*
+ * Author - Ted Li
+ *
+ * This file defines the function and macros used to write an
+ * equijoin results table to disk as an Apache Arrow IPC file
+ * (https://arrow.apache.org/docs/format/Columnar.html), so that
+ * readers may load (or mmap) the typed columns directly instead
+ * of re-parsing CSV text.  The Arrow metadata (flatbuffers) is
+ * written by hand, so the Arrow libraries are NOT needed.
+ */
+
+#ifndef ARROW_RESULTS_WRITER_H
+#define ARROW_RESULTS_WRITER_H
+
+#include "data_structures_opencl.h"
+
+/*
+ * Most rows in a single Arrow record batch; the results table is written as
+ * consecutive record batches of up to this many (non-NULL) rows each.
+ */
+#define ARROW_RECORD_BATCH_MAX_ROWS (1024 * 1024)
+/*
+ * Alignment (in bytes) of every column buffer within the body of a record batch;
+ * the Arrow format asks for 8, and recommends 64 for SIMD-friendly reads.
+ */
+#define ARROW_BUFFER_ALIGNMENT 64
+// Width of the fixed-size binary EAN13 barcode column; shorter barcodes are padded with zero bytes
+#define ARROW_EAN13_BYTE_WIDTH (EAN13_MAX_CHARS - 1)
+
+// Format string used to inform user where the table join result is being written to as an Arrow file.
+#define WRITING_TABLE_TO_ARROW_FILE_MSG "Currently writing results table to Arrow IPC file '%s' on disk...\n\n"
+
+/*
+ * Parameter(s):
+ * - struct Joined_Results_Table * results_table: A pointer to a table containing the equijoined results
+ *                                                of two different tables from disk.
+ * - const char * file_location: String representation of a relative or absolute filepath of the Arrow IPC
+ *                               file to which the table stored under "results_table" will be written; any
+ *                               old contents of the file WILL BE OVERWRITTEN.
+ *
+ * Writes the same rows as "write_results_table_to_csv_file" (skipping rows containing NULL values) as
+ * an Arrow IPC file with the columns "epochTimePurchased", "customerID" and "purchaseQuantity" as int64,
+ * "customerName" as utf8 and "purchaseEAN13" as fixed_size_binary[ARROW_EAN13_BYTE_WIDTH].
+ */
+void write_results_table_to_arrow_file(struct Joined_Results_Table* results_table, const char* file_location);
+
+#endif // ARROW_RESULTS_WRITER_H
@@ -0,0 +1,183 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for measuring how many bytes per second the machine can move at best (STREAM copy
+// and triad kernels over main memory, and host to device, device to host and device to device
+// copies of an OpenCL device) and for reporting how close each phase of the host program comes
+// to the peak that bounds it, with the bytes of each phase computed from the sizes of the table
+// rows in "data_structures_opencl.h" and the number of rows it worked on.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef BANDWIDTH_ROOFLINE_H
+#define BANDWIDTH_ROOFLINE_H
+
+#include <stdbool.h>
+#include "data_structures_opencl.h"
+#include "opencl_profiling.h"
+
+/*
+ * Elements (doubles) of each of the three arrays of the STREAM kernels; every array has to be
+ * several times larger than the last level cache so that it's streamed from main memory.
+ */
+#define STREAM_ARRAY_ELEMENTS (16ul * 1024ul * 1024ul)
+// Scalar of the STREAM triad kernel (a = b + scalar * c)
+#define STREAM_TRIAD_SCALAR 3.0
+// Times each kernel or transfer is run; the fastest run is its peak, as in STREAM
+#define BANDWIDTH_CALIBRATION_REPETITIONS 5
+// Bytes of the buffer copied to, from and within the OpenCL device (less if the device can't allocate it)
+#define DEVICE_TRANSFER_CALIBRATION_BYTES (64ul * 1024ul * 1024ul)
+// Maximum number of phases that can be recorded in a single report
+#define MAX_ROOFLINE_PHASES 32
+// Maximum length of the label identifying each phase recorded
+#define ROOFLINE_PHASE_LABEL_MAX_LEN 64
+// File to which the JSON version of the roofline report is written
+#define ROOFLINE_REPORT_FILE_PATH "./data/roofline_report.json"
+// Number of bytes in a gigabyte, and in a megabyte
+#define ROOFLINE_BYTES_IN_GB 1000000000.0
+#define ROOFLINE_BYTES_IN_MB 1000000.0
+
+/*
+ * Bytes a probe moves for every purchases table row probed: the purchases table row is read, the
+ * customer table row it hashes to is read, and a results table row is written.
+ */
+#define PROBE_BYTES_PER_ROW (sizeof(struct Purchases_Table_Row) + sizeof(struct Hashed_Customer_Table_Row) + \
+                               sizeof(struct Joined_Results_Table_Row))
+
+// Messages informing user of the peaks measured
+#define HOST_BANDWIDTH_CALIBRATION_MSG ">>> Main memory bandwidth (best of %u runs, %u thread(s), %lu MB arrays):"\
+                                         " copy %.2lf GB/s, triad %.2lf GB/s\n"
+#define DEVICE_BANDWIDTH_CALIBRATION_MSG ">>> OpenCL transfer bandwidth (best of %u runs, %lu MB buffer): host to"\
+                                           " device %.2lf GB/s, device to host %.2lf GB/s, device copy %.2lf GB/s\n\n"
+// Format strings for printing out the human-readable version of the roofline report
+#define ROOFLINE_REPORT_HEADER ">>> Memory bandwidth roofline report (bytes from row sizes times rows):\n"\
+                               "    %-22s %12s %10s %10s   %-14s %10s %9s\n"
+#define ROOFLINE_REPORT_ROW_FORMAT "    %-22s %12.1lf %10.4lf %10.3lf   %-14s %10.3lf %9.1lf\n"
+#define ROOFLINE_REPORT_FOOTER "    (peaks that weren't measured, and their percentages, are shown as -1)\n\n"
+#define ROOFLINE_REPORT_JSON_MSG "Currently writing roofline report to '%s' on disk...\n\n"
+
+/*
+ * Peaks measured, each the ceiling of a different kind of phase.
+ *   - host_copy --- STREAM copy (c = a) over main memory by every thread; bounds parsing and writing
+ *   - host_triad --- STREAM triad (a = b + scalar * c); bounds probing on the CPU, which also reads
+ *                    two rows for every row it writes
+ *   - host_to_device, device_to_host --- copies of a host buffer to and from the OpenCL device
+ *   - device_copy --- copy between two buffers of the OpenCL device; bounds probing on the device
+ */
+enum Bandwidth_Peak {
+    BANDWIDTH_PEAK_HOST_COPY = 0,
+    BANDWIDTH_PEAK_HOST_TRIAD,
+    BANDWIDTH_PEAK_HOST_TO_DEVICE,
+    BANDWIDTH_PEAK_DEVICE_TO_HOST,
+    BANDWIDTH_PEAK_DEVICE_COPY,
+    NUM_BANDWIDTH_PEAKS
+};
+
+/*
+ * A struct containing:
+ *    - bytes_per_sec --- bytes moved per second at best, of every peak
+ *    - is_measured --- whether each peak was measured
+ */
+struct Bandwidth_Calibration {
+    double bytes_per_sec[NUM_BANDWIDTH_PEAKS];
+    bool is_measured[NUM_BANDWIDTH_PEAKS];
+};
+
+/*
+ * A single phase of the roofline report.
+ *   - label --- what the phase did (e.g. which engine probed)
+ *   - num_bytes --- bytes the phase read and wrote, from row sizes times rows
+ *   - seconds --- how long the phase took
+ *   - peak --- the peak bounding the phase
+ */
+struct Roofline_Phase {
+    char label[ROOFLINE_PHASE_LABEL_MAX_LEN];
+    double num_bytes;
+    double seconds;
+    enum Bandwidth_Peak peak;
+};
+
+/*
+ * A struct containing:
+ *    - phases --- every phase recorded so far
+ *    - num_phases --- the number of phases recorded so far
+ */
+struct Roofline_Report {
+    struct Roofline_Phase phases[MAX_ROOFLINE_PHASES];
+    unsigned int num_phases;
+};
+
+/*
+ * Marks every peak of "calibration" as not measured.
+ */
+void init_bandwidth_calibration(struct Bandwidth_Calibration* calibration);
+
+/*
+ * Runs the STREAM copy and triad kernels over three arrays of STREAM_ARRAY_ELEMENTS doubles with
+ * "num_threads" threads (0 for one per online CPU), BANDWIDTH_CALIBRATION_REPETITIONS times each,
+ * and stores the fastest run of each in "calibration".  Copy moves 16 bytes per element and triad
+ * 24, counted as STREAM counts them.
+ */
+void measure_host_memory_bandwidth(struct Bandwidth_Calibration* calibration, unsigned int num_threads);
+
+/*
+ * Copies DEVICE_TRANSFER_CALIBRATION_BYTES from a (pageable, like every table) host buffer to a
+ * buffer of the device of "queue", back, and to a second buffer of the device,
+ * BANDWIDTH_CALIBRATION_REPETITIONS times each, and stores the fastest of each (as timed by the
+ * device; "queue" MUST have profiling enabled) in "calibration".  A device copy moves twice the
+ * bytes of the buffer, as it reads and writes all of them.
+ */
+void measure_device_transfer_bandwidth(cl_context context, cl_command_queue queue,
+                                         struct Bandwidth_Calibration* calibration);
+
+/*
+ * Empties "report" of all phases recorded.
+ */
+void reset_roofline_report(struct Roofline_Report* report);
+
+/*
+ * Parameter details:
+ *   - report --- report in which to record the phase
+ *   - label --- what the phase did
+ *   - num_bytes --- bytes the phase read and wrote
+ *   - seconds --- how long the phase took
+ *   - peak --- the peak bounding the phase
+ *
+ * Records the phase in "report"; phases that took no time at all aren't recorded.
+ */
+void record_roofline_phase(struct Roofline_Report* report, const char* label, double num_bytes, double seconds,
+                             enum Bandwidth_Peak peak);
+
+/*
+ * Records the upload, kernel and readback phases of the OpenCL commands of "profiling_report"
+ * in "report", each lasting the time its commands spent executing on the device; kernels are
+ * bounded by the device copy peak, and also read one customer table row per row probed.
+ */
+void record_opencl_roofline_phases(struct Roofline_Report* report,
+                                     const struct Opencl_Profiling_Report* profiling_report);
+
+/*
+ * Prints out to screen the bytes, time and bytes per second of every phase recorded in "report",
+ * and how many percent of the peak of "calibration" bounding it that is.
+ */
+void print_roofline_report(const struct Roofline_Report* report, const struct Bandwidth_Calibration* calibration);
+
+/*
+ * Writes the same information as "print_roofline_report", along with every peak of "calibration",
+ * as a JSON document to "file_location", unmeasured peaks as null; old contents of the file WILL
+ * BE OVERWRITTEN.
+ */
+void write_roofline_report_to_json_file(const struct Roofline_Report* report,
+                                          const struct Bandwidth_Calibration* calibration,
+                                          const char* file_location);
+
+#endif // BANDWIDTH_ROOFLINE_H
+// =================================================================================================
@@ -59,6 +59,39 @@
  * Number of fields in a Joined_Results_Table_Row struct
  */
 #define JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT 5
+/*
+ * Number of consecutive purchases table rows summarized by each zone of a zone map
+ * (see "purchases_zone_map.h"); MUST be a multiple of every ROWS_PER_WORK_ITEM used.
+ */
+#define ZONE_MAP_BLOCK_ROWS (64u * 1024u)
+/*
+ * Most queries probed together in a single pass over the purchases table (see
+ * "equijoin_batch_queries.h"); each query gets one bit of a 32-bit match mask.
+ */
+#define MAX_BATCH_QUERIES 32
+/*
+ * Largest work-group the batch kernels' local memory is sized for (see NUM_THREADS_IN_BLOCK);
+ * batch queries MUST NOT be probed with larger work-groups.
+ */
+#define MAX_BATCH_WORK_GROUP_SIZE 256
+/*
+ * Columns of a Joined_Results_Table_Row a batch query can project its joined
+ * records onto, one bit per column; columns not projected are left zeroed.
+ */
+#define PROJECT_TIME_OF_PURCHASE (1u << 0)
+#define PROJECT_CUSTOMER_ID (1u << 1)
+#define PROJECT_FIRST_NAME (1u << 2)
+#define PROJECT_EAN13 (1u << 3)
+#define PROJECT_QUANTITY_PURCHASED (1u << 4)
+#define PROJECT_ALL_COLUMNS ((1u << JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT) - 1)
+/*
+ * Slots of the hot customer table (see "equijoin_hot_customers.h"): a small open-addressing
+ * hash table of the customers most purchases belong to, copied into local memory on OpenCL
+ * devices and small enough for the L1 cache on the CPU.  At most half of the slots are used,
+ * so that every lookup ends at an empty slot.
+ */
+#define HOT_CUSTOMER_TABLE_SLOT_BITS 8
+#define HOT_CUSTOMER_TABLE_SLOTS (1u << HOT_CUSTOMER_TABLE_SLOT_BITS)
 
 
 /*
@@ -181,6 +214,45 @@ struct List_Of_Tables {
  */
 #define customer_id_to_row_index(customer_id) (customer_id - 1)
 
+/*
+ * Key of an empty slot in the hash tables used to aggregate
+ * joined results; no customer ID or EAN13 key ever equals it.
+ */
+#define EMPTY_AGGREGATION_KEY (~0ul)
+/*
+ * Hash function used to find the slot of an aggregation key in
+ * a hash table whose number of slots is a power of two; the
+ * result is masked with the number of slots minus one.
+ */
+#define aggregation_key_to_slot(key) (((key) * 0x9e3779b97f4a7c15ul) >> 24)
+/*
+ * Hash function used to find the first slot of a customer ID in the
+ * hot customer table; consecutive slots are tried from there on.
+ */
+#define hot_customer_id_to_slot(customer_id) \
+            ((unsigned int) (((customer_id) * 0x9e3779b97f4a7c15ul) >> (64 - HOT_CUSTOMER_TABLE_SLOT_BITS)))
+/*
+ * Number of bits the number of digits of an EAN13 barcode is
+ * shifted by within its aggregation key; the digits themselves
+ * (at most 13 of them) take up fewer bits than that.
+ */
+#define EAN13_KEY_DIGITS_SHIFT 48
+
+/*
+ * Converts an EAN13 barcode into the key its purchases are aggregated
+ * under: the barcode's digits as a number, with the number of digits
+ * above EAN13_KEY_DIGITS_SHIFT so that barcodes differing only in
+ * leading zeros get different keys.  Shared with the OpenCL kernels,
+ * which pass a private copy of the barcode.
+ */
+static inline unsigned long ean13_to_aggregation_key(const char ean13[EAN13_MAX_CHARS]) {
+    unsigned long key = 0, num_digits = 0;
+    for (; num_digits < EAN13_MAX_CHARS - 1 && ean13[num_digits] != '\0'; ++num_digits) {
+        key = key * 10 + (unsigned long)(ean13[num_digits] - '0');
+    }
+    return (num_digits << EAN13_KEY_DIGITS_SHIFT) | key;
+}
+
 #endif // DATA_STRUCTURES_OPENCL_H
 
 // =================================================================================================
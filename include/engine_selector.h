@@ -0,0 +1,140 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for choosing the probe engine (serial, multi-threaded CPU or OpenCL) predicted to
+// join a given pair of tables the fastest, with a cost model of each engine whose inputs (probing
+// speed of the CPU with the customer table in and out of the cache, number of CPU cores, main
+// memory bandwidth, OpenCL setup time, transfer bandwidth and probing throughput of the device)
+// are measured once by a calibration run and cached per machine in a file.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef ENGINE_SELECTOR_H
+#define ENGINE_SELECTOR_H
+
+#include <stdbool.h>
+#include "data_structures_opencl.h"
+
+// File the calibration of this machine is cached in, and file predicted and actual times are logged to
+#define ENGINE_CALIBRATION_FILE_PATH "./data/engine_calibration.txt"
+#define ENGINE_PREDICTION_LOG_FILE_PATH "./data/engine_predictions.log"
+
+/*
+ * Synthetic tables probed by the calibration run: a customer table small enough for the cache and
+ * one far larger than any last level cache, each probed by the same purchases table (a multiple
+ * of NUM_THREADS_IN_BLOCK rows, so that every probe kernel can probe it).
+ */
+#define ENGINE_CALIBRATION_CACHED_CUSTOMERS 4096ul
+#define ENGINE_CALIBRATION_DRAM_CUSTOMERS (4ul * 1024ul * 1024ul)
+#define ENGINE_CALIBRATION_PURCHASES (1024ul * 1024ul)
+// Times each calibration probe is timed; the fastest time is kept
+#define ENGINE_CALIBRATION_REPETITIONS 3
+// Seed of the customers the synthetic purchases belong to
+#define ENGINE_CALIBRATION_SEED 0x5eed5eedul
+// Last level cache size assumed when the system doesn't report it
+#define ENGINE_DEFAULT_LAST_LEVEL_CACHE_BYTES (8ul * 1024ul * 1024ul)
+// Seconds assumed to start and join each thread of the multi-threaded CPU engine
+#define ENGINE_THREAD_START_SECS 0.00005
+// Longest machine description and line of the calibration file
+#define MAX_ENGINE_MACHINE_LEN 256
+#define MAX_ENGINE_CALIBRATION_LINE_LEN 512
+
+// Messages informing user of the calibration and of the engine selected
+#define ENGINE_CALIBRATION_READ_MSG ">>> Engine cost calibration of '%s' read from '%s'\n"
+#define ENGINE_CALIBRATION_RUN_MSG ">>> Calibrating engine costs of '%s' (cached in '%s' afterwards)...\n"
+#define ENGINE_CALIBRATION_MSG ">>> Serial probe %.2lf ns/row (cached) %.2lf ns/row (main memory), %u core(s),"\
+                                 " triad %.2lf GB/s; OpenCL setup %.3lf s, upload %.2lf GB/s, readback %.2lf GB/s,"\
+                                 " kernel %.1lf Mrows/s\n"
+#define ENGINE_PREDICTION_MSG "    %-12s predicted %10.4lf seconds%s\n"
+#define ENGINE_SELECTED_MARK "  <- selected"
+#define ENGINE_PREDICTION_HEADER ">>> Predicted probing time of customer table with %lu row(s) and purchases table"\
+                                   " with %lu row(s):\n"
+#define ENGINE_ACTUAL_MSG ">>> %s probing took %.4lf seconds; predicted %.4lf seconds (%+.1lf%% off)\n\n"
+#define ENGINE_PREDICTION_LOGGED_MSG ">>> Predicted and actual time logged to '%s'\n\n"
+
+/*
+ * Engines the selector chooses from.
+ *   - serial --- "serial_hash_equijoin_probe" on a single CPU core
+ *   - cpu-threads --- "threaded_hash_equijoin_probe" with one thread per core
+ *   - opencl --- setting up the default OpenCL device, uploading the tables, probing them and
+ *                reading back the joined results
+ */
+enum Probe_Engine {
+    PROBE_ENGINE_SERIAL = 0,
+    PROBE_ENGINE_CPU_THREADS,
+    PROBE_ENGINE_OPENCL,
+    NUM_PROBE_ENGINES
+};
+
+/*
+ * Inputs of the cost model, as measured on a single machine.
+ *   - machine --- description of the machine measured (host name, online CPUs, OpenCL platform index)
+ *   - serial_cached_secs_per_row --- seconds the serial probe takes per row, customer table in the cache
+ *   - serial_dram_secs_per_row --- the same, customer table far larger than the last level cache
+ *   - last_level_cache_bytes --- size of the last level cache
+ *   - num_cpu_cores --- online CPUs, each running a thread of the multi-threaded CPU engine
+ *   - host_triad_bytes_per_sec --- main memory bandwidth (STREAM triad) of every core together
+ *   - opencl_setup_secs --- seconds to set up the OpenCL device and build the probe program
+ *   - host_to_device_bytes_per_sec, device_to_host_bytes_per_sec --- transfer bandwidth of the device
+ *   - device_rows_per_sec --- rows the probe kernel probes per second
+ */
+struct Engine_Cost_Calibration {
+    char machine[MAX_ENGINE_MACHINE_LEN];
+    double serial_cached_secs_per_row;
+    double serial_dram_secs_per_row;
+    double last_level_cache_bytes;
+    unsigned int num_cpu_cores;
+    double host_triad_bytes_per_sec;
+    double opencl_setup_secs;
+    double host_to_device_bytes_per_sec;
+    double device_to_host_bytes_per_sec;
+    double device_rows_per_sec;
+};
+
+/*
+ * Returns the name of "engine", as shown to the user and logged.
+ */
+const char* probe_engine_name(enum Probe_Engine engine);
+
+/*
+ * Stores the calibration of this machine in "calibration": read from "file_location" if it holds
+ * one of this machine (and "is_recalibration_forced" is false), or else measured by a calibration
+ * run on synthetic tables and written to "file_location" (old contents WILL BE OVERWRITTEN).
+ */
+void get_engine_cost_calibration(const char* file_location, bool is_recalibration_forced,
+                                   struct Engine_Cost_Calibration* calibration);
+
+/*
+ * Predicts into "predicted_secs" (indexed by "enum Probe_Engine") how many seconds each engine
+ * takes to probe a customer table of "num_customers" rows with "num_purchases" purchases:
+ *   - serial: num_purchases * the serial seconds per row of a customer table of its size (in or
+ *             out of the last level cache)
+ *   - cpu-threads: the serial time spread over every core, or moving PROBE_BYTES_PER_ROW bytes per
+ *                  purchase at the triad bandwidth, whichever takes longer, plus starting the threads
+ *   - opencl: setup, uploading the customer, purchases and (empty) results tables, probing at the
+ *             device's throughput, and reading back the results table
+ * Prints out every prediction, and returns the engine predicted to be the fastest.
+ */
+enum Probe_Engine predict_engine_costs(const struct Engine_Cost_Calibration* calibration,
+                                         unsigned long num_customers, unsigned long num_purchases,
+                                         double predicted_secs[NUM_PROBE_ENGINES]);
+
+/*
+ * Appends a line with the machine, table sizes, predicted time of every engine, "engine" run and
+ * the "actual_secs" it took to "file_location", so that the cost model can be refined.
+ */
+void log_engine_prediction(const char* file_location, const struct Engine_Cost_Calibration* calibration,
+                             unsigned long num_customers, unsigned long num_purchases,
+                             const double predicted_secs[NUM_PROBE_ENGINES], enum Probe_Engine engine,
+                             double actual_secs);
+
+#endif // ENGINE_SELECTOR_H
+// =================================================================================================
@@ -0,0 +1,145 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for hash equijoin probing fused with a group-by aggregation of the joined records, on
+// an OpenCL device and on the CPU.  Instead of materializing every joined record, each joined record
+// is counted and its quantity summed up under its key (customer ID or EAN13 barcode), so that only
+// one row per key is ever transferred back from the device and written to disk.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_AGGREGATION_H
+#define EQUIJOIN_AGGREGATION_H
+
+#include <stdbool.h>
+#include "equijoin_opencl.h"
+#include "opencl_profiling.h"
+#include "purchase_predicate.h"
+
+// Name of the fused probe-and-aggregate kernel function in OpenCL program file
+#define AGGREGATE_KERNEL_FUNC_NAME "aggregate_hash_equijoin_probe"
+// OpenCL extension the fused probe-and-aggregate kernel needs
+#define AGGREGATION_REQUIRED_EXTENSION "cl_khr_int64_base_atomics"
+// Most characters in the extensions string of an OpenCL device looked at
+#define MAX_DEVICE_EXTENSIONS_LEN 8192
+/*
+ * Number of slots in the hash table each CPU thread starts aggregating into; tables
+ * double in size whenever they become half full.
+ */
+#define INITIAL_CPU_AGGREGATION_SLOTS 1024
+
+// Headers of the CSV files aggregated results are written to, one per key column
+#define AGGREGATED_BY_CUSTOMER_ID_HEADER "\"customerID\",\"purchaseCount\",\"totalQuantity\"\n"
+#define AGGREGATED_BY_EAN13_HEADER "\"purchaseEAN13\",\"purchaseCount\",\"totalQuantity\"\n"
+// Format strings of rows of the CSV files aggregated results are written to, one per key column
+#define AGGREGATED_BY_CUSTOMER_ID_ROW_FORMAT "%ld,%lu,%lu\n"
+#define AGGREGATED_BY_EAN13_ROW_FORMAT "\"%0*lu\",%lu,%lu\n"
+
+// Messages informing user of aggregation progress
+#define NOTIFY_USER_DEVICE_AGGREGATION ">>> Performing parallelized hash equijoin probing fused with"\
+                                         " aggregation by %s on OpenCL device (%lu hash table slots)\n"
+#define NOTIFY_USER_CPU_AGGREGATION ">>> Performing hash equijoin probing fused with aggregation by %s"\
+                                      " on the CPU with %u thread(s)\n"
+#define AGGREGATION_UNSUPPORTED_MSG ">>> OpenCL device lacks '%s'; skipping aggregation on the device\n"
+#define WRITING_AGGREGATED_RESULTS_MSG "Currently writing %lu aggregated row(s) to '%s' on disk...\n\n"
+
+/*
+ * Column joined records are grouped by when aggregating.
+ */
+enum Aggregation_Key_Column {
+    AGGREGATION_KEY_CUSTOMER_ID = 0,
+    AGGREGATION_KEY_EAN13
+};
+
+/*
+ * Aggregate of every joined record with the same key.
+ *   - key --- customer ID, or EAN13 barcode as converted by "ean13_to_aggregation_key"
+ *   - num_purchases --- number of joined records with the key
+ *   - total_quantity --- sum of the quantities purchased of the joined records with the key
+ */
+struct Aggregated_Results_Row {
+    unsigned long key;
+    unsigned long num_purchases;
+    unsigned long total_quantity;
+};
+
+/*
+ * Aggregated results of a join, one row per key, sorted by key.
+ *   - table --- rows of the aggregated results
+ *   - num_records --- number of rows (i.e. distinct keys)
+ *   - key_column --- column the joined records were grouped by
+ */
+struct Aggregated_Results_Table {
+    struct Aggregated_Results_Row* table;
+    unsigned long num_records;
+    enum Aggregation_Key_Column key_column;
+};
+
+/*
+ * Returns whether "device" supports the fused probe-and-aggregate kernel, which
+ * needs 64-bit atomics (AGGREGATION_REQUIRED_EXTENSION).
+ */
+bool opencl_device_supports_aggregation(cl_device_id device);
+
+/*
+ * Parameter details:
+ *   - context, queue --- OpenCL context and command queue of the device to aggregate on.
+ *   - program --- program compiled from PROGRAM_FILE for "kernel_variant" (with any purchases
+ *                 predicate pushed down into it), on a device supporting aggregation.
+ *   - tables_list --- tables to join; "tables_list.results_table" isn't used, as no joined
+ *                     record is ever stored.
+ *   - is_customer_active, kernel_variant, profiling_report --- same as for
+ *                                                            "opencl_hash_equijoin_probe".
+ *   - key_column --- column to group joined records by.
+ *   - aggregated_results --- where to store the aggregated results; its "table" is allocated
+ *                            here and has to be freed by the caller.
+ *
+ * Loads the customer and purchases tables into device memory, joins them with the
+ * "aggregate_hash_equijoin_probe" kernel, compacts the occupied slots of the global hash
+ * table of aggregates on the device, and reads back only those rows, sorted by key here.
+ */
+void opencl_hash_equijoin_aggregate(cl_context* context, cl_command_queue* queue, cl_program* program,
+                                      struct List_Of_Tables tables_list, char is_customer_active,
+                                        enum Aggregation_Key_Column key_column,
+                                          const struct Probe_Kernel_Variant* kernel_variant,
+                                            struct Opencl_Profiling_Report* profiling_report,
+                                              struct Aggregated_Results_Table* aggregated_results);
+
+/*
+ * Parameter details:
+ *   - tables_list, is_customer_active, purchase_predicate --- same as for "serial_hash_equijoin_probe";
+ *                                                            "tables_list.results_table" isn't used.
+ *   - key_column, aggregated_results --- same as for "opencl_hash_equijoin_aggregate".
+ *   - num_threads --- number of threads; 0 means one thread per online CPU.
+ *
+ * Joins the customer and purchases tables on the CPU, with every thread aggregating the
+ * purchases of its own slice of the purchases table into a hash table of its own; the
+ * thread-local hash tables are merged once every thread is done, then sorted by key.
+ */
+void cpu_hash_equijoin_aggregate(struct List_Of_Tables tables_list, char is_customer_active,
+                                   const struct Purchase_Predicate* purchase_predicate,
+                                     enum Aggregation_Key_Column key_column, unsigned int num_threads,
+                                       struct Aggregated_Results_Table* aggregated_results);
+
+/*
+ * Writes "aggregated_results" to the CSV file at "file_location" (overwriting it), one row per key.
+ */
+void write_aggregated_results_to_csv_file(const struct Aggregated_Results_Table* aggregated_results,
+                                            const char* file_location);
+
+/*
+ * Returns whether both aggregated results hold the very same rows.
+ */
+bool aggregated_results_tables_equal(const struct Aggregated_Results_Table* first_aggregated_results,
+                                       const struct Aggregated_Results_Table* second_aggregated_results);
+
+#endif // EQUIJOIN_AGGREGATION_H
+// =================================================================================================
@@ -0,0 +1,107 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for probing a batch of queries over the same customer and purchases tables in a
+// single pass, on an OpenCL device and on the CPU.  Each query has its own purchases predicate,
+// customer status and projection; the purchases table is read once and each customer is looked up
+// once per purchase for the whole batch, and every joined record is routed to the compacted
+// results of each query it belongs to, in the same order as in the purchases table.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_BATCH_QUERIES_H
+#define EQUIJOIN_BATCH_QUERIES_H
+
+#include <stdbool.h>
+#include "equijoin_opencl.h"
+#include "opencl_profiling.h"
+#include "purchase_predicate.h"
+
+// Names of the kernel functions of both passes of probing a batch on an OpenCL device
+#define COUNT_BATCH_KERNEL_FUNC_NAME "count_batch_query_matches"
+#define WRITE_BATCH_KERNEL_FUNC_NAME "write_batch_query_results"
+// Rows the compacted results of each query on the CPU start out with room for; doubled when full
+#define INITIAL_CPU_BATCH_RESULT_ROWS 1024
+
+// Messages informing user of batch probing progress
+#define NOTIFY_USER_DEVICE_BATCH ">>> Performing parallelized hash equijoin probing of %u queries in a"\
+                                   " single pass on OpenCL device\n"
+#define NOTIFY_USER_CPU_BATCH ">>> Performing hash equijoin probing of %u queries in a single pass on the CPU\n"
+#define BATCH_QUERY_RESULT_MSG ">>> Query %u joined %lu row(s)\n"
+#define WRITING_BATCH_QUERY_RESULTS_MSG "Currently writing %lu row(s) of query %u to '%s' on disk...\n\n"
+
+/*
+ * One query of a batch.
+ *   - is_customer_active --- join purchases of active (CUSTOMER_ACTIVE_FLAG) or inactive
+ *                            (CUSTOMER_INACTIVE_FLAG) customers only
+ *   - predicate --- predicate purchases have to satisfy to be joined
+ *   - projection --- PROJECT_* columns of the joined records to keep
+ */
+struct Batch_Query {
+    char is_customer_active;
+    struct Purchase_Predicate predicate;
+    unsigned int projection;
+};
+
+/*
+ * Parameter details:
+ *   - context, queue --- OpenCL context and command queue of the device to probe on.
+ *   - program_cache --- cache the batch's program is compiled (once per batch of queries) into.
+ *   - tables_list --- customer and purchases tables to join; "results_table" isn't used.
+ *   - queries, num_queries --- batch of (1 to MAX_BATCH_QUERIES) queries to probe.
+ *   - kernel_variant --- variant (see "select_probe_kernel_variant") whose ROWS_PER_WORK_ITEM and
+ *                        compiler options to use; NULL for one row per work-item.
+ *   - profiling_report --- where to record how long each OpenCL command took.
+ *   - query_results --- array of "num_queries" tables in which to store the compacted results of
+ *                       each query, with only the projected columns filled in; free each with
+ *                       "free_batch_query_results".
+ *
+ * Probes every query in two passes over the purchases table: the first works out which queries
+ * join each purchase and how many rows each work-group contributes to each query, the second
+ * writes each joined record straight to its place in the compacted results, so that only rows
+ * actually joined are ever transferred back from the device.
+ */
+void opencl_batch_hash_equijoin_probe(cl_context* context, cl_command_queue* queue,
+                                        struct Predicate_Program_Cache* program_cache,
+                                          struct List_Of_Tables tables_list, const struct Batch_Query* queries,
+                                            unsigned int num_queries, const struct Probe_Kernel_Variant* kernel_variant,
+                                              struct Opencl_Profiling_Report* profiling_report,
+                                                struct Joined_Results_Table* query_results);
+
+/*
+ * Same as "opencl_batch_hash_equijoin_probe", but on the CPU in a single pass over the
+ * purchases table, and with the very same results.
+ */
+void cpu_batch_hash_equijoin_probe(struct List_Of_Tables tables_list, const struct Batch_Query* queries,
+                                     unsigned int num_queries, struct Joined_Results_Table* query_results);
+
+/*
+ * Writes the compacted results of query "query_index" (of projection "projection") to the CSV
+ * file at "file_location", with only the projected columns, in the same format as
+ * "write_results_table_to_csv_file" otherwise; any old contents WILL BE OVERWRITTEN.
+ */
+void write_batch_query_results_to_csv_file(const struct Joined_Results_Table* query_results, unsigned int query_index,
+                                             unsigned int projection, const char* file_location);
+
+/*
+ * Returns whether both compacted results hold the same rows in the same order, looking only at
+ * the columns in "projection".
+ */
+bool batch_query_results_equal(const struct Joined_Results_Table* first_query_results,
+                                 const struct Joined_Results_Table* second_query_results, unsigned int projection);
+
+/*
+ * Gives back memory used by the compacted results of a query to the system.
+ */
+void free_batch_query_results(struct Joined_Results_Table* query_results);
+
+#endif // EQUIJOIN_BATCH_QUERIES_H
+// =================================================================================================
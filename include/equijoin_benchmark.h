@@ -0,0 +1,214 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the benchmark driver of the hash equijoin engines ("make benchmark").  Every
+// engine is run with warm-up iterations and a number of measured repetitions for each combination
+// of purchases table row count, work-group size and thread count given on the command-line, and
+// the time spent in each phase (parse, build, upload, probe, readback, write) is summarized
+// with its minimum, median, 95th percentile, mean and standard deviation, both on screen and
+// as a JSON document for regression dashboards.  Medians can also be compared against (or
+// recorded in) a baseline file, as "make bench" does to catch performance regressions.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_BENCHMARK_H
+#define EQUIJOIN_BENCHMARK_H
+
+#include <stdbool.h>
+#include "equijoin_opencl.h"
+
+// Number of warm-up iterations and measured repetitions of each benchmark by default
+#define DEFAULT_BENCHMARK_WARMUP_ITERATIONS 2
+#define DEFAULT_BENCHMARK_REPETITIONS 10
+// Most measured repetitions of a benchmark, and most values of any swept parameter
+#define MAX_BENCHMARK_REPETITIONS 1000
+#define MAX_BENCHMARK_SWEEP_VALUES 32
+// Largest work-group size the kernels' local memory is sized for (see NUM_THREADS_IN_BLOCK)
+#define MAX_BENCHMARK_WORK_GROUP_SIZE 256
+// Percentile reported next to the median
+#define BENCHMARK_PERCENTILE 95.0
+/*
+ * Rows of the batches the "opencl-resident" engine streams the purchases table through a single
+ * resident session in; batches alternate between this many rows and twice as many, so the session's
+ * buffers grow once and are reused afterwards, and (as it's no multiple of NUM_THREADS_IN_BLOCK)
+ * every batch has rows left over for a second launch.
+ */
+#define BENCHMARK_RESIDENT_BATCH_ROWS 65537ul
+
+// File the JSON report of the benchmark is written to by default
+#define BENCHMARK_REPORT_FILE_PATH "./data/benchmark_report.json"
+// Files each engine's results are written to while benchmarking the write phase
+#define BENCHMARK_RESULTS_FILE_PATH "./data/benchmark_results.csv"
+#define BENCHMARK_BATCH_RESULTS_FILE_PATH_FORMAT "./data/benchmark_batch_query_%u_results.csv"
+// Where engines' progress messages go while they're being benchmarked
+#define BENCHMARK_SILENCED_OUTPUT_PATH "/dev/null"
+
+// Message informing user of the command-line options the benchmark driver accepts
+#define BENCHMARK_USAGE_MESSAGE "Usage: %s [--engines NAME,...] [--rows N,...] [--work-group-sizes N,...]"\
+                                  " [--threads N,...] [--warmup N] [--repetitions N] [--json FILE]"\
+                                  " [--customers FILE] [--purchases FILE] [--no-write] [--baseline FILE]"\
+                                  " [--dataset NAME] [--record-baseline]\n"\
+                                  "Engines: parse, serial, cpu-threads, opencl, cpu-aggregate, opencl-aggregate,"\
+                                  " cpu-batch, opencl-batch, cpu-hot, opencl-hot, opencl-resident (default: all)\n"
+#define BENCHMARK_INVALID_OPTION_MESSAGE "Invalid value '%s' for option '--%s'\n"
+
+// Messages informing user of benchmark progress and results
+#define BENCHMARK_RUN_MSG ">>> Benchmarking %-16s rows=%-10lu work-group size=%-4zu threads=%-3u"\
+                            " (%u warm-up, %u measured)\n"
+#define BENCHMARK_PHASE_HEADER "    %-9s %12s %12s %12s %12s %12s   (seconds)\n"
+#define BENCHMARK_PHASE_ROW_FORMAT "    %-9s %12.6lf %12.6lf %12.6lf %12.6lf %12.6lf\n"
+#define BENCHMARK_SKIPPED_MSG ">>> Skipping %s: %s\n"
+#define BENCHMARK_REPORT_MSG "Currently writing benchmark report to '%s' on disk...\n"
+// Message informing user the results of the resident engine differ from those of the serial engine
+#define BENCHMARK_RESIDENT_MISMATCH_MSG "Results of %lu batch(es) probed by a resident session differ from"\
+                                          " serial results\n"
+
+/*
+ * Slowdown of a phase's median over its baseline median allowed by default, both in percent and in
+ * seconds; a phase only regresses when it's slower by more than both, so that phases taking next to
+ * no time don't fail on noise.  Baseline files override them per phase with "tolerance" lines.
+ */
+#define DEFAULT_BASELINE_TOLERANCE_PERCENT 10.0
+#define DEFAULT_BASELINE_TOLERANCE_SECONDS 0.001
+// Name results are recorded under in baseline files when no "--dataset" is given
+#define DEFAULT_BENCHMARK_DATASET_NAME "default"
+// Longest dataset name, engine name and phase name of a baseline file line
+#define MAX_BASELINE_DATASET_NAME_LEN 64
+#define MAX_BASELINE_NAME_LEN 32
+// Keyword of the lines of a baseline file setting a phase's tolerances
+#define BASELINE_TOLERANCE_KEYWORD "tolerance"
+// Suffix of the file a baseline file is rewritten into before replacing it
+#define BASELINE_TEMPORARY_FILE_SUFFIX ".tmp"
+
+// Messages and format strings of the comparison against a baseline (printed to standard output)
+#define BASELINE_TABLE_HEADER "%-16s %-16s %10s %4s %7s %-8s %12s %12s %8s %12s  %s\n"
+#define BASELINE_TABLE_ROW_FORMAT "%-16s %-16s %10lu %4zu %7u %-8s %12s %12s %8s %12s  %s\n"
+#define BASELINE_INVALID_LINE_MESSAGE "Invalid line %u of baseline file '%s': %s"
+#define BASELINE_RECORDED_MSG "Recorded %u phase median(s) of dataset '%s' in baseline file '%s'\n"
+#define BASELINE_REGRESSIONS_MSG ">>> %u phase median(s) of dataset '%s' regressed against baseline file '%s'\n"
+
+/*
+ * Phases each benchmark repetition is broken down into; engines only report the phases they have.
+ *   - parse --- reading both tables from their CSV files (hashing the customer table included)
+ *   - build --- compiling the OpenCL program for the engine's kernel variant, and sampling the
+ *               purchases table for the hot customer table of the hot engines
+ *   - upload, probe, readback --- device time (from OpenCL profiling) of moving the tables to the
+ *                                 device, of the kernels, and of moving results back; wall-clock
+ *                                 time of probing for CPU engines
+ *   - write --- writing the engine's results to disk
+ */
+enum Benchmark_Phase {
+    BENCHMARK_PHASE_PARSE = 0,
+    BENCHMARK_PHASE_BUILD,
+    BENCHMARK_PHASE_UPLOAD,
+    BENCHMARK_PHASE_PROBE,
+    BENCHMARK_PHASE_READBACK,
+    BENCHMARK_PHASE_WRITE,
+    NUM_BENCHMARK_PHASES
+};
+
+/*
+ * Engines the benchmark driver can run; "parse" only measures reading the input tables, the
+ * hot engines probe with a hot customer table (see "equijoin_hot_customers.h"), and "opencl-resident"
+ * probes batches of the purchases table against a customer table kept on the device (see
+ * "equijoin_resident.h"; creating the session counts as its build phase).
+ */
+enum Benchmark_Engine {
+    BENCHMARK_ENGINE_PARSE = 0,
+    BENCHMARK_ENGINE_SERIAL,
+    BENCHMARK_ENGINE_CPU_THREADS,
+    BENCHMARK_ENGINE_OPENCL,
+    BENCHMARK_ENGINE_CPU_AGGREGATE,
+    BENCHMARK_ENGINE_OPENCL_AGGREGATE,
+    BENCHMARK_ENGINE_CPU_BATCH,
+    BENCHMARK_ENGINE_OPENCL_BATCH,
+    BENCHMARK_ENGINE_CPU_HOT,
+    BENCHMARK_ENGINE_OPENCL_HOT,
+    BENCHMARK_ENGINE_OPENCL_RESIDENT,
+    NUM_BENCHMARK_ENGINES
+};
+
+/*
+ * One combination of engine and swept parameters to benchmark.
+ *   - engine --- engine run
+ *   - num_rows --- number of purchases table rows probed
+ *   - work_group_size --- work-items per work-group for OpenCL engines; 0 for CPU engines
+ *   - num_threads --- threads for multi-threaded CPU engines (and for writing results); 0 otherwise
+ */
+struct Benchmark_Config {
+    enum Benchmark_Engine engine;
+    unsigned long num_rows;
+    size_t work_group_size;
+    unsigned int num_threads;
+};
+
+/*
+ * Summary of the time spent in one phase over every measured repetition, in seconds.
+ */
+struct Benchmark_Phase_Stats {
+    double min;
+    double median;
+    double percentile;
+    double mean;
+    double stddev;
+};
+
+/*
+ * Measured repetitions of one benchmark.
+ *   - config --- what was benchmarked
+ *   - is_phase_measured --- whether the engine has each phase at all
+ *   - stats --- summary of each phase measured
+ *   - num_repetitions --- number of measured repetitions summarized
+ */
+struct Benchmark_Result {
+    struct Benchmark_Config config;
+    bool is_phase_measured[NUM_BENCHMARK_PHASES];
+    struct Benchmark_Phase_Stats stats[NUM_BENCHMARK_PHASES];
+    unsigned int num_repetitions;
+};
+
+/*
+ * Median of one phase of one benchmark, as recorded in a baseline file.
+ *   - config --- what was benchmarked
+ *   - phase --- phase whose median it is
+ *   - median --- median seconds spent in the phase
+ *   - is_compared --- whether a benchmark result has been compared against it yet
+ */
+struct Benchmark_Baseline_Entry {
+    struct Benchmark_Config config;
+    enum Benchmark_Phase phase;
+    double median;
+    bool is_compared;
+};
+
+/*
+ * Everything a baseline file holds for one dataset.
+ *   - tolerance_percent, tolerance_seconds --- slowdown allowed for each phase (see
+ *                                              DEFAULT_BASELINE_TOLERANCE_PERCENT)
+ *   - entries --- baseline median of every phase of every benchmark of the dataset
+ *   - num_entries --- number of entries
+ */
+struct Benchmark_Baseline {
+    double tolerance_percent[NUM_BENCHMARK_PHASES];
+    double tolerance_seconds[NUM_BENCHMARK_PHASES];
+    struct Benchmark_Baseline_Entry* entries;
+    unsigned int num_entries;
+};
+
+/*
+ * Stores in "stats" the summary of "num_samples" (at least 1) samples; "samples" is sorted
+ * in place.  The percentile is the nearest-rank BENCHMARK_PERCENTILE percentile, and the standard
+ * deviation is the sample standard deviation (0 for a single sample).
+ */
+void summarize_benchmark_samples(double* samples, unsigned int num_samples, struct Benchmark_Phase_Stats* stats);
+
+#endif // EQUIJOIN_BENCHMARK_H
+// =================================================================================================
@@ -0,0 +1,124 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the native generator of customer and purchases tables ("make generator"), a
+// faster and reproducible replacement of "generate_custom_data.py".  Tables are written by several
+// threads, either as CSV files of the same schema as the Python script's or straight in the binary
+// format (see TABLE_BINARY_FILE_EXTENSION in "table_utilities.h").  Every random value is derived
+// from the seed, the row it belongs to and which value of the row it is by a counter-based random
+// number generator, so that the same seed gives the very same tables with any number of threads.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_DATA_GENERATOR_H
+#define EQUIJOIN_DATA_GENERATOR_H
+
+#include <stdbool.h>
+
+// Defaults of the options of the generator
+#define DEFAULT_GENERATOR_SEED 1
+#define DEFAULT_GENERATOR_ACTIVE_RATIO 0.5
+#define DEFAULT_GENERATOR_ZIPF_EXPONENT 1.0
+// First "epochTimePurchased" timestamp, in Epoch nanoseconds, unless given on the command-line
+#define DEFAULT_GENERATOR_START_TIME 1623447438954609116ul
+// Files tables are written to by default, depending on the format written
+#define GENERATOR_CUSTOMER_CSV_FILE_PATH "./data/custom_customer_data.csv"
+#define GENERATOR_PURCHASES_CSV_FILE_PATH "./data/custom_purchases_data.csv"
+#define GENERATOR_CUSTOMER_BINARY_FILE_PATH "./data/custom_customer_data.bin"
+#define GENERATOR_PURCHASES_BINARY_FILE_PATH "./data/custom_purchases_data.bin"
+
+// Same bounds as "generate_custom_data.py": nanoseconds between consecutive purchases and quantity
+#define GENERATOR_MIN_NS_GAP 1
+#define GENERATOR_MAX_NS_GAP 2000
+#define GENERATOR_MIN_QUANTITY 1
+#define GENERATOR_MAX_QUANTITY 9999
+// Digits of an EAN13 barcode before its check digit
+#define GENERATOR_EAN13_DATA_DIGITS 12
+
+// Rows each thread generates at a time; tables are written chunk by chunk, in order
+#define GENERATOR_CHUNK_ROWS (64ul * 1024ul)
+// Most bytes a single generated row takes up in either format
+#define GENERATOR_MAX_ROW_LEN 128
+
+// Message informing user of the command-line options the generator accepts
+#define GENERATOR_USAGE_MESSAGE "Usage: %s --customers N --purchases N [--active-ratio R] [--distribution"\
+                                  " uniform|zipf] [--zipf-exponent S] [--seed N] [--start-time NS]"\
+                                  " [--threads N] [--format csv|binary] [--customer-file FILE]"\
+                                  " [--purchases-file FILE]\n"
+#define GENERATOR_INVALID_OPTION_MESSAGE "Invalid value '%s' for option '--%s'\n"
+// Messages informing user of the generator's progress
+#define GENERATING_TABLE_MSG "Generating %lu row(s) of the %s table into '%s' with %u thread(s)...\n"
+#define GENERATED_TABLE_MSG "%s table has been written to '%s' in %.3lf seconds.\n\n"
+
+/*
+ * Distribution customer IDs of purchases are drawn from.
+ *   - uniform --- every customer equally likely, as "generate_custom_data.py" does
+ *   - zipf --- customer ID k drawn with probability proportional to 1 / k^s, so that low
+ *              customer IDs are hot
+ */
+enum Customer_Id_Distribution {
+    CUSTOMER_ID_DISTRIBUTION_UNIFORM = 0,
+    CUSTOMER_ID_DISTRIBUTION_ZIPF
+};
+
+/*
+ * Random values drawn for each row of either table; the index of each value is the counter of
+ * the random number generator's stream of the row.  Drawing customer IDs from a Zipfian
+ * distribution may take more than one attempt, each drawing the next value from
+ * PURCHASE_DRAW_CUSTOMER_ID onwards.
+ */
+enum Customer_Row_Draw {
+    CUSTOMER_DRAW_FIRST_NAME = 0,
+    CUSTOMER_DRAW_ACTIVE
+};
+enum Purchase_Row_Draw {
+    PURCHASE_DRAW_NS_GAP = 0,
+    PURCHASE_DRAW_EAN13,
+    PURCHASE_DRAW_QUANTITY,
+    PURCHASE_DRAW_CUSTOMER_ID
+};
+// Streams of purchases table rows are told apart from those of customer table rows by this bit
+#define PURCHASES_TABLE_STREAM_BIT (1ul << 63)
+
+/*
+ * Precomputed constants of drawing from a Zipfian distribution over 1 to "num_elements" with
+ * exponent "exponent" by rejection-inversion (Hormann and Derflinger), which takes constant time
+ * and memory however many customers there are.
+ */
+struct Zipf_Sampler {
+    unsigned long num_elements;
+    double exponent;
+    double h_integral_x1;
+    double h_integral_num_elements;
+    double s;
+};
+
+/*
+ * Returns 64 random bits that only depend on "seed", "stream" and "counter": the "counter"-th
+ * value of stream "stream".
+ */
+unsigned long generator_random_bits(unsigned long seed, unsigned long stream, unsigned long counter);
+
+/*
+ * Sets up "sampler" for drawing from 1 to "num_elements" (at least 1) with exponent "exponent"
+ * (more than 0).
+ */
+void init_zipf_sampler(struct Zipf_Sampler* sampler, unsigned long num_elements, double exponent);
+
+/*
+ * Returns a number drawn from the distribution of "sampler", using values "first_counter" onwards
+ * of stream "stream" of the generator seeded with "seed".
+ */
+unsigned long sample_zipf(const struct Zipf_Sampler* sampler, unsigned long seed, unsigned long stream,
+                            unsigned long first_counter);
+
+#endif // EQUIJOIN_DATA_GENERATOR_H
+// =================================================================================================
@@ -16,34 +16,167 @@
 #define EQUIJOIN_GPU_VS_CPU_H 
 
 #include "equijoin_opencl.h"
+#include "opencl_environment.h"
+#include "purchase_predicate.h"
 
-// Number of OpenCL platforms on host machine
-#define NUM_CL_PLATFORMS 2
 /*
- * Index of desired OpenCL platform (e.g. Portable Computing
- *    Language, AMD Accelerated Parallel Processing) in
- *    list of platforms returned.
+ * Whether to split parallelized hash equijoin probing across every OpenCL device on every
+ * OpenCL platform (1), with CPU devices partitioned into sub-devices, instead of probing on
+ * the single default device of the platform at DESIRED_PLATFORM_INDEX (0).
  */
-#define DESIRED_PLATFORM_INDEX 0
-// Number of OpenCL devices per OpenCL platform
-#define NUM_CL_DEVICES 1
-// Number of OpenCL programs to be loaded
-#define OPENCL_PROGS 1
-// OpenCL device name max length
-#define MAX_LEN 1024
-// Delimiter for reading non-csv text files
-#define TEXT_FILE_DELIM '\0'
+#define MULTI_DEVICE_MODE 0
 
-// Number of nanoseconds in a second
-#define NANOSECS_IN_SEC 1000000000.0
+/*
+ * Whether to read back the joined results of single-device probing in chunks which are written
+ * to disk as they arrive (1), instead of writing the results only once all of them have been
+ * read back (0).  Probing time reported then includes writing the results to disk.
+ */
+#define STREAM_RESULTS_READBACK 1
+
+/*
+ * Number of threads writing each joined results table to disk once probing is done (0 for one
+ * thread per online CPU, 1 for writing the whole table from a single thread).
+ */
+#define RESULTS_WRITER_THREADS 0
+
+/*
+ * Whether to also write the joined results of parallelized probing to PARALLEL_RESULTS_ARROW_FILE_PATH
+ * as an Arrow IPC file with typed columns (1) or not (0).
+ */
+#define WRITE_ARROW_RESULTS 1
+
+/*
+ * Whether to verify the results of each engine in memory by comparing digests of their
+ * results tables with each other and with a cached digest of the known correct result (1),
+ * instead of comparing the results files written to disk (0).  Digests depend on the order of
+ * rows, so results files are compared regardless when VERIFY_RESULTS_IN_ANY_ORDER is 1.
+ */
+#define VERIFY_RESULTS_BY_DIGEST 1
+
+/*
+ * Whether results tables only have to hold the same rows as the table they're checked against
+ * in any order (1), e.g. when trying out engines emitting rows out of order, instead of holding
+ * them in the same order (0).
+ */
+#define VERIFY_RESULTS_IN_ANY_ORDER 0
+
+/*
+ * Whether to only probe the rows of the purchases table inside the time window given by
+ * "--from-time" and "--to-time" (1), found by binary search when the purchases table is sorted
+ * by time of purchase, instead of scanning every row of the purchases table (0).
+ */
+#define NARROW_PROBE_TO_TIME_WINDOW 1
+
+/*
+ * Whether to only probe the blocks of ZONE_MAP_BLOCK_ROWS purchases table rows which the zone
+ * map of the purchases table (persisted at PURCHASES_ZONE_MAP_FILE_PATH) can't rule out for the
+ * purchases predicate (1), instead of probing every block (0).
+ */
+#define SKIP_BLOCKS_BY_ZONE_MAP 1
+
+/*
+ * Number of queries "--batch" probes together: joined records of active customers, of inactive
+ * customers, and of active customers projected onto their customer ID and quantity purchased,
+ * each of purchases satisfying the purchases predicate given on the command-line.
+ */
+#define NUM_DEMO_BATCH_QUERIES 3
+
+/*
+ * Number of threads aggregating joined records on the CPU when run with "--aggregate-by"
+ * (0 for one thread per online CPU).
+ */
+#define AGGREGATION_CPU_THREADS 0
+
+/*
+ * Whether to print out (and write as JSON to OPENCL_PROFILING_REPORT_FILE_PATH) a
+ * per-phase breakdown of every OpenCL command enqueued for probing (1) or not (0).
+ */
+#define PRINT_OPENCL_PROFILING_REPORT 1
+
+/*
+ * Whether to count hardware events (cycles, instructions, cache, TLB and branch misses) of
+ * reading the tables, building, each probe engine and writing results, and print them out
+ * (and write them as JSON to HARDWARE_COUNTERS_REPORT_FILE_PATH) (1) or not (0).  OpenCL
+ * phases only count what the host does; counters that aren't allowed are left out.
+ */
+#define COUNT_HARDWARE_EVENTS 1
+
+/*
+ * Number of partitions joined at once when run with "--memory-budget" (0 for one per online
+ * CPU); the budget is shared by all of them.
+ */
+#define GRACE_JOIN_THREADS 0
+// Number of bytes in each megabyte of "--memory-budget"
+#define MEMORY_BUDGET_BYTES_IN_MB (1024ul * 1024ul)
+
+/*
+ * Number of threads running the STREAM kernels measuring peak main memory bandwidth when run
+ * with "--roofline" (0 for one thread per online CPU).
+ */
+#define ROOFLINE_CALIBRATION_THREADS 0
+
+/*
+ * Message informing user of the command-line options this program accepts; every option
+ * adds a term to the predicate purchases have to satisfy to be joined.  Time window bounds
+ * are in nanoseconds since Jan 1 1970, and the window includes its start but not its end.
+ */
+#define USAGE_MESSAGE "Usage: %s [--min-quantity N] [--max-quantity N] [--from-time NS]"\
+                                  " [--to-time NS] [--ean13-prefix DIGITS] [--aggregate-by customer|ean13]"\
+                                  " [--batch] [--hot-customers] [--memory-budget MB] [--trace FILE]"\
+                                  " [--roofline] [--select-engine [--recalibrate] [--log-predictions]]\n"
+// Values of "--aggregate-by" choosing the column joined records are grouped by
+#define AGGREGATE_BY_CUSTOMER_ID_VALUE "customer"
+#define AGGREGATE_BY_EAN13_VALUE "ean13"
+// Message informing user a command-line option value couldn't be understood
+#define INVALID_OPTION_VALUE_MESSAGE "Invalid value '%s' for option '--%s'\n"
 
 // Messages to user informing time took to perform different joins and size of tables joined
 #define EQUIJOIN_PARALLEL_MESSAGE "Parallelized hash equijoin probing of hashed customer"\
                                    " table with %ld row(s) and purchases table with"\
                                    " %ld row(s) on OpenCL device took %lf seconds\n\n"
+#define EQUIJOIN_PARALLEL_STREAMED_MESSAGE "Parallelized hash equijoin probing of hashed customer"\
+                                   " table with %ld row(s) and purchases table with"\
+                                   " %ld row(s) on OpenCL device, including writing results"\
+                                   " to disk, took %lf seconds\n\n"
+#define EQUIJOIN_AGGREGATE_DEVICE_MESSAGE "Parallelized hash equijoin probing and aggregation of hashed"\
+                                   " customer table with %ld row(s) and purchases table with %ld row(s)"\
+                                   " into %lu row(s) on OpenCL device took %lf seconds\n\n"
+#define EQUIJOIN_AGGREGATE_CPU_MESSAGE "Hash equijoin probing and aggregation of hashed customer table"\
+                                   " with %ld row(s) and purchases table with %ld row(s) into %lu row(s)"\
+                                   " on the CPU took %lf seconds\n\n"
+#define EQUIJOIN_BATCH_DEVICE_MESSAGE "Parallelized hash equijoin probing of %u queries over hashed"\
+                                   " customer table with %ld row(s) and purchases table with %ld row(s)"\
+                                   " in a single pass on OpenCL device took %lf seconds\n\n"
+#define EQUIJOIN_BATCH_CPU_MESSAGE "Hash equijoin probing of %u queries over hashed customer table"\
+                                   " with %ld row(s) and purchases table with %ld row(s) in a single"\
+                                   " pass on the CPU took %lf seconds\n\n"
 #define EQUIJOIN_SERIAL_MESSAGE "Serial hash equijoin probing of hashed customer"\
                                    " table with %ld row(s) and purchases table with"\
                                    " %ld row(s) in main memory took %lf seconds\n\n"
+#define EQUIJOIN_GRACE_MESSAGE "Out-of-core hash equijoin of the tables at '%s' and '%s' within a memory"\
+                                 " budget of %lu MB took %lf seconds\n\n"
+
+/*
+ * Message informing user the known correct result can't be used for verification, as it
+ * was generated without the purchases predicate given on the command-line.
+ */
+#define CHECK_PREDICATE_RESULTS_MESSAGE ">>> Purchases predicate given; verifying OpenCL results against"\
+                                                     " serial results instead of '%s'.\n"
+
+// What the digest of each engine's results table is described as to the user
+#define PARALLEL_RESULTS_DIGEST_DESCRIPTION "OpenCL results"
+#define SERIAL_RESULTS_DIGEST_DESCRIPTION "serial results"
+#define REF_RESULTS_DIGEST_DESCRIPTION "known correct result"
+
+// Messages informing user whether the aggregated results of the OpenCL device and the CPU agree
+#define AGGREGATED_RESULTS_MATCH_MSG "Congratulations, aggregated results of the OpenCL device and the CPU"\
+                                        " are identical!\n\n"
+#define AGGREGATED_RESULTS_MISMATCH_MSG "Aggregated results at '%s' differ from aggregated results at '%s'\n"
+
+// Messages informing user whether the batch query results of the OpenCL device and the CPU agree
+#define BATCH_RESULTS_MATCH_MSG "Congratulations, results of every query of the batch on the OpenCL device"\
+                                  " and the CPU are identical!\n\n"
+#define BATCH_RESULTS_MISMATCH_MSG "Results of batch query %u at '%s' differ from results at '%s'\n"
 
 /*
  * Message informing user which table is being checked for correctness and which table
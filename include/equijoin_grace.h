@@ -0,0 +1,104 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the out-of-core (Grace) hash equijoin, for tables too large for memory: while
+// being read, both tables are partitioned by customer ID into spill files on disk, and each pair
+// of partitions (customers and purchases of the same customer IDs) is then joined in memory with
+// the serial probe engine, several pairs at a time, without using more memory than a budget.
+// Joined records are written to a CSV file in the order of the purchases table, like every other
+// engine's results.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_GRACE_H
+#define EQUIJOIN_GRACE_H
+
+#include "data_structures_opencl.h"
+#include "purchase_predicate.h"
+
+/*
+ * Most partitions tables are split into; every partition's spill file is open at once while
+ * tables are partitioned, and while joined records are put back in order.
+ */
+#define MAX_GRACE_PARTITIONS 512
+/*
+ * Share (in percent) of each thread's part of the memory budget its partition of the customer
+ * table may take up; the rest holds the purchases and joined records it probes at a time.
+ */
+#define GRACE_CUSTOMER_BUDGET_PERCENT 50
+/*
+ * Share (in percent) of the memory budget the buffers of every spill file open at once may take up
+ * together, and largest and smallest size of the buffer of each spill file being read or written;
+ * buffers shrink from the largest size as the number of partitions grows, to stay within that share.
+ */
+#define GRACE_SPILL_BUDGET_PERCENT 10
+#define GRACE_SPILL_BUFFER_SIZE (64 * 1024)
+#define MIN_GRACE_SPILL_BUFFER_SIZE (4 * 1024)
+// Most spill files each thread joining partitions has open at once (its purchases and results files)
+#define GRACE_WORKER_SPILL_FILES 2
+// Joined records put back in order before being written to the results CSV file at once
+#define GRACE_MERGE_BATCH_ROWS 4096
+// Spill files are written into a new directory named after this template ("mkdtemp")
+#define GRACE_SPILL_DIRECTORY_TEMPLATE "./data/grace_spill_XXXXXX"
+// Names of the spill files within the spill directory; partition files are numbered by partition
+#define GRACE_CUSTOMER_SPILL_FILE_FORMAT "%s/customers_%u.bin"
+#define GRACE_PURCHASES_SPILL_FILE_FORMAT "%s/purchases_%u.bin"
+#define GRACE_RESULTS_SPILL_FILE_FORMAT "%s/results_%u.bin"
+#define GRACE_PARTITION_MAP_FILE_FORMAT "%s/partition_map.bin"
+// Message informing user that a spill file's location would be longer than PATH_MAX
+#define GRACE_SPILL_LOCATION_TOO_LONG_MSG "Spill directory '%s' is too long to hold spill files.\n"
+
+/*
+ * Hashes customer ID "customer_id" (1 or more) to one of "num_partitions" partitions, and to the
+ * customer ID it has within its partition; every partition is a hashed customer table of its
+ * own, in which customer IDs (num_partitions * k) + p + 1 of partition p get customer ID k + 1.
+ */
+#define customer_id_to_grace_partition(customer_id, num_partitions) \
+            ((unsigned int) (((customer_id) - 1) % (num_partitions)))
+#define customer_id_to_grace_local_id(customer_id, num_partitions) \
+            ((((customer_id) - 1) / (num_partitions)) + 1)
+#define grace_local_id_to_customer_id(local_id, partition, num_partitions) \
+            ((((local_id) - 1) * (num_partitions)) + (partition) + 1)
+
+// Messages informing user of the progress of the out-of-core hash equijoin
+#define GRACE_PLAN_MSG ">>> Joining out of core with a memory budget of %lu MB: %u partition(s),"\
+                         " %u thread(s), %lu purchase(s) probed at a time per thread\n"
+#define GRACE_PARTITIONED_MSG ">>> Partitioned %lu customer(s) and %lu purchase(s) into '%s' in %.3lf seconds\n"
+#define GRACE_JOINED_MSG ">>> Joined every partition in %.3lf seconds\n"
+#define GRACE_MERGED_MSG ">>> Wrote %lu joined record(s) in purchases table order in %.3lf seconds\n\n"
+#define GRACE_BUDGET_TOO_SMALL_MSG "A memory budget of %lu MB is too small for %lu customer(s) with %u"\
+                                     " thread(s); at least %u partitions would be needed\n"
+
+/*
+ * Parameter details:
+ *   - customer_table_file_location, purchases_table_file_location --- tables to join, either CSV
+ *                                   or binary files (see "read_hashed_customer_table_from_file");
+ *                                   every customer ID of either table MUST be 1 or more.
+ *   - results_file_location --- CSV file joined records are written to, exactly as
+ *                               "write_results_table_to_csv_file" would write them; old contents
+ *                               WILL BE OVERWRITTEN.
+ *   - is_customer_active, purchase_predicate --- same as for "serial_hash_equijoin_probe".
+ *   - memory_budget_bytes --- most bytes of tables, joined records and spill file buffers held in
+ *                             memory at once.
+ *   - num_threads --- number of partitions joined at once; 0 for one per online CPU.
+ *
+ * Reads the customer table once to count its rows and once to partition it, reads the purchases
+ * table once to partition it (remembering which partition each purchase went to), joins every
+ * partition, and merges the joined records of every partition back into purchases table order.
+ * Spill files are deleted once they're no longer needed.
+ */
+void grace_hash_equijoin_to_csv(const char* customer_table_file_location, const char* purchases_table_file_location,
+                                  const char* results_file_location, const char is_customer_active,
+                                  const struct Purchase_Predicate* purchase_predicate,
+                                  unsigned long memory_budget_bytes, unsigned int num_threads);
+
+#endif // EQUIJOIN_GRACE_H
+// =================================================================================================
@@ -0,0 +1,90 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for skew-aware probing, for purchases most of which belong to a few hot customers
+// (e.g. customer IDs drawn from a Zipfian distribution).  A sample of the purchases table tells
+// which customers are hot; their rows are copied into a hot customer table of
+// HOT_CUSTOMER_TABLE_SLOTS slots, which OpenCL devices keep in local memory and the CPU keeps in
+// its L1 cache, and probing looks every customer up there before the hashed customer table.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_HOT_CUSTOMERS_H
+#define EQUIJOIN_HOT_CUSTOMERS_H
+
+#include <stdbool.h>
+#include "data_structures_opencl.h"
+#include "purchase_predicate.h"
+
+// Number of purchases table rows sampled to find hot customers (all of them in smaller tables)
+#define HOT_CUSTOMER_SAMPLE_ROWS (64ul * 1024ul)
+// Most customers the hot customer table holds; half of its slots, so that lookups stay short
+#define MAX_HOT_CUSTOMERS (HOT_CUSTOMER_TABLE_SLOTS / 2)
+/*
+ * A customer is hot if it made at least HOT_CUSTOMER_MIN_SAMPLED_PURCHASES of the sampled
+ * purchases, and at least HOT_CUSTOMER_MIN_SKEW times as many as it would if purchases were
+ * spread evenly over every customer; uniformly distributed purchases have no hot customers.
+ */
+#define HOT_CUSTOMER_MIN_SAMPLED_PURCHASES 8
+#define HOT_CUSTOMER_MIN_SKEW 4.0
+
+// Messages informing user of the hot customers found and of skew-aware probing
+#define HOT_CUSTOMERS_FOUND_MSG ">>> Found %u hot customer(s) making %.1lf%% of %lu sampled purchases\n"
+#define NOTIFY_USER_HOT_CACHED_HASH_JOIN_OP ">>> Performing hash equijoin probing with a hot customer"\
+                                              " table of %u customer(s) in main memory\n"
+
+/*
+ * Customers most purchases belong to, found by sampling the purchases table.
+ *   - slots --- rows of the hot customers, each at the first slot from "hot_customer_id_to_slot"
+ *               on which was free; empty slots are NULL rows (of NULL_CUSTOMER_ID)
+ *   - num_hot_customers --- number of slots used
+ *   - num_sampled_purchases --- number of purchases table rows sampled
+ *   - num_sampled_hot_purchases --- number of sampled purchases of hot customers
+ */
+struct Hot_Customer_Table {
+    struct Hashed_Customer_Table_Row slots[HOT_CUSTOMER_TABLE_SLOTS];
+    unsigned int num_hot_customers;
+    unsigned long num_sampled_purchases;
+    unsigned long num_sampled_hot_purchases;
+};
+
+/*
+ * Parameter details:
+ *   - hashed_customer_table --- customer table the hot customers' rows are copied from.
+ *   - purchases_table --- purchases table to sample; at least one row.
+ *   - hot_customer_table --- where to store the (at most MAX_HOT_CUSTOMERS) hottest customers
+ *                            of those making enough of the sampled purchases; none at all for
+ *                            uniformly distributed purchases.
+ *
+ * Samples HOT_CUSTOMER_SAMPLE_ROWS rows spread over the whole purchases table, one from each
+ * stretch of (nearly) equally many rows at a pseudo-random (but reproducible) row of the stretch, and
+ * counts the purchases of each customer sampled.
+ */
+void build_hot_customer_table(const struct Hashed_Customer_Table* hashed_customer_table,
+                                const struct Purchases_Table* purchases_table,
+                                  struct Hot_Customer_Table* hot_customer_table);
+
+/*
+ * Returns the slot of customer "customer_id" in "hot_customer_table", or -1 if the customer isn't
+ * hot; same as the "find_hot_customer_slot" function of the OpenCL kernels.
+ */
+int find_hot_customer_slot(const struct Hot_Customer_Table* hot_customer_table, unsigned long customer_id);
+
+/*
+ * Same as "serial_hash_equijoin_probe" (without a block selection), with the very same results,
+ * but looking every customer up in "hot_customer_table" before the hashed customer table.
+ */
+void hot_cached_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                      const struct Purchase_Predicate* purchase_predicate,
+                                        const struct Hot_Customer_Table* hot_customer_table);
+
+#endif // EQUIJOIN_HOT_CUSTOMERS_H
+// =================================================================================================
@@ -0,0 +1,86 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the component microbenchmarks ("make microbenchmark"): the CSV row parsers, the
+// customer table hashing, the serial probe engine (with customer tables sized to fit in each
+// level of the cache hierarchy, and beyond) and the results CSV formatter are each timed on their
+// own, on synthetic tables generated in memory, with the CPU's cycle counter.  Each is reported in
+// cycles and nanoseconds per row, and in bytes processed per cycle.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_MICROBENCHMARK_H
+#define EQUIJOIN_MICROBENCHMARK_H
+
+#include <stdint.h>
+
+// Rows each component works on in every repetition, and number of repetitions, by default
+#define DEFAULT_MICROBENCHMARK_ROWS 1000000ul
+#define DEFAULT_MICROBENCHMARK_REPETITIONS 5
+// Most repetitions, and most customer table sizes the probe is timed with
+#define MAX_MICROBENCHMARK_REPETITIONS 1000
+#define MAX_MICROBENCHMARK_CUSTOMER_SIZES 16
+// Seed of every synthetic value, so that every run times the very same tables
+#define MICROBENCHMARK_SEED 0x5eed5eedul
+
+/*
+ * Cache sizes assumed when the system doesn't report them; customer tables for the probe are
+ * sized to half of each cache level, and to MICROBENCHMARK_DRAM_FACTOR times the last level
+ * (but at least MICROBENCHMARK_MIN_DRAM_BYTES) so they only fit in main memory.
+ */
+#define MICROBENCHMARK_DEFAULT_L1D_BYTES (32ul * 1024ul)
+#define MICROBENCHMARK_DEFAULT_L2_BYTES (1024ul * 1024ul)
+#define MICROBENCHMARK_DEFAULT_L3_BYTES (16ul * 1024ul * 1024ul)
+#define MICROBENCHMARK_DRAM_FACTOR 8
+#define MICROBENCHMARK_MIN_DRAM_BYTES (256ul * 1024ul * 1024ul)
+
+// How long the cycle counter is compared against the monotonic clock to find its frequency
+#define MICROBENCHMARK_CALIBRATION_NANOSECS 100000000ul
+// Nanoseconds in a second
+#define MICROBENCHMARK_NANOSECS_IN_SEC 1000000000.0
+
+// Longest synthetic CSV line of either table, newline and null character included
+#define MICROBENCHMARK_MAX_CSV_LINE_LEN 96
+
+// Message informing user of the command-line options the microbenchmark accepts
+#define MICROBENCHMARK_USAGE_MESSAGE "Usage: %s [--rows N] [--repetitions N] [--customer-rows N,...]\n"
+#define MICROBENCHMARK_INVALID_OPTION_MESSAGE "Invalid value '%s' for option '--%s'\n"
+
+// Messages and format strings of the microbenchmark report
+#define MICROBENCHMARK_CLOCK_MSG ">>> Cycle counter: %s at %.3lf GHz; %lu row(s) per repetition, %u repetition(s)"\
+                                   " (median and minimum shown)\n\n"
+#define MICROBENCHMARK_HEADER "%-28s %-5s %12s %12s %12s %12s %10s %11s\n"
+#define MICROBENCHMARK_ROW_FORMAT "%-28s %-5s %12s %12.2lf %12.3lf %12.3lf %10.1lf %11.3lf\n"
+
+/*
+ * Timing of one component, over every repetition.
+ *   - cycles_per_row, nanosecs_per_row --- median over repetitions
+ *   - min_nanosecs_per_row --- fastest repetition
+ *   - bytes_per_row --- bytes each row takes up in what the component reads and writes
+ *   - bytes_per_cycle --- "bytes_per_row" over the median cycles per row
+ */
+struct Microbenchmark_Result {
+    double cycles_per_row;
+    double nanosecs_per_row;
+    double min_nanosecs_per_row;
+    double bytes_per_row;
+    double bytes_per_cycle;
+};
+
+/*
+ * Reads the CPU's cycle counter (the time stamp counter on x86, which ticks at a constant rate
+ * whatever the clock speed of the core; the monotonic clock in nanoseconds elsewhere), with
+ * earlier instructions finished before it's read and later ones not started.
+ */
+uint64_t read_cycle_counter(void);
+
+#endif // EQUIJOIN_MICROBENCHMARK_H
+// =================================================================================================
@@ -0,0 +1,126 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the heterogeneous multi-device OpenCL hash equijoin probe.  Every OpenCL device
+// available across all platforms (with CPU devices partitioned into sub-devices) receives its own
+// copy of the hashed customer table and a contiguous range of the purchases table, sized in
+// proportion to how fast the device finished a short calibration probe.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_MULTI_DEVICE_H
+#define EQUIJOIN_MULTI_DEVICE_H
+
+#include <pthread.h>
+#include "equijoin_opencl.h"
+#include "opencl_environment.h"
+#include "opencl_profiling.h"
+#include "purchase_predicate.h"
+
+// Maximum number of OpenCL platforms queried when enumerating every device
+#define MAX_MULTI_DEVICE_PLATFORMS 16
+// Maximum number of OpenCL devices (including sub-devices) used for the probe
+#define MAX_MULTI_DEVICES 64
+/*
+ * Number of compute units given to each sub-device when partitioning a CPU
+ * device with CL_DEVICE_PARTITION_EQUALLY; a CPU device which has no more than
+ * this many compute units is used as a whole instead.
+ */
+#define CPU_SUB_DEVICE_COMPUTE_UNITS 2
+/*
+ * Number of purchases table rows each device probes during calibration;
+ * MUST be a multiple of NUM_THREADS_IN_BLOCK.
+ */
+#define CALIBRATION_PURCHASES_ROWS (NUM_THREADS_IN_BLOCK * 200)
+
+// Messages informing user of the devices found and of the work ratio given to each device
+#define MULTI_DEVICE_FOUND_MSG ">>> Using OpenCL device #%u: %s\n"
+#define MULTI_DEVICE_CALIBRATION_MSG ">>> Calibration probe on OpenCL device #%u (%s) ran at %.0lf rows/second\n"
+#define MULTI_DEVICE_SPLIT_MSG ">>> OpenCL device #%u (%s) probes purchases table rows [%lu, %lu), "\
+                                 "i.e. %.2lf%% of all rows, and took %lf seconds\n"
+
+/*
+ * Everything a single OpenCL device needs for probing its share of the
+ * purchases table, including the host thread driving the device.
+ *   - device, context, queue, program, kernel --- OpenCL objects owned by this device only
+ *   - hashed_customer_table_buffer, purchases_table_buffer, joined_results_table_buffer --- the
+ *                          device's own copy of the customer table, and its range of the
+ *                          purchases table and of the results table
+ *   - device_name --- human-readable name of "device"
+ *   - kernel_variant --- variant of the probe kernel chosen for "device"
+ *   - device_index --- position of this device in the list of devices used
+ *   - purchases_view, results_view --- "table" structs pointing into the middle of the
+ *                                      full purchases and results tables
+ *   - tables_list --- the full tables being joined
+ *   - is_customer_active --- which customers the join results should contain
+ *   - first_row, num_rows --- range of the purchases table this device is responsible for
+ *   - rows_per_second --- probe throughput measured during calibration
+ *   - probe_seconds --- wall-clock time this device took to probe its range
+ *   - profiling_report --- profiling information of every OpenCL command this device executed
+ *                          while probing its range
+ *   - thread --- host thread driving this device
+ */
+struct Opencl_Device_Worker {
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernel;
+    cl_mem hashed_customer_table_buffer;
+    cl_mem purchases_table_buffer;
+    cl_mem joined_results_table_buffer;
+    char device_name[MAX_LEN];
+    struct Probe_Kernel_Variant kernel_variant;
+    unsigned int device_index;
+    struct Purchases_Table purchases_view;
+    struct Joined_Results_Table results_view;
+    struct List_Of_Tables tables_list;
+    char is_customer_active;
+    unsigned long first_row;
+    unsigned long num_rows;
+    double rows_per_second;
+    double probe_seconds;
+    struct Opencl_Profiling_Report profiling_report;
+    pthread_t thread;
+};
+
+/*
+ * Parameter details:
+ *   - devices --- array of at least "max_devices" entries in which to store every device found
+ *   - max_devices --- maximum number of devices to store in "devices"
+ *
+ * Enumerates every OpenCL device on every OpenCL platform; CPU devices with more
+ * than CPU_SUB_DEVICE_COMPUTE_UNITS compute units are replaced by the sub-devices
+ * created by partitioning them equally.  Returns the number of devices stored.
+ */
+unsigned int enumerate_all_opencl_devices(cl_device_id* devices, unsigned int max_devices);
+
+/*
+ * Parameter details:
+ *   - tables_list --- the tables to be equijoined and the table storing the joined results;
+ *                     each table HAS TO CONTAIN at least one row.
+ *   - is_customer_active --- a flag variable indicating whether to have join results
+ *                            contain data solely on active or solely on inactive customers.
+ *   - purchase_predicate --- predicate compiled into every device's probe kernel which purchases
+ *                            have to satisfy to be joined; NULL if every purchase should be joined.
+ *
+ * Hash equijoin probing split across every available OpenCL device.  Each device
+ * first probes CALIBRATION_PURCHASES_ROWS rows so that its throughput may be measured;
+ * the purchases table is then split into contiguous ranges proportional to those
+ * throughputs, which all devices probe concurrently.  Each device reads its results
+ * back into the same row range of "tables_list.results_table", so the joined rows
+ * end up in their original order.
+ */
+void multi_device_hash_equijoin_probe(struct List_Of_Tables tables_list, char is_customer_active,
+                                        const struct Purchase_Predicate* purchase_predicate);
+
+#endif // EQUIJOIN_MULTI_DEVICE_H
+// =================================================================================================
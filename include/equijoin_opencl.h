@@ -51,6 +51,28 @@
 #define KERNEL_FUNC_NAME "naive_hash_equijoin_probe"
 // Compiler options for compiling contents of OpenCL program file
 #define OPENCL_COMPILER_OPTIONS ""
+// Maximum length of the compiler options used for compiling a probe kernel variant
+#define MAX_COMPILER_OPTIONS_LEN 1024
+
+/*
+ * Whether to probe using the thread-coarsened, vector-load variant of the probe kernel (1),
+ * or using the "naive_hash_equijoin_probe" kernel (0), on every OpenCL device.
+ */
+#define USE_COARSENED_PROBE_KERNEL 1
+// Name of thread-coarsened kernel function in OpenCL program file
+#define COARSENED_KERNEL_FUNC_NAME "coarsened_hash_equijoin_probe"
+/*
+ * Number of consecutive purchases table rows joined by each work-item of the
+ * thread-coarsened kernel on CPU devices and on all other (e.g. GPU) devices.
+ */
+#define CPU_ROWS_PER_WORK_ITEM 16
+#define GPU_ROWS_PER_WORK_ITEM 4
+// Compiler option handing the number of rows per work-item to the thread-coarsened kernel
+#define ROWS_PER_WORK_ITEM_COMPILER_OPTION " -D ROWS_PER_WORK_ITEM=%u"
+// Name of kernel function in OpenCL program file only probing the blocks a zone map left to probe
+#define ZONE_MAPPED_KERNEL_FUNC_NAME "zone_mapped_hash_equijoin_probe"
+// Name of kernel function in OpenCL program file looking customers up in a hot customer table first
+#define HOT_CACHED_KERNEL_FUNC_NAME "hot_cached_hash_equijoin_probe"
 
 /*
  * Message notifying user of start of hash join probing on OpenCL device
@@ -58,6 +80,41 @@
  */
 #define NOTIFY_USER_HASH_JOIN_OP ">>> Performing parallelized hash equijoin "\
                                    "probing on OpenCL device with %d work-items per workgroup\n"
+// Message informing user which variant of the probe kernel is used
+#define NOTIFY_USER_KERNEL_VARIANT ">>> Using probe kernel '%s' with %u row(s) per work-item\n"
+
+/*
+ * Customers most purchases belong to, probed from local memory (see "equijoin_hot_customers.h").
+ */
+struct Hot_Customer_Table;
+
+/*
+ * Variant of the probe kernel chosen for a particular OpenCL device.
+ *   - kernel_func_name --- name of kernel function in OpenCL program file
+ *   - rows_per_work_item --- number of consecutive purchases table rows joined by each work-item
+ *   - compiler_options --- options to compile the OpenCL program file with for this variant
+ *   - work_group_size --- number of work-items per work-group (at most 256; see NUM_THREADS_IN_BLOCK)
+ *   - hot_customer_table --- if not NULL, probe every row with the "hot_cached_hash_equijoin_probe"
+ *                            kernel, looking customers up in this hot customer table first
+ */
+struct Probe_Kernel_Variant {
+     const char* kernel_func_name;
+     unsigned int rows_per_work_item;
+     char compiler_options[MAX_COMPILER_OPTIONS_LEN];
+     size_t work_group_size;
+     const struct Hot_Customer_Table* hot_customer_table;
+};
+
+/*
+ * Profiling report in which the timestamps of every OpenCL command enqueued
+ * by the functions below are recorded (see "opencl_profiling.h").
+ */
+struct Opencl_Profiling_Report;
+
+/*
+ * Blocks of the purchases table a zone map left to probe (see "purchases_zone_map.h").
+ */
+struct Purchases_Block_Selection;
 
 /* 
  * A group of operands where each operand points to a
@@ -75,6 +132,22 @@ struct Cl_Mem_Operands_List {
      cl_mem* joined_results_table_buffer;
 };
 
+/*
+ * Chooses the probe kernel variant best suited to "device" and stores it in "variant";
+ * CPU devices get CPU_ROWS_PER_WORK_ITEM rows per work-item and all other devices get
+ * GPU_ROWS_PER_WORK_ITEM rows per work-item, unless USE_COARSENED_PROBE_KERNEL is 0, in
+ * which case every device gets the "naive_hash_equijoin_probe" kernel.  Every variant starts
+ * out with work-groups of NUM_THREADS_IN_BLOCK work-items and without a hot customer table.
+ */
+void select_probe_kernel_variant(cl_device_id device, struct Probe_Kernel_Variant* variant);
+
+/*
+ * Returns the total number of work-items needed for "variant" to join "num_rows" rows,
+ * rounded up to a whole number of work-groups of the variant's work-group size for
+ * the thread-coarsened variant.
+ */
+size_t probe_kernel_global_size(const struct Probe_Kernel_Variant* variant, unsigned long num_rows);
+
 /* 
  * Load tables to be equijoined using hash join probing AND the empty
  * table used to store the joined result in into OpenCL device's memory;
@@ -92,9 +165,38 @@ struct Cl_Mem_Operands_List {
  *                      to a "buffer handle" of a segment of data in the OpenCL
  *                      device's memory, where each segment of data was copied
  *                      over from main memory.
+ *   - profiling_report --- report in which to record the profiling information of each
+ *                          write command; may be NULL if no report is wanted.
  */
 void load_tables_hash_equijoin_probe(cl_context *context, cl_command_queue* queue, 
-                                      struct List_Of_Tables tables_list, struct Cl_Mem_Operands_List cl_operands);
+                                      struct List_Of_Tables tables_list, struct Cl_Mem_Operands_List cl_operands,
+                                        struct Opencl_Profiling_Report* profiling_report);
+
+/*
+ * Creates the probe kernel of "kernel_variant" (or "naive_hash_equijoin_probe" if NULL) from
+ * "program" into "kernel", sets its arguments and enqueues it on "queue" without waiting for it
+ * to finish; the parameters are the same as for "opencl_hash_equijoin_probe" below.  Stores the
+ * event of the kernel (to be released by the caller) in "kernel_event", and returns the name of
+ * the kernel function enqueued.  Rows of the naive kernel which don't fill a whole work-group are
+ * probed by a separate launch enqueued ahead of it, whose event is stored in "remainder_kernel_event"
+ * (NULL if there was no such launch); "kernel_event" completes after both.
+ */
+const char* enqueue_hash_equijoin_probe_kernel(cl_command_queue *queue, cl_program *program,
+                                                 cl_kernel* kernel, struct List_Of_Tables tables_list,
+                                                   struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                                     const struct Probe_Kernel_Variant* kernel_variant,
+                                                       const struct Purchases_Block_Selection* block_selection,
+                                                         cl_event* kernel_event, cl_event* remainder_kernel_event);
+
+/*
+ * Records the (finished) launches "enqueue_hash_equijoin_probe_kernel" enqueued of "kernel_func_name"
+ * for "tables_list" and "kernel_variant" in "profiling_report" (unless it is NULL), each with the rows
+ * it probed, and releases their events.
+ */
+void record_hash_equijoin_probe_kernel_profiles(struct Opencl_Profiling_Report* profiling_report,
+                                                  const char* kernel_func_name, struct List_Of_Tables tables_list,
+                                                  const struct Probe_Kernel_Variant* kernel_variant,
+                                                  cl_event kernel_event, cl_event remainder_kernel_event);
 
 /* 
  * Parameter details:
@@ -120,6 +222,14 @@ void load_tables_hash_equijoin_probe(cl_context *context, cl_command_queue* queu
  *                          contain data solely on active customers or solely on
  *                          inactive customers; this function DOES NOT support producing
  *                          a resulting table containing data for both types of customers
+ * - kernel_variant --- variant of the probe kernel "program" was compiled for; if NULL, the
+ *                      "naive_hash_equijoin_probe" kernel is used.
+ * - block_selection --- blocks of ZONE_MAP_BLOCK_ROWS rows of "tables_list.purchases_table" to
+ *                       probe with the "zone_mapped_hash_equijoin_probe" kernel instead, leaving
+ *                       the results of every other block as uploaded; NULL to probe every row.
+ *                       Takes precedence over the variant's hot customer table.
+ * - profiling_report --- report in which to record the profiling information of the kernel
+ *                        and read commands; may be NULL if no report is wanted.
  *
  * Custom implementation of hash join probing using OpenCL;
  * Each set of tables being joined together is performed within
@@ -130,7 +240,10 @@ void load_tables_hash_equijoin_probe(cl_context *context, cl_command_queue* queu
  */
 void opencl_hash_equijoin_probe(cl_command_queue *queue, cl_program *program,
                                  cl_kernel* kernel, struct List_Of_Tables tables_list,
-                                   struct Cl_Mem_Operands_List cl_operands, char is_customer_active);
+                                   struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                     const struct Probe_Kernel_Variant* kernel_variant,
+                                       const struct Purchases_Block_Selection* block_selection,
+                                         struct Opencl_Profiling_Report* profiling_report);
 
 #endif // EQUIJOIN_OPENCL_H
 // =================================================================================================
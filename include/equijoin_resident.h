@@ -0,0 +1,114 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for probing many batches of purchases against a hashed customer table which stays
+// resident in OpenCL device memory.  The OpenCL context, queue, program and kernel are created once
+// per session, and the device buffers holding each purchases batch and its joined results are only
+// reallocated when a batch bigger than any batch seen before arrives.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_RESIDENT_H
+#define EQUIJOIN_RESIDENT_H
+
+#include "equijoin_opencl.h"
+#include "opencl_environment.h"
+#include "opencl_profiling.h"
+#include "purchase_predicate.h"
+
+/*
+ * Everything that stays alive on the OpenCL device between batches.
+ *   - context, queue, program, kernel --- OpenCL objects created once per session
+ *   - kernel_variant --- variant of the probe kernel "program" was compiled for
+ *   - predicate_program_cache --- programs compiled with a purchases predicate pushed down;
+ *                                 "kernel" comes from one of them while a predicate is set
+ *   - hashed_customer_table_buffer --- device copy of the hashed customer table
+ *   - purchases_table_buffer, joined_results_table_buffer --- device buffers reused by
+ *                                                             every batch
+ *   - hashed_customer_table --- the hashed customer table currently resident on the device
+ *   - is_customer_active --- which customers the join results of every batch should contain
+ *   - customer_buffer_rows --- number of rows "hashed_customer_table_buffer" can hold
+ *   - batch_buffer_rows --- number of rows the batch buffers can hold; the high-water
+ *                           mark of every batch probed so far
+ *   - num_batches_probed --- number of batches probed so far
+ */
+struct Resident_Probe_Session {
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernel;
+    struct Probe_Kernel_Variant kernel_variant;
+    struct Predicate_Program_Cache predicate_program_cache;
+    cl_mem hashed_customer_table_buffer;
+    cl_mem purchases_table_buffer;
+    cl_mem joined_results_table_buffer;
+    struct Hashed_Customer_Table* hashed_customer_table;
+    char is_customer_active;
+    unsigned long customer_buffer_rows;
+    unsigned long batch_buffer_rows;
+    unsigned long num_batches_probed;
+};
+
+/*
+ * Parameter details:
+ *   - hashed_customer_table --- hashed customer table to keep resident on the device; it
+ *                               HAS TO CONTAIN at least one row and must stay allocated
+ *                               for as long as the session is alive.
+ *   - is_customer_active --- a flag variable indicating whether to have the join results of
+ *                            every batch contain data solely on active or inactive customers.
+ *
+ * Configures the OpenCL environment, builds the probe kernel and copies the hashed
+ * customer table into device memory; returns the session which later batches use.
+ */
+struct Resident_Probe_Session* create_resident_probe_session(struct Hashed_Customer_Table* hashed_customer_table,
+                                                                char is_customer_active);
+
+/*
+ * Replaces the hashed customer table resident on the device of "session" with
+ * "hashed_customer_table"; the device buffer is only reallocated if the new table
+ * has more rows than the buffer can hold.
+ */
+void update_resident_customer_table(struct Resident_Probe_Session* session,
+                                      struct Hashed_Customer_Table* hashed_customer_table);
+
+/*
+ * Makes every batch probed by "session" from now on only join purchases satisfying
+ * "purchase_predicate", or every purchase if "purchase_predicate" is NULL.  The probe
+ * kernel for each distinct predicate is compiled only once per session, so switching
+ * back and forth between predicates doesn't recompile anything.
+ */
+void set_resident_purchase_predicate(struct Resident_Probe_Session* session,
+                                       const struct Purchase_Predicate* purchase_predicate);
+
+/*
+ * Parameter details:
+ *   - session --- session created by "create_resident_probe_session"
+ *   - purchases_batch --- batch of purchases to be joined with the resident customer table;
+ *                         it HAS TO CONTAIN at least one row, but its number of rows does NOT
+ *                         have to be divisible by NUM_THREADS_IN_BLOCK.
+ *   - results_batch --- table with as many rows as "purchases_batch" in which the joined
+ *                       results are stored.
+ *   - profiling_report --- report in which to record every OpenCL command; may be NULL.
+ *
+ * Uploads only "purchases_batch", probes it against the resident customer table and
+ * reads back only the joined results.
+ */
+void probe_batch(struct Resident_Probe_Session* session, struct Purchases_Table* purchases_batch,
+                   struct Joined_Results_Table* results_batch, struct Opencl_Profiling_Report* profiling_report);
+
+/*
+ * Gives back all device memory and OpenCL objects used by "session", and then
+ * frees "session" itself; the resident hashed customer table is NOT freed.
+ */
+void destroy_resident_probe_session(struct Resident_Probe_Session* session);
+
+#endif // EQUIJOIN_RESIDENT_H
+// =================================================================================================
@@ -8,11 +8,18 @@
 #define EQUIJOIN_SERIAL_H 
 
 #include "data_structures_opencl.h"
+#include "purchase_predicate.h"
+#include "purchases_zone_map.h"
+#include "host_threads.h"
 
 /*
  * Message notifying user start of serial hash join probing
  */
 #define NOTIFY_USER_SERIAL_HASH_JOIN_OP ">>> Performing serial hash equijoin probing in main memory\n"
+/*
+ * Message notifying user start of multi-threaded hash join probing
+ */
+#define NOTIFY_USER_THREADED_HASH_JOIN_OP ">>> Performing hash equijoin probing in main memory with %u thread(s)\n"
 
 /*
  * Serial implementation of hash equijoin probing in C.
@@ -27,6 +34,14 @@
  * - const char is_customer_active --- Flag variable indicating whether to have "tables_list.results_table"
  *                                     contain only data about active or inactive customers
  *                                     (but not both).
+ * - const struct Purchase_Predicate* purchase_predicate --- Predicate every row of "tables_list.purchases_table"
+ *                                                          has to satisfy to be joined; rows which don't satisfy
+ *                                                          it are stored as NULL rows without looking up their
+ *                                                          customer.  NULL if every row should be joined.
+ * - const struct Purchases_Block_Selection* block_selection --- Blocks of ZONE_MAP_BLOCK_ROWS rows of
+ *                                                          "tables_list.purchases_table" to probe, leaving the
+ *                                                          results of every other block untouched (see
+ *                                                          "purchases_zone_map.h").  NULL to probe every row.
  *
  * This function executes the probe of the hash equijoin of "tables_list.hashed_customer_table"
  * (a.k.a. the hashed customer table) and "tables_list.purchases_table" (a.k.a. the purchases table).
@@ -43,7 +58,26 @@
  * customer table during the hash equijoin probing. 
  *
  */
-void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active);
+void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                   const struct Purchase_Predicate* purchase_predicate,
+                                     const struct Purchases_Block_Selection* block_selection);
+
+/*
+ * Probes rows "first_row" up to (but not including) "end_row" of "tables_list.purchases_table"
+ * exactly as "serial_hash_equijoin_probe" documents, but without checking the tables or notifying
+ * the user; for engines probing many small tables in turn (e.g. "equijoin_grace.h").
+ */
+void serial_hash_equijoin_probe_rows(struct List_Of_Tables tables_list, const char is_customer_active,
+                                       const struct Purchase_Predicate* purchase_predicate,
+                                         unsigned long first_row, unsigned long end_row);
+
+/*
+ * Same as "serial_hash_equijoin_probe" without a block selection, but with the purchases table
+ * split into "num_threads" contiguous slices (0 for one per online CPU, see "resolve_num_threads"),
+ * each probed by its own thread; results are exactly the same.
+ */
+void threaded_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                    const struct Purchase_Predicate* purchase_predicate, unsigned int num_threads);
 
 #endif // EQUIJOIN_SERIAL_H
 
@@ -0,0 +1,84 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for OpenCL hash equijoin probing whose joined results are read back in chunks and
+// written out to a CSV file while the rest of the results are still being transferred.  Every chunk
+// is read back with a non-blocking read whose completion callback hands the chunk over to a writer
+// thread, which writes the chunks to disk strictly in order.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef EQUIJOIN_STREAMED_READBACK_H
+#define EQUIJOIN_STREAMED_READBACK_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "equijoin_opencl.h"
+#include "opencl_profiling.h"
+#include "table_utilities.h"
+
+/*
+ * Number of chunks the joined results are read back in; the more chunks, the sooner
+ * writing to disk starts, but the more read commands the OpenCL device has to process.
+ */
+#define NUM_READBACK_CHUNKS 16
+
+// Message notifying user of streamed readback
+#define NOTIFY_USER_STREAMED_READBACK ">>> Reading back joined results in %u chunk(s) of up to %lu row(s)"\
+                                         " while writing them to disk\n"
+
+/*
+ * State shared between the OpenCL runtime's callbacks and the writer thread.
+ *   - results_table --- host table each chunk is read back into
+ *   - results_table_file --- CSV file the chunks are written to
+ *   - chunk_rows --- number of rows per chunk; the last chunk may have fewer
+ *   - num_chunks --- number of chunks the results are read back in
+ *   - chunk_status --- execution status each chunk's read finished with, as handed to
+ *                      its callback
+ *   - is_chunk_read --- whether each chunk has been read back into "results_table"
+ *   - lock, chunk_read_cond --- guard "chunk_status" and "is_chunk_read", and wake
+ *                               up the writer thread when a chunk has been read back
+ */
+struct Streamed_Results_Writer {
+    struct Joined_Results_Table* results_table;
+    struct Results_Csv_File* results_table_file;
+    unsigned long chunk_rows;
+    unsigned int num_chunks;
+    cl_int chunk_status[NUM_READBACK_CHUNKS];
+    bool is_chunk_read[NUM_READBACK_CHUNKS];
+    pthread_mutex_t lock;
+    pthread_cond_t chunk_read_cond;
+};
+
+/*
+ * Parameter details:
+ *   - queue, program, kernel, tables_list, cl_operands, is_customer_active, kernel_variant,
+ *     block_selection, profiling_report --- same as for "opencl_hash_equijoin_probe" in "equijoin_opencl.h";
+ *                          the tables MUST already be loaded with "load_tables_hash_equijoin_probe".
+ *   - results_file_location --- path of the CSV file to write the joined results to, in the
+ *                               same format as "write_results_table_to_csv_file".
+ *
+ * Probes like "opencl_hash_equijoin_probe", but enqueues the readback of the joined results as
+ * NUM_READBACK_CHUNKS non-blocking reads right behind the kernel.  As each read completes, its
+ * callback hands the chunk to a writer thread, so formatting and writing the results overlaps with
+ * the transfers still in flight; returns once every chunk has been written and the file closed,
+ * with the whole joined results table also in "tables_list.results_table".
+ */
+void opencl_hash_equijoin_probe_streamed_to_csv(cl_command_queue *queue, cl_program *program,
+                                                  cl_kernel* kernel, struct List_Of_Tables tables_list,
+                                                    struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                                      const struct Probe_Kernel_Variant* kernel_variant,
+                                                        const struct Purchases_Block_Selection* block_selection,
+                                                          struct Opencl_Profiling_Report* profiling_report,
+                                                                            const char* results_file_location);
+
+#endif // EQUIJOIN_STREAMED_READBACK_H
+// =================================================================================================
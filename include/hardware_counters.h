@@ -0,0 +1,148 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for counting hardware events (cycles, instructions, cache, TLB and branch misses) of
+// each phase of the host program with Linux's "perf_event_open", and for reporting them per phase
+// and per table row both as human-readable text and as JSON.  Counters the kernel, the CPU or the
+// container don't allow are reported as unavailable; if none is allowed, phases are still
+// recorded but nothing is counted.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef HARDWARE_COUNTERS_H
+#define HARDWARE_COUNTERS_H
+
+#include <stdbool.h>
+
+// Maximum number of phases that can be recorded in a single report
+#define MAX_COUNTED_PHASES 32
+// Maximum length of the label identifying each phase recorded
+#define COUNTED_PHASE_LABEL_MAX_LEN 64
+// File to which the JSON version of the hardware counters report is written
+#define HARDWARE_COUNTERS_REPORT_FILE_PATH "./data/hardware_counters_report.json"
+
+// Messages informing user of counters that couldn't be opened
+#define HARDWARE_COUNTER_UNAVAILABLE_MSG ">>> Hardware counter '%s' is unavailable: %s\n"
+#define NO_HARDWARE_COUNTERS_MSG ">>> No hardware counters are available; phases are not counted"\
+                                   " (see /proc/sys/kernel/perf_event_paranoid)\n\n"
+// Format strings for printing out the human-readable version of the hardware counters report
+#define HARDWARE_COUNTERS_REPORT_HEADER ">>> Hardware counters report (per phase, then per row):\n"\
+                                        "    %-20s %12s %14s %14s %6s %12s %12s %12s %12s\n"
+#define HARDWARE_COUNTERS_REPORT_ROW_FORMAT "    %-20s %12lu %14.0lf %14.0lf %6.2lf %12.0lf %12.0lf %12.0lf %12.0lf\n"
+#define HARDWARE_COUNTERS_REPORT_PER_ROW_FORMAT "    %-20s %12s %14.2lf %14.2lf %6s %12.4lf %12.4lf %12.4lf %12.4lf\n\n"
+#define HARDWARE_COUNTERS_REPORT_JSON_MSG "Currently writing hardware counters report to '%s' on disk...\n\n"
+
+/*
+ * Hardware events counted for every phase.
+ *   - cycles, instructions --- CPU cycles and instructions retired, giving instructions per cycle
+ *   - l1d_misses, llc_misses --- level 1 data cache and last level cache read misses
+ *   - dtlb_misses --- data TLB read misses
+ *   - branch_misses --- mispredicted branches
+ */
+enum Hardware_Counter {
+    HARDWARE_COUNTER_CYCLES = 0,
+    HARDWARE_COUNTER_INSTRUCTIONS,
+    HARDWARE_COUNTER_L1D_MISSES,
+    HARDWARE_COUNTER_LLC_MISSES,
+    HARDWARE_COUNTER_DTLB_MISSES,
+    HARDWARE_COUNTER_BRANCH_MISSES,
+    NUM_HARDWARE_COUNTERS
+};
+
+/*
+ * Counters of this process (and of every thread it starts after they're opened).
+ *   - descriptors --- "perf_event_open" file descriptor of each counter; -1 if it's unavailable
+ *   - phase_start_values --- value of each counter when the current phase began
+ */
+struct Hardware_Counters {
+    int descriptors[NUM_HARDWARE_COUNTERS];
+    double phase_start_values[NUM_HARDWARE_COUNTERS];
+};
+
+/*
+ * Hardware events of a single phase.
+ *   - label --- what the phase did (e.g. which engine probed)
+ *   - num_rows --- number of table rows worked on by the phase
+ *   - is_counted --- whether each counter was available
+ *   - values --- events of each counter during the phase, scaled up if the kernel only counted
+ *                part of the phase because too many counters were open at once
+ */
+struct Counted_Phase {
+    char label[COUNTED_PHASE_LABEL_MAX_LEN];
+    unsigned long num_rows;
+    bool is_counted[NUM_HARDWARE_COUNTERS];
+    double values[NUM_HARDWARE_COUNTERS];
+};
+
+/*
+ * A struct containing:
+ *    - phases --- the hardware events of every phase recorded so far
+ *    - num_phases --- the number of phases recorded so far
+ */
+struct Hardware_Counters_Report {
+    struct Counted_Phase phases[MAX_COUNTED_PHASES];
+    unsigned int num_phases;
+};
+
+/*
+ * Marks every counter of "counters" unavailable, so that phases are recorded without being counted;
+ * the same as "open_hardware_counters" when none of them can be opened.
+ */
+void init_hardware_counters(struct Hardware_Counters* counters);
+
+/*
+ * Opens and starts every counter of "counters" that this process is allowed to, printing out why
+ * each of the others is unavailable.  Returns whether any counter could be opened.
+ */
+bool open_hardware_counters(struct Hardware_Counters* counters);
+
+/*
+ * Closes every counter of "counters" opened by "open_hardware_counters".
+ */
+void close_hardware_counters(struct Hardware_Counters* counters);
+
+/*
+ * Empties "report" of all phases recorded.
+ */
+void reset_hardware_counters_report(struct Hardware_Counters_Report* report);
+
+/*
+ * Remembers the value of every counter of "counters" as the start of the phase about to run.
+ */
+void begin_counted_phase(struct Hardware_Counters* counters);
+
+/*
+ * Parameter details:
+ *   - counters --- counters "begin_counted_phase" was called on when the phase began
+ *   - report --- report in which to record the phase; if NULL nothing is recorded
+ *   - label --- what the phase did
+ *   - num_rows --- number of table rows worked on by the phase
+ *
+ * Records the events counted by each counter of "counters" since "begin_counted_phase" in "report".
+ */
+void end_counted_phase(struct Hardware_Counters* counters, struct Hardware_Counters_Report* report,
+                         const char* label, unsigned long num_rows);
+
+/*
+ * Prints out to screen the events of every phase recorded in "report", both in total and per
+ * table row, along with instructions per cycle; unavailable counters are shown as "-1".
+ */
+void print_hardware_counters_report(const struct Hardware_Counters_Report* report);
+
+/*
+ * Writes the same information as "print_hardware_counters_report" as a JSON document to
+ * "file_location", unavailable counters as null; old contents of the file WILL BE OVERWRITTEN.
+ */
+void write_hardware_counters_report_to_json_file(const struct Hardware_Counters_Report* report,
+                                                   const char* file_location);
+
+#endif // HARDWARE_COUNTERS_H
+// =================================================================================================
@@ -0,0 +1,33 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the helpers every multi-threaded host engine (and the benchmark and data generator
+// programs) shares to decide how many threads to run and which rows each thread works on.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef HOST_THREADS_H
+#define HOST_THREADS_H
+
+/*
+ * Returns "num_threads", unless it is 0, in which case returns the number of online CPUs
+ * (or 1 if that can't be found out).
+ */
+unsigned int resolve_num_threads(unsigned int num_threads);
+
+/*
+ * Returns the number of rows in slice "slice_index" when "num_rows" rows are split into "num_slices"
+ * contiguous slices of (nearly) the same number of rows; the first "num_rows % num_slices" slices
+ * get one row more than the others.
+ */
+unsigned long slice_num_rows(unsigned long num_rows, unsigned int num_slices, unsigned int slice_index);
+
+#endif // HOST_THREADS_H
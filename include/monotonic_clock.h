@@ -0,0 +1,30 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for the monotonic clock every phase of the host program (and of the benchmark
+// and data generator programs) is timed with; unlike the time of day, it never jumps.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+// Number of nanoseconds in a second
+#define MONOTONIC_CLOCK_NANOSECS_IN_SEC 1000000000ul
+
+/*
+ * Return the current time of the monotonic clock, in nanoseconds and in seconds respectively;
+ * only differences between two readings mean anything.
+ */
+unsigned long monotonic_clock_nanosecs(void);
+double monotonic_clock_secs(void);
+
+#endif // MONOTONIC_CLOCK_H
@@ -0,0 +1,73 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for host functions which set up the OpenCL execution environment (platform, device,
+// context, command queue and compiled program) used by every OpenCL hash equijoin probe engine.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef OPENCL_ENVIRONMENT_H
+#define OPENCL_ENVIRONMENT_H
+
+#include "equijoin_opencl.h"
+
+// Number of OpenCL platforms on host machine
+#define NUM_CL_PLATFORMS 2
+/*
+ * Index of desired OpenCL platform (e.g. Portable Computing
+ *    Language, AMD Accelerated Parallel Processing) in
+ *    list of platforms returned.
+ */
+#define DESIRED_PLATFORM_INDEX 0
+// Number of OpenCL devices per OpenCL platform
+#define NUM_CL_DEVICES 1
+// Number of OpenCL programs to be loaded
+#define OPENCL_PROGS 1
+// OpenCL device name max length
+#define MAX_LEN 1024
+// Delimiter for reading non-csv text files
+#define TEXT_FILE_DELIM '\0'
+
+/*
+ * Given a specified file location containing an OpenCL program
+ * reads the entire contents of the file into memory and returns
+ * a pointer marking the start of the contents in memory.
+ */
+char* get_opencl_program_code(char* opencl_program_file_location);
+
+/*
+ * Parameter details:
+ *   - context --- the OpenCL execution context in which to create the program
+ *   - device --- the device within "context" for which to compile the program
+ *   - opencl_program_string --- full source code of the OpenCL program
+ *   - compiler_options --- options handed to the OpenCL compiler (e.g. "-D" macros)
+ *
+ * Compiles "opencl_program_string" for "device" and outputs any compiler-generated
+ * messages to the user; returns the compiled program.
+ */
+cl_program build_opencl_program(cl_context context, cl_device_id device,
+                                  const char* opencl_program_string, const char* compiler_options);
+
+/*
+ * Setup procedure for executing OpenCL programs.  The procedure involves
+ * creating an execution context to be used by the OpenCL-programmed device
+ * (in this case the GPU or CPU), setting up the queue which is used to store
+ * the kernels to be executed by the device within the execution context, and
+ * then dynamically compiling the program containing the kernels which are to be
+ * executed once the kernels (or even multiple copies of each kernel) gets added
+ * to the queue.  The program is compiled for the probe kernel variant best suited
+ * to the device, which is stored in "kernel_variant" unless it is NULL.
+ */
+void configure_opencl_env(cl_context *context, cl_command_queue* queue,
+                            cl_program *program, struct Probe_Kernel_Variant* kernel_variant);
+
+#endif // OPENCL_ENVIRONMENT_H
+// =================================================================================================
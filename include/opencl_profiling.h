@@ -0,0 +1,123 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for collecting the profiling information of every OpenCL command (write, kernel and
+// read) enqueued for hash equijoin probing, and for reporting that information per phase both as
+// human-readable text and as JSON.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef OPENCL_PROFILING_H
+#define OPENCL_PROFILING_H
+
+#include <stdio.h>
+#include "equijoin_opencl.h"
+
+// Maximum number of OpenCL commands that can be recorded in a single report
+#define MAX_PROFILED_COMMANDS 64
+// Maximum length of the label identifying each OpenCL command recorded
+#define PROFILED_COMMAND_LABEL_MAX_LEN 64
+// File to which the JSON version of the profiling report is written
+#define OPENCL_PROFILING_REPORT_FILE_PATH "./data/opencl_profiling_report.json"
+
+// Number of nanoseconds in a second, and number of bytes in a gigabyte
+#define PROFILING_NANOSECS_IN_SEC 1000000000.0
+#define PROFILING_BYTES_IN_GB 1000000000.0
+
+// Format strings for printing out the human-readable version of the profiling report
+#define PROFILING_REPORT_HEADER ">>> OpenCL command profiling report (all times in milliseconds):\n"\
+                                "    %-10s %-24s %10s %10s %10s %10s %14s\n"
+#define PROFILING_REPORT_ROW_FORMAT "    %-10s %-24s %10.3lf %10.3lf %10.3lf %10.3lf %14.0lf\n"
+#define PROFILING_REPORT_PHASE_FORMAT "    Total %-8s time on device: %10.3lf ms (%.3lf GB/s)\n"
+#define PROFILING_REPORT_SUMMARY_FORMAT "    Total queueing overhead: %10.3lf ms; first command queued to last "\
+                                        "command finished: %10.3lf ms\n\n"
+// Message informing user where the JSON version of the profiling report was written to
+#define PROFILING_REPORT_JSON_MSG "Currently writing OpenCL profiling report to '%s' on disk...\n\n"
+
+/*
+ * Phases of OpenCL hash equijoin probing an OpenCL command may belong to.
+ */
+enum Opencl_Profiling_Phase {
+    PROFILING_PHASE_UPLOAD = 0,
+    PROFILING_PHASE_KERNEL,
+    PROFILING_PHASE_READBACK,
+    NUM_PROFILING_PHASES
+};
+
+/*
+ * Profiling information of a single OpenCL command.
+ *   - label --- what the command worked on (e.g. which table was uploaded)
+ *   - phase --- which phase of probing the command belongs to
+ *   - queued, submitted, started, ended --- device timestamps in nanoseconds of the
+ *                                           CL_PROFILING_COMMAND_QUEUED/SUBMIT/START/END
+ *                                           points of the command
+ *   - num_bytes --- number of bytes moved by the command
+ *   - num_rows --- number of table rows worked on by the command
+ */
+struct Opencl_Command_Profile {
+    char label[PROFILED_COMMAND_LABEL_MAX_LEN];
+    enum Opencl_Profiling_Phase phase;
+    cl_ulong queued;
+    cl_ulong submitted;
+    cl_ulong started;
+    cl_ulong ended;
+    size_t num_bytes;
+    unsigned long num_rows;
+};
+
+/*
+ * A struct containing:
+ *    - commands --- the profiling information of every OpenCL command recorded so far
+ *    - num_commands --- the number of commands recorded so far
+ */
+struct Opencl_Profiling_Report {
+    struct Opencl_Command_Profile commands[MAX_PROFILED_COMMANDS];
+    unsigned int num_commands;
+};
+
+/*
+ * Empties "report" of all commands recorded.
+ */
+void reset_opencl_profiling_report(struct Opencl_Profiling_Report* report);
+
+/*
+ * Parameter details:
+ *   - report --- report in which to record the command; if NULL nothing is recorded
+ *   - event --- event of an OpenCL command which has ALREADY FINISHED executing and
+ *               which was enqueued on a queue with CL_QUEUE_PROFILING_ENABLE set
+ *   - phase --- phase of probing the command belongs to
+ *   - label --- what the command worked on
+ *   - num_bytes --- number of bytes moved by the command
+ *   - num_rows --- number of table rows worked on by the command
+ *
+ * Queries the CL_PROFILING_COMMAND_QUEUED/SUBMIT/START/END timestamps of "event"
+ * and records them in "report".
+ */
+void record_opencl_command_profile(struct Opencl_Profiling_Report* report, cl_event event,
+                                     enum Opencl_Profiling_Phase phase, const char* label,
+                                     size_t num_bytes, unsigned long num_rows);
+
+/*
+ * Prints out to screen every command recorded in "report" along with per-phase
+ * totals, the effective transfer rate in GB/s and throughput in rows/s of each
+ * command, and the time commands spent waiting in the queue.
+ */
+void print_opencl_profiling_report(const struct Opencl_Profiling_Report* report);
+
+/*
+ * Writes the same information as "print_opencl_profiling_report" as a JSON
+ * document to "file_location"; old contents of the file WILL BE OVERWRITTEN.
+ */
+void write_opencl_profiling_report_to_json_file(const struct Opencl_Profiling_Report* report,
+                                                  const char* file_location);
+
+#endif // OPENCL_PROFILING_H
+// =================================================================================================
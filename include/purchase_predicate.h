@@ -0,0 +1,173 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for predicates over purchases table rows which are pushed down into the probe of the
+// hash equijoin.  A predicate is a conjunction (AND) of simple terms comparing a column of the
+// purchases table to a constant; the same predicate can be evaluated on the host for the serial
+// probe, or turned into OpenCL C with every constant inlined and compiled into the probe kernels.
+// Compiled programs are cached per predicate so that each predicate is only ever compiled once.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef PURCHASE_PREDICATE_H
+#define PURCHASE_PREDICATE_H
+
+#include <stdbool.h>
+#include "equijoin_opencl.h"
+#include "data_structures_opencl.h"
+
+// Maximum number of terms in a single purchases table predicate
+#define MAX_PREDICATE_TERMS 16
+// Maximum length of the OpenCL C source generated for a single predicate
+#define MAX_PREDICATE_SOURCE_LEN 4096
+// Maximum number of compiled programs kept in a predicate program cache
+#define MAX_CACHED_PREDICATE_PROGRAMS 32
+/*
+ * Name of the macro the probe kernels evaluate for every purchases table row
+ * before looking up the customer who made the purchase.
+ */
+#define PURCHASE_PREDICATE_MACRO_NAME "PURCHASE_PREDICATE"
+
+// Message informing user of the predicate purchases are filtered with
+#define PURCHASE_PREDICATE_MSG ">>> Only joining purchases satisfying: %s\n\n"
+
+/*
+ * Columns of the purchases table a predicate term may refer to.
+ */
+enum Purchase_Predicate_Column {
+    PREDICATE_COLUMN_TIME_OF_PURCHASE = 0,
+    PREDICATE_COLUMN_CUSTOMER_ID,
+    PREDICATE_COLUMN_QUANTITY_PURCHASED,
+    PREDICATE_COLUMN_EAN13
+};
+
+/*
+ * Comparisons a predicate term may make; PREDICATE_OP_PREFIX is only valid for
+ * PREDICATE_COLUMN_EAN13, and every other operator only for the numeric columns.
+ */
+enum Purchase_Predicate_Operator {
+    PREDICATE_OP_EQ = 0,
+    PREDICATE_OP_NE,
+    PREDICATE_OP_LT,
+    PREDICATE_OP_LE,
+    PREDICATE_OP_GT,
+    PREDICATE_OP_GE,
+    PREDICATE_OP_PREFIX
+};
+
+/*
+ * A single term of a predicate.
+ *   - column --- the purchases table column compared
+ *   - op --- the comparison made
+ *   - value --- constant a numeric column is compared to
+ *   - ean13_prefix --- string an EAN13 barcode must start with (PREDICATE_OP_PREFIX only)
+ */
+struct Purchase_Predicate_Term {
+    enum Purchase_Predicate_Column column;
+    enum Purchase_Predicate_Operator op;
+    unsigned long value;
+    char ean13_prefix[EAN13_MAX_CHARS];
+};
+
+/*
+ * A struct containing:
+ *    - terms --- every term of the predicate; a row satisfies the predicate only if
+ *                it satisfies ALL terms
+ *    - num_terms --- number of terms; a predicate with no terms is satisfied by every row
+ */
+struct Purchase_Predicate {
+    struct Purchase_Predicate_Term terms[MAX_PREDICATE_TERMS];
+    unsigned int num_terms;
+};
+
+/*
+ * Cache of OpenCL programs compiled for a single OpenCL context and device, keyed by
+ * the predicate and compiler options each program was compiled with.
+ *   - context, device --- where every cached program was compiled for
+ *   - base_program_string --- source code of the OpenCL program file
+ *   - keys --- generated predicate source plus compiler options of each cached program
+ *   - programs --- the cached programs
+ *   - num_programs --- number of programs cached
+ */
+struct Predicate_Program_Cache {
+    cl_context context;
+    cl_device_id device;
+    char* base_program_string;
+    char* keys[MAX_CACHED_PREDICATE_PROGRAMS];
+    cl_program programs[MAX_CACHED_PREDICATE_PROGRAMS];
+    unsigned int num_programs;
+};
+
+/*
+ * Empties "predicate" of all terms, so that every row satisfies it.
+ */
+void init_purchase_predicate(struct Purchase_Predicate* predicate);
+
+/*
+ * Adds the term "'column' 'op' 'value'" to "predicate"; "column" MUST be numeric.
+ */
+void add_purchase_predicate_term(struct Purchase_Predicate* predicate, enum Purchase_Predicate_Column column,
+                                   enum Purchase_Predicate_Operator op, unsigned long value);
+
+/*
+ * Adds the term "EAN13 barcode starts with 'ean13_prefix'" to "predicate"; "ean13_prefix"
+ * MUST consist of at most EAN13_MAX_CHARS - 1 digits.
+ */
+void add_purchase_predicate_ean13_prefix(struct Purchase_Predicate* predicate, const char* ean13_prefix);
+
+/*
+ * Returns whether "purchases_table_row" satisfies every term of "predicate"; a NULL
+ * "predicate" is satisfied by every row.
+ */
+bool evaluate_purchase_predicate(const struct Purchase_Predicate* predicate,
+                                   const struct Purchases_Table_Row* purchases_table_row);
+
+/*
+ * Writes into "source" (of "source_len" bytes) a "#define PURCHASE_PREDICATE(purchase_row) ..."
+ * line of OpenCL C which evaluates "predicate" with every constant inlined.
+ */
+void purchase_predicate_to_opencl_c(const struct Purchase_Predicate* predicate, char* source, size_t source_len);
+
+/*
+ * Same as "purchase_predicate_to_opencl_c", but names the macro defined "macro_name" instead of
+ * PURCHASE_PREDICATE_MACRO_NAME, e.g. to compile several predicates into the same program.
+ */
+void purchase_predicate_to_opencl_c_macro(const struct Purchase_Predicate* predicate, const char* macro_name,
+                                            char* source, size_t source_len);
+
+/*
+ * Sets up "cache" for compiling programs for "context", which MUST contain exactly one device.
+ */
+void init_predicate_program_cache(struct Predicate_Program_Cache* cache, cl_context context);
+
+/*
+ * Returns the OpenCL program file compiled with "predicate" inlined and with the compiler options
+ * of "kernel_variant"; the program is compiled only the first time each combination is asked for.
+ * The program returned is owned by "cache" and MUST NOT be released by the caller.
+ */
+cl_program get_predicate_program(struct Predicate_Program_Cache* cache, const struct Purchase_Predicate* predicate,
+                                   const struct Probe_Kernel_Variant* kernel_variant);
+
+/*
+ * Returns the OpenCL program file compiled with "source_prefix" (e.g. generated "#define"s) in front
+ * of it and with the compiler options of "kernel_variant"; like "get_predicate_program", the program
+ * is compiled only once per combination, is owned by "cache" and MUST NOT be released by the caller.
+ */
+cl_program get_program_with_source_prefix(struct Predicate_Program_Cache* cache, const char* source_prefix,
+                                            const struct Probe_Kernel_Variant* kernel_variant);
+
+/*
+ * Releases every program cached in "cache".
+ */
+void release_predicate_program_cache(struct Predicate_Program_Cache* cache);
+
+#endif // PURCHASE_PREDICATE_H
+// =================================================================================================
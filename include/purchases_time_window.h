@@ -0,0 +1,74 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for narrowing the probe of the hash equijoin down to the rows of the purchases table
+// inside a time window.  Purchases are logged (and generated) in order of their time of purchase,
+// so once the purchases table is known to be sorted by time, the rows a window given through the
+// purchases predicate can match are found by binary search, and the probe engines are handed only
+// that range of rows instead of scanning the whole purchases table.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef PURCHASES_TIME_WINDOW_H
+#define PURCHASES_TIME_WINDOW_H
+
+#include <stdbool.h>
+#include "data_structures_opencl.h"
+#include "purchase_predicate.h"
+
+// Messages informing user whether the purchases table can be narrowed down to a time window
+#define TIME_WINDOW_ROWS_MSG ">>> Time window [%lu, %lu] spans purchases table rows [%lu, %lu) of %lu\n\n"
+#define TIME_WINDOW_UNSORTED_MSG ">>> Purchases table isn't sorted by time of purchase; scanning all of it\n\n"
+
+/*
+ * Range of consecutive rows of a purchases table.
+ *   - first_row --- index of the first row in the range
+ *   - num_rows --- number of rows in the range
+ */
+struct Purchases_Row_Range {
+    unsigned long first_row;
+    unsigned long num_rows;
+};
+
+/*
+ * Returns whether the rows of "purchases_table" are in non-decreasing order of their
+ * time of purchase.
+ */
+bool is_purchases_table_sorted_by_time(const struct Purchases_Table* purchases_table);
+
+/*
+ * Parameter details:
+ *   - purchase_predicate --- predicate to find the time window of; may be NULL.
+ *   - min_time, max_time --- where to store the earliest and latest time of purchase (both
+ *                            inclusive) a row satisfying "purchase_predicate" can have.
+ *
+ * Returns whether any term of "purchase_predicate" bounds the time of purchase at all; if the
+ * terms contradict each other, "min_time" ends up greater than "max_time".
+ */
+bool get_purchase_predicate_time_window(const struct Purchase_Predicate* purchase_predicate,
+                                          unsigned long* min_time, unsigned long* max_time);
+
+/*
+ * Parameter details:
+ *   - purchases_table --- purchases table sorted by time of purchase (see
+ *                         "is_purchases_table_sorted_by_time"); HAS to have at least 1 row.
+ *   - min_time, max_time --- time window, both ends inclusive.
+ *
+ * Returns the range of rows of "purchases_table" purchased within the time window, found by
+ * binary search.  The range is widened to a single row next to where the window would be if
+ * no row is inside it, as the probe engines need at least one row; rows outside the window
+ * are still filtered out by the purchases predicate the window came from.
+ */
+struct Purchases_Row_Range find_purchases_time_window_rows(const struct Purchases_Table* purchases_table,
+                                                             unsigned long min_time, unsigned long max_time);
+
+#endif // PURCHASES_TIME_WINDOW_H
+// =================================================================================================
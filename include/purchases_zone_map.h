@@ -0,0 +1,104 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for zone maps of the purchases table: the smallest and largest value of each numeric
+// column within every block of ZONE_MAP_BLOCK_ROWS consecutive rows.  A block whose ranges can't
+// satisfy the purchases predicate can't hold a single joined record, so the probe engines only
+// probe the blocks the zone map can't rule out.  Zone maps are persisted next to the purchases
+// table file and only rebuilt when that file changes.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef PURCHASES_ZONE_MAP_H
+#define PURCHASES_ZONE_MAP_H
+
+#include "data_structures_opencl.h"
+#include "purchase_predicate.h"
+
+// Identifies (and versions) files zone maps are persisted in
+#define ZONE_MAP_FILE_MAGIC "PZONEMA1"
+
+// Messages informing user where zone maps came from and how many blocks they rule out
+#define ZONE_MAP_LOADED_MSG ">>> Using zone map of %lu block(s) persisted in '%s'\n"
+#define ZONE_MAP_BUILT_MSG ">>> Built zone map of %lu block(s) and persisted it in '%s'\n"
+#define ZONE_MAP_SELECTION_MSG ">>> Zone map leaves %lu of %lu block(s) of %u row(s) to probe\n\n"
+
+/*
+ * Smallest and largest value of each numeric column of the purchases table within one block.
+ */
+struct Purchases_Zone {
+    unsigned long min_time_of_purchase;
+    unsigned long max_time_of_purchase;
+    unsigned long min_customer_id;
+    unsigned long max_customer_id;
+    unsigned long min_quantity_purchased;
+    unsigned long max_quantity_purchased;
+};
+
+/*
+ * Zone map of a purchases table.
+ *   - zones --- zone of each block of ZONE_MAP_BLOCK_ROWS rows; the last block may be shorter
+ *   - num_zones --- number of blocks
+ *   - num_rows --- number of rows of the purchases table the zone map was built for
+ */
+struct Purchases_Zone_Map {
+    struct Purchases_Zone* zones;
+    unsigned long num_zones;
+    unsigned long num_rows;
+};
+
+/*
+ * Blocks of ZONE_MAP_BLOCK_ROWS rows of a purchases table (or of a "view" of one) left to probe.
+ *   - blocks --- index of each block left to probe, in increasing order
+ *   - num_blocks --- number of blocks left to probe
+ */
+struct Purchases_Block_Selection {
+    unsigned long* blocks;
+    unsigned long num_blocks;
+};
+
+/*
+ * Parameter details:
+ *   - purchases_table --- purchases table read from "purchases_table_file_location".
+ *   - purchases_table_file_location --- CSV file "purchases_table" was read from.
+ *   - zone_map_file_location --- file the zone map of "purchases_table" is persisted in.
+ *   - zone_map --- where to store the zone map; free it with "free_purchases_zone_map".
+ *
+ * Reads the zone map of "purchases_table" from "zone_map_file_location" if it was persisted
+ * for the current version of "purchases_table_file_location"; otherwise builds it and persists it.
+ */
+void get_purchases_zone_map(const struct Purchases_Table* purchases_table, const char* purchases_table_file_location,
+                              const char* zone_map_file_location, struct Purchases_Zone_Map* zone_map);
+
+/*
+ * Parameter details:
+ *   - zone_map --- zone map of the whole purchases table.
+ *   - first_row, num_rows --- rows of the purchases table probed, e.g. a time window of it; blocks
+ *                             selected are of ZONE_MAP_BLOCK_ROWS rows counted from "first_row".
+ *   - purchase_predicate --- predicate purchases have to satisfy to be joined; may be NULL.
+ *   - block_selection --- where to store the blocks left to probe; free it with
+ *                         "free_purchases_block_selection".
+ *
+ * Returns whether the zone map rules out any block at all; "block_selection" is only filled
+ * in if it does.
+ */
+bool select_purchases_blocks(const struct Purchases_Zone_Map* zone_map, unsigned long first_row,
+                               unsigned long num_rows, const struct Purchase_Predicate* purchase_predicate,
+                                 struct Purchases_Block_Selection* block_selection);
+
+/*
+ * Gives back memory used by "zone_map" and "block_selection" to the system.
+ */
+void free_purchases_zone_map(struct Purchases_Zone_Map* zone_map);
+void free_purchases_block_selection(struct Purchases_Block_Selection* block_selection);
+
+#endif // PURCHASES_ZONE_MAP_H
+// =================================================================================================
@@ -0,0 +1,103 @@
+
+/*
+ * Author - Ted Li
+ *
+ * This file defines the functions and macros used to verify equijoin
+ * results tables in memory, without writing them to disk and reading
+ * them back.  Every results table is reduced to a 64-bit digest that
+ * depends on each of its (non-NULL) rows and on their order; digests
+ * of different engines are compared with each other, and with the
+ * digest of the known correct result.  That reference digest is
+ * computed from the known correct CSV file once per input and cached
+ * next to it, so the sqlite3 script generating the known correct
+ * result only needs to be run to bootstrap the cache.
+ */
+
+#ifndef RESULTS_DIGEST_H
+#define RESULTS_DIGEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "data_structures_opencl.h"
+
+/*
+ * Number of threads computing the digest of a results table (0 for one thread per online CPU).
+ */
+#define RESULTS_DIGEST_THREADS 0
+/*
+ * Fewest rows per thread worth digesting in parallel; smaller tables are digested by fewer threads.
+ */
+#define MIN_DIGEST_ROWS_PER_THREAD (64 * 1024)
+
+// Messages informing user about digests computed and compared
+#define RESULTS_DIGEST_MSG ">>> Digest of %s: %016" PRIx64 " over %lu row(s)\n"
+#define RESULTS_REF_DIGEST_CACHED_MSG ">>> Using reference digest cached in '%s'\n"
+#define RESULTS_REF_DIGEST_COMPUTED_MSG ">>> Computed reference digest from '%s' and cached it in '%s'\n"
+#define RESULTS_REF_DIGEST_MISSING_MSG "Neither an up-to-date reference digest in '%s' nor the known correct"\
+                                          " result '%s' exist; run the script generating the known correct"\
+                                          " result first.\n"
+#define RESULTS_DIGEST_MISMATCH_MSG "Digest of %s (%016" PRIx64 " over %lu row(s)) differs from digest of %s"\
+                                       " (%016" PRIx64 " over %lu row(s))\n"
+#define RESULTS_DIGESTS_MATCH_MSG "Congratulations, digests of %s and %s are identical!\n\n"
+
+/*
+ * Order-aware digest of a results table.
+ *   - digest --- 64-bit digest of the rows, in order
+ *   - num_rows --- number of (non-NULL) rows the digest was computed over
+ */
+struct Results_Table_Digest {
+    uint64_t digest;
+    unsigned long num_rows;
+};
+
+/*
+ * Parameter details:
+ *   - results_table --- joined results table to compute the digest of.
+ *   - num_threads --- number of threads computing the digest; 0 means one thread per online CPU.
+ *
+ * Returns the digest of every row of "results_table" which doesn't consist of NULL values,
+ * in order; tables holding the same rows in the same order have the same digest, no matter
+ * how many NULL rows sit in between, as do the CSV files "write_results_table_to_csv_file"
+ * writes for them (see "compute_results_csv_file_digest").
+ */
+struct Results_Table_Digest compute_results_table_digest(const struct Joined_Results_Table* results_table,
+                                                           unsigned int num_threads);
+
+/*
+ * Parameter details:
+ *   - file_location --- CSV file containing a joined results table, as written either by
+ *                       "write_results_table_to_csv_file" or by sqlite3.
+ *
+ * Returns the digest of the table in the file, as "compute_results_table_digest" would
+ * compute it for the table in memory.
+ */
+struct Results_Table_Digest compute_results_csv_file_digest(const char* file_location);
+
+/*
+ * Parameter details:
+ *   - reference_file_location --- CSV file containing the known correct joined results table.
+ *   - digest_cache_location --- file the digest of "reference_file_location" is cached in.
+ *   - customer_table_file_location, purchases_table_file_location --- the input tables joined.
+ *
+ * Returns the digest of the known correct result, cached in "digest_cache_location" as long
+ * as both input tables stay the same size and aren't modified; otherwise the digest is
+ * computed from "reference_file_location" and cached.  Aborts the program if neither exist.
+ */
+struct Results_Table_Digest get_reference_results_digest(const char* reference_file_location,
+                                                            const char* digest_cache_location,
+                                                            const char* customer_table_file_location,
+                                                            const char* purchases_table_file_location);
+
+/*
+ * Parameter details:
+ *   - first_digest, second_digest --- digests to compare.
+ *   - first_description, second_description --- what each digest was computed from.
+ *
+ * Returns whether both digests (and their row counts) are the same, after printing
+ * both digests if not.
+ */
+bool compare_results_digests(struct Results_Table_Digest first_digest, const char* first_description,
+                               struct Results_Table_Digest second_digest, const char* second_description);
+
+#endif // RESULTS_DIGEST_H
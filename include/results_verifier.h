@@ -0,0 +1,54 @@
+
+/*
+ * Author - Ted Li
+ *
+ * This file defines the functions and macros used to verify that
+ * two equijoin results tables on disk hold the same rows.  Both CSV
+ * files are memory-mapped and compared in parallel; files written by
+ * this program are compared byte for byte, while files written in a
+ * different CSV dialect (e.g. the known correct results written by
+ * sqlite3, which only quotes fields when needed and ends lines with
+ * "\r\n") are compared row by row, ignoring quotes and carriage returns.
+ */
+
+#ifndef RESULTS_VERIFIER_H
+#define RESULTS_VERIFIER_H
+
+#include <stdbool.h>
+
+/*
+ * Number of threads comparing two results tables (0 for one thread per online CPU).
+ */
+#define RESULTS_VERIFIER_THREADS 0
+/*
+ * Smallest number of bytes per thread worth comparing in parallel; smaller files
+ * are compared by fewer threads.
+ */
+#define MIN_VERIFIER_BYTES_PER_THREAD (1024 * 1024)
+
+// Messages informing user how two results tables turned out to compare
+#define RESULTS_FILES_BYTE_IDENTICAL_MSG "'%s' and '%s' are byte-for-byte identical (%u thread(s))\n"
+#define RESULTS_FILES_ROW_COUNT_MISMATCH_MSG "'%s' has %lu row(s) (header included), but '%s' has %lu row(s)\n"
+#define RESULTS_FILES_ROW_MISMATCH_MSG "First difference is on row %lu (header is row 0), column %d (\"%s\"):\n"
+#define RESULTS_FILES_MISSING_ROW_MSG "Row %lu (header is row 0) is only present in '%s':\n"
+#define RESULTS_FILES_UNMATCHED_ROWS_MSG "%lu row(s) of '%s' and %lu row(s) of '%s' have no match in the other file;"\
+                                            " for example, row %lu (header is row 0) of '%s':\n"
+#define RESULTS_FILES_ROW_TEXT_MSG "    %s: %.*s\n"
+
+/*
+ * Parameter details:
+ *   - first_results_file, second_results_file --- CSV files each containing an equijoin results table.
+ *   - is_order_insensitive --- whether the rows of either file may come in any order (true), e.g. for
+ *                              engines emitting rows out of order, instead of having to be in the same
+ *                              order in both files (false).
+ *   - num_threads --- number of threads comparing the files; 0 means one thread per online CPU.
+ *
+ * Returns whether both files hold the same rows.  Identical files are found with a parallel "memcmp"
+ * over both mappings; otherwise rows are compared with quotes and carriage returns ignored, either in
+ * order (reporting the first differing row and column) or as multisets of 64-bit row hashes (reporting
+ * a row without a match).  Details of any difference are printed to stderr.
+ */
+bool compare_results_table_files(const char* first_results_file, const char* second_results_file,
+                                   bool is_order_insensitive, unsigned int num_threads);
+
+#endif // RESULTS_VERIFIER_H
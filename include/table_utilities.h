@@ -10,6 +10,9 @@
 #ifndef TABLE_UTILITIES_H
 #define TABLE_UTILITIES_H
 
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include "data_structures_opencl.h"
 
 /* 
@@ -42,19 +45,40 @@
     
     #define CUSTOMER_TABLE_FILE_PATH "./data/example_customer_data.csv"
     #define PURCHASES_TABLE_FILE_PATH "./data/example_purchases_data.csv"
+    // Results of each query of a batch (run with "--batch"), numbered by the query's index
+    #define PARALLEL_BATCH_RESULTS_FILE_PATH_FORMAT "./data/example_results"\
+                                                    "/parallel_example_batch_query_%u_result.csv"
+    #define CPU_BATCH_RESULTS_FILE_PATH_FORMAT "./data/example_results"\
+                                               "/cpu_example_batch_query_%u_result.csv"
     
     #if (IS_CUSTOMER_ACTIVE == CUSTOMER_ACTIVE_FLAG)
         #define PARALLEL_RESULTS_TABLE_FILE_PATH "./data/example_results"\
                                                  "/parallel_example_join_result_active_customers.csv"
+        #define PARALLEL_RESULTS_ARROW_FILE_PATH "./data/example_results"\
+                                                 "/parallel_example_join_result_active_customers.arrow"
         #define SERIAL_RESULTS_TABLE_FILE_PATH "./data/example_results"\
                                                "/serial_example_join_result_active_customers.csv"
+        #define GRACE_RESULTS_TABLE_FILE_PATH "./data/example_results"\
+                                              "/grace_example_join_result_active_customers.csv"
+        #define PARALLEL_AGGREGATED_RESULTS_FILE_PATH "./data/example_results"\
+                                                      "/parallel_example_aggregated_result_active_customers.csv"
+        #define CPU_AGGREGATED_RESULTS_FILE_PATH "./data/example_results"\
+                                                 "/cpu_example_aggregated_result_active_customers.csv"
         #define RESULTS_REF_TABLE_FILE_PATH "./data/example_results"\
                                             "/example_correct_join_result_active_customers.csv" 
     #elif (IS_CUSTOMER_ACTIVE == CUSTOMER_INACTIVE_FLAG)
         #define PARALLEL_RESULTS_TABLE_FILE_PATH "./data/example_results"\
                                                  "/parallel_example_join_result_inactive_customers.csv"
+        #define PARALLEL_RESULTS_ARROW_FILE_PATH "./data/example_results"\
+                                                 "/parallel_example_join_result_inactive_customers.arrow"
         #define SERIAL_RESULTS_TABLE_FILE_PATH "./data/example_results"\
                                                "/serial_example_join_result_inactive_customers.csv"
+        #define GRACE_RESULTS_TABLE_FILE_PATH "./data/example_results"\
+                                              "/grace_example_join_result_inactive_customers.csv"
+        #define PARALLEL_AGGREGATED_RESULTS_FILE_PATH "./data/example_results"\
+                                                      "/parallel_example_aggregated_result_inactive_customers.csv"
+        #define CPU_AGGREGATED_RESULTS_FILE_PATH "./data/example_results"\
+                                                 "/cpu_example_aggregated_result_inactive_customers.csv"
         #define RESULTS_REF_TABLE_FILE_PATH "./data/example_results"\
                                             "/example_correct_join_result_inactive_customers.csv" 
     #endif
@@ -63,25 +87,66 @@
 
     #define CUSTOMER_TABLE_FILE_PATH "./data/custom_customer_data.csv"
     #define PURCHASES_TABLE_FILE_PATH "./data/custom_purchases_data.csv"
+    // Results of each query of a batch (run with "--batch"), numbered by the query's index
+    #define PARALLEL_BATCH_RESULTS_FILE_PATH_FORMAT "./data/custom_results"\
+                                                    "/parallel_custom_batch_query_%u_result.csv"
+    #define CPU_BATCH_RESULTS_FILE_PATH_FORMAT "./data/custom_results"\
+                                               "/cpu_custom_batch_query_%u_result.csv"
 
     #if (IS_CUSTOMER_ACTIVE == CUSTOMER_ACTIVE_FLAG)
         #define PARALLEL_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
                                                  "/parallel_custom_join_result_active_customers.csv"
+        #define PARALLEL_RESULTS_ARROW_FILE_PATH "./data/custom_results"\
+                                                 "/parallel_custom_join_result_active_customers.arrow"
         #define SERIAL_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
                                                "/serial_custom_join_result_active_customers.csv"
+        #define GRACE_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
+                                              "/grace_custom_join_result_active_customers.csv"
+        #define PARALLEL_AGGREGATED_RESULTS_FILE_PATH "./data/custom_results"\
+                                                      "/parallel_custom_aggregated_result_active_customers.csv"
+        #define CPU_AGGREGATED_RESULTS_FILE_PATH "./data/custom_results"\
+                                                 "/cpu_custom_aggregated_result_active_customers.csv"
         #define RESULTS_REF_TABLE_FILE_PATH "./data/custom_results"\
                                             "/custom_correct_join_result_active_customers.csv" 
     #elif (IS_CUSTOMER_ACTIVE == CUSTOMER_INACTIVE_FLAG)
         #define PARALLEL_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
                                                  "/parallel_custom_join_result_inactive_customers.csv"
+        #define PARALLEL_RESULTS_ARROW_FILE_PATH "./data/custom_results"\
+                                                 "/parallel_custom_join_result_inactive_customers.arrow"
         #define SERIAL_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
                                                "/serial_custom_join_result_inactive_customers.csv"
+        #define GRACE_RESULTS_TABLE_FILE_PATH "./data/custom_results"\
+                                              "/grace_custom_join_result_inactive_customers.csv"
+        #define PARALLEL_AGGREGATED_RESULTS_FILE_PATH "./data/custom_results"\
+                                                      "/parallel_custom_aggregated_result_inactive_customers.csv"
+        #define CPU_AGGREGATED_RESULTS_FILE_PATH "./data/custom_results"\
+                                                 "/cpu_custom_aggregated_result_inactive_customers.csv"
         #define RESULTS_REF_TABLE_FILE_PATH "./data/custom_results"\
                                             "/custom_correct_join_result_inactive_customers.csv" 
     #endif
 
 #endif
 
+/*
+ * File caching the digest of the known correct result at RESULTS_REF_TABLE_FILE_PATH
+ * (see "results_digest.h").
+ */
+#define RESULTS_REF_DIGEST_FILE_PATH RESULTS_REF_TABLE_FILE_PATH ".digest"
+
+/*
+ * File persisting the zone map of the purchases table at PURCHASES_TABLE_FILE_PATH
+ * (see "purchases_zone_map.h").
+ */
+#define PURCHASES_ZONE_MAP_FILE_PATH PURCHASES_TABLE_FILE_PATH ".zonemap"
+
+/*
+ * Tables may also be stored in a binary format (see "equijoin_data_generator"), recognized by the
+ * extension of the file: a "Table_Binary_File_Header" followed by the rows exactly as they are laid
+ * out in memory; customer table rows are already hashed, i.e. stored at their row index.
+ */
+#define TABLE_BINARY_FILE_EXTENSION ".bin"
+#define TABLE_BINARY_FILE_MAGIC "EQJTBL1"
+
 // Different modes for specifying how "fopen" should open a file
 #define FOPEN_READ_ONLY_MODE "r"
 #define FOPEN_OVERWRITE_ONLY_MODE "w"
@@ -117,8 +182,26 @@
  * Format string used to inform user which table from which file is being read from disk.
  */
 #define FILE_BEING_READ_MSG "Currently reading table in '%s' from disk into memory...\n\n"
+/*
+ * Size of the buffer joined results are formatted into before being written to disk with
+ * a single "write" call; large enough that the number of system calls doesn't matter.
+ */
+#define RESULTS_CSV_WRITE_BUFFER_SIZE (8 * 1024 * 1024)
+/*
+ * Most characters a single row of the joined results table can take up in CSV form
+ * (three 20 character integers, the full width of both string fields, two quotes
+ * around each string field, four commas and a newline), rounded up.
+ */
+#define MAX_JOINED_RESULT_ROW_CSV_LEN 128
+// Most digits (including a minus sign) in an integer printed with "%ld"
+#define MAX_DECIMAL_DIGITS_IN_LONG 20
+// Permissions CSV files containing joined results are created with (before the umask is applied)
+#define RESULTS_CSV_FILE_MODE 0666
 // Format string used to inform user where the table join result is being written to.
 #define WRITING_TABLE_TO_FILE_MSG "Currently writing results table to '%s' on disk...\n\n"
+// Format string used to inform user where and by how many threads the table join result is being written.
+#define WRITING_TABLE_TO_FILE_IN_PARALLEL_MSG "Currently writing results table to '%s' on disk"\
+                                                " with %u thread(s)...\n\n"
 
 /*
  * Parameter(s):
@@ -141,6 +224,20 @@
  */
 struct Hashed_Customer_Table* read_hashed_customer_table_from_csv_file(const char* file_location);
 
+/*
+ * Building blocks of the CSV table readers, exposed for the component microbenchmarks ("make
+ * microbenchmark"); see "table_utilities.c" for their parameters.  The line parsers split
+ * "file_line" (which they modify) into a customer (or purchases) table row; the record storers
+ * parse "line_read" and store it in the table, growing the table (and "current_table_row_count")
+ * as needed.
+ */
+void csv_file_line_to_customer_table_row(char* file_line, struct Hashed_Customer_Table_Row* customer_table_row);
+void csv_file_line_to_purchases_table_row(char* file_line, struct Purchases_Table_Row* purchases_table_row);
+void hash_and_store_record_in_hashed_customer_table(char* line_read, size_t *current_table_row_count,
+                                                    struct Hashed_Customer_Table** hashed_customer_table);
+void store_record_in_purchases_table(char* line_read, size_t *current_table_row_count,
+                                     struct Purchases_Table** purchases_table);
+
 /*
  * Parameter(s):
  * - const char * file_location: String representation of a relative or absolute filepath of a CSV file
@@ -160,6 +257,81 @@ struct Hashed_Customer_Table* read_hashed_customer_table_from_csv_file(const cha
  */
 struct Purchases_Table* read_purchases_table_from_csv_file(const char* file_location);
 
+/*
+ * Header of a table stored in the binary format.
+ *   - magic --- TABLE_BINARY_FILE_MAGIC, with its terminating null character
+ *   - row_size --- size in bytes of each row, to catch files written with other struct layouts
+ *   - num_records --- number of rows following the header
+ */
+struct Table_Binary_File_Header {
+    char magic[sizeof(TABLE_BINARY_FILE_MAGIC)];
+    unsigned long row_size;
+    unsigned long num_records;
+};
+
+/*
+ * Same as "read_hashed_customer_table_from_csv_file" and "read_purchases_table_from_csv_file",
+ * but for tables stored in the binary format; aborts if the file isn't one.
+ */
+struct Hashed_Customer_Table* read_hashed_customer_table_from_binary_file(const char* file_location);
+struct Purchases_Table* read_purchases_table_from_binary_file(const char* file_location);
+
+/*
+ * Reads a table from either a CSV file or, if "file_location" ends in TABLE_BINARY_FILE_EXTENSION,
+ * a binary file.
+ */
+struct Hashed_Customer_Table* read_hashed_customer_table_from_file(const char* file_location);
+struct Purchases_Table* read_purchases_table_from_file(const char* file_location);
+
+/*
+ * Stores the size and modification time (in nanoseconds) of "file_location" in "file_size"
+ * and "mtime"; both are -1 if the file doesn't exist.  Caches built from a file (e.g. zone maps
+ * and results digests) compare signatures to tell whether they're still up to date.
+ */
+void get_file_signature(const char* file_location, long* file_size, long* mtime);
+
+// Size of the buffer tables read one row at a time are read from disk through
+#define TABLE_FILE_READER_BUFFER_SIZE (1024 * 1024)
+
+/*
+ * Table file read one row at a time, for tables too large to be read into memory whole.
+ *   - file --- table file, positioned at the next row to be read
+ *   - is_binary --- whether the table is stored in the binary format
+ *   - num_binary_rows_left --- number of rows of a binary table file not read yet
+ *   - line, line_buffer_size --- buffer each line of a CSV table file is read into
+ */
+struct Table_File_Reader {
+    FILE* file;
+    bool is_binary;
+    unsigned long num_binary_rows_left;
+    char* line;
+    size_t line_buffer_size;
+};
+
+/*
+ * Opens the customer (or purchases) table stored at "file_location", either as a CSV file or, if
+ * it ends in TABLE_BINARY_FILE_EXTENSION, as a binary file, for reading one row at a time with
+ * "reader"; aborts if the file can't be opened.
+ */
+void open_customer_table_file_reader(const char* file_location, struct Table_File_Reader* reader);
+void open_purchases_table_file_reader(const char* file_location, struct Table_File_Reader* reader);
+
+/*
+ * Reads the next row of the table "reader" was opened on into "customer_table_row" (or
+ * "purchases_table_row"), parsed exactly like the whole-table readers above do.  Returns false,
+ * leaving the row untouched, once every row has been read.  Unlike rows read by
+ * "read_hashed_customer_table_from_file", customer rows come in the order they're stored in.
+ */
+bool read_next_customer_table_row(struct Table_File_Reader* reader,
+                                    struct Hashed_Customer_Table_Row* customer_table_row);
+bool read_next_purchases_table_row(struct Table_File_Reader* reader,
+                                     struct Purchases_Table_Row* purchases_table_row);
+
+/*
+ * Closes the table file of "reader" and frees its line buffer.
+ */
+void close_table_file_reader(struct Table_File_Reader* reader);
+
 /*
  * Parameter(s):
  * - struct Joined_Results_Table * results_table: A pointer to a table containing the equijoined results
@@ -172,6 +344,70 @@ struct Purchases_Table* read_purchases_table_from_csv_file(const char* file_loca
  */
 void write_results_table_to_csv_file(struct Joined_Results_Table* results_table, const char* file_location);
 
+/*
+ * A CSV file joined results are being written to.
+ *   - file_descriptor --- the open file
+ *   - buffer --- RESULTS_CSV_WRITE_BUFFER_SIZE bytes in which rows are formatted before being
+ *                written out to the file
+ *   - buffer_used --- number of bytes in "buffer" not yet written out to the file
+ */
+struct Results_Csv_File {
+    int file_descriptor;
+    char* buffer;
+    size_t buffer_used;
+};
+
+/*
+ * Opens the CSV file at "file_location" for writing (overwriting any old contents) and puts the
+ * joined results table header in front of everything else written to it; rows are then written
+ * with "write_results_table_rows_to_csv_file" and the file closed with "close_results_table_csv_file".
+ */
+struct Results_Csv_File* open_results_table_csv_file(const char* file_location);
+
+/*
+ * Writes rows "first_row" up to (but not including) "first_row" + "num_rows" of "results_table"
+ * to "results_csv_file" in the same format as "write_results_table_to_csv_file", skipping rows
+ * containing NULL values just like it does.
+ */
+void write_results_table_rows_to_csv_file(struct Results_Csv_File* results_csv_file,
+                                            const struct Joined_Results_Table* results_table,
+                                            unsigned long first_row, unsigned long num_rows);
+
+/*
+ * Writes out whatever is still buffered for "results_csv_file", closes the file and
+ * frees "results_csv_file".
+ */
+void close_results_table_csv_file(struct Results_Csv_File* results_csv_file);
+
+/*
+ * Formats rows "first_row" up to (but not including) "first_row" + "num_rows" of "results_table"
+ * into "output" exactly as JOINED_RESULT_TABLE_ROW_FORMAT would, skipping rows containing NULL
+ * values; "output" MUST have room for "num_rows" * MAX_JOINED_RESULT_ROW_CSV_LEN bytes.  Returns
+ * the number of bytes formatted; nothing (not even a null character) is written past them.
+ */
+size_t format_results_table_rows_as_csv(const struct Joined_Results_Table* results_table, unsigned long first_row,
+                                          unsigned long num_rows, char* output);
+
+/*
+ * Number of bytes "format_results_table_rows_as_csv" would format for the same rows, computed
+ * without formatting anything.
+ */
+size_t results_table_rows_csv_length(const struct Joined_Results_Table* results_table, unsigned long first_row,
+                                       unsigned long num_rows);
+
+/*
+ * Parameter(s):
+ * - results_table, file_location: same as for "write_results_table_to_csv_file".
+ * - num_threads: number of threads writing the file; 0 to use one thread per online CPU.
+ *
+ * Writes the exact same file as "write_results_table_to_csv_file", with each thread writing a
+ * contiguous slice of "results_table".  Every thread first measures how many bytes its slice takes
+ * up; a prefix sum over those lengths gives each slice's offset in the file, and every thread then
+ * formats its slice one RESULTS_CSV_WRITE_BUFFER_SIZE buffer at a time and "pwrite"s it in place.
+ */
+void write_results_table_to_csv_file_parallel(struct Joined_Results_Table* results_table, const char* file_location,
+                                                unsigned int num_threads);
+
 /*
  * The following three functions each prints out to screen the
  * contents of the table specified by the struct parameter.
@@ -186,15 +422,20 @@ void print_joined_results_table(struct Joined_Results_Table* joined_results_tabl
 #define ASSERTION_PASSED_INFORM_USER "Congratulations, both of your tables are identical in content!\n\n"
 /*
  * Assert equality between two equijoin results tables on disk,
- *   where each table is represented by a CSV file on disk.
+ *   where each table is represented by a CSV file on disk; the
+ *   files are compared in parallel by "compare_results_table_files"
+ *   (see "results_verifier.h"), which reports the first difference.
  * Parameter details:
  *     - first_equijoin_result_table_file: the file containing the first equijoin 
  *                                          result table to be tested for equality.
  *     - second_equijoin_result_table_file: the file containing the second equijoin
  *                                          result table to be tested for equality.
+ *     - is_order_insensitive: whether both tables only have to hold the same rows
+ *                             in any order (true) instead of in the same order (false).
  */
 void assert_equijoin_results_tables_equality(const char* first_equijoin_result_table_file,
-                                             const char* second_equijoin_result_table_file);
+                                             const char* second_equijoin_result_table_file,
+                                             bool is_order_insensitive);
 
 
 
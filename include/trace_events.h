@@ -0,0 +1,114 @@
+
+// =================================================================================================
+//
+// File description:
+// Header file for tracing the host program as a timeline: spans of host phases (reading, parsing,
+// building, probing, writing, verifying) are recorded along with the thread that ran them, OpenCL
+// commands recorded in profiling reports are moved from the device's clock onto the host's, and
+// everything is written as a Chrome/Perfetto trace-event JSON document (open it in
+// "chrome://tracing" or "https://ui.perfetto.dev").  Nothing is recorded until "start_tracing".
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <stdbool.h>
+#include "opencl_profiling.h"
+
+// Maximum number of spans that can be recorded in a single trace; any more are dropped
+#define MAX_TRACE_EVENTS 8192
+// Maximum length of the name of each span recorded
+#define TRACE_EVENT_NAME_MAX_LEN 64
+
+// Categories of host spans, shown (and filterable) as such in trace viewers
+#define TRACE_CATEGORY_READ "read"
+#define TRACE_CATEGORY_PARSE "parse"
+#define TRACE_CATEGORY_BUILD "build"
+#define TRACE_CATEGORY_PROBE "probe"
+#define TRACE_CATEGORY_WRITE "write"
+#define TRACE_CATEGORY_VERIFY "verify"
+// Category of OpenCL commands, whose spans are named after their profiling phase
+#define TRACE_CATEGORY_OPENCL "opencl"
+
+/*
+ * Trace viewers group spans by process, then by thread: host threads go under the host "process"
+ * by their thread ID, and OpenCL commands under the device "process", one "thread" per profiling
+ * phase (upload, kernel, readback) so that overlapping commands stay apart.
+ */
+#define TRACE_HOST_PROCESS_ID 1
+#define TRACE_DEVICE_PROCESS_ID 2
+
+// Messages informing user of the trace
+#define TRACE_DEVICE_CLOCK_MSG ">>> OpenCL device clock mapped onto the host clock with %s (offset %lld ns)\n"
+#define TRACE_EVENTS_DROPPED_MSG ">>> Trace ran out of room for %u span(s); raise MAX_TRACE_EVENTS to keep them\n"
+#define TRACE_JSON_MSG "Currently writing trace of %u span(s) to '%s' on disk...\n\n"
+
+/*
+ * How to move device timestamps of a device's OpenCL commands onto the host clock of the trace.
+ *   - offset_nanosecs --- nanoseconds to add to a device timestamp to get the host timestamp
+ *   - is_calibrated --- whether the offset is known; commands aren't traced otherwise
+ */
+struct Trace_Device_Clock {
+    long long offset_nanosecs;
+    bool is_calibrated;
+};
+
+/*
+ * Starts recording every span from now on; trace timestamps count from this moment.
+ */
+void start_tracing(void);
+
+/*
+ * Returns whether "start_tracing" was called.
+ */
+bool is_tracing(void);
+
+/*
+ * Returns the current time of the host clock of the trace (monotonic) in nanoseconds; call it when
+ * a span begins and pass it to "record_trace_span" when it ends.
+ */
+unsigned long trace_clock_nanosecs(void);
+
+/*
+ * Parameter details:
+ *   - category --- TRACE_CATEGORY_* the span belongs to
+ *   - name --- what the span did (e.g. "write slice"); truncated to TRACE_EVENT_NAME_MAX_LEN
+ *   - start_nanosecs --- "trace_clock_nanosecs" when the span began
+ *
+ * Records a span of the calling thread that began at "start_nanosecs" and ends now; does nothing
+ * if not tracing.  Safe to call from any thread.
+ */
+void record_trace_span(const char* category, const char* name, unsigned long start_nanosecs);
+
+/*
+ * Measures the offset between the clock of the device of "queue" (which MUST have profiling
+ * enabled) and the host clock of the trace into "clock": with "clGetDeviceAndHostTimer" if the
+ * device supports it, or else from the end of a marker command waited for by the host (which
+ * makes commands appear up to the latency of that wait late).  Does nothing if not tracing.
+ */
+void calibrate_trace_device_clock(cl_command_queue queue, struct Trace_Device_Clock* clock);
+
+/*
+ * Records a span for every OpenCL command of "report", from when it started executing to when
+ * it ended on the device, moved onto the host clock with "clock"; does nothing if not tracing or
+ * if "clock" wasn't calibrated.
+ */
+void record_opencl_profiling_trace(const struct Opencl_Profiling_Report* report,
+                                     const struct Trace_Device_Clock* clock);
+
+/*
+ * Writes every span recorded so far as a Chrome trace-event JSON document to "file_location";
+ * old contents of the file WILL BE OVERWRITTEN.  Does nothing if not tracing.
+ */
+void write_trace_to_json_file(const char* file_location);
+
+#endif // TRACE_EVENTS_H
+// =================================================================================================
@@ -0,0 +1,589 @@
+
+/*
+ * File description: Writes an equijoin results table to disk as an Apache Arrow IPC file.
+ *   Implementation based on https://arrow.apache.org/docs/format/Columnar.html#ipc-file-format
+ *   and the flatbuffers binary format described at https://flatbuffers.dev/internals/
+ */
+
+// Necessary libraries and headers for functions
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include "data_structures_opencl.h"
+#include "arrow_results_writer.h"
+
+// Magic bytes at the start (padded to 8 bytes) and at the very end of an Arrow IPC file
+#define ARROW_FILE_MAGIC "ARROW1"
+#define ARROW_FILE_MAGIC_LEN 6
+// Marks the start of every encapsulated message, and (followed by a zero length) the end of the stream
+#define ARROW_CONTINUATION_MARKER 0xFFFFFFFFu
+// Values from the Arrow flatbuffers schema (Schema.fbs and Message.fbs)
+#define ARROW_METADATA_VERSION_V5 4
+#define ARROW_ENDIANNESS_LITTLE 0
+#define ARROW_MESSAGE_HEADER_SCHEMA 1
+#define ARROW_MESSAGE_HEADER_RECORD_BATCH 3
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_UTF8 5
+#define ARROW_TYPE_FIXED_SIZE_BINARY 15
+// Bit width of every integer column
+#define ARROW_INT_BIT_WIDTH 64
+
+// Number of columns written, and number of buffers (validity buffers included) all columns have in total
+#define ARROW_NUM_COLUMNS JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT
+#define ARROW_NUM_BUFFERS 11
+// Most fields in any flatbuffers table written
+#define MAX_FLATBUFFER_TABLE_FIELDS 8
+// Size of the flatbuffers "uoffset_t" type
+#define FLATBUFFER_OFFSET_SIZE 4
+
+/*
+ * Kinds of column written; every column is non-nullable, so each one's
+ * validity buffer is empty.
+ */
+enum Arrow_Column_Type {
+    ARROW_COLUMN_INT64 = 0,
+    ARROW_COLUMN_UTF8,
+    ARROW_COLUMN_FIXED_SIZE_BINARY
+};
+
+/*
+ * Name and type of every column, in the same order as the columns of
+ * JOINED_RESULT_TABLE_HEADER.
+ */
+static const char* const ARROW_COLUMN_NAMES[ARROW_NUM_COLUMNS] = {
+    "epochTimePurchased", "customerID", "customerName", "purchaseEAN13", "purchaseQuantity"
+};
+static const enum Arrow_Column_Type ARROW_COLUMN_TYPES[ARROW_NUM_COLUMNS] = {
+    ARROW_COLUMN_INT64, ARROW_COLUMN_INT64, ARROW_COLUMN_UTF8, ARROW_COLUMN_FIXED_SIZE_BINARY, ARROW_COLUMN_INT64
+};
+
+/*
+ * Flatbuffer being built front to back; every object only ever refers to objects
+ * written after it, so that offsets can be patched in once their target is written.
+ *   - bytes --- contents of the flatbuffer so far
+ *   - size --- number of bytes in "bytes" used
+ *   - capacity --- number of bytes "bytes" can hold
+ */
+struct Flatbuffer_Builder {
+    unsigned char* bytes;
+    size_t size;
+    size_t capacity;
+};
+
+/*
+ * A scalar field of a flatbuffers table.
+ *   - size --- size of the field in bytes (1, 2, 4 or 8), or 0 if the field is absent;
+ *              offset fields have a size of FLATBUFFER_OFFSET_SIZE and get patched later
+ *   - value --- value of the field
+ */
+struct Flatbuffer_Field {
+    unsigned char size;
+    uint64_t value;
+};
+
+/*
+ * Column buffers of one record batch.
+ *   - num_rows --- number of rows in the record batch
+ *   - time_of_purchase, customer_id, quantity_purchased --- int64 column values
+ *   - first_name_offsets, first_name_data --- utf8 column offsets and characters
+ *   - ean13 --- fixed-size binary column values
+ */
+struct Arrow_Record_Batch {
+    unsigned long num_rows;
+    int64_t* time_of_purchase;
+    int64_t* customer_id;
+    int64_t* quantity_purchased;
+    int32_t* first_name_offsets;
+    char* first_name_data;
+    char* ean13;
+};
+
+/*
+ * Location of one record batch, as listed in the file footer ("Block" struct of File.fbs).
+ *   - offset --- offset of the record batch's message from the start of the file
+ *   - metadata_len --- length of its metadata, padding, continuation marker and length included
+ *   - padding --- unused; keeps "body_len" 8-byte aligned like the flatbuffers struct
+ *   - body_len --- length of its body
+ */
+struct Arrow_Block {
+    int64_t offset;
+    int32_t metadata_len;
+    int32_t padding;
+    int64_t body_len;
+};
+
+// =================================================================================================
+
+static void flatbuffer_reserve(struct Flatbuffer_Builder* builder, size_t num_bytes) {
+
+    if (builder->size + num_bytes > builder->capacity) {
+        while (builder->size + num_bytes > builder->capacity) {
+            builder->capacity = (builder->capacity == 0) ? 1024 : builder->capacity * 2;
+        }
+        builder->bytes = realloc(builder->bytes, builder->capacity);
+        assert(builder->bytes != NULL);
+    }
+
+}
+
+// Appends "num_bytes" bytes of "data" (or zero bytes if NULL); returns where they were put
+static size_t flatbuffer_append(struct Flatbuffer_Builder* builder, const void* data, size_t num_bytes) {
+
+    flatbuffer_reserve(builder, num_bytes);
+    const size_t position = builder->size;
+    if (data != NULL) {
+        memcpy(builder->bytes + position, data, num_bytes);
+    } else {
+        memset(builder->bytes + position, 0, num_bytes);
+    }
+    builder->size += num_bytes;
+    return position;
+
+}
+
+// Pads the flatbuffer with zero bytes until its size is a multiple of "alignment"
+static void flatbuffer_pad(struct Flatbuffer_Builder* builder, size_t alignment) {
+
+    while (builder->size % alignment != 0) {
+        flatbuffer_append(builder, NULL, 1);
+    }
+
+}
+
+// Points the offset field at "field_position" to the object at "target_position"
+static void flatbuffer_patch_offset(struct Flatbuffer_Builder* builder, size_t field_position,
+                                      size_t target_position) {
+
+    // Flatbuffers offsets are unsigned; targets MUST come after the field
+    assert(target_position > field_position);
+    const uint32_t offset = (uint32_t)(target_position - field_position);
+    memcpy(builder->bytes + field_position, &offset, sizeof(offset));
+
+}
+
+/*
+ * Writes a vtable followed by a table with "num_fields" fields, stores the position of each
+ * field in "field_positions" (if not NULL), and returns the position of the table.
+ */
+static size_t flatbuffer_write_table(struct Flatbuffer_Builder* builder, const struct Flatbuffer_Field* fields,
+                                       unsigned int num_fields, size_t* field_positions) {
+
+    assert(num_fields <= MAX_FLATBUFFER_TABLE_FIELDS);
+
+    // Lay out the table: the offset to its vtable, then each field aligned to its own size
+    uint16_t vtable[2 + MAX_FLATBUFFER_TABLE_FIELDS];
+    size_t table_size = sizeof(int32_t);
+    for (unsigned int field_index = 0; field_index < num_fields; ++field_index) {
+        if (fields[field_index].size == 0) {
+            vtable[2 + field_index] = 0;
+            continue;
+        }
+        table_size = (table_size + fields[field_index].size - 1) / fields[field_index].size * fields[field_index].size;
+        vtable[2 + field_index] = (uint16_t) table_size;
+        table_size += fields[field_index].size;
+    }
+    vtable[0] = (uint16_t)((2 + num_fields) * sizeof(uint16_t));
+    vtable[1] = (uint16_t) table_size;
+
+    flatbuffer_pad(builder, sizeof(uint16_t));
+    const size_t vtable_position = flatbuffer_append(builder, vtable, vtable[0]);
+
+    // Align the table for its widest possible field
+    flatbuffer_pad(builder, sizeof(uint64_t));
+    const size_t table_position = flatbuffer_append(builder, NULL, table_size);
+    const int32_t vtable_offset = (int32_t)(table_position - vtable_position);
+    memcpy(builder->bytes + table_position, &vtable_offset, sizeof(vtable_offset));
+
+    for (unsigned int field_index = 0; field_index < num_fields; ++field_index) {
+        if (fields[field_index].size == 0) {
+            continue;
+        }
+        const size_t field_position = table_position + vtable[2 + field_index];
+        // Host is little-endian (as asserted when writing the file); copy the low bytes of the value
+        memcpy(builder->bytes + field_position, &(fields[field_index].value), fields[field_index].size);
+        if (field_positions != NULL) {
+            field_positions[field_index] = field_position;
+        }
+    }
+
+    return table_position;
+
+}
+
+// Writes a string; returns its position
+static size_t flatbuffer_write_string(struct Flatbuffer_Builder* builder, const char* string) {
+
+    const uint32_t string_len = (uint32_t) strlen(string);
+    flatbuffer_pad(builder, sizeof(uint32_t));
+    const size_t string_position = flatbuffer_append(builder, &string_len, sizeof(string_len));
+    // Strings are null-terminated in flatbuffers
+    flatbuffer_append(builder, string, string_len + 1);
+    return string_position;
+
+}
+
+// Writes a vector of "num_elements" structs of "element_size" bytes each, aligned to 8 bytes; returns its position
+static size_t flatbuffer_write_struct_vector(struct Flatbuffer_Builder* builder, const void* elements,
+                                               uint32_t num_elements, size_t element_size) {
+
+    // Elements (right after the 4 byte length) have to be aligned to 8 bytes
+    flatbuffer_pad(builder, sizeof(uint32_t));
+    if ((builder->size + sizeof(uint32_t)) % sizeof(uint64_t) != 0) {
+        flatbuffer_append(builder, NULL, sizeof(uint32_t));
+    }
+    const size_t vector_position = flatbuffer_append(builder, &num_elements, sizeof(num_elements));
+    flatbuffer_append(builder, elements, num_elements * element_size);
+    return vector_position;
+
+}
+
+// Writes a vector of "num_elements" offsets, all to be patched later; returns its position
+static size_t flatbuffer_write_offset_vector(struct Flatbuffer_Builder* builder, uint32_t num_elements) {
+
+    flatbuffer_pad(builder, sizeof(uint32_t));
+    const size_t vector_position = flatbuffer_append(builder, &num_elements, sizeof(num_elements));
+    flatbuffer_append(builder, NULL, num_elements * FLATBUFFER_OFFSET_SIZE);
+    return vector_position;
+
+}
+
+// Position of element "element_index" of the offset vector at "vector_position"
+static inline size_t flatbuffer_offset_vector_element(size_t vector_position, unsigned int element_index) {
+
+    return vector_position + sizeof(uint32_t) + element_index * FLATBUFFER_OFFSET_SIZE;
+
+}
+
+// Writes an Arrow "Field" table describing column "column_index"; returns its position
+static size_t arrow_write_field(struct Flatbuffer_Builder* builder, unsigned int column_index) {
+
+    uint8_t type_type;
+    switch (ARROW_COLUMN_TYPES[column_index]) {
+        case ARROW_COLUMN_INT64: type_type = ARROW_TYPE_INT; break;
+        case ARROW_COLUMN_UTF8: type_type = ARROW_TYPE_UTF8; break;
+        default: type_type = ARROW_TYPE_FIXED_SIZE_BINARY; break;
+    }
+
+    // name, nullable, type_type, type, dictionary, children
+    const struct Flatbuffer_Field field_fields[] = {
+        { FLATBUFFER_OFFSET_SIZE, 0 }, { sizeof(uint8_t), 0 }, { sizeof(uint8_t), type_type },
+        { FLATBUFFER_OFFSET_SIZE, 0 }, { 0, 0 }, { FLATBUFFER_OFFSET_SIZE, 0 }
+    };
+    size_t field_positions[6];
+    const size_t field_position = flatbuffer_write_table(builder, field_fields, 6, field_positions);
+
+    flatbuffer_patch_offset(builder, field_positions[0],
+                              flatbuffer_write_string(builder, ARROW_COLUMN_NAMES[column_index]));
+
+    size_t type_position;
+    if (ARROW_COLUMN_TYPES[column_index] == ARROW_COLUMN_INT64) {
+        // bitWidth, is_signed; values are signed, just like "%ld" prints them
+        const struct Flatbuffer_Field int_fields[] = { { sizeof(int32_t), ARROW_INT_BIT_WIDTH }, { sizeof(uint8_t), 1 } };
+        type_position = flatbuffer_write_table(builder, int_fields, 2, NULL);
+    } else if (ARROW_COLUMN_TYPES[column_index] == ARROW_COLUMN_UTF8) {
+        type_position = flatbuffer_write_table(builder, NULL, 0, NULL);
+    } else {
+        // byteWidth
+        const struct Flatbuffer_Field binary_fields[] = { { sizeof(int32_t), ARROW_EAN13_BYTE_WIDTH } };
+        type_position = flatbuffer_write_table(builder, binary_fields, 1, NULL);
+    }
+    flatbuffer_patch_offset(builder, field_positions[3], type_position);
+
+    // No column has any children
+    flatbuffer_patch_offset(builder, field_positions[5], flatbuffer_write_offset_vector(builder, 0));
+
+    return field_position;
+
+}
+
+// Writes an Arrow "Schema" table describing every column; returns its position
+static size_t arrow_write_schema(struct Flatbuffer_Builder* builder) {
+
+    // endianness, fields
+    const struct Flatbuffer_Field schema_fields[] = {
+        { sizeof(int16_t), ARROW_ENDIANNESS_LITTLE }, { FLATBUFFER_OFFSET_SIZE, 0 }
+    };
+    size_t field_positions[2];
+    const size_t schema_position = flatbuffer_write_table(builder, schema_fields, 2, field_positions);
+
+    const size_t fields_vector_position = flatbuffer_write_offset_vector(builder, ARROW_NUM_COLUMNS);
+    flatbuffer_patch_offset(builder, field_positions[1], fields_vector_position);
+    for (unsigned int column_index = 0; column_index < ARROW_NUM_COLUMNS; ++column_index) {
+        flatbuffer_patch_offset(builder, flatbuffer_offset_vector_element(fields_vector_position, column_index),
+                                  arrow_write_field(builder, column_index));
+    }
+
+    return schema_position;
+
+}
+
+/*
+ * Builds an Arrow "Message" flatbuffer whose header is a "Schema" (if "record_batch" is NULL)
+ * or a "RecordBatch" describing "record_batch", whose body takes up "body_len" bytes and whose
+ * buffers are described by "buffers" (pairs of offset and length within the body).
+ */
+static void arrow_build_message(struct Flatbuffer_Builder* builder, const struct Arrow_Record_Batch* record_batch,
+                                  const int64_t* buffers, int64_t body_len) {
+
+    builder->size = 0;
+    // Root offset to the "Message" table
+    const size_t root_position = flatbuffer_append(builder, NULL, FLATBUFFER_OFFSET_SIZE);
+
+    // version, header_type, header, bodyLength
+    const struct Flatbuffer_Field message_fields[] = {
+        { sizeof(int16_t), ARROW_METADATA_VERSION_V5 },
+        { sizeof(uint8_t), (record_batch == NULL) ? ARROW_MESSAGE_HEADER_SCHEMA : ARROW_MESSAGE_HEADER_RECORD_BATCH },
+        { FLATBUFFER_OFFSET_SIZE, 0 }, { sizeof(int64_t), (uint64_t) body_len }
+    };
+    size_t message_field_positions[4];
+    flatbuffer_patch_offset(builder, root_position,
+                              flatbuffer_write_table(builder, message_fields, 4, message_field_positions));
+
+    if (record_batch == NULL) {
+        flatbuffer_patch_offset(builder, message_field_positions[2], arrow_write_schema(builder));
+        return;
+    }
+
+    // length, nodes, buffers
+    const struct Flatbuffer_Field record_batch_fields[] = {
+        { sizeof(int64_t), (uint64_t) record_batch->num_rows }, { FLATBUFFER_OFFSET_SIZE, 0 },
+        { FLATBUFFER_OFFSET_SIZE, 0 }
+    };
+    size_t record_batch_field_positions[3];
+    flatbuffer_patch_offset(builder, message_field_positions[2],
+                              flatbuffer_write_table(builder, record_batch_fields, 3, record_batch_field_positions));
+
+    // One "FieldNode" (length, null_count) per column; no column has any NULL values
+    int64_t field_nodes[ARROW_NUM_COLUMNS][2];
+    for (unsigned int column_index = 0; column_index < ARROW_NUM_COLUMNS; ++column_index) {
+        field_nodes[column_index][0] = (int64_t) record_batch->num_rows;
+        field_nodes[column_index][1] = 0;
+    }
+    flatbuffer_patch_offset(builder, record_batch_field_positions[1],
+                              flatbuffer_write_struct_vector(builder, field_nodes, ARROW_NUM_COLUMNS,
+                                                               sizeof(field_nodes[0])));
+    flatbuffer_patch_offset(builder, record_batch_field_positions[2],
+                              flatbuffer_write_struct_vector(builder, buffers, ARROW_NUM_BUFFERS,
+                                                               2 * sizeof(int64_t)));
+
+}
+
+/*
+ * Writes "num_bytes" bytes of "bytes" (or zero bytes if NULL) to "arrow_file", and adds them
+ * to "*file_offset".
+ */
+static void arrow_file_write(FILE* arrow_file, const void* bytes, size_t num_bytes, int64_t* file_offset) {
+
+    static const unsigned char zero_bytes[ARROW_BUFFER_ALIGNMENT] = { 0 };
+
+    if (bytes == NULL) {
+        assert(num_bytes <= sizeof(zero_bytes));
+        bytes = zero_bytes;
+    }
+    if (num_bytes > 0) {
+        size_t num_bytes_written = fwrite(bytes, 1, num_bytes, arrow_file);
+        // Make sure there are no problems writing the file
+        assert(num_bytes_written == num_bytes);
+    }
+    *file_offset += (int64_t) num_bytes;
+
+}
+
+// Number of zero bytes needed after "num_bytes" bytes to reach a multiple of "alignment"
+static inline size_t padding_len(int64_t num_bytes, size_t alignment) {
+
+    return (size_t)((alignment - (size_t)(num_bytes % (int64_t) alignment)) % alignment);
+
+}
+
+/*
+ * Writes the metadata in "builder" as an encapsulated message (continuation marker, metadata
+ * length, metadata padded to 8 bytes); returns the number of bytes written.
+ */
+static int32_t arrow_write_encapsulated_metadata(FILE* arrow_file, const struct Flatbuffer_Builder* builder,
+                                                   int64_t* file_offset) {
+
+    const uint32_t continuation_marker = ARROW_CONTINUATION_MARKER;
+    const int32_t metadata_len = (int32_t)(builder->size + padding_len((int64_t) builder->size, sizeof(uint64_t)));
+
+    arrow_file_write(arrow_file, &continuation_marker, sizeof(continuation_marker), file_offset);
+    arrow_file_write(arrow_file, &metadata_len, sizeof(metadata_len), file_offset);
+    arrow_file_write(arrow_file, builder->bytes, builder->size, file_offset);
+    arrow_file_write(arrow_file, NULL, (size_t) metadata_len - builder->size, file_offset);
+
+    return (int32_t)(sizeof(continuation_marker) + sizeof(metadata_len)) + metadata_len;
+
+}
+
+/*
+ * Gathers up to ARROW_RECORD_BATCH_MAX_ROWS rows of "results_table" containing no NULL values,
+ * starting at "*row_index", into the column buffers of "record_batch"; "*row_index" is left at
+ * the first row not yet looked at.
+ */
+static void gather_arrow_record_batch(const struct Joined_Results_Table* results_table, unsigned long* row_index,
+                                        struct Arrow_Record_Batch* record_batch) {
+
+    unsigned long num_rows = 0;
+    int32_t first_name_data_len = 0;
+    record_batch->first_name_offsets[0] = 0;
+
+    for (; *row_index < results_table->num_records && num_rows < ARROW_RECORD_BATCH_MAX_ROWS; ++(*row_index)) {
+
+        const struct Joined_Results_Table_Row* row = &(results_table->table[*row_index]);
+
+        // Skip over table records where customer id and customer name are null values
+        if (row->customer_id_customer == NULL_CUSTOMER_ID &&
+            row->first_name_customer[NULL_CHARACTER_POS] == NULL_CUSTOMER_NAME) {
+            continue;
+        }
+
+        record_batch->time_of_purchase[num_rows] = (int64_t) row->time_of_purchase;
+        record_batch->customer_id[num_rows] = (int64_t) row->customer_id_customer;
+        record_batch->quantity_purchased[num_rows] = (int64_t) row->quantity_purchased;
+        const size_t first_name_len = strnlen(row->first_name_customer, FIRST_NAME_MAX_LEN);
+        memcpy(record_batch->first_name_data + first_name_data_len, row->first_name_customer, first_name_len);
+        first_name_data_len += (int32_t) first_name_len;
+        record_batch->first_name_offsets[num_rows + 1] = first_name_data_len;
+        // Pads barcodes shorter than ARROW_EAN13_BYTE_WIDTH with zero bytes
+        strncpy(record_batch->ean13 + num_rows * ARROW_EAN13_BYTE_WIDTH, row->ean13, ARROW_EAN13_BYTE_WIDTH);
+        ++num_rows;
+
+    }
+
+    record_batch->num_rows = num_rows;
+
+}
+
+void write_results_table_to_arrow_file(struct Joined_Results_Table* results_table, const char* file_location) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
+    assert(results_table != NULL);
+    assert(results_table->table != NULL);
+    // Column buffers are written as they are in memory, and Arrow files here declare little-endian data
+    const uint16_t endianness_probe = 1;
+    assert(*(const unsigned char*) &endianness_probe == 1);
+
+    FILE* arrow_file = fopen(file_location, "wb");
+    // Inform user if file didn't open correctly and abort program
+    if (arrow_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    // Inform user this program is beginning to write table contents to disk.
+    printf(WRITING_TABLE_TO_ARROW_FILE_MSG, file_location);
+
+    struct Flatbuffer_Builder builder = { NULL, 0, 0 };
+    int64_t file_offset = 0;
+
+    // Magic bytes padded to 8 bytes, then the schema
+    arrow_file_write(arrow_file, ARROW_FILE_MAGIC, ARROW_FILE_MAGIC_LEN, &file_offset);
+    arrow_file_write(arrow_file, NULL, padding_len(file_offset, sizeof(uint64_t)), &file_offset);
+    arrow_build_message(&builder, NULL, NULL, 0);
+    arrow_write_encapsulated_metadata(arrow_file, &builder, &file_offset);
+
+    struct Arrow_Record_Batch record_batch;
+    record_batch.time_of_purchase = malloc(ARROW_RECORD_BATCH_MAX_ROWS * sizeof(int64_t));
+    record_batch.customer_id = malloc(ARROW_RECORD_BATCH_MAX_ROWS * sizeof(int64_t));
+    record_batch.quantity_purchased = malloc(ARROW_RECORD_BATCH_MAX_ROWS * sizeof(int64_t));
+    record_batch.first_name_offsets = malloc((ARROW_RECORD_BATCH_MAX_ROWS + 1) * sizeof(int32_t));
+    record_batch.first_name_data = malloc(ARROW_RECORD_BATCH_MAX_ROWS * FIRST_NAME_MAX_LEN);
+    record_batch.ean13 = malloc(ARROW_RECORD_BATCH_MAX_ROWS * ARROW_EAN13_BYTE_WIDTH);
+    assert(record_batch.time_of_purchase != NULL && record_batch.customer_id != NULL &&
+           record_batch.quantity_purchased != NULL && record_batch.first_name_offsets != NULL &&
+           record_batch.first_name_data != NULL && record_batch.ean13 != NULL);
+
+    struct Arrow_Block* blocks = NULL;
+    unsigned int num_blocks = 0;
+
+    unsigned long row_index = 0;
+    do {
+
+        gather_arrow_record_batch(results_table, &row_index, &record_batch);
+        // A table containing nothing but NULL values still gets one empty record batch
+        if (record_batch.num_rows == 0 && num_blocks > 0) {
+            break;
+        }
+
+        // Body buffers, in column order; every validity buffer is empty
+        const int64_t num_rows = (int64_t) record_batch.num_rows;
+        const void* buffer_data[ARROW_NUM_BUFFERS] = {
+            NULL, record_batch.time_of_purchase, NULL, record_batch.customer_id,
+            NULL, record_batch.first_name_offsets, record_batch.first_name_data,
+            NULL, record_batch.ean13, NULL, record_batch.quantity_purchased
+        };
+        const int64_t buffer_lens[ARROW_NUM_BUFFERS] = {
+            0, num_rows * (int64_t) sizeof(int64_t), 0, num_rows * (int64_t) sizeof(int64_t),
+            0, (num_rows + 1) * (int64_t) sizeof(int32_t), record_batch.first_name_offsets[num_rows],
+            0, num_rows * ARROW_EAN13_BYTE_WIDTH, 0, num_rows * (int64_t) sizeof(int64_t)
+        };
+        int64_t buffers[ARROW_NUM_BUFFERS][2];
+        int64_t body_len = 0;
+        for (unsigned int buffer_index = 0; buffer_index < ARROW_NUM_BUFFERS; ++buffer_index) {
+            buffers[buffer_index][0] = body_len;
+            buffers[buffer_index][1] = buffer_lens[buffer_index];
+            body_len += buffer_lens[buffer_index] + (int64_t) padding_len(buffer_lens[buffer_index],
+                                                                           ARROW_BUFFER_ALIGNMENT);
+        }
+
+        blocks = realloc(blocks, (num_blocks + 1) * sizeof(*blocks));
+        assert(blocks != NULL);
+        blocks[num_blocks].offset = file_offset;
+        blocks[num_blocks].padding = 0;
+        blocks[num_blocks].body_len = body_len;
+
+        arrow_build_message(&builder, &record_batch, &(buffers[0][0]), body_len);
+        blocks[num_blocks].metadata_len = arrow_write_encapsulated_metadata(arrow_file, &builder, &file_offset);
+        // Body starts right after the metadata, which ends 8-byte aligned; align it further
+        for (unsigned int buffer_index = 0; buffer_index < ARROW_NUM_BUFFERS; ++buffer_index) {
+            arrow_file_write(arrow_file, buffer_data[buffer_index], (size_t) buffer_lens[buffer_index], &file_offset);
+            arrow_file_write(arrow_file, NULL, padding_len(buffer_lens[buffer_index], ARROW_BUFFER_ALIGNMENT),
+                               &file_offset);
+        }
+        ++num_blocks;
+
+    } while (row_index < results_table->num_records);
+
+    // End-of-stream marker
+    const uint32_t end_of_stream[2] = { ARROW_CONTINUATION_MARKER, 0 };
+    arrow_file_write(arrow_file, end_of_stream, sizeof(end_of_stream), &file_offset);
+
+    // Footer: version, schema, dictionaries, recordBatches
+    builder.size = 0;
+    const size_t root_position = flatbuffer_append(&builder, NULL, FLATBUFFER_OFFSET_SIZE);
+    const struct Flatbuffer_Field footer_fields[] = {
+        { sizeof(int16_t), ARROW_METADATA_VERSION_V5 }, { FLATBUFFER_OFFSET_SIZE, 0 },
+        { FLATBUFFER_OFFSET_SIZE, 0 }, { FLATBUFFER_OFFSET_SIZE, 0 }
+    };
+    size_t footer_field_positions[4];
+    flatbuffer_patch_offset(&builder, root_position,
+                              flatbuffer_write_table(&builder, footer_fields, 4, footer_field_positions));
+    flatbuffer_patch_offset(&builder, footer_field_positions[1], arrow_write_schema(&builder));
+    flatbuffer_patch_offset(&builder, footer_field_positions[2],
+                              flatbuffer_write_struct_vector(&builder, NULL, 0, sizeof(*blocks)));
+    flatbuffer_patch_offset(&builder, footer_field_positions[3],
+                              flatbuffer_write_struct_vector(&builder, blocks, num_blocks, sizeof(*blocks)));
+
+    const int32_t footer_len = (int32_t) builder.size;
+    arrow_file_write(arrow_file, builder.bytes, builder.size, &file_offset);
+    arrow_file_write(arrow_file, &footer_len, sizeof(footer_len), &file_offset);
+    arrow_file_write(arrow_file, ARROW_FILE_MAGIC, ARROW_FILE_MAGIC_LEN, &file_offset);
+
+    // Done writing to file; close it
+    int func_status = fclose(arrow_file);
+    assert(func_status == 0);
+
+    free(blocks);
+    free(builder.bytes);
+    free(record_batch.time_of_purchase);
+    free(record_batch.customer_id);
+    free(record_batch.quantity_purchased);
+    free(record_batch.first_name_offsets);
+    free(record_batch.first_name_data);
+    free(record_batch.ean13);
+
+}
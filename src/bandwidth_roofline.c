@@ -0,0 +1,401 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for measuring the peak bandwidth of main memory and
+// of transfers to, from and within an OpenCL device, and for reporting each phase of the host
+// program against the peak bounding it.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <bsd/string.h>
+#include "monotonic_clock.h"
+#include "host_threads.h"
+#include "bandwidth_roofline.h"
+
+// Name of each peak, indexed by "enum Bandwidth_Peak"
+static const char* const bandwidth_peak_names[NUM_BANDWIDTH_PEAKS] = {
+    "host_copy", "host_triad", "host_to_device", "device_to_host", "device_copy"
+};
+
+/*
+ * STREAM kernels run by the threads measuring main memory bandwidth; initializing the arrays is
+ * done by the same threads, so that every page is first touched by the thread streaming it.
+ */
+enum Stream_Kernel {
+    STREAM_KERNEL_INIT = 0,
+    STREAM_KERNEL_COPY,
+    STREAM_KERNEL_TRIAD
+};
+
+/*
+ * Slice of the STREAM arrays a single thread runs a kernel over.
+ *   - thread --- thread running the kernel
+ *   - a, b, c --- the STREAM arrays
+ *   - first_element, end_element --- elements of the slice, the last one excluded
+ *   - kernel --- kernel to run
+ */
+struct Stream_Slice {
+    pthread_t thread;
+    double* a;
+    double* b;
+    double* c;
+    unsigned long first_element;
+    unsigned long end_element;
+    enum Stream_Kernel kernel;
+};
+
+// =================================================================================================
+
+static void* run_stream_slice(void* slice_arg) {
+
+    struct Stream_Slice* slice = slice_arg;
+    double* restrict a = slice->a;
+    double* restrict b = slice->b;
+    double* restrict c = slice->c;
+    switch (slice->kernel) {
+        case STREAM_KERNEL_INIT:
+            for (unsigned long element = slice->first_element; element < slice->end_element; ++element) {
+                a[element] = 1.0;
+                b[element] = 2.0;
+                c[element] = 0.0;
+            }
+            break;
+        case STREAM_KERNEL_COPY:
+            for (unsigned long element = slice->first_element; element < slice->end_element; ++element) {
+                c[element] = a[element];
+            }
+            break;
+        case STREAM_KERNEL_TRIAD:
+            for (unsigned long element = slice->first_element; element < slice->end_element; ++element) {
+                a[element] = b[element] + STREAM_TRIAD_SCALAR * c[element];
+            }
+            break;
+    }
+    return NULL;
+
+}
+
+/*
+ * Runs "kernel" over every element of the STREAM arrays of "slices" with "num_threads" threads;
+ * returns how many seconds it took, threads started and joined included (as in STREAM's
+ * parallel loops).
+ */
+static double run_stream_kernel(struct Stream_Slice* slices, unsigned int num_threads, enum Stream_Kernel kernel) {
+
+    int thread_status;
+    const double start_secs = monotonic_clock_secs();
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].kernel = kernel;
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, run_stream_slice, &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+    }
+    return monotonic_clock_secs() - start_secs;
+
+}
+
+void init_bandwidth_calibration(struct Bandwidth_Calibration* calibration) {
+
+    // No null pointers allowed
+    assert(calibration != NULL);
+
+    for (unsigned int peak = 0; peak < NUM_BANDWIDTH_PEAKS; ++peak) {
+        calibration->bytes_per_sec[peak] = 0.0;
+        calibration->is_measured[peak] = false;
+    }
+
+}
+
+void measure_host_memory_bandwidth(struct Bandwidth_Calibration* calibration, unsigned int num_threads) {
+
+    // No null pointers allowed
+    assert(calibration != NULL);
+
+    num_threads = resolve_num_threads(num_threads);
+
+    double* a = malloc(STREAM_ARRAY_ELEMENTS * sizeof(*a));
+    double* b = malloc(STREAM_ARRAY_ELEMENTS * sizeof(*b));
+    double* c = malloc(STREAM_ARRAY_ELEMENTS * sizeof(*c));
+    assert(a != NULL && b != NULL && c != NULL);
+    struct Stream_Slice* slices = malloc(num_threads * sizeof(*slices));
+    assert(slices != NULL);
+
+    // Every thread streams its own slice of the arrays
+    unsigned long first_element = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].a = a;
+        slices[slice_index].b = b;
+        slices[slice_index].c = c;
+        slices[slice_index].first_element = first_element;
+        first_element += slice_num_rows(STREAM_ARRAY_ELEMENTS, num_threads, slice_index);
+        slices[slice_index].end_element = first_element;
+    }
+    run_stream_kernel(slices, num_threads, STREAM_KERNEL_INIT);
+
+    double best_copy_secs = 0.0, best_triad_secs = 0.0;
+    for (unsigned int repetition = 0; repetition < BANDWIDTH_CALIBRATION_REPETITIONS; ++repetition) {
+        const double copy_secs = run_stream_kernel(slices, num_threads, STREAM_KERNEL_COPY);
+        const double triad_secs = run_stream_kernel(slices, num_threads, STREAM_KERNEL_TRIAD);
+        if (repetition == 0 || copy_secs < best_copy_secs) {
+            best_copy_secs = copy_secs;
+        }
+        if (repetition == 0 || triad_secs < best_triad_secs) {
+            best_triad_secs = triad_secs;
+        }
+    }
+    calibration->bytes_per_sec[BANDWIDTH_PEAK_HOST_COPY] = 2.0 * sizeof(*a) * STREAM_ARRAY_ELEMENTS / best_copy_secs;
+    calibration->is_measured[BANDWIDTH_PEAK_HOST_COPY] = true;
+    calibration->bytes_per_sec[BANDWIDTH_PEAK_HOST_TRIAD] = 3.0 * sizeof(*a) * STREAM_ARRAY_ELEMENTS / best_triad_secs;
+    calibration->is_measured[BANDWIDTH_PEAK_HOST_TRIAD] = true;
+    printf(HOST_BANDWIDTH_CALIBRATION_MSG, BANDWIDTH_CALIBRATION_REPETITIONS, num_threads,
+             (unsigned long) (STREAM_ARRAY_ELEMENTS * sizeof(*a) / (1024ul * 1024ul)),
+             calibration->bytes_per_sec[BANDWIDTH_PEAK_HOST_COPY] / ROOFLINE_BYTES_IN_GB,
+             calibration->bytes_per_sec[BANDWIDTH_PEAK_HOST_TRIAD] / ROOFLINE_BYTES_IN_GB);
+
+    free(slices);
+    free(a);
+    free(b);
+    free(c);
+
+}
+
+// Seconds the finished OpenCL command of "event" spent executing on the device; releases "event"
+static double opencl_command_secs(cl_event event) {
+
+    cl_ulong started, ended;
+    cl_int func_error_code = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(started),
+                                                       &started, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(ended), &ended, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    clReleaseEvent(event);
+    return (double) (ended - started) / PROFILING_NANOSECS_IN_SEC;
+
+}
+
+void measure_device_transfer_bandwidth(cl_context context, cl_command_queue queue,
+                                         struct Bandwidth_Calibration* calibration) {
+
+    // No null pointers allowed
+    assert(calibration != NULL);
+
+    cl_device_id device;
+    cl_int func_error_code = clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    cl_ulong max_alloc_bytes;
+    func_error_code = clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc_bytes),
+                                        &max_alloc_bytes, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    const size_t num_bytes = (DEVICE_TRANSFER_CALIBRATION_BYTES < max_alloc_bytes) ?
+                                DEVICE_TRANSFER_CALIBRATION_BYTES : (size_t) max_alloc_bytes;
+
+    char* host_buffer = malloc(num_bytes);
+    assert(host_buffer != NULL);
+    memset(host_buffer, 1, num_bytes);
+    cl_mem device_buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, num_bytes, NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem device_copy_buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, num_bytes, NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    double best_secs[NUM_BANDWIDTH_PEAKS] = { 0.0 };
+    for (unsigned int repetition = 0; repetition < BANDWIDTH_CALIBRATION_REPETITIONS; ++repetition) {
+        cl_event event;
+        double secs[NUM_BANDWIDTH_PEAKS] = { 0.0 };
+        func_error_code = clEnqueueWriteBuffer(queue, device_buffer, CL_BLOCKING, 0, num_bytes, host_buffer,
+                                                 0, NULL, &event);
+        assert(func_error_code == CL_SUCCESS);
+        secs[BANDWIDTH_PEAK_HOST_TO_DEVICE] = opencl_command_secs(event);
+        func_error_code = clEnqueueReadBuffer(queue, device_buffer, CL_BLOCKING, 0, num_bytes, host_buffer,
+                                                0, NULL, &event);
+        assert(func_error_code == CL_SUCCESS);
+        secs[BANDWIDTH_PEAK_DEVICE_TO_HOST] = opencl_command_secs(event);
+        func_error_code = clEnqueueCopyBuffer(queue, device_buffer, device_copy_buffer, 0, 0, num_bytes,
+                                                0, NULL, &event);
+        assert(func_error_code == CL_SUCCESS);
+        func_error_code = clWaitForEvents(1, &event);
+        assert(func_error_code == CL_SUCCESS);
+        secs[BANDWIDTH_PEAK_DEVICE_COPY] = opencl_command_secs(event);
+        for (unsigned int peak = BANDWIDTH_PEAK_HOST_TO_DEVICE; peak <= BANDWIDTH_PEAK_DEVICE_COPY; ++peak) {
+            if (repetition == 0 || secs[peak] < best_secs[peak]) {
+                best_secs[peak] = secs[peak];
+            }
+        }
+    }
+    for (unsigned int peak = BANDWIDTH_PEAK_HOST_TO_DEVICE; peak <= BANDWIDTH_PEAK_DEVICE_COPY; ++peak) {
+        // Devices which finish a command in no measurable time don't get a peak
+        if (best_secs[peak] > 0.0) {
+            calibration->bytes_per_sec[peak] = ((peak == BANDWIDTH_PEAK_DEVICE_COPY) ? 2.0 : 1.0) * num_bytes /
+                                                 best_secs[peak];
+            calibration->is_measured[peak] = true;
+        }
+    }
+    printf(DEVICE_BANDWIDTH_CALIBRATION_MSG, BANDWIDTH_CALIBRATION_REPETITIONS,
+             (unsigned long) (num_bytes / (1024ul * 1024ul)),
+             calibration->bytes_per_sec[BANDWIDTH_PEAK_HOST_TO_DEVICE] / ROOFLINE_BYTES_IN_GB,
+             calibration->bytes_per_sec[BANDWIDTH_PEAK_DEVICE_TO_HOST] / ROOFLINE_BYTES_IN_GB,
+             calibration->bytes_per_sec[BANDWIDTH_PEAK_DEVICE_COPY] / ROOFLINE_BYTES_IN_GB);
+
+    clReleaseMemObject(device_buffer);
+    clReleaseMemObject(device_copy_buffer);
+    free(host_buffer);
+
+}
+
+void reset_roofline_report(struct Roofline_Report* report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+
+    report->num_phases = 0;
+
+}
+
+void record_roofline_phase(struct Roofline_Report* report, const char* label, double num_bytes, double seconds,
+                             enum Bandwidth_Peak peak) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(label != NULL);
+
+    if (seconds <= 0.0) {
+        return;
+    }
+    // Report HAS to have room left for another phase
+    assert(report->num_phases < MAX_ROOFLINE_PHASES);
+
+    struct Roofline_Phase* phase = &(report->phases[report->num_phases]);
+    strlcpy(phase->label, label, ROOFLINE_PHASE_LABEL_MAX_LEN);
+    phase->num_bytes = num_bytes;
+    phase->seconds = seconds;
+    phase->peak = peak;
+    ++(report->num_phases);
+
+}
+
+void record_opencl_roofline_phases(struct Roofline_Report* report,
+                                     const struct Opencl_Profiling_Report* profiling_report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(profiling_report != NULL);
+
+    static const char* const phase_labels[NUM_PROFILING_PHASES] = {
+        "opencl upload", "opencl kernel", "opencl readback"
+    };
+    static const enum Bandwidth_Peak phase_peaks[NUM_PROFILING_PHASES] = {
+        BANDWIDTH_PEAK_HOST_TO_DEVICE, BANDWIDTH_PEAK_DEVICE_COPY, BANDWIDTH_PEAK_DEVICE_TO_HOST
+    };
+    double phase_bytes[NUM_PROFILING_PHASES] = { 0.0 };
+    double phase_secs[NUM_PROFILING_PHASES] = { 0.0 };
+    for (unsigned int command_index = 0; command_index < profiling_report->num_commands; ++command_index) {
+        const struct Opencl_Command_Profile* command = &(profiling_report->commands[command_index]);
+        phase_secs[command->phase] += (double) (command->ended - command->started) / PROFILING_NANOSECS_IN_SEC;
+        phase_bytes[command->phase] += (double) command->num_bytes;
+        // Kernels record the purchases and results rows they move; add the customer rows they gather
+        if (command->phase == PROFILING_PHASE_KERNEL) {
+            phase_bytes[command->phase] += (double) command->num_rows * sizeof(struct Hashed_Customer_Table_Row);
+        }
+    }
+    for (unsigned int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+        record_roofline_phase(report, phase_labels[phase], phase_bytes[phase], phase_secs[phase], phase_peaks[phase]);
+    }
+
+}
+
+/*
+ * Returns bytes per second of "phase" as a percentage of its peak in "calibration", or -1 if the
+ * peak wasn't measured.
+ */
+static inline double percent_of_peak(const struct Roofline_Phase* phase,
+                                       const struct Bandwidth_Calibration* calibration) {
+    return calibration->is_measured[phase->peak] ?
+                100.0 * (phase->num_bytes / phase->seconds) / calibration->bytes_per_sec[phase->peak] : -1.0;
+}
+
+void print_roofline_report(const struct Roofline_Report* report, const struct Bandwidth_Calibration* calibration) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(calibration != NULL);
+
+    printf(ROOFLINE_REPORT_HEADER, "phase", "MB moved", "seconds", "GB/s", "peak", "peak GB/s", "% of peak");
+    for (unsigned int phase_index = 0; phase_index < report->num_phases; ++phase_index) {
+        const struct Roofline_Phase* phase = &(report->phases[phase_index]);
+        printf(ROOFLINE_REPORT_ROW_FORMAT, phase->label, phase->num_bytes / ROOFLINE_BYTES_IN_MB, phase->seconds,
+                 phase->num_bytes / phase->seconds / ROOFLINE_BYTES_IN_GB, bandwidth_peak_names[phase->peak],
+                 calibration->is_measured[phase->peak] ?
+                     calibration->bytes_per_sec[phase->peak] / ROOFLINE_BYTES_IN_GB : -1.0,
+                 percent_of_peak(phase, calibration));
+    }
+    printf(ROOFLINE_REPORT_FOOTER);
+
+}
+
+void write_roofline_report_to_json_file(const struct Roofline_Report* report,
+                                          const struct Bandwidth_Calibration* calibration,
+                                          const char* file_location) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(calibration != NULL);
+    assert(file_location != NULL);
+
+    FILE * report_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (report_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    printf(ROOFLINE_REPORT_JSON_MSG, file_location);
+
+    fprintf(report_file, "{\n  \"peaks_bytes_per_sec\": {");
+    for (unsigned int peak = 0; peak < NUM_BANDWIDTH_PEAKS; ++peak) {
+        if (calibration->is_measured[peak]) {
+            fprintf(report_file, "%s\"%s\": %.0lf", (peak > 0) ? ", " : "", bandwidth_peak_names[peak],
+                      calibration->bytes_per_sec[peak]);
+        } else {
+            fprintf(report_file, "%s\"%s\": null", (peak > 0) ? ", " : "", bandwidth_peak_names[peak]);
+        }
+    }
+    fprintf(report_file, "},\n  \"phases\": [\n");
+    for (unsigned int phase_index = 0; phase_index < report->num_phases; ++phase_index) {
+
+        const struct Roofline_Phase* phase = &(report->phases[phase_index]);
+        fprintf(report_file, "    {\"label\": \"%s\", \"bytes\": %.0lf, \"seconds\": %.9lf, \"bytes_per_sec\": %.0lf,"
+                               " \"peak\": \"%s\"", phase->label, phase->num_bytes, phase->seconds,
+                  phase->num_bytes / phase->seconds, bandwidth_peak_names[phase->peak]);
+        const double percent = percent_of_peak(phase, calibration);
+        if (percent >= 0.0) {
+            fprintf(report_file, ", \"percent_of_peak\": %.2lf}%s\n", percent,
+                      (phase_index + 1 < report->num_phases) ? "," : "");
+        } else {
+            fprintf(report_file, ", \"percent_of_peak\": null}%s\n", (phase_index + 1 < report->num_phases) ? "," : "");
+        }
+
+    }
+    fprintf(report_file, "  ]\n}\n");
+
+    // Done writing to file; close it
+    fclose(report_file);
+
+}
+
+// =================================================================================================
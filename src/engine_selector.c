@@ -0,0 +1,433 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for calibrating the cost model of each probe engine
+// on this machine, caching the calibration on disk, and predicting which engine probes a pair of
+// tables the fastest.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <bsd/string.h>
+#include "data_structures_opencl.h"
+#include "equijoin_opencl.h"
+#include "opencl_environment.h"
+#include "opencl_profiling.h"
+#include "equijoin_serial.h"
+#include "bandwidth_roofline.h"
+#include "monotonic_clock.h"
+#include "engine_selector.h"
+
+// Name of each engine, indexed by "enum Probe_Engine"
+static const char* const probe_engine_names[NUM_PROBE_ENGINES] = {
+    "serial", "cpu-threads", "opencl"
+};
+
+// =================================================================================================
+
+const char* probe_engine_name(enum Probe_Engine engine) {
+
+    assert(engine < NUM_PROBE_ENGINES);
+    return probe_engine_names[engine];
+
+}
+
+/*
+ * Describes this machine in "machine" (of "machine_len" bytes), without any whitespace: its host
+ * name, online CPUs and the OpenCL platform probed on.  Calibrations of other machines don't apply.
+ */
+static void describe_machine(char* machine, size_t machine_len) {
+
+    char host_name[MAX_ENGINE_MACHINE_LEN / 2] = { 0 };
+    if (gethostname(host_name, sizeof(host_name) - 1) != 0 || host_name[0] == '\0') {
+        strlcpy(host_name, "unknown", sizeof(host_name));
+    }
+    // Host names never hold whitespace, but keep the calibration file's format safe regardless
+    for (char* character = host_name; *character != '\0'; ++character) {
+        if (*character == ' ' || *character == '\t' || *character == '\n') {
+            *character = '_';
+        }
+    }
+    snprintf(machine, machine_len, "%s/cpus=%u/platform=%d", host_name, resolve_num_threads(0),
+               DESIRED_PLATFORM_INDEX);
+
+}
+
+// Next pseudo-random number of "state" ("splitmix64")
+static uint64_t next_random_number(uint64_t* state) {
+
+    uint64_t value = (*state += 0x9e3779b97f4a7c15ull);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+
+}
+
+/*
+ * Fills "hashed_customer_table" with customer IDs 1 to its "num_records", half of them active,
+ * and points every purchase of "purchases_table" at a random one of them.
+ */
+static void fill_calibration_tables(struct Hashed_Customer_Table* hashed_customer_table,
+                                      struct Purchases_Table* purchases_table) {
+
+    for (unsigned long row = 0; row < hashed_customer_table->num_records; ++row) {
+        struct Hashed_Customer_Table_Row* customer_row =
+                        &(hashed_customer_table->table[customer_id_to_row_index(row + 1)]);
+        customer_row->customer_id = row + 1;
+        strlcpy(customer_row->first_name, "Calibration", FIRST_NAME_MAX_LEN);
+        customer_row->active_customer = (row % 2 == 0) ? CUSTOMER_ACTIVE_FLAG : CUSTOMER_INACTIVE_FLAG;
+    }
+    uint64_t random_state = ENGINE_CALIBRATION_SEED;
+    for (unsigned long row = 0; row < purchases_table->num_records; ++row) {
+        const uint64_t random_number = next_random_number(&random_state);
+        struct Purchases_Table_Row* purchase_row = &(purchases_table->table[row]);
+        purchase_row->time_of_purchase = row;
+        purchase_row->customer_id = (random_number % hashed_customer_table->num_records) + 1;
+        strlcpy(purchase_row->ean13, "4006381333931", EAN13_MAX_CHARS);
+        purchase_row->quantity_purchased = (random_number >> 32) % 100 + 1;
+    }
+
+}
+
+// Fastest of ENGINE_CALIBRATION_REPETITIONS serial probes of "tables_list", in seconds per purchase
+static double time_serial_calibration_probe(struct List_Of_Tables tables_list) {
+
+    // Probe once before timing, so that no page of the results table is touched for the first time
+    const unsigned long num_rows = tables_list.purchases_table->num_records;
+    serial_hash_equijoin_probe_rows(tables_list, CUSTOMER_ACTIVE_FLAG, NULL, 0, num_rows);
+    double best_secs = 0.0;
+    for (unsigned int repetition = 0; repetition < ENGINE_CALIBRATION_REPETITIONS; ++repetition) {
+        const double start_secs = monotonic_clock_secs();
+        serial_hash_equijoin_probe_rows(tables_list, CUSTOMER_ACTIVE_FLAG, NULL, 0, num_rows);
+        const double secs = monotonic_clock_secs() - start_secs;
+        if (repetition == 0 || secs < best_secs) {
+            best_secs = secs;
+        }
+    }
+    return best_secs / num_rows;
+
+}
+
+/*
+ * Measures how long setting up the default OpenCL device takes, its transfer bandwidth, and how
+ * many rows per second its probe kernel probes "tables_list" at, into "calibration".
+ */
+static void calibrate_opencl_engine_costs(struct List_Of_Tables tables_list,
+                                            struct Engine_Cost_Calibration* calibration) {
+
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernel;
+    cl_mem hashed_customer_table_buffer, purchases_table_buffer, results_table_buffer;
+    struct Cl_Mem_Operands_List cl_mem_ops = {
+        &hashed_customer_table_buffer, &purchases_table_buffer, &results_table_buffer
+    };
+    struct Probe_Kernel_Variant kernel_variant;
+
+    const double setup_start_secs = monotonic_clock_secs();
+    configure_opencl_env(&context, &queue, &program, &kernel_variant);
+    calibration->opencl_setup_secs = monotonic_clock_secs() - setup_start_secs;
+
+    struct Bandwidth_Calibration bandwidth_calibration;
+    init_bandwidth_calibration(&bandwidth_calibration);
+    measure_device_transfer_bandwidth(context, queue, &bandwidth_calibration);
+    calibration->host_to_device_bytes_per_sec = bandwidth_calibration.bytes_per_sec[BANDWIDTH_PEAK_HOST_TO_DEVICE];
+    calibration->device_to_host_bytes_per_sec = bandwidth_calibration.bytes_per_sec[BANDWIDTH_PEAK_DEVICE_TO_HOST];
+
+    // The kernel's own throughput, as timed by the device, apart from the transfers around it
+    struct Opencl_Profiling_Report profiling_report;
+    reset_opencl_profiling_report(&profiling_report);
+    load_tables_hash_equijoin_probe(&context, &queue, tables_list, cl_mem_ops, &profiling_report);
+    opencl_hash_equijoin_probe(&queue, &program, &kernel, tables_list, cl_mem_ops, CUSTOMER_ACTIVE_FLAG,
+                                 &kernel_variant, NULL, &profiling_report);
+    double kernel_rows = 0.0, kernel_secs = 0.0;
+    for (unsigned int command_index = 0; command_index < profiling_report.num_commands; ++command_index) {
+        const struct Opencl_Command_Profile* command = &(profiling_report.commands[command_index]);
+        if (command->phase == PROFILING_PHASE_KERNEL) {
+            kernel_rows += (double) command->num_rows;
+            kernel_secs += (double) (command->ended - command->started) / PROFILING_NANOSECS_IN_SEC;
+        }
+    }
+    calibration->device_rows_per_sec = (kernel_secs > 0.0) ? kernel_rows / kernel_secs : 0.0;
+
+    clReleaseKernel(kernel);
+    clReleaseMemObject(hashed_customer_table_buffer);
+    clReleaseMemObject(purchases_table_buffer);
+    clReleaseMemObject(results_table_buffer);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+
+}
+
+// Measures every input of the cost model on this machine into "calibration"
+static void calibrate_engine_costs(struct Engine_Cost_Calibration* calibration) {
+
+    calibration->num_cpu_cores = resolve_num_threads(0);
+    long last_level_cache_bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (last_level_cache_bytes <= 0) {
+        last_level_cache_bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    calibration->last_level_cache_bytes = (last_level_cache_bytes > 0) ? (double) last_level_cache_bytes :
+                                                                         ENGINE_DEFAULT_LAST_LEVEL_CACHE_BYTES;
+
+    struct Bandwidth_Calibration bandwidth_calibration;
+    init_bandwidth_calibration(&bandwidth_calibration);
+    measure_host_memory_bandwidth(&bandwidth_calibration, calibration->num_cpu_cores);
+    calibration->host_triad_bytes_per_sec = bandwidth_calibration.bytes_per_sec[BANDWIDTH_PEAK_HOST_TRIAD];
+
+    struct Hashed_Customer_Table hashed_customer_table;
+    hashed_customer_table.table = calloc(ENGINE_CALIBRATION_DRAM_CUSTOMERS, sizeof(*(hashed_customer_table.table)));
+    assert(hashed_customer_table.table != NULL);
+    struct Purchases_Table purchases_table;
+    purchases_table.num_records = ENGINE_CALIBRATION_PURCHASES;
+    purchases_table.table = calloc(ENGINE_CALIBRATION_PURCHASES, sizeof(*(purchases_table.table)));
+    assert(purchases_table.table != NULL);
+    struct Joined_Results_Table results_table;
+    results_table.num_records = ENGINE_CALIBRATION_PURCHASES;
+    results_table.table = calloc(ENGINE_CALIBRATION_PURCHASES, sizeof(*(results_table.table)));
+    assert(results_table.table != NULL);
+    struct List_Of_Tables tables_list = { &hashed_customer_table, &purchases_table, &results_table };
+
+    hashed_customer_table.num_records = ENGINE_CALIBRATION_CACHED_CUSTOMERS;
+    fill_calibration_tables(&hashed_customer_table, &purchases_table);
+    calibration->serial_cached_secs_per_row = time_serial_calibration_probe(tables_list);
+
+    hashed_customer_table.num_records = ENGINE_CALIBRATION_DRAM_CUSTOMERS;
+    fill_calibration_tables(&hashed_customer_table, &purchases_table);
+    calibration->serial_dram_secs_per_row = time_serial_calibration_probe(tables_list);
+
+    calibrate_opencl_engine_costs(tables_list, calibration);
+
+    free(hashed_customer_table.table);
+    free(purchases_table.table);
+    free(results_table.table);
+
+}
+
+/*
+ * Reads the calibration cached in "file_location" into "calibration"; returns whether the file
+ * exists and holds every input of the cost model.
+ */
+static bool read_engine_cost_calibration(const char* file_location, struct Engine_Cost_Calibration* calibration) {
+
+    FILE* calibration_file = fopen(file_location, "r");
+    if (calibration_file == NULL) {
+        return false;
+    }
+
+    // Bit of every input read, in the order of the fields of "Engine_Cost_Calibration"
+    unsigned int inputs_read = 0;
+    const unsigned int all_inputs_read = (1u << 10) - 1;
+    char line[MAX_ENGINE_CALIBRATION_LINE_LEN];
+    char key[MAX_ENGINE_CALIBRATION_LINE_LEN];
+    char value[MAX_ENGINE_CALIBRATION_LINE_LEN];
+    while (fgets(line, sizeof(line), calibration_file) != NULL) {
+        if (line[0] == '#' || sscanf(line, "%511s %511s", key, value) != 2) {
+            continue;
+        }
+        if (strcmp(key, "machine") == 0) {
+            strlcpy(calibration->machine, value, MAX_ENGINE_MACHINE_LEN);
+            inputs_read |= 1u << 0;
+            continue;
+        }
+        char* value_end;
+        const double number = strtod(value, &value_end);
+        if (*value_end != '\0' || number < 0.0) {
+            continue;
+        }
+        if (strcmp(key, "serial_cached_secs_per_row") == 0) {
+            calibration->serial_cached_secs_per_row = number;
+            inputs_read |= 1u << 1;
+        } else if (strcmp(key, "serial_dram_secs_per_row") == 0) {
+            calibration->serial_dram_secs_per_row = number;
+            inputs_read |= 1u << 2;
+        } else if (strcmp(key, "last_level_cache_bytes") == 0) {
+            calibration->last_level_cache_bytes = number;
+            inputs_read |= 1u << 3;
+        } else if (strcmp(key, "num_cpu_cores") == 0 && number >= 1.0) {
+            calibration->num_cpu_cores = (unsigned int) number;
+            inputs_read |= 1u << 4;
+        } else if (strcmp(key, "host_triad_bytes_per_sec") == 0) {
+            calibration->host_triad_bytes_per_sec = number;
+            inputs_read |= 1u << 5;
+        } else if (strcmp(key, "opencl_setup_secs") == 0) {
+            calibration->opencl_setup_secs = number;
+            inputs_read |= 1u << 6;
+        } else if (strcmp(key, "host_to_device_bytes_per_sec") == 0) {
+            calibration->host_to_device_bytes_per_sec = number;
+            inputs_read |= 1u << 7;
+        } else if (strcmp(key, "device_to_host_bytes_per_sec") == 0) {
+            calibration->device_to_host_bytes_per_sec = number;
+            inputs_read |= 1u << 8;
+        } else if (strcmp(key, "device_rows_per_sec") == 0) {
+            calibration->device_rows_per_sec = number;
+            inputs_read |= 1u << 9;
+        }
+    }
+    fclose(calibration_file);
+    return inputs_read == all_inputs_read;
+
+}
+
+// Writes "calibration" to "file_location", in the format "read_engine_cost_calibration" reads
+static void write_engine_cost_calibration(const char* file_location, const struct Engine_Cost_Calibration* calibration) {
+
+    FILE* calibration_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (calibration_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+
+    fprintf(calibration_file, "# Engine cost calibration of a single machine; delete this file (or run with\n"
+                                "# \"--recalibrate\") to measure it again.\n");
+    fprintf(calibration_file, "machine %s\n", calibration->machine);
+    fprintf(calibration_file, "serial_cached_secs_per_row %.6e\n", calibration->serial_cached_secs_per_row);
+    fprintf(calibration_file, "serial_dram_secs_per_row %.6e\n", calibration->serial_dram_secs_per_row);
+    fprintf(calibration_file, "last_level_cache_bytes %.0lf\n", calibration->last_level_cache_bytes);
+    fprintf(calibration_file, "num_cpu_cores %u\n", calibration->num_cpu_cores);
+    fprintf(calibration_file, "host_triad_bytes_per_sec %.0lf\n", calibration->host_triad_bytes_per_sec);
+    fprintf(calibration_file, "opencl_setup_secs %.6lf\n", calibration->opencl_setup_secs);
+    fprintf(calibration_file, "host_to_device_bytes_per_sec %.0lf\n", calibration->host_to_device_bytes_per_sec);
+    fprintf(calibration_file, "device_to_host_bytes_per_sec %.0lf\n", calibration->device_to_host_bytes_per_sec);
+    fprintf(calibration_file, "device_rows_per_sec %.0lf\n", calibration->device_rows_per_sec);
+
+    // Done writing to file; close it
+    fclose(calibration_file);
+
+}
+
+void get_engine_cost_calibration(const char* file_location, bool is_recalibration_forced,
+                                   struct Engine_Cost_Calibration* calibration) {
+
+    // No null pointers allowed
+    assert(file_location != NULL);
+    assert(calibration != NULL);
+
+    char machine[MAX_ENGINE_MACHINE_LEN];
+    describe_machine(machine, sizeof(machine));
+    if (!is_recalibration_forced && read_engine_cost_calibration(file_location, calibration) &&
+        strcmp(calibration->machine, machine) == 0) {
+        printf(ENGINE_CALIBRATION_READ_MSG, machine, file_location);
+    } else {
+        printf(ENGINE_CALIBRATION_RUN_MSG, machine, file_location);
+        memset(calibration, 0, sizeof(*calibration));
+        strlcpy(calibration->machine, machine, MAX_ENGINE_MACHINE_LEN);
+        calibrate_engine_costs(calibration);
+        write_engine_cost_calibration(file_location, calibration);
+    }
+    printf(ENGINE_CALIBRATION_MSG, calibration->serial_cached_secs_per_row * PROFILING_NANOSECS_IN_SEC,
+             calibration->serial_dram_secs_per_row * PROFILING_NANOSECS_IN_SEC, calibration->num_cpu_cores,
+             calibration->host_triad_bytes_per_sec / ROOFLINE_BYTES_IN_GB, calibration->opencl_setup_secs,
+             calibration->host_to_device_bytes_per_sec / ROOFLINE_BYTES_IN_GB,
+             calibration->device_to_host_bytes_per_sec / ROOFLINE_BYTES_IN_GB,
+             calibration->device_rows_per_sec / 1000000.0);
+
+}
+
+/*
+ * Seconds it takes to move "num_bytes" at "bytes_per_sec"; an engine whose bandwidth couldn't be
+ * measured takes forever, so that it's never selected.
+ */
+static inline double transfer_secs(double num_bytes, double bytes_per_sec) {
+    return (bytes_per_sec > 0.0) ? num_bytes / bytes_per_sec : HUGE_VAL;
+}
+
+enum Probe_Engine predict_engine_costs(const struct Engine_Cost_Calibration* calibration,
+                                         unsigned long num_customers, unsigned long num_purchases,
+                                         double predicted_secs[NUM_PROBE_ENGINES]) {
+
+    // No null pointers allowed
+    assert(calibration != NULL);
+    assert(predicted_secs != NULL);
+
+    const double customer_table_bytes = (double) num_customers * sizeof(struct Hashed_Customer_Table_Row);
+    const double purchases_table_bytes = (double) num_purchases * sizeof(struct Purchases_Table_Row);
+    const double results_table_bytes = (double) num_purchases * sizeof(struct Joined_Results_Table_Row);
+
+    const double serial_secs_per_row = (customer_table_bytes <= calibration->last_level_cache_bytes) ?
+                                          calibration->serial_cached_secs_per_row :
+                                          calibration->serial_dram_secs_per_row;
+    predicted_secs[PROBE_ENGINE_SERIAL] = num_purchases * serial_secs_per_row;
+
+    const double threaded_compute_secs = predicted_secs[PROBE_ENGINE_SERIAL] / calibration->num_cpu_cores;
+    const double threaded_memory_secs = transfer_secs((double) num_purchases * PROBE_BYTES_PER_ROW,
+                                                        calibration->host_triad_bytes_per_sec);
+    predicted_secs[PROBE_ENGINE_CPU_THREADS] = ((threaded_compute_secs > threaded_memory_secs) ?
+                                                   threaded_compute_secs : threaded_memory_secs) +
+                                               calibration->num_cpu_cores * ENGINE_THREAD_START_SECS;
+
+    predicted_secs[PROBE_ENGINE_OPENCL] = calibration->opencl_setup_secs +
+                    transfer_secs(customer_table_bytes + purchases_table_bytes + results_table_bytes,
+                                    calibration->host_to_device_bytes_per_sec) +
+                    transfer_secs((double) num_purchases, calibration->device_rows_per_sec) +
+                    transfer_secs(results_table_bytes, calibration->device_to_host_bytes_per_sec);
+
+    enum Probe_Engine fastest_engine = PROBE_ENGINE_SERIAL;
+    for (unsigned int engine = 0; engine < NUM_PROBE_ENGINES; ++engine) {
+        if (predicted_secs[engine] < predicted_secs[fastest_engine]) {
+            fastest_engine = (enum Probe_Engine) engine;
+        }
+    }
+    printf(ENGINE_PREDICTION_HEADER, num_customers, num_purchases);
+    for (unsigned int engine = 0; engine < NUM_PROBE_ENGINES; ++engine) {
+        printf(ENGINE_PREDICTION_MSG, probe_engine_names[engine], predicted_secs[engine],
+                 (engine == fastest_engine) ? ENGINE_SELECTED_MARK : "");
+    }
+    return fastest_engine;
+
+}
+
+void log_engine_prediction(const char* file_location, const struct Engine_Cost_Calibration* calibration,
+                             unsigned long num_customers, unsigned long num_purchases,
+                             const double predicted_secs[NUM_PROBE_ENGINES], enum Probe_Engine engine,
+                             double actual_secs) {
+
+    // No null pointers allowed
+    assert(file_location != NULL);
+    assert(calibration != NULL);
+    assert(predicted_secs != NULL);
+
+    FILE* log_file = fopen(file_location, "a");
+    // Inform user if file didn't open correctly and abort program
+    if (log_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+
+    // One line per run: machine, table sizes, every engine's prediction, and the engine run with its time
+    fprintf(log_file, "%ld %s customers=%lu purchases=%lu", (long) time(NULL), calibration->machine,
+              num_customers, num_purchases);
+    for (unsigned int predicted_engine = 0; predicted_engine < NUM_PROBE_ENGINES; ++predicted_engine) {
+        fprintf(log_file, " predicted_%s=%.6lf", probe_engine_names[predicted_engine],
+                  predicted_secs[predicted_engine]);
+    }
+    fprintf(log_file, " engine=%s actual=%.6lf\n", probe_engine_names[engine], actual_secs);
+
+    // Done writing to file; close it
+    fclose(log_file);
+    printf(ENGINE_PREDICTION_LOGGED_MSG, file_location);
+
+}
+
+// =================================================================================================
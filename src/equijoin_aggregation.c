@@ -0,0 +1,514 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for hash equijoin probing fused with a group-by
+// aggregation of the joined records, both on an OpenCL device and on the CPU.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "host_threads.h"
+#include "equijoin_aggregation.h"
+
+// Name of the kernel function compacting the global hash table of aggregates
+#define COMPACT_KERNEL_FUNC_NAME "compact_aggregates"
+// Number of values each aggregated row is read back from the OpenCL device as
+#define VALUES_PER_AGGREGATED_ROW 3
+// Smallest number of slots of the global hash table of aggregates on an OpenCL device
+#define MIN_DEVICE_AGGREGATION_SLOTS 1024
+
+// Names of the key columns as shown to the user
+static const char* const AGGREGATION_KEY_COLUMN_NAMES[] = { "customer ID", "EAN13" };
+
+/*
+ * Hash table of aggregates on the CPU, with open addressing and linear probing.
+ *   - slots --- each slot holds an aggregate, or EMPTY_AGGREGATION_KEY as key if empty
+ *   - num_slots --- number of slots; always a power of two
+ *   - num_keys --- number of slots holding a key
+ */
+struct Aggregation_Hash_Table {
+    struct Aggregated_Results_Row* slots;
+    unsigned long num_slots;
+    unsigned long num_keys;
+};
+
+/*
+ * Work of one CPU thread aggregating a slice of the purchases table.
+ *   - thread --- thread doing the work
+ *   - tables_list, is_customer_active, purchase_predicate, key_column --- what to join and how
+ *   - first_row, num_rows --- slice of the purchases table to join
+ *   - hash_table --- hash table the thread aggregates into
+ */
+struct Cpu_Aggregation_Slice {
+    pthread_t thread;
+    struct List_Of_Tables tables_list;
+    char is_customer_active;
+    const struct Purchase_Predicate* purchase_predicate;
+    enum Aggregation_Key_Column key_column;
+    unsigned long first_row;
+    unsigned long num_rows;
+    struct Aggregation_Hash_Table hash_table;
+};
+
+// =================================================================================================
+
+bool opencl_device_supports_aggregation(cl_device_id device) {
+
+    char extensions[MAX_DEVICE_EXTENSIONS_LEN] = { 0 };
+    cl_int func_error_code = clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, sizeof(extensions) - 1,
+                                                                          extensions, NULL);
+    return func_error_code == CL_SUCCESS && strstr(extensions, AGGREGATION_REQUIRED_EXTENSION) != NULL;
+
+}
+
+// Smallest power of two no smaller than "value"
+static unsigned long next_power_of_two(unsigned long value) {
+
+    unsigned long power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+
+}
+
+// Most distinct keys the join of "tables_list" can aggregate into for "key_column"
+static unsigned long max_aggregation_keys(struct List_Of_Tables tables_list, enum Aggregation_Key_Column key_column) {
+
+    const unsigned long num_purchases = tables_list.purchases_table->num_records;
+    const unsigned long num_customers = tables_list.hashed_customer_table->num_records;
+    return (key_column == AGGREGATION_KEY_CUSTOMER_ID && num_customers < num_purchases) ? num_customers : num_purchases;
+
+}
+
+// Orders aggregated rows by key
+static int compare_aggregated_rows(const void* first_row, const void* second_row) {
+
+    const unsigned long first_key = ((const struct Aggregated_Results_Row*) first_row)->key;
+    const unsigned long second_key = ((const struct Aggregated_Results_Row*) second_row)->key;
+    return (first_key > second_key) - (first_key < second_key);
+
+}
+
+void opencl_hash_equijoin_aggregate(cl_context* context, cl_command_queue* queue, cl_program* program,
+                                      struct List_Of_Tables tables_list, char is_customer_active,
+                                        enum Aggregation_Key_Column key_column,
+                                          const struct Probe_Kernel_Variant* kernel_variant,
+                                            struct Opencl_Profiling_Report* profiling_report,
+                                              struct Aggregated_Results_Table* aggregated_results) {
+    // No null pointers allowed
+    assert(context != NULL);
+    assert(queue != NULL);
+    assert(program != NULL);
+    assert(aggregated_results != NULL);
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    // Each table HAS to have at least 1 row
+    assert(tables_list.hashed_customer_table->num_records >= 1);
+    assert(tables_list.purchases_table->num_records >= 1);
+
+    cl_int func_error_code;
+    const unsigned long num_purchases_rows = tables_list.purchases_table->num_records;
+    const size_t customer_table_size = tables_list.hashed_customer_table->num_records *
+                                          sizeof(*(tables_list.hashed_customer_table->table));
+    const size_t purchases_table_size = num_purchases_rows * sizeof(*(tables_list.purchases_table->table));
+
+    // At most half of the global hash table ever fills up, which keeps probe sequences short
+    const unsigned long max_keys = max_aggregation_keys(tables_list, key_column);
+    unsigned long num_slots = next_power_of_two(2 * max_keys);
+    if (num_slots < MIN_DEVICE_AGGREGATION_SLOTS) {
+        num_slots = MIN_DEVICE_AGGREGATION_SLOTS;
+    }
+    const unsigned long slot_mask = num_slots - 1;
+    printf(NOTIFY_USER_DEVICE_AGGREGATION, AGGREGATION_KEY_COLUMN_NAMES[key_column], num_slots);
+
+    // Only the input tables and the hash table of aggregates live in device memory
+    cl_mem customer_table_buffer = clCreateBuffer(*context, CL_MEM_READ_ONLY, customer_table_size,
+                                                                      NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem purchases_table_buffer = clCreateBuffer(*context, CL_MEM_READ_ONLY, purchases_table_size,
+                                                                       NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem aggregate_buffers[VALUES_PER_AGGREGATED_ROW];
+    for (unsigned int value_index = 0; value_index < VALUES_PER_AGGREGATED_ROW; ++value_index) {
+        aggregate_buffers[value_index] = clCreateBuffer(*context, CL_MEM_READ_WRITE, num_slots * sizeof(cl_ulong),
+                                                                                      NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+    }
+    cl_mem aggregated_rows_buffer = clCreateBuffer(*context, CL_MEM_READ_WRITE,
+                                                     max_keys * VALUES_PER_AGGREGATED_ROW * sizeof(cl_ulong),
+                                                                                      NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem num_aggregated_rows_buffer = clCreateBuffer(*context, CL_MEM_READ_WRITE, sizeof(cl_uint),
+                                                                                      NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Upload the input tables and empty the hash table of aggregates
+    cl_event upload_events[2];
+    func_error_code = clEnqueueWriteBuffer(*queue, customer_table_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                                             customer_table_size, tables_list.hashed_customer_table->table,
+                                             0, NULL, &(upload_events[0]));
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clEnqueueWriteBuffer(*queue, purchases_table_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                                             purchases_table_size, tables_list.purchases_table->table,
+                                             0, NULL, &(upload_events[1]));
+    assert(func_error_code == CL_SUCCESS);
+    const cl_ulong empty_key = EMPTY_AGGREGATION_KEY, zero_value = 0;
+    const cl_uint zero_rows = 0;
+    func_error_code = clEnqueueFillBuffer(*queue, aggregate_buffers[0], &empty_key, sizeof(empty_key),
+                                            CL_BUFFER_OFFSET, num_slots * sizeof(cl_ulong), 0, NULL, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    for (unsigned int value_index = 1; value_index < VALUES_PER_AGGREGATED_ROW; ++value_index) {
+        func_error_code = clEnqueueFillBuffer(*queue, aggregate_buffers[value_index], &zero_value,
+                                                sizeof(zero_value), CL_BUFFER_OFFSET, num_slots * sizeof(cl_ulong),
+                                                0, NULL, NULL);
+        assert(func_error_code == CL_SUCCESS);
+    }
+    func_error_code = clEnqueueFillBuffer(*queue, num_aggregated_rows_buffer, &zero_rows, sizeof(zero_rows),
+                                            CL_BUFFER_OFFSET, sizeof(zero_rows), 0, NULL, NULL);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Join and aggregate, ROWS_PER_WORK_ITEM purchases per work-item
+    cl_kernel aggregate_kernel = clCreateKernel(*program, AGGREGATE_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    const unsigned int rows_per_work_item = (kernel_variant != NULL) ? kernel_variant->rows_per_work_item : 1;
+    const size_t work_group_size = (kernel_variant != NULL) ? kernel_variant->work_group_size : NUM_THREADS_IN_BLOCK;
+    const size_t num_work_items = (num_purchases_rows + rows_per_work_item - 1) / rows_per_work_item;
+    const size_t local[OPERAND_DIMS] = { work_group_size };
+    const size_t global[OPERAND_DIMS] = {
+        ((num_work_items + work_group_size - 1) / work_group_size) * work_group_size
+    };
+    const char is_keyed_by_ean13 = (key_column == AGGREGATION_KEY_EAN13);
+    func_error_code = clSetKernelArg(aggregate_kernel, 0, sizeof(customer_table_buffer), &customer_table_buffer);
+    func_error_code |= clSetKernelArg(aggregate_kernel, 1, sizeof(purchases_table_buffer), &purchases_table_buffer);
+    for (unsigned int value_index = 0; value_index < VALUES_PER_AGGREGATED_ROW; ++value_index) {
+        func_error_code |= clSetKernelArg(aggregate_kernel, 2 + value_index, sizeof(cl_mem),
+                                                              &(aggregate_buffers[value_index]));
+    }
+    func_error_code |= clSetKernelArg(aggregate_kernel, 5, sizeof(slot_mask), &slot_mask);
+    func_error_code |= clSetKernelArg(aggregate_kernel, 6, sizeof(is_customer_active), &is_customer_active);
+    func_error_code |= clSetKernelArg(aggregate_kernel, 7, sizeof(num_purchases_rows), &num_purchases_rows);
+    func_error_code |= clSetKernelArg(aggregate_kernel, 8, sizeof(is_keyed_by_ean13), &is_keyed_by_ean13);
+    assert(func_error_code == CL_SUCCESS);
+    cl_event aggregate_event;
+    func_error_code = clEnqueueNDRangeKernel(*queue, aggregate_kernel, OPERAND_DIMS, NULL, global, local,
+                                               2, upload_events, &aggregate_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Gather the slots holding a key into consecutive rows
+    cl_kernel compact_kernel = clCreateKernel(*program, COMPACT_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    const size_t compact_global[OPERAND_DIMS] = {
+        ((num_slots + work_group_size - 1) / work_group_size) * work_group_size
+    };
+    func_error_code = 0;
+    for (unsigned int value_index = 0; value_index < VALUES_PER_AGGREGATED_ROW; ++value_index) {
+        func_error_code |= clSetKernelArg(compact_kernel, value_index, sizeof(cl_mem),
+                                                            &(aggregate_buffers[value_index]));
+    }
+    func_error_code |= clSetKernelArg(compact_kernel, 3, sizeof(num_slots), &num_slots);
+    func_error_code |= clSetKernelArg(compact_kernel, 4, sizeof(aggregated_rows_buffer), &aggregated_rows_buffer);
+    func_error_code |= clSetKernelArg(compact_kernel, 5, sizeof(num_aggregated_rows_buffer),
+                                                         &num_aggregated_rows_buffer);
+    assert(func_error_code == CL_SUCCESS);
+    cl_event compact_event;
+    func_error_code = clEnqueueNDRangeKernel(*queue, compact_kernel, OPERAND_DIMS, NULL, compact_global, local,
+                                               1, &aggregate_event, &compact_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Read back how many rows there are, then only those rows
+    cl_uint num_aggregated_rows = 0;
+    cl_event count_read_event, rows_read_event;
+    func_error_code = clEnqueueReadBuffer(*queue, num_aggregated_rows_buffer, CL_BLOCKING, CL_BUFFER_OFFSET,
+                                            sizeof(num_aggregated_rows), &num_aggregated_rows, 1, &compact_event,
+                                            &count_read_event);
+    assert(func_error_code == CL_SUCCESS);
+    assert(num_aggregated_rows <= max_keys);
+
+    aggregated_results->key_column = key_column;
+    aggregated_results->num_records = num_aggregated_rows;
+    // Rows of three cl_ulong values each have the very same layout as Aggregated_Results_Row
+    aggregated_results->table = malloc((num_aggregated_rows > 0 ? num_aggregated_rows : 1) *
+                                          sizeof(*(aggregated_results->table)));
+    assert(aggregated_results->table != NULL);
+    if (num_aggregated_rows > 0) {
+        func_error_code = clEnqueueReadBuffer(*queue, aggregated_rows_buffer, CL_BLOCKING, CL_BUFFER_OFFSET,
+                                                num_aggregated_rows * sizeof(*(aggregated_results->table)),
+                                                aggregated_results->table, 0, NULL, &rows_read_event);
+        assert(func_error_code == CL_SUCCESS);
+    }
+
+    // Record how long each phase took
+    record_opencl_command_profile(profiling_report, upload_events[0], PROFILING_PHASE_UPLOAD,
+                                    "hashed_customer_table", customer_table_size,
+                                    tables_list.hashed_customer_table->num_records);
+    record_opencl_command_profile(profiling_report, upload_events[1], PROFILING_PHASE_UPLOAD,
+                                    "purchases_table", purchases_table_size, num_purchases_rows);
+    record_opencl_command_profile(profiling_report, aggregate_event, PROFILING_PHASE_KERNEL,
+                                    AGGREGATE_KERNEL_FUNC_NAME, customer_table_size + purchases_table_size,
+                                    num_purchases_rows);
+    record_opencl_command_profile(profiling_report, compact_event, PROFILING_PHASE_KERNEL,
+                                    COMPACT_KERNEL_FUNC_NAME,
+                                    num_slots * VALUES_PER_AGGREGATED_ROW * sizeof(cl_ulong), num_slots);
+    record_opencl_command_profile(profiling_report, count_read_event, PROFILING_PHASE_READBACK,
+                                    "num_aggregated_rows", sizeof(num_aggregated_rows), 1);
+    clReleaseEvent(upload_events[0]);
+    clReleaseEvent(upload_events[1]);
+    clReleaseEvent(aggregate_event);
+    clReleaseEvent(compact_event);
+    clReleaseEvent(count_read_event);
+    if (num_aggregated_rows > 0) {
+        record_opencl_command_profile(profiling_report, rows_read_event, PROFILING_PHASE_READBACK,
+                                        "aggregated_rows", num_aggregated_rows * sizeof(*(aggregated_results->table)),
+                                        num_aggregated_rows);
+        clReleaseEvent(rows_read_event);
+    }
+
+    clReleaseKernel(aggregate_kernel);
+    clReleaseKernel(compact_kernel);
+    clReleaseMemObject(customer_table_buffer);
+    clReleaseMemObject(purchases_table_buffer);
+    for (unsigned int value_index = 0; value_index < VALUES_PER_AGGREGATED_ROW; ++value_index) {
+        clReleaseMemObject(aggregate_buffers[value_index]);
+    }
+    clReleaseMemObject(aggregated_rows_buffer);
+    clReleaseMemObject(num_aggregated_rows_buffer);
+
+    // Compaction leaves rows in whatever order work-items got to them
+    qsort(aggregated_results->table, aggregated_results->num_records, sizeof(*(aggregated_results->table)),
+            compare_aggregated_rows);
+
+}
+
+static void init_aggregation_hash_table(struct Aggregation_Hash_Table* hash_table, unsigned long num_slots) {
+
+    hash_table->slots = malloc(num_slots * sizeof(*(hash_table->slots)));
+    assert(hash_table->slots != NULL);
+    for (unsigned long slot = 0; slot < num_slots; ++slot) {
+        hash_table->slots[slot].key = EMPTY_AGGREGATION_KEY;
+    }
+    hash_table->num_slots = num_slots;
+    hash_table->num_keys = 0;
+
+}
+
+/*
+ * Adds "num_purchases" purchases of "total_quantity" items in total to the aggregate of "key"
+ * in "hash_table", doubling the number of slots of "hash_table" once it's half full.
+ */
+static void cpu_aggregate(struct Aggregation_Hash_Table* hash_table, unsigned long key,
+                            unsigned long num_purchases, unsigned long total_quantity) {
+
+    const unsigned long slot_mask = hash_table->num_slots - 1;
+    unsigned long slot = aggregation_key_to_slot(key) & slot_mask;
+    while (hash_table->slots[slot].key != key && hash_table->slots[slot].key != EMPTY_AGGREGATION_KEY) {
+        slot = (slot + 1) & slot_mask;
+    }
+
+    if (hash_table->slots[slot].key == key) {
+        hash_table->slots[slot].num_purchases += num_purchases;
+        hash_table->slots[slot].total_quantity += total_quantity;
+        return;
+    }
+
+    hash_table->slots[slot].key = key;
+    hash_table->slots[slot].num_purchases = num_purchases;
+    hash_table->slots[slot].total_quantity = total_quantity;
+    ++(hash_table->num_keys);
+
+    if (2 * hash_table->num_keys > hash_table->num_slots) {
+        // Re-insert every aggregate into a table twice the size
+        struct Aggregation_Hash_Table larger_hash_table;
+        init_aggregation_hash_table(&larger_hash_table, 2 * hash_table->num_slots);
+        for (unsigned long old_slot = 0; old_slot < hash_table->num_slots; ++old_slot) {
+            if (hash_table->slots[old_slot].key != EMPTY_AGGREGATION_KEY) {
+                cpu_aggregate(&larger_hash_table, hash_table->slots[old_slot].key,
+                                hash_table->slots[old_slot].num_purchases,
+                                hash_table->slots[old_slot].total_quantity);
+            }
+        }
+        free(hash_table->slots);
+        *hash_table = larger_hash_table;
+    }
+
+}
+
+// Joins and aggregates a slice of the purchases table into the slice's own hash table
+static void* cpu_aggregate_slice(void* slice_arg) {
+
+    struct Cpu_Aggregation_Slice* slice = (struct Cpu_Aggregation_Slice*) slice_arg;
+    const struct Hashed_Customer_Table_Row* customer_table = slice->tables_list.hashed_customer_table->table;
+    const struct Purchases_Table_Row* purchases_table = slice->tables_list.purchases_table->table;
+
+    init_aggregation_hash_table(&(slice->hash_table), INITIAL_CPU_AGGREGATION_SLOTS);
+
+    for (unsigned long purchases_table_row = slice->first_row;
+         purchases_table_row < slice->first_row + slice->num_rows; ++purchases_table_row) {
+
+        const unsigned long hashed_customer_table_row =
+                    customer_id_to_row_index(purchases_table[purchases_table_row].customer_id);
+
+        // Filtered out records never touch the customer table, as in "serial_hash_equijoin_probe"
+        if (evaluate_purchase_predicate(slice->purchase_predicate, &(purchases_table[purchases_table_row])) &&
+            customer_table[hashed_customer_table_row].active_customer == slice->is_customer_active) {
+            const unsigned long key = (slice->key_column == AGGREGATION_KEY_EAN13) ?
+                                         ean13_to_aggregation_key(purchases_table[purchases_table_row].ean13) :
+                                         customer_table[hashed_customer_table_row].customer_id;
+            cpu_aggregate(&(slice->hash_table), key, 1, purchases_table[purchases_table_row].quantity_purchased);
+        }
+
+    }
+
+    return NULL;
+
+}
+
+void cpu_hash_equijoin_aggregate(struct List_Of_Tables tables_list, char is_customer_active,
+                                   const struct Purchase_Predicate* purchase_predicate,
+                                     enum Aggregation_Key_Column key_column, unsigned int num_threads,
+                                       struct Aggregated_Results_Table* aggregated_results) {
+
+    // No null pointers allowed
+    assert(aggregated_results != NULL);
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    // Check that "is_customer_active" is of valid value
+    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG || is_customer_active == CUSTOMER_INACTIVE_FLAG);
+
+    num_threads = resolve_num_threads(num_threads);
+    const unsigned long num_purchases_rows = tables_list.purchases_table->num_records;
+    if (num_threads > num_purchases_rows) {
+        num_threads = (num_purchases_rows > 0) ? (unsigned int) num_purchases_rows : 1;
+    }
+    printf(NOTIFY_USER_CPU_AGGREGATION, AGGREGATION_KEY_COLUMN_NAMES[key_column], num_threads);
+
+    struct Cpu_Aggregation_Slice* slices = malloc(num_threads * sizeof(*slices));
+    assert(slices != NULL);
+    int thread_status;
+
+    unsigned long first_row = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].tables_list = tables_list;
+        slices[slice_index].is_customer_active = is_customer_active;
+        slices[slice_index].purchase_predicate = purchase_predicate;
+        slices[slice_index].key_column = key_column;
+        slices[slice_index].first_row = first_row;
+        slices[slice_index].num_rows = slice_num_rows(num_purchases_rows, num_threads, slice_index);
+        first_row += slices[slice_index].num_rows;
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, cpu_aggregate_slice,
+                                                                      &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+
+    // Merge every thread's hash table into the first thread's as each thread finishes
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+        if (slice_index == 0) {
+            continue;
+        }
+        const struct Aggregation_Hash_Table* hash_table = &(slices[slice_index].hash_table);
+        for (unsigned long slot = 0; slot < hash_table->num_slots; ++slot) {
+            if (hash_table->slots[slot].key != EMPTY_AGGREGATION_KEY) {
+                cpu_aggregate(&(slices[0].hash_table), hash_table->slots[slot].key,
+                                hash_table->slots[slot].num_purchases, hash_table->slots[slot].total_quantity);
+            }
+        }
+        free(hash_table->slots);
+    }
+
+    // Compact the merged hash table into rows sorted by key
+    const struct Aggregation_Hash_Table* merged_hash_table = &(slices[0].hash_table);
+    aggregated_results->key_column = key_column;
+    aggregated_results->num_records = 0;
+    aggregated_results->table = malloc((merged_hash_table->num_keys > 0 ? merged_hash_table->num_keys : 1) *
+                                          sizeof(*(aggregated_results->table)));
+    assert(aggregated_results->table != NULL);
+    for (unsigned long slot = 0; slot < merged_hash_table->num_slots; ++slot) {
+        if (merged_hash_table->slots[slot].key != EMPTY_AGGREGATION_KEY) {
+            aggregated_results->table[(aggregated_results->num_records)++] = merged_hash_table->slots[slot];
+        }
+    }
+    qsort(aggregated_results->table, aggregated_results->num_records, sizeof(*(aggregated_results->table)),
+            compare_aggregated_rows);
+
+    free(merged_hash_table->slots);
+    free(slices);
+
+}
+
+void write_aggregated_results_to_csv_file(const struct Aggregated_Results_Table* aggregated_results,
+                                            const char* file_location) {
+
+    // Assert non-null pointers
+    assert(aggregated_results != NULL);
+    assert(aggregated_results->table != NULL);
+    assert(file_location != NULL);
+
+    FILE* aggregated_results_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (aggregated_results_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    // Inform user this program is beginning to write table contents to disk.
+    printf(WRITING_AGGREGATED_RESULTS_MSG, aggregated_results->num_records, file_location);
+
+    const bool is_keyed_by_ean13 = aggregated_results->key_column == AGGREGATION_KEY_EAN13;
+    fprintf(aggregated_results_file, is_keyed_by_ean13 ? AGGREGATED_BY_EAN13_HEADER : AGGREGATED_BY_CUSTOMER_ID_HEADER);
+    for (unsigned long row_index = 0; row_index < aggregated_results->num_records; ++row_index) {
+        const struct Aggregated_Results_Row* row = &(aggregated_results->table[row_index]);
+        if (is_keyed_by_ean13) {
+            // Turn the key back into the barcode, leading zeros included
+            fprintf(aggregated_results_file, AGGREGATED_BY_EAN13_ROW_FORMAT,
+                      (int)(row->key >> EAN13_KEY_DIGITS_SHIFT), row->key & ((1ul << EAN13_KEY_DIGITS_SHIFT) - 1),
+                      row->num_purchases, row->total_quantity);
+        } else {
+            fprintf(aggregated_results_file, AGGREGATED_BY_CUSTOMER_ID_ROW_FORMAT, row->key, row->num_purchases,
+                      row->total_quantity);
+        }
+    }
+
+    // Done writing to file; close it
+    int func_status = fclose(aggregated_results_file);
+    assert(func_status == 0);
+
+}
+
+bool aggregated_results_tables_equal(const struct Aggregated_Results_Table* first_aggregated_results,
+                                       const struct Aggregated_Results_Table* second_aggregated_results) {
+
+    // Assert non-null pointers
+    assert(first_aggregated_results != NULL);
+    assert(second_aggregated_results != NULL);
+
+    if (first_aggregated_results->key_column != second_aggregated_results->key_column ||
+        first_aggregated_results->num_records != second_aggregated_results->num_records) {
+        return false;
+    }
+    // Both tables are sorted by key, so equal tables are equal row for row
+    return first_aggregated_results->num_records == 0 ||
+           memcmp(first_aggregated_results->table, second_aggregated_results->table,
+                    first_aggregated_results->num_records * sizeof(*(first_aggregated_results->table))) == 0;
+
+}
+
+// =================================================================================================
@@ -0,0 +1,480 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for probing a batch of queries over the same customer
+// and purchases tables in a single pass, both on an OpenCL device and on the CPU.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <bsd/string.h>
+#include "equijoin_batch_queries.h"
+
+// Name of the macro holding the predicate of query "query_index" in the batch's program
+#define BATCH_QUERY_PREDICATE_NAME_FORMAT "BATCH_QUERY_PREDICATE_%u"
+// Most characters of the name of a query's predicate macro
+#define MAX_BATCH_QUERY_PREDICATE_NAME_LEN 48
+// Room for everything but the predicates in front of the batch's program
+#define BATCH_PROGRAM_PREFIX_OVERHEAD (MAX_BATCH_QUERIES * 128 + 512)
+
+// Header and row format of each column of a Joined_Results_Table_Row, in PROJECT_* bit order
+static const char* const JOINED_RESULT_COLUMN_HEADERS[JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT] = {
+    "\"epochTimePurchased\"", "\"customerID\"", "\"customerName\"", "\"purchaseEAN13\"", "\"purchaseQuantity\""
+};
+
+// =================================================================================================
+
+/*
+ * Writes into "source_prefix" the "#define"s the batch kernels of the OpenCL program file need
+ * for "queries" (see "equijoin_program.cl"); "source_prefix" MUST have room for
+ * "num_queries" * MAX_PREDICATE_SOURCE_LEN + BATCH_PROGRAM_PREFIX_OVERHEAD bytes.
+ */
+static void batch_queries_to_opencl_c(const struct Batch_Query* queries, unsigned int num_queries,
+                                        char* source_prefix) {
+
+    size_t source_used = 0;
+    unsigned int active_mask = 0;
+    char predicate_name[MAX_BATCH_QUERY_PREDICATE_NAME_LEN];
+
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        snprintf(predicate_name, sizeof(predicate_name), BATCH_QUERY_PREDICATE_NAME_FORMAT, query_index);
+        purchase_predicate_to_opencl_c_macro(&(queries[query_index].predicate), predicate_name,
+                                               source_prefix + source_used, MAX_PREDICATE_SOURCE_LEN);
+        source_used += strlen(source_prefix + source_used);
+        if (queries[query_index].is_customer_active == CUSTOMER_ACTIVE_FLAG) {
+            active_mask |= 1u << query_index;
+        }
+    }
+
+    source_used += sprintf(source_prefix + source_used, "#define NUM_BATCH_QUERIES %u\n", num_queries);
+    source_used += sprintf(source_prefix + source_used, "#define BATCH_QUERY_ACTIVE_MASK %uu\n", active_mask);
+    source_used += sprintf(source_prefix + source_used, "#define BATCH_QUERY_PURCHASE_MASK(purchase_row) (0u");
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        source_used += sprintf(source_prefix + source_used, " | (" BATCH_QUERY_PREDICATE_NAME_FORMAT
+                                 "(purchase_row) ? %uu : 0u)", query_index, 1u << query_index);
+    }
+    source_used += sprintf(source_prefix + source_used, ")\n#define BATCH_QUERY_PROJECTIONS {");
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        source_used += sprintf(source_prefix + source_used, "%s%uu", (query_index > 0) ? ", " : "",
+                                 queries[query_index].projection);
+    }
+    sprintf(source_prefix + source_used, "}\n");
+
+}
+
+// Checks what every batch probing function requires of its arguments
+static void assert_valid_batch(struct List_Of_Tables tables_list, const struct Batch_Query* queries,
+                                 unsigned int num_queries, const struct Joined_Results_Table* query_results) {
+
+    // No null pointers allowed
+    assert(queries != NULL);
+    assert(query_results != NULL);
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    // Each table HAS to have at least 1 row
+    assert(tables_list.hashed_customer_table->num_records >= 1);
+    assert(tables_list.purchases_table->num_records >= 1);
+    // Every query gets one bit of a match mask
+    assert(num_queries >= 1 && num_queries <= MAX_BATCH_QUERIES);
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        assert(queries[query_index].is_customer_active == CUSTOMER_ACTIVE_FLAG ||
+               queries[query_index].is_customer_active == CUSTOMER_INACTIVE_FLAG);
+        assert((queries[query_index].projection & ~PROJECT_ALL_COLUMNS) == 0);
+    }
+
+}
+
+void opencl_batch_hash_equijoin_probe(cl_context* context, cl_command_queue* queue,
+                                        struct Predicate_Program_Cache* program_cache,
+                                          struct List_Of_Tables tables_list, const struct Batch_Query* queries,
+                                            unsigned int num_queries, const struct Probe_Kernel_Variant* kernel_variant,
+                                              struct Opencl_Profiling_Report* profiling_report,
+                                                struct Joined_Results_Table* query_results) {
+    // No null pointers allowed
+    assert(context != NULL);
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert_valid_batch(tables_list, queries, num_queries, query_results);
+
+    printf(NOTIFY_USER_DEVICE_BATCH, num_queries);
+
+    // Compile (or reuse) the program with every query of the batch inlined into it
+    static const struct Probe_Kernel_Variant one_row_per_work_item = { NULL, 1, "", NUM_THREADS_IN_BLOCK, NULL };
+    if (kernel_variant == NULL) {
+        kernel_variant = &one_row_per_work_item;
+    }
+    char* source_prefix = malloc(num_queries * MAX_PREDICATE_SOURCE_LEN + BATCH_PROGRAM_PREFIX_OVERHEAD);
+    assert(source_prefix != NULL);
+    batch_queries_to_opencl_c(queries, num_queries, source_prefix);
+    cl_program program = get_program_with_source_prefix(program_cache, source_prefix, kernel_variant);
+    free(source_prefix);
+
+    cl_int func_error_code;
+    const unsigned long num_purchases_rows = tables_list.purchases_table->num_records;
+    const size_t customer_table_size = tables_list.hashed_customer_table->num_records *
+                                          sizeof(*(tables_list.hashed_customer_table->table));
+    const size_t purchases_table_size = num_purchases_rows * sizeof(*(tables_list.purchases_table->table));
+
+    // Both passes MUST be run with the same work-groups, as the second relies on the first's counts
+    const unsigned int rows_per_work_item = kernel_variant->rows_per_work_item;
+    const size_t num_work_items = (num_purchases_rows + rows_per_work_item - 1) / rows_per_work_item;
+    const size_t work_group_size = kernel_variant->work_group_size;
+    // Both kernels scan the work-group's counts in local memory of MAX_BATCH_WORK_GROUP_SIZE entries
+    assert(work_group_size <= MAX_BATCH_WORK_GROUP_SIZE);
+    const size_t num_work_groups = (num_work_items + work_group_size - 1) / work_group_size;
+    const size_t local[OPERAND_DIMS] = { work_group_size };
+    const size_t global[OPERAND_DIMS] = { num_work_groups * work_group_size };
+    const size_t group_counts_size = num_work_groups * num_queries * sizeof(cl_uint);
+    const size_t group_offsets_size = num_work_groups * num_queries * sizeof(cl_ulong);
+
+    cl_mem customer_table_buffer = clCreateBuffer(*context, CL_MEM_READ_ONLY, customer_table_size,
+                                                                      NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem purchases_table_buffer = clCreateBuffer(*context, CL_MEM_READ_ONLY, purchases_table_size,
+                                                                       NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem match_masks_buffer = clCreateBuffer(*context, CL_MEM_READ_WRITE, num_purchases_rows * sizeof(cl_uint),
+                                                                                    NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem group_counts_buffer = clCreateBuffer(*context, CL_MEM_WRITE_ONLY, group_counts_size,
+                                                                    NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    cl_event upload_events[2];
+    func_error_code = clEnqueueWriteBuffer(*queue, customer_table_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                                             customer_table_size, tables_list.hashed_customer_table->table,
+                                             0, NULL, &(upload_events[0]));
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clEnqueueWriteBuffer(*queue, purchases_table_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                                             purchases_table_size, tables_list.purchases_table->table,
+                                             0, NULL, &(upload_events[1]));
+    assert(func_error_code == CL_SUCCESS);
+
+    // First pass: which queries join each purchase, and how many rows each work-group has per query
+    cl_kernel count_kernel = clCreateKernel(program, COUNT_BATCH_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clSetKernelArg(count_kernel, 0, sizeof(customer_table_buffer), &customer_table_buffer);
+    func_error_code |= clSetKernelArg(count_kernel, 1, sizeof(purchases_table_buffer), &purchases_table_buffer);
+    func_error_code |= clSetKernelArg(count_kernel, 2, sizeof(match_masks_buffer), &match_masks_buffer);
+    func_error_code |= clSetKernelArg(count_kernel, 3, sizeof(group_counts_buffer), &group_counts_buffer);
+    func_error_code |= clSetKernelArg(count_kernel, 4, sizeof(num_purchases_rows), &num_purchases_rows);
+    assert(func_error_code == CL_SUCCESS);
+    cl_event count_event, counts_read_event;
+    func_error_code = clEnqueueNDRangeKernel(*queue, count_kernel, OPERAND_DIMS, NULL, global, local,
+                                               2, upload_events, &count_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    cl_uint* group_counts = malloc(group_counts_size);
+    assert(group_counts != NULL);
+    func_error_code = clEnqueueReadBuffer(*queue, group_counts_buffer, CL_BLOCKING, CL_BUFFER_OFFSET,
+                                            group_counts_size, group_counts, 1, &count_event, &counts_read_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Lay the queries' results out one after the other, each work-group's rows after the previous one's
+    cl_ulong* group_offsets = malloc(group_offsets_size);
+    assert(group_offsets != NULL);
+    unsigned long* first_result_rows = malloc(num_queries * sizeof(*first_result_rows));
+    assert(first_result_rows != NULL);
+    unsigned long num_batch_result_rows = 0;
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        first_result_rows[query_index] = num_batch_result_rows;
+        for (size_t group = 0; group < num_work_groups; ++group) {
+            group_offsets[group * num_queries + query_index] = num_batch_result_rows;
+            num_batch_result_rows += group_counts[group * num_queries + query_index];
+        }
+        query_results[query_index].num_records = num_batch_result_rows - first_result_rows[query_index];
+    }
+    free(group_counts);
+
+    // Second pass: route every joined record to its place in each query's compacted results
+    const size_t batch_results_size = (num_batch_result_rows > 0 ? num_batch_result_rows : 1) *
+                                        sizeof(struct Joined_Results_Table_Row);
+    cl_mem group_offsets_buffer = clCreateBuffer(*context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                                   group_offsets_size, group_offsets, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    free(group_offsets);
+    cl_mem batch_results_buffer = clCreateBuffer(*context, CL_MEM_WRITE_ONLY, batch_results_size,
+                                                                     NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    cl_kernel write_kernel = clCreateKernel(program, WRITE_BATCH_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clSetKernelArg(write_kernel, 0, sizeof(customer_table_buffer), &customer_table_buffer);
+    func_error_code |= clSetKernelArg(write_kernel, 1, sizeof(purchases_table_buffer), &purchases_table_buffer);
+    func_error_code |= clSetKernelArg(write_kernel, 2, sizeof(match_masks_buffer), &match_masks_buffer);
+    func_error_code |= clSetKernelArg(write_kernel, 3, sizeof(group_offsets_buffer), &group_offsets_buffer);
+    func_error_code |= clSetKernelArg(write_kernel, 4, sizeof(batch_results_buffer), &batch_results_buffer);
+    func_error_code |= clSetKernelArg(write_kernel, 5, sizeof(num_purchases_rows), &num_purchases_rows);
+    assert(func_error_code == CL_SUCCESS);
+    cl_event write_event;
+    func_error_code = clEnqueueNDRangeKernel(*queue, write_kernel, OPERAND_DIMS, NULL, global, local,
+                                               0, NULL, &write_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Read back each query's rows straight into its own table
+    cl_event* results_read_events = malloc(num_queries * sizeof(*results_read_events));
+    assert(results_read_events != NULL);
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        const unsigned long num_records = query_results[query_index].num_records;
+        query_results[query_index].table = malloc((num_records > 0 ? num_records : 1) *
+                                                    sizeof(*(query_results[query_index].table)));
+        assert(query_results[query_index].table != NULL);
+        results_read_events[query_index] = NULL;
+        if (num_records > 0) {
+            func_error_code = clEnqueueReadBuffer(*queue, batch_results_buffer, CL_NON_BLOCKING,
+                                                    first_result_rows[query_index] *
+                                                      sizeof(*(query_results[query_index].table)),
+                                                    num_records * sizeof(*(query_results[query_index].table)),
+                                                    query_results[query_index].table, 1, &write_event,
+                                                    &(results_read_events[query_index]));
+            assert(func_error_code == CL_SUCCESS);
+        }
+    }
+    func_error_code = clFinish(*queue);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Record how long each phase took
+    record_opencl_command_profile(profiling_report, upload_events[0], PROFILING_PHASE_UPLOAD,
+                                    "hashed_customer_table", customer_table_size,
+                                    tables_list.hashed_customer_table->num_records);
+    record_opencl_command_profile(profiling_report, upload_events[1], PROFILING_PHASE_UPLOAD,
+                                    "purchases_table", purchases_table_size, num_purchases_rows);
+    record_opencl_command_profile(profiling_report, count_event, PROFILING_PHASE_KERNEL,
+                                    COUNT_BATCH_KERNEL_FUNC_NAME, customer_table_size + purchases_table_size,
+                                    num_purchases_rows);
+    record_opencl_command_profile(profiling_report, counts_read_event, PROFILING_PHASE_READBACK,
+                                    "group_match_counts", group_counts_size, num_work_groups * num_queries);
+    record_opencl_command_profile(profiling_report, write_event, PROFILING_PHASE_KERNEL,
+                                    WRITE_BATCH_KERNEL_FUNC_NAME, batch_results_size, num_batch_result_rows);
+    clReleaseEvent(upload_events[0]);
+    clReleaseEvent(upload_events[1]);
+    clReleaseEvent(count_event);
+    clReleaseEvent(counts_read_event);
+    clReleaseEvent(write_event);
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        if (results_read_events[query_index] != NULL) {
+            record_opencl_command_profile(profiling_report, results_read_events[query_index], PROFILING_PHASE_READBACK,
+                                            "batch_query_results",
+                                            query_results[query_index].num_records *
+                                              sizeof(*(query_results[query_index].table)),
+                                            query_results[query_index].num_records);
+            clReleaseEvent(results_read_events[query_index]);
+        }
+        printf(BATCH_QUERY_RESULT_MSG, query_index, query_results[query_index].num_records);
+    }
+    printf("\n");
+    free(results_read_events);
+    free(first_result_rows);
+
+    clReleaseKernel(count_kernel);
+    clReleaseKernel(write_kernel);
+    clReleaseMemObject(customer_table_buffer);
+    clReleaseMemObject(purchases_table_buffer);
+    clReleaseMemObject(match_masks_buffer);
+    clReleaseMemObject(group_counts_buffer);
+    clReleaseMemObject(group_offsets_buffer);
+    clReleaseMemObject(batch_results_buffer);
+
+}
+
+/*
+ * Stores row "purchases_row" joined with "customer_row" in "result_row", keeping only the
+ * columns in "projection" and zeroing out the others, as "store_projected_joined_row" does
+ * on the device.
+ */
+static void store_projected_joined_row(const struct Hashed_Customer_Table_Row* customer_row,
+                                         const struct Purchases_Table_Row* purchases_row,
+                                         struct Joined_Results_Table_Row* result_row, unsigned int projection) {
+
+    memset(result_row, 0, sizeof(*result_row));
+    if (projection & PROJECT_TIME_OF_PURCHASE) {
+        result_row->time_of_purchase = purchases_row->time_of_purchase;
+    }
+    if (projection & PROJECT_CUSTOMER_ID) {
+        result_row->customer_id_customer = customer_row->customer_id;
+    }
+    if (projection & PROJECT_FIRST_NAME) {
+        strlcpy(result_row->first_name_customer, customer_row->first_name, FIRST_NAME_MAX_LEN);
+    }
+    if (projection & PROJECT_EAN13) {
+        strlcpy(result_row->ean13, purchases_row->ean13, EAN13_MAX_CHARS);
+    }
+    if (projection & PROJECT_QUANTITY_PURCHASED) {
+        result_row->quantity_purchased = purchases_row->quantity_purchased;
+    }
+
+}
+
+void cpu_batch_hash_equijoin_probe(struct List_Of_Tables tables_list, const struct Batch_Query* queries,
+                                     unsigned int num_queries, struct Joined_Results_Table* query_results) {
+
+    assert_valid_batch(tables_list, queries, num_queries, query_results);
+    printf(NOTIFY_USER_CPU_BATCH, num_queries);
+
+    const struct Hashed_Customer_Table_Row* customer_table = tables_list.hashed_customer_table->table;
+    const struct Purchases_Table_Row* purchases_table = tables_list.purchases_table->table;
+
+    unsigned long* result_capacities = malloc(num_queries * sizeof(*result_capacities));
+    assert(result_capacities != NULL);
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        result_capacities[query_index] = INITIAL_CPU_BATCH_RESULT_ROWS;
+        query_results[query_index].table = malloc(INITIAL_CPU_BATCH_RESULT_ROWS *
+                                                    sizeof(*(query_results[query_index].table)));
+        assert(query_results[query_index].table != NULL);
+        query_results[query_index].num_records = 0;
+    }
+
+    for (unsigned long purchases_table_row = 0; purchases_table_row < tables_list.purchases_table->num_records;
+         ++purchases_table_row) {
+
+        const struct Purchases_Table_Row* purchases_row = &(purchases_table[purchases_table_row]);
+        unsigned int match_mask = 0;
+        for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+            if (evaluate_purchase_predicate(&(queries[query_index].predicate), purchases_row)) {
+                match_mask |= 1u << query_index;
+            }
+        }
+        // Rows no predicate holds for never touch the customer table
+        if (match_mask == 0) {
+            continue;
+        }
+
+        // One customer lookup serves every query of the batch
+        const struct Hashed_Customer_Table_Row* customer_row =
+                        &(customer_table[customer_id_to_row_index(purchases_row->customer_id)]);
+        for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+            if (!((match_mask >> query_index) & 1u) ||
+                customer_row->active_customer != queries[query_index].is_customer_active) {
+                continue;
+            }
+            struct Joined_Results_Table* results = &(query_results[query_index]);
+            if (results->num_records == result_capacities[query_index]) {
+                result_capacities[query_index] *= 2;
+                results->table = realloc(results->table, result_capacities[query_index] * sizeof(*(results->table)));
+                assert(results->table != NULL);
+            }
+            store_projected_joined_row(customer_row, purchases_row, &(results->table[(results->num_records)++]),
+                                         queries[query_index].projection);
+        }
+
+    }
+
+    for (unsigned int query_index = 0; query_index < num_queries; ++query_index) {
+        printf(BATCH_QUERY_RESULT_MSG, query_index, query_results[query_index].num_records);
+    }
+    printf("\n");
+    free(result_capacities);
+
+}
+
+void write_batch_query_results_to_csv_file(const struct Joined_Results_Table* query_results, unsigned int query_index,
+                                             unsigned int projection, const char* file_location) {
+
+    // Assert non-null pointers
+    assert(query_results != NULL);
+    assert(query_results->table != NULL);
+    assert(file_location != NULL);
+
+    FILE* query_results_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (query_results_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    // Inform user this program is beginning to write table contents to disk.
+    printf(WRITING_BATCH_QUERY_RESULTS_MSG, query_results->num_records, query_index, file_location);
+
+    bool is_first_column = true;
+    for (unsigned int column = 0; column < JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT; ++column) {
+        if (projection & (1u << column)) {
+            fprintf(query_results_file, "%s%s", is_first_column ? "" : ",", JOINED_RESULT_COLUMN_HEADERS[column]);
+            is_first_column = false;
+        }
+    }
+    fprintf(query_results_file, "\n");
+
+    for (unsigned long row_index = 0; row_index < query_results->num_records; ++row_index) {
+        const struct Joined_Results_Table_Row* row = &(query_results->table[row_index]);
+        // Columns in the same order and format as JOINED_RESULT_TABLE_ROW_FORMAT
+        const char* separator = "";
+        if (projection & PROJECT_TIME_OF_PURCHASE) {
+            fprintf(query_results_file, "%s%ld", separator, row->time_of_purchase);
+            separator = ",";
+        }
+        if (projection & PROJECT_CUSTOMER_ID) {
+            fprintf(query_results_file, "%s%ld", separator, row->customer_id_customer);
+            separator = ",";
+        }
+        if (projection & PROJECT_FIRST_NAME) {
+            fprintf(query_results_file, "%s\"%s\"", separator, row->first_name_customer);
+            separator = ",";
+        }
+        if (projection & PROJECT_EAN13) {
+            fprintf(query_results_file, "%s\"%s\"", separator, row->ean13);
+            separator = ",";
+        }
+        if (projection & PROJECT_QUANTITY_PURCHASED) {
+            fprintf(query_results_file, "%s%ld", separator, row->quantity_purchased);
+        }
+        fprintf(query_results_file, "\n");
+    }
+
+    // Done writing to file; close it
+    int func_status = fclose(query_results_file);
+    assert(func_status == 0);
+
+}
+
+bool batch_query_results_equal(const struct Joined_Results_Table* first_query_results,
+                                 const struct Joined_Results_Table* second_query_results, unsigned int projection) {
+
+    // Assert non-null pointers
+    assert(first_query_results != NULL);
+    assert(second_query_results != NULL);
+
+    if (first_query_results->num_records != second_query_results->num_records) {
+        return false;
+    }
+    for (unsigned long row_index = 0; row_index < first_query_results->num_records; ++row_index) {
+        const struct Joined_Results_Table_Row* first_row = &(first_query_results->table[row_index]);
+        const struct Joined_Results_Table_Row* second_row = &(second_query_results->table[row_index]);
+        // Bytes past the end of string fields may differ between engines; compare the strings only
+        if (((projection & PROJECT_TIME_OF_PURCHASE) && first_row->time_of_purchase != second_row->time_of_purchase) ||
+            ((projection & PROJECT_CUSTOMER_ID) && first_row->customer_id_customer != second_row->customer_id_customer) ||
+            ((projection & PROJECT_FIRST_NAME) &&
+               strncmp(first_row->first_name_customer, second_row->first_name_customer, FIRST_NAME_MAX_LEN) != 0) ||
+            ((projection & PROJECT_EAN13) && strncmp(first_row->ean13, second_row->ean13, EAN13_MAX_CHARS) != 0) ||
+            ((projection & PROJECT_QUANTITY_PURCHASED) &&
+               first_row->quantity_purchased != second_row->quantity_purchased)) {
+            return false;
+        }
+    }
+    return true;
+
+}
+
+void free_batch_query_results(struct Joined_Results_Table* query_results) {
+
+    assert(query_results != NULL);
+    free(query_results->table);
+    query_results->table = NULL;
+    query_results->num_records = 0;
+
+}
+
+// =================================================================================================
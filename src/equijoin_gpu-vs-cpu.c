@@ -15,22 +15,41 @@
 // Libraries used by this program with custom headers
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <getopt.h>
+#include <limits.h>
 #include "data_structures_opencl.h"
 #include "table_utilities.h"
 #include "equijoin_opencl.h"
 #include "equijoin_serial.h"
+#include "equijoin_multi_device.h"
+#include "equijoin_streamed_readback.h"
+#include "opencl_profiling.h"
+#include "purchase_predicate.h"
+#include "arrow_results_writer.h"
+#include "results_digest.h"
+#include "equijoin_aggregation.h"
+#include "equijoin_batch_queries.h"
+#include "purchases_time_window.h"
+#include "purchases_zone_map.h"
+#include "equijoin_hot_customers.h"
+#include "hardware_counters.h"
+#include "equijoin_grace.h"
+#include "trace_events.h"
+#include "monotonic_clock.h"
+#include "bandwidth_roofline.h"
+#include "engine_selector.h"
 #include "equijoin_gpu-vs-cpu.h"
 
 // =================================================================================================
 
 /*
  * Initialize "results_table" as an empty table with
- * "num_records" empty records; "num_records" MUST be
- * greater than zero.
+ * "num_records" empty records, each of NULL values (so
+ * that rows engines don't probe are NULL rows);
+ * "num_records" MUST be greater than zero.
  */
 void initialize_results_table(struct Joined_Results_Table ** results_table, const unsigned long num_records) {
 
@@ -43,107 +62,541 @@ void initialize_results_table(struct Joined_Results_Table ** results_table, cons
      assert(*results_table != NULL);
      (*results_table)->num_records = num_records;
      // Now initialize all entries of table to be "blank" records
-     (*results_table)->table = malloc(sizeof(*((*results_table)->table)) * num_records);
+     (*results_table)->table = calloc(num_records, sizeof(*((*results_table)->table)));
      assert((*results_table)->table != NULL);
 
 }
 
-/* 
- * Given a specified file location containing an OpenCL program
- * reads the entire contents of the file into memory and returns
- * a pointer marking the start of the contents in memory.
+/*
+ * Parses "option_value" of command-line option "option_name" as an unsigned number;
+ * exits with an error message if "option_value" isn't one.
  */
-char* get_opencl_program_code(char* opencl_program_file_location) {
-   
-      // No null pointers allowed
-      assert(opencl_program_file_location != NULL);
-
-      char *source_code_content = NULL;
-      const char *file_read_mode = "r";
-      const char *file_open_error_msg = "Error opening %s: %s.\n";
-      const char *file_io_error_msg = "Error reading %s: %s\n";
-      FILE *opencl_prog_file = fopen(opencl_program_file_location, file_read_mode);
-
-      if (opencl_prog_file == NULL) {
-         int global_err_num = errno;
-         fprintf(stderr, file_open_error_msg, opencl_program_file_location,
-                                                       strerror(global_err_num));
-         exit(global_err_num);
-      } else {
-            size_t init_buffer_size = 0;
-            ssize_t num_bytes_read = getdelim(&source_code_content, &init_buffer_size,
-                                                      TEXT_FILE_DELIM, opencl_prog_file);
-            if (num_bytes_read < 0) {
-                   int global_err_num = errno;
-                   fprintf(stderr, file_io_error_msg, opencl_program_file_location,
-                                                                strerror(global_err_num));
-                   exit(global_err_num);
-            }
-      }
-
-      return source_code_content;
+static unsigned long parse_unsigned_option_value(const char* option_name, const char* option_value) {
+
+    char* value_end;
+    errno = 0;
+    unsigned long value = strtoul(option_value, &value_end, 10);
+    if (errno != 0 || value_end == option_value || *value_end != '\0' || option_value[0] == '-') {
+        fprintf(stderr, INVALID_OPTION_VALUE_MESSAGE, option_value, option_name);
+        exit(EXIT_FAILURE);
+    }
+    return value;
 
 }
 
 /*
- * Setup procedure for executing OpenCL programs.  The procedure involves
- * creating an execution context to be used by the OpenCL-programmed device
- * (in this case the GPU or CPU), setting up the queue which is used to store
- * the kernels to be executed by the device within the execution context, and
- * then dynamically compiling the program containing the kernels which are to be
- * executed once the kernels (or even multiple copies of each kernel) gets added
- * to the queue.
+ * Builds "purchase_predicate" out of the command-line options this program was run with, sets
+ * "is_aggregation_mode" (and "key_column") according to whether joined records are to be
+ * aggregated, "is_batch_mode" according to whether a batch of queries is to be probed,
+ * "is_hot_customer_mode" according to whether to probe with a hot customer table,
+ * "memory_budget_mb" to the memory budget of joining out of core (0 to join in memory),
+ * "trace_file_location" to the file to write a trace of this program to (NULL not to trace it),
+ * "is_roofline_mode" according to whether to report phases against measured bandwidth peaks,
+ * "is_engine_selection_mode" according to whether to probe with only the engine predicted fastest,
+ * "is_recalibration_forced" according to whether to calibrate the engine cost model again, and
+ * "is_prediction_logged" according to whether to log predicted and actual probing times;
+ * prints out usage and exits if any option can't be understood.
  */
-void configure_opencl_env(cl_context *context, cl_command_queue* queue,
-                                                      cl_program *program) {
-    
-    // No null pointers allowed
-    assert(context != NULL);
-    assert(queue != NULL);
-    assert(program != NULL);
+static void parse_command_line_options(int argc, char* argv[], struct Purchase_Predicate* purchase_predicate,
+                                         bool* is_aggregation_mode, enum Aggregation_Key_Column* key_column,
+                                           bool* is_batch_mode, bool* is_hot_customer_mode,
+                                             unsigned long* memory_budget_mb, const char** trace_file_location,
+                                               bool* is_roofline_mode, bool* is_engine_selection_mode,
+                                                 bool* is_recalibration_forced, bool* is_prediction_logged) {
+
+    static const struct option long_options[] = {
+        {"min-quantity", required_argument, NULL, 'q'},
+        {"max-quantity", required_argument, NULL, 'Q'},
+        {"from-time", required_argument, NULL, 't'},
+        {"to-time", required_argument, NULL, 'T'},
+        {"ean13-prefix", required_argument, NULL, 'e'},
+        {"aggregate-by", required_argument, NULL, 'a'},
+        {"batch", no_argument, NULL, 'b'},
+        {"hot-customers", no_argument, NULL, 'h'},
+        {"memory-budget", required_argument, NULL, 'm'},
+        {"trace", required_argument, NULL, 'r'},
+        {"roofline", no_argument, NULL, 'o'},
+        {"select-engine", no_argument, NULL, 's'},
+        {"recalibrate", no_argument, NULL, 'c'},
+        {"log-predictions", no_argument, NULL, 'l'},
+        {NULL, 0, NULL, 0}
+    };
+    int option_index = 0;
+    int option_char;
+
+    init_purchase_predicate(purchase_predicate);
+    *is_aggregation_mode = false;
+    *is_batch_mode = false;
+    *is_hot_customer_mode = false;
+    *memory_budget_mb = 0;
+    *trace_file_location = NULL;
+    *is_roofline_mode = false;
+    *is_engine_selection_mode = false;
+    *is_recalibration_forced = false;
+    *is_prediction_logged = false;
+
+    while ((option_char = getopt_long(argc, argv, "", long_options, &option_index)) != -1) {
+        switch (option_char) {
+            case 'q':
+                add_purchase_predicate_term(purchase_predicate, PREDICATE_COLUMN_QUANTITY_PURCHASED, PREDICATE_OP_GE,
+                                              parse_unsigned_option_value(long_options[option_index].name, optarg));
+                break;
+            case 'Q':
+                add_purchase_predicate_term(purchase_predicate, PREDICATE_COLUMN_QUANTITY_PURCHASED, PREDICATE_OP_LE,
+                                              parse_unsigned_option_value(long_options[option_index].name, optarg));
+                break;
+            case 't':
+                add_purchase_predicate_term(purchase_predicate, PREDICATE_COLUMN_TIME_OF_PURCHASE, PREDICATE_OP_GE,
+                                              parse_unsigned_option_value(long_options[option_index].name, optarg));
+                break;
+            case 'T':
+                add_purchase_predicate_term(purchase_predicate, PREDICATE_COLUMN_TIME_OF_PURCHASE, PREDICATE_OP_LT,
+                                              parse_unsigned_option_value(long_options[option_index].name, optarg));
+                break;
+            case 'e':
+                if (strlen(optarg) >= EAN13_MAX_CHARS || strspn(optarg, "0123456789") != strlen(optarg)) {
+                    fprintf(stderr, INVALID_OPTION_VALUE_MESSAGE, optarg, long_options[option_index].name);
+                    exit(EXIT_FAILURE);
+                }
+                add_purchase_predicate_ean13_prefix(purchase_predicate, optarg);
+                break;
+            case 'a':
+                if (strcmp(optarg, AGGREGATE_BY_CUSTOMER_ID_VALUE) == 0) {
+                    *key_column = AGGREGATION_KEY_CUSTOMER_ID;
+                } else if (strcmp(optarg, AGGREGATE_BY_EAN13_VALUE) == 0) {
+                    *key_column = AGGREGATION_KEY_EAN13;
+                } else {
+                    fprintf(stderr, INVALID_OPTION_VALUE_MESSAGE, optarg, long_options[option_index].name);
+                    exit(EXIT_FAILURE);
+                }
+                *is_aggregation_mode = true;
+                break;
+            case 'b':
+                *is_batch_mode = true;
+                break;
+            case 'h':
+                *is_hot_customer_mode = true;
+                break;
+            case 'm':
+                *memory_budget_mb = parse_unsigned_option_value(long_options[option_index].name, optarg);
+                if (*memory_budget_mb == 0) {
+                    fprintf(stderr, INVALID_OPTION_VALUE_MESSAGE, optarg, long_options[option_index].name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                *trace_file_location = optarg;
+                break;
+            case 'o':
+                *is_roofline_mode = true;
+                break;
+            case 's':
+                *is_engine_selection_mode = true;
+                break;
+            case 'c':
+                *is_recalibration_forced = true;
+                break;
+            case 'l':
+                *is_prediction_logged = true;
+                break;
+            default:
+                fprintf(stderr, USAGE_MESSAGE, argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        fprintf(stderr, USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+    }
 
+}
+
+/*
+ * Joins the tables in "tables_list" fused with aggregating the joined records by "key_column",
+ * both on the default OpenCL device (if it supports aggregation) and on the CPU; writes both
+ * aggregated results to disk and checks that they agree.
+ */
+static void hash_equijoin_aggregate(struct List_Of_Tables tables_list,
+                                      const struct Purchase_Predicate* pushed_down_predicate,
+                                        enum Aggregation_Key_Column key_column) {
+
+    double aggregate_start_time, aggregate_end_time;
+
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
     cl_device_id device;
-    char deviceName[MAX_LEN];
-    cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
-    cl_platform_id *platforms = malloc(sizeof(*platforms) * NUM_CL_PLATFORMS);
-    
-    clGetPlatformIDs(NUM_CL_PLATFORMS, platforms, NULL);
-    clGetDeviceIDs(platforms[DESIRED_PLATFORM_INDEX], CL_DEVICE_TYPE_DEFAULT, NUM_CL_DEVICES, &device, NULL);
-    *context = clCreateContext(NULL, NUM_CL_DEVICES, &device, NULL, NULL, NULL);
-    *queue = clCreateCommandQueueWithProperties(*context, device, queue_properties, NULL);
+    struct Probe_Kernel_Variant kernel_variant;
+    struct Opencl_Profiling_Report profiling_report;
+    reset_opencl_profiling_report(&profiling_report);
 
-    // read OpenCL program file into string
-    const char* opencl_program_string = get_opencl_program_code(PROGRAM_FILE);
+    unsigned long trace_start = trace_clock_nanosecs();
+    configure_opencl_env(&context, &queue, &program, &kernel_variant);
+    cl_int func_error_code = clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL);
+    assert(func_error_code == CL_SUCCESS);
 
-    clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_LEN, deviceName, NULL);
+    struct Predicate_Program_Cache predicate_program_cache;
+    init_predicate_program_cache(&predicate_program_cache, context);
+    if (pushed_down_predicate != NULL) {
+        clReleaseProgram(program);
+        program = get_predicate_program(&predicate_program_cache, pushed_down_predicate, &kernel_variant);
+        clRetainProgram(program);
+    }
+    record_trace_span(TRACE_CATEGORY_BUILD, "opencl build", trace_start);
+    struct Trace_Device_Clock device_clock;
+    calibrate_trace_device_clock(queue, &device_clock);
 
+    struct Aggregated_Results_Table device_aggregated_results = { NULL, 0, key_column };
+    const bool is_device_aggregation_supported = opencl_device_supports_aggregation(device);
+    if (is_device_aggregation_supported) {
+        aggregate_start_time = monotonic_clock_secs();
 
-    if (opencl_program_string != NULL) {
+        trace_start = trace_clock_nanosecs();
+        opencl_hash_equijoin_aggregate(&context, &queue, &program, tables_list, IS_CUSTOMER_ACTIVE, key_column,
+                                         &kernel_variant, &profiling_report, &device_aggregated_results);
+        record_trace_span(TRACE_CATEGORY_PROBE, "opencl aggregate", trace_start);
+        record_opencl_profiling_trace(&profiling_report, &device_clock);
 
-        // Compile the opencl_program
-        *program = clCreateProgramWithSource(*context, OPENCL_PROGS, &opencl_program_string, NULL, NULL);
-        clBuildProgram(*program, 0, NULL, OPENCL_COMPILER_OPTIONS, NULL, NULL);
+        aggregate_end_time = monotonic_clock_secs();
+        printf(EQUIJOIN_AGGREGATE_DEVICE_MESSAGE,
+                     tables_list.hashed_customer_table->num_records,
+                     tables_list.purchases_table->num_records,
+                     device_aggregated_results.num_records,
+                       aggregate_end_time - aggregate_start_time);
+    } else {
+        printf(AGGREGATION_UNSUPPORTED_MSG, AGGREGATION_REQUIRED_EXTENSION);
+    }
 
-        // Get info generated by compiler and output any compiler-generated messages to user
-        size_t logSize;
-        clGetProgramBuildInfo(*program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
-        char* messages = (char*)malloc((1+logSize)*sizeof(char));
-        clGetProgramBuildInfo(*program, device, CL_PROGRAM_BUILD_LOG, logSize, messages, NULL);
-        messages[logSize] = TEXT_FILE_DELIM;
-        printf(">>> OpenCL program compiler result message: - %s\n\n", messages); 
-        free(messages);
-    
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    clReleaseProgram(program);
+    release_predicate_program_cache(&predicate_program_cache);
+
+#if (PRINT_OPENCL_PROFILING_REPORT)
+    if (is_device_aggregation_supported) {
+        print_opencl_profiling_report(&profiling_report);
+        write_opencl_profiling_report_to_json_file(&profiling_report, OPENCL_PROFILING_REPORT_FILE_PATH);
+    }
+#endif
+
+    struct Aggregated_Results_Table cpu_aggregated_results;
+
+    aggregate_start_time = monotonic_clock_secs();
+
+    trace_start = trace_clock_nanosecs();
+    cpu_hash_equijoin_aggregate(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate, key_column,
+                                  AGGREGATION_CPU_THREADS, &cpu_aggregated_results);
+    record_trace_span(TRACE_CATEGORY_PROBE, "cpu aggregate", trace_start);
+
+    aggregate_end_time = monotonic_clock_secs();
+    printf(EQUIJOIN_AGGREGATE_CPU_MESSAGE,
+                 tables_list.hashed_customer_table->num_records,
+                 tables_list.purchases_table->num_records,
+                 cpu_aggregated_results.num_records,
+                   aggregate_end_time - aggregate_start_time);
+
+    trace_start = trace_clock_nanosecs();
+    write_aggregated_results_to_csv_file(&cpu_aggregated_results, CPU_AGGREGATED_RESULTS_FILE_PATH);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write cpu aggregated", trace_start);
+    if (is_device_aggregation_supported) {
+        trace_start = trace_clock_nanosecs();
+        write_aggregated_results_to_csv_file(&device_aggregated_results, PARALLEL_AGGREGATED_RESULTS_FILE_PATH);
+        record_trace_span(TRACE_CATEGORY_WRITE, "write opencl aggregated", trace_start);
+        // Both engines aggregate the very same joined records, so they must agree row for row
+        if (!aggregated_results_tables_equal(&device_aggregated_results, &cpu_aggregated_results)) {
+            fprintf(stderr, AGGREGATED_RESULTS_MISMATCH_MSG, PARALLEL_AGGREGATED_RESULTS_FILE_PATH,
+                                                             CPU_AGGREGATED_RESULTS_FILE_PATH);
+            assert(false);
+        }
+        printf(AGGREGATED_RESULTS_MATCH_MSG);
+        free(device_aggregated_results.table);
+    }
+    free(cpu_aggregated_results.table);
+
+}
+
+/*
+ * Joins the tables in "tables_list" for a batch of NUM_DEMO_BATCH_QUERIES queries (see its
+ * documentation) in a single pass, both on the default OpenCL device and on the CPU; writes every
+ * query's results of both to disk and checks that they agree.
+ */
+static void hash_equijoin_batch(struct List_Of_Tables tables_list, const struct Purchase_Predicate* purchase_predicate) {
+
+    struct Batch_Query queries[NUM_DEMO_BATCH_QUERIES] = {
+        { CUSTOMER_ACTIVE_FLAG, *purchase_predicate, PROJECT_ALL_COLUMNS },
+        { CUSTOMER_INACTIVE_FLAG, *purchase_predicate, PROJECT_ALL_COLUMNS },
+        { CUSTOMER_ACTIVE_FLAG, *purchase_predicate, PROJECT_CUSTOMER_ID | PROJECT_QUANTITY_PURCHASED }
+    };
+
+    double batch_start_time, batch_end_time;
+
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    struct Probe_Kernel_Variant kernel_variant;
+    struct Opencl_Profiling_Report profiling_report;
+    reset_opencl_profiling_report(&profiling_report);
+
+    unsigned long trace_start = trace_clock_nanosecs();
+    configure_opencl_env(&context, &queue, &program, &kernel_variant);
+    struct Predicate_Program_Cache batch_program_cache;
+    init_predicate_program_cache(&batch_program_cache, context);
+    record_trace_span(TRACE_CATEGORY_BUILD, "opencl build", trace_start);
+    struct Trace_Device_Clock device_clock;
+    calibrate_trace_device_clock(queue, &device_clock);
+
+    struct Joined_Results_Table device_query_results[NUM_DEMO_BATCH_QUERIES];
+    batch_start_time = monotonic_clock_secs();
+
+    trace_start = trace_clock_nanosecs();
+    opencl_batch_hash_equijoin_probe(&context, &queue, &batch_program_cache, tables_list, queries,
+                                       NUM_DEMO_BATCH_QUERIES, &kernel_variant, &profiling_report,
+                                       device_query_results);
+    record_trace_span(TRACE_CATEGORY_PROBE, "opencl batch probe", trace_start);
+    record_opencl_profiling_trace(&profiling_report, &device_clock);
+
+    batch_end_time = monotonic_clock_secs();
+    printf(EQUIJOIN_BATCH_DEVICE_MESSAGE, NUM_DEMO_BATCH_QUERIES,
+                 tables_list.hashed_customer_table->num_records,
+                 tables_list.purchases_table->num_records,
+                   batch_end_time - batch_start_time);
+
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    clReleaseProgram(program);
+    release_predicate_program_cache(&batch_program_cache);
+
+#if (PRINT_OPENCL_PROFILING_REPORT)
+    print_opencl_profiling_report(&profiling_report);
+    write_opencl_profiling_report_to_json_file(&profiling_report, OPENCL_PROFILING_REPORT_FILE_PATH);
+#endif
+
+    struct Joined_Results_Table cpu_query_results[NUM_DEMO_BATCH_QUERIES];
+    batch_start_time = monotonic_clock_secs();
+
+    trace_start = trace_clock_nanosecs();
+    cpu_batch_hash_equijoin_probe(tables_list, queries, NUM_DEMO_BATCH_QUERIES, cpu_query_results);
+    record_trace_span(TRACE_CATEGORY_PROBE, "cpu batch probe", trace_start);
+
+    batch_end_time = monotonic_clock_secs();
+    printf(EQUIJOIN_BATCH_CPU_MESSAGE, NUM_DEMO_BATCH_QUERIES,
+                 tables_list.hashed_customer_table->num_records,
+                 tables_list.purchases_table->num_records,
+                   batch_end_time - batch_start_time);
+
+    char device_results_path[PATH_MAX], cpu_results_path[PATH_MAX];
+    trace_start = trace_clock_nanosecs();
+    for (unsigned int query_index = 0; query_index < NUM_DEMO_BATCH_QUERIES; ++query_index) {
+        snprintf(device_results_path, sizeof(device_results_path), PARALLEL_BATCH_RESULTS_FILE_PATH_FORMAT, query_index);
+        snprintf(cpu_results_path, sizeof(cpu_results_path), CPU_BATCH_RESULTS_FILE_PATH_FORMAT, query_index);
+        write_batch_query_results_to_csv_file(&(device_query_results[query_index]), query_index,
+                                                queries[query_index].projection, device_results_path);
+        write_batch_query_results_to_csv_file(&(cpu_query_results[query_index]), query_index,
+                                                queries[query_index].projection, cpu_results_path);
+        // Both engines route the very same joined records to each query, in the same order
+        if (!batch_query_results_equal(&(device_query_results[query_index]), &(cpu_query_results[query_index]),
+                                         queries[query_index].projection)) {
+            fprintf(stderr, BATCH_RESULTS_MISMATCH_MSG, query_index, device_results_path, cpu_results_path);
+            assert(false);
+        }
+        free_batch_query_results(&(device_query_results[query_index]));
+        free_batch_query_results(&(cpu_query_results[query_index]));
+    }
+    record_trace_span(TRACE_CATEGORY_WRITE, "write and verify batch", trace_start);
+    printf(BATCH_RESULTS_MATCH_MSG);
+
+}
+
+/*
+ * Joins the tables in "tables_list" with only the engine the cost model of this machine (calibrated
+ * first if "is_recalibration_forced" or none is cached) predicts to be the fastest; writes its
+ * results to disk, checks them against the known correct result if no predicate filtered them, and
+ * logs the predicted and actual times if "is_prediction_logged".
+ */
+static void hash_equijoin_selected_engine(struct List_Of_Tables tables_list,
+                                            const struct Purchase_Predicate* pushed_down_predicate,
+                                              bool is_recalibration_forced, bool is_prediction_logged) {
+
+    double equijoin_start_time, equijoin_end_time;
+
+    struct Engine_Cost_Calibration calibration;
+    get_engine_cost_calibration(ENGINE_CALIBRATION_FILE_PATH, is_recalibration_forced, &calibration);
+    double predicted_secs[NUM_PROBE_ENGINES];
+    const enum Probe_Engine engine = predict_engine_costs(&calibration, tables_list.hashed_customer_table->num_records,
+                                                            tables_list.purchases_table->num_records, predicted_secs);
+
+    // Get time of when probing with the engine selected starts executing, including any OpenCL setup
+    equijoin_start_time = monotonic_clock_secs();
+
+    unsigned long trace_start = trace_clock_nanosecs();
+    if (engine == PROBE_ENGINE_SERIAL) {
+        serial_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate, NULL);
+    } else if (engine == PROBE_ENGINE_CPU_THREADS) {
+        threaded_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate, 0);
+    } else {
+        cl_context context;
+        cl_command_queue queue;
+        cl_program program;
+        cl_kernel kernel;
+        cl_mem hashed_customer_table_buffer, purchases_table_buffer, results_table_buffer;
+        struct Cl_Mem_Operands_List cl_mem_ops = {
+            &hashed_customer_table_buffer, &purchases_table_buffer, &results_table_buffer
+        };
+        struct Probe_Kernel_Variant kernel_variant;
+
+        configure_opencl_env(&context, &queue, &program, &kernel_variant);
+        struct Predicate_Program_Cache predicate_program_cache;
+        init_predicate_program_cache(&predicate_program_cache, context);
+        if (pushed_down_predicate != NULL) {
+            clReleaseProgram(program);
+            program = get_predicate_program(&predicate_program_cache, pushed_down_predicate, &kernel_variant);
+            clRetainProgram(program);
+        }
+        load_tables_hash_equijoin_probe(&context, &queue, tables_list, cl_mem_ops, NULL);
+        opencl_hash_equijoin_probe(&queue, &program, &kernel, tables_list, cl_mem_ops, IS_CUSTOMER_ACTIVE,
+                                     &kernel_variant, NULL, NULL);
+
+        clReleaseCommandQueue(queue);
+        clReleaseContext(context);
+        clReleaseProgram(program);
+        release_predicate_program_cache(&predicate_program_cache);
+        clReleaseKernel(kernel);
+        clReleaseMemObject(hashed_customer_table_buffer);
+        clReleaseMemObject(purchases_table_buffer);
+        clReleaseMemObject(results_table_buffer);
+    }
+    record_trace_span(TRACE_CATEGORY_PROBE, probe_engine_name(engine), trace_start);
+
+    // Get time of when probing with the engine selected finishes executing
+    equijoin_end_time = monotonic_clock_secs();
+    const double actual_secs = equijoin_end_time - equijoin_start_time;
+    printf(ENGINE_ACTUAL_MSG, probe_engine_name(engine), actual_secs, predicted_secs[engine],
+             (actual_secs > 0.0) ? 100.0 * (predicted_secs[engine] - actual_secs) / actual_secs : 0.0);
+    if (is_prediction_logged) {
+        log_engine_prediction(ENGINE_PREDICTION_LOG_FILE_PATH, &calibration,
+                                tables_list.hashed_customer_table->num_records,
+                                tables_list.purchases_table->num_records, predicted_secs, engine, actual_secs);
+    }
+
+    // Results of the OpenCL device go where they always do; those of either CPU engine where the serial ones do
+    const char* results_file_location = (engine == PROBE_ENGINE_OPENCL) ? PARALLEL_RESULTS_TABLE_FILE_PATH :
+                                                                          SERIAL_RESULTS_TABLE_FILE_PATH;
+    trace_start = trace_clock_nanosecs();
+    write_results_table_to_csv_file_parallel(tables_list.results_table, results_file_location,
+                                               RESULTS_WRITER_THREADS);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write selected", trace_start);
+
+    if (pushed_down_predicate == NULL) {
+        // Check output result of the engine selected against known correct result.
+        printf(CHECK_RESULTS_MESSAGE, results_file_location, RESULTS_REF_TABLE_FILE_PATH);
+        trace_start = trace_clock_nanosecs();
+        assert_equijoin_results_tables_equality(results_file_location, RESULTS_REF_TABLE_FILE_PATH,
+                                                  VERIFY_RESULTS_IN_ANY_ORDER);
+        record_trace_span(TRACE_CATEGORY_VERIFY, "verify selected results", trace_start);
     }
 
-    // Platforms already acquired; free malloc'ed memory
-    free(platforms);
+}
+
+/*
+ * Prints out (and writes as JSON) the hardware events of every phase recorded in "report", if
+ * they were counted at all, and closes "counters".
+ */
+static void finish_hardware_counters(struct Hardware_Counters* counters,
+                                       const struct Hardware_Counters_Report* report) {
+
+#if (COUNT_HARDWARE_EVENTS)
+    print_hardware_counters_report(report);
+    write_hardware_counters_report_to_json_file(report, HARDWARE_COUNTERS_REPORT_FILE_PATH);
+#endif
+    close_hardware_counters(counters);
+
+}
+
+/*
+ * Writes the trace of this program to "trace_file_location", if it was traced at all.
+ */
+static void finish_trace(const char* trace_file_location) {
+
+    if (trace_file_location != NULL) {
+        write_trace_to_json_file(trace_file_location);
+    }
 
 }
 
+/*
+ * Prints out (and writes as JSON) every phase recorded in "report" against the peaks of
+ * "calibration", if the roofline report was asked for at all.
+ */
+static void finish_roofline(bool is_roofline_mode, const struct Roofline_Report* report,
+                              const struct Bandwidth_Calibration* calibration) {
+
+    if (is_roofline_mode) {
+        print_roofline_report(report, calibration);
+        write_roofline_report_to_json_file(report, calibration, ROOFLINE_REPORT_FILE_PATH);
+    }
+
+}
 
 // Testing hash join of two tables using a custom OpenCL program.
 int main(int argc, char* argv[]) {
     
+    // Predicate purchases have to satisfy to be joined, as given on the command-line
+    struct Purchase_Predicate purchase_predicate;
+    // Whether (and by which column) to aggregate joined records instead of outputting each of them
+    bool is_aggregation_mode;
+    enum Aggregation_Key_Column key_column = AGGREGATION_KEY_CUSTOMER_ID;
+    // Whether to probe a batch of queries in a single pass instead of the single IS_CUSTOMER_ACTIVE one
+    bool is_batch_mode;
+    // Whether to look customers up in a table of the hot customers sampled from the purchases first
+    bool is_hot_customer_mode;
+    // Memory budget in megabytes of joining out of core, partition by partition; 0 to join in memory
+    unsigned long memory_budget_mb;
+    // File to write a timeline of every phase and OpenCL command to; NULL if this program isn't traced
+    const char* trace_file_location;
+    // Whether to measure peak bandwidths and report how close each phase comes to them
+    bool is_roofline_mode;
+    // Whether to probe with only the engine predicted fastest (calibrating it again, logging how it did)
+    bool is_engine_selection_mode, is_recalibration_forced, is_prediction_logged;
+    parse_command_line_options(argc, argv, &purchase_predicate, &is_aggregation_mode, &key_column, &is_batch_mode,
+                                 &is_hot_customer_mode, &memory_budget_mb, &trace_file_location, &is_roofline_mode,
+                                   &is_engine_selection_mode, &is_recalibration_forced, &is_prediction_logged);
+    if (trace_file_location != NULL) {
+        start_tracing();
+    }
+    // Peak bandwidths (measured before anything else runs) and bytes moved per second of each phase
+    struct Bandwidth_Calibration bandwidth_calibration;
+    init_bandwidth_calibration(&bandwidth_calibration);
+    struct Roofline_Report roofline_report;
+    reset_roofline_report(&roofline_report);
+    if (is_roofline_mode) {
+        measure_host_memory_bandwidth(&bandwidth_calibration, ROOFLINE_CALIBRATION_THREADS);
+    }
+    // Start of the phase currently reported against its peak bandwidth
+    double roofline_start_time;
+    // Start of the span of the phase currently traced
+    unsigned long trace_start;
+    // Only push a predicate down into the engines if there's something to filter
+    const struct Purchase_Predicate* pushed_down_predicate =
+                        (purchase_predicate.num_terms > 0) ? &purchase_predicate : NULL;
+    if (pushed_down_predicate != NULL) {
+        char predicate_source[MAX_PREDICATE_SOURCE_LEN];
+        purchase_predicate_to_opencl_c(pushed_down_predicate, predicate_source, sizeof(predicate_source));
+        // Drop the trailing newline of the generated "#define" when showing it to the user
+        predicate_source[strcspn(predicate_source, "\n")] = '\0';
+        printf(PURCHASE_PREDICATE_MSG, predicate_source);
+    }
+
+    // Hardware events of each phase of this program, if they're to be counted at all
+    struct Hardware_Counters hardware_counters;
+    struct Hardware_Counters_Report hardware_counters_report;
+    reset_hardware_counters_report(&hardware_counters_report);
+#if (COUNT_HARDWARE_EVENTS)
+    open_hardware_counters(&hardware_counters);
+#else
+    init_hardware_counters(&hardware_counters);
+#endif
+
+
     // All variable declarations
     cl_context context;
     cl_command_queue queue;
@@ -153,19 +606,149 @@ int main(int argc, char* argv[]) {
     cl_mem purchases_table_buffer;
     cl_mem results_table_buffer;
 
-    struct Hashed_Customer_Table* hashed_customer_table = read_hashed_customer_table_from_csv_file(CUSTOMER_TABLE_FILE_PATH);
-    struct Purchases_Table* purchases_table = read_purchases_table_from_csv_file(PURCHASES_TABLE_FILE_PATH); 
+    if (memory_budget_mb > 0) {
+        // Tables are never read into memory whole; they're joined partition by partition instead
+        const double grace_start_time = monotonic_clock_secs();
+        begin_counted_phase(&hardware_counters);
+        trace_start = trace_clock_nanosecs();
+        grace_hash_equijoin_to_csv(CUSTOMER_TABLE_FILE_PATH, PURCHASES_TABLE_FILE_PATH, GRACE_RESULTS_TABLE_FILE_PATH,
+                                     IS_CUSTOMER_ACTIVE, pushed_down_predicate,
+                                     memory_budget_mb * MEMORY_BUDGET_BYTES_IN_MB, GRACE_JOIN_THREADS);
+        record_trace_span(TRACE_CATEGORY_PROBE, "grace join", trace_start);
+        end_counted_phase(&hardware_counters, &hardware_counters_report, "grace join", 0);
+        printf(EQUIJOIN_GRACE_MESSAGE, CUSTOMER_TABLE_FILE_PATH, PURCHASES_TABLE_FILE_PATH, memory_budget_mb,
+                 monotonic_clock_secs() - grace_start_time);
+        finish_hardware_counters(&hardware_counters, &hardware_counters_report);
+
+        if (pushed_down_predicate == NULL) {
+            // Check output result of the out-of-core equijoin against known correct result.
+            printf(CHECK_RESULTS_MESSAGE, GRACE_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
+            trace_start = trace_clock_nanosecs();
+            assert_equijoin_results_tables_equality(GRACE_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH,
+                                                      VERIFY_RESULTS_IN_ANY_ORDER);
+            record_trace_span(TRACE_CATEGORY_VERIFY, "verify grace results", trace_start);
+        }
+        finish_trace(trace_file_location);
+        finish_roofline(is_roofline_mode, &roofline_report, &bandwidth_calibration);
+        return EXIT_SUCCESS;
+    }
+
+    begin_counted_phase(&hardware_counters);
+    roofline_start_time = monotonic_clock_secs();
+    struct Hashed_Customer_Table* hashed_customer_table = read_hashed_customer_table_from_file(CUSTOMER_TABLE_FILE_PATH);
+    record_roofline_phase(&roofline_report, "parse customers",
+                            (double) hashed_customer_table->num_records * sizeof(*(hashed_customer_table->table)),
+                            monotonic_clock_secs() - roofline_start_time, BANDWIDTH_PEAK_HOST_COPY);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "parse customers",
+                        hashed_customer_table->num_records);
+    begin_counted_phase(&hardware_counters);
+    roofline_start_time = monotonic_clock_secs();
+    struct Purchases_Table* purchases_table = read_purchases_table_from_file(PURCHASES_TABLE_FILE_PATH); 
+    record_roofline_phase(&roofline_report, "parse purchases",
+                            (double) purchases_table->num_records * sizeof(*(purchases_table->table)),
+                            monotonic_clock_secs() - roofline_start_time, BANDWIDTH_PEAK_HOST_COPY);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "parse purchases",
+                        purchases_table->num_records);
+
+    /*
+     * "View" of the rows of the purchases table every engine probes; only the rows inside the
+     * time window of the purchases predicate, if the table is sorted by time, and all of them otherwise.
+     */
+    struct Purchases_Table purchases_window = *purchases_table;
+#if (NARROW_PROBE_TO_TIME_WINDOW)
+    unsigned long window_min_time, window_max_time;
+    if (get_purchase_predicate_time_window(pushed_down_predicate, &window_min_time, &window_max_time)) {
+        if (is_purchases_table_sorted_by_time(purchases_table)) {
+            const struct Purchases_Row_Range window_rows =
+                        find_purchases_time_window_rows(purchases_table, window_min_time, window_max_time);
+            purchases_window.table += window_rows.first_row;
+            purchases_window.num_records = window_rows.num_rows;
+            printf(TIME_WINDOW_ROWS_MSG, window_min_time, window_max_time, window_rows.first_row,
+                     window_rows.first_row + window_rows.num_rows, purchases_table->num_records);
+        } else {
+            printf(TIME_WINDOW_UNSORTED_MSG);
+        }
+    }
+#endif
+
+    if (is_aggregation_mode || is_batch_mode) {
+        // No joined results table is needed; each query's results are compacted, or aggregated by key
+        struct List_Of_Tables compact_tables_list = { hashed_customer_table, &purchases_window, NULL };
+        begin_counted_phase(&hardware_counters);
+        if (is_aggregation_mode) {
+            hash_equijoin_aggregate(compact_tables_list, pushed_down_predicate, key_column);
+        } else {
+            hash_equijoin_batch(compact_tables_list, &purchase_predicate);
+        }
+        end_counted_phase(&hardware_counters, &hardware_counters_report,
+                            is_aggregation_mode ? "aggregate (both)" : "batch (both)", purchases_window.num_records);
+        finish_hardware_counters(&hardware_counters, &hardware_counters_report);
+        finish_trace(trace_file_location);
+        finish_roofline(is_roofline_mode, &roofline_report, &bandwidth_calibration);
+
+        free(hashed_customer_table->table);
+        free(hashed_customer_table);
+        free(purchases_table->table);
+        free(purchases_table);
+        return EXIT_SUCCESS;
+    }
+
+    if (is_engine_selection_mode) {
+        // Only the engine predicted fastest probes; every row probed, without zone map or hot customers
+        struct Joined_Results_Table* selected_results_table;
+        initialize_results_table(&selected_results_table, purchases_window.num_records);
+        struct List_Of_Tables selected_tables_list = { hashed_customer_table, &purchases_window, selected_results_table };
+        begin_counted_phase(&hardware_counters);
+        hash_equijoin_selected_engine(selected_tables_list, pushed_down_predicate, is_recalibration_forced,
+                                        is_prediction_logged);
+        end_counted_phase(&hardware_counters, &hardware_counters_report, "selected engine",
+                            purchases_window.num_records);
+        finish_hardware_counters(&hardware_counters, &hardware_counters_report);
+        finish_trace(trace_file_location);
+        finish_roofline(is_roofline_mode, &roofline_report, &bandwidth_calibration);
+
+        free(selected_results_table->table);
+        free(selected_results_table);
+        free(hashed_customer_table->table);
+        free(hashed_customer_table);
+        free(purchases_table->table);
+        free(purchases_table);
+        return EXIT_SUCCESS;
+    }
    
-    // Initialize results table according to how many rows "purchases_table" has.
+#if (SKIP_BLOCKS_BY_ZONE_MAP)
+    // Blocks of the probed rows the purchases predicate may match at all, according to the zone map
+    struct Purchases_Zone_Map zone_map;
+    struct Purchases_Block_Selection block_selection;
+    get_purchases_zone_map(purchases_table, PURCHASES_TABLE_FILE_PATH, PURCHASES_ZONE_MAP_FILE_PATH, &zone_map);
+    const struct Purchases_Block_Selection* probed_blocks =
+                select_purchases_blocks(&zone_map, (unsigned long)(purchases_window.table - purchases_table->table),
+                                          purchases_window.num_records, pushed_down_predicate, &block_selection) ?
+                &block_selection : NULL;
+#else
+    const struct Purchases_Block_Selection* probed_blocks = NULL;
+#endif
+
+    // Customers most of the probed purchases belong to, if skew-aware probing was asked for
+    struct Hot_Customer_Table hot_customer_table;
+    if (is_hot_customer_mode) {
+        begin_counted_phase(&hardware_counters);
+        trace_start = trace_clock_nanosecs();
+        build_hot_customer_table(hashed_customer_table, &purchases_window, &hot_customer_table);
+        record_trace_span(TRACE_CATEGORY_BUILD, "sample hot customers", trace_start);
+        end_counted_phase(&hardware_counters, &hardware_counters_report, "sample hot customers",
+                            purchases_window.num_records);
+    }
+
+    // Initialize results table according to how many rows of "purchases_table" are probed.
     struct Joined_Results_Table* results_table;
-    initialize_results_table(&results_table, purchases_table->num_records);
+    initialize_results_table(&results_table, purchases_window.num_records);
    
-    struct timespec current_time;
     double equijoin_start_time, equijoin_end_time;
 
     struct List_Of_Tables tables_list = {
                                           hashed_customer_table,
-                                          purchases_table,
+                                          &purchases_window,
                                           results_table
                                         };
     struct Cl_Mem_Operands_List cl_mem_ops = {
@@ -174,19 +757,85 @@ int main(int argc, char* argv[]) {
                                                &results_table_buffer
                                              };
     
-    configure_opencl_env(&context, &queue, &program);
+#if (MULTI_DEVICE_MODE)
 
     // Get time of when parallelized hash equijoin probing starts executing
-    timespec_get(&current_time, TIME_UTC);
-    equijoin_start_time = (double) current_time.tv_sec + ((double) current_time.tv_nsec) / NANOSECS_IN_SEC;
+    equijoin_start_time = monotonic_clock_secs();
 
-    load_tables_hash_equijoin_probe(&context, &queue, tables_list, cl_mem_ops);
+    /*
+     * Split probing across every OpenCL device available; each device sets up,
+     * loads and releases its own OpenCL objects and device memory.
+     */
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    multi_device_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate);
+    record_trace_span(TRACE_CATEGORY_PROBE, "multi-device probe", trace_start);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "multi-device probe",
+                        purchases_window.num_records);
+
+    // Get time of when parallelized hash equijoin probing finishes executing
+    equijoin_end_time = monotonic_clock_secs();
+
+#else
+
+    // Profiling information of every OpenCL command enqueued for probing
+    struct Opencl_Profiling_Report profiling_report;
+    reset_opencl_profiling_report(&profiling_report);
 
-    opencl_hash_equijoin_probe(&queue, &program, &kernel, tables_list, cl_mem_ops, IS_CUSTOMER_ACTIVE);
+    // Variant of the probe kernel best suited to the OpenCL device used
+    struct Probe_Kernel_Variant kernel_variant;
+
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    configure_opencl_env(&context, &queue, &program, &kernel_variant);
+
+    // Programs compiled with the purchases predicate inlined, if one was given
+    struct Predicate_Program_Cache predicate_program_cache;
+    init_predicate_program_cache(&predicate_program_cache, context);
+    if (pushed_down_predicate != NULL) {
+        // Probe with the program specialized for the predicate; keep a reference of our own to it
+        clReleaseProgram(program);
+        program = get_predicate_program(&predicate_program_cache, pushed_down_predicate, &kernel_variant);
+        clRetainProgram(program);
+    }
+    if (is_hot_customer_mode) {
+        // Only used if no zone map narrowed probing down to a selection of blocks
+        kernel_variant.hot_customer_table = &hot_customer_table;
+    }
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "opencl build", 0);
+    record_trace_span(TRACE_CATEGORY_BUILD, "opencl build", trace_start);
+    // OpenCL commands are put on the timeline once probing is done, moved onto the host's clock
+    struct Trace_Device_Clock device_clock;
+    calibrate_trace_device_clock(queue, &device_clock);
+    if (is_roofline_mode) {
+        measure_device_transfer_bandwidth(context, queue, &bandwidth_calibration);
+    }
+
+    // Get time of when parallelized hash equijoin probing starts executing
+    equijoin_start_time = monotonic_clock_secs();
+
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    load_tables_hash_equijoin_probe(&context, &queue, tables_list, cl_mem_ops, &profiling_report);
+
+#if (STREAM_RESULTS_READBACK)
+    // Results get written to disk while the rest of them are still being read back
+    opencl_hash_equijoin_probe_streamed_to_csv(&queue, &program, &kernel, tables_list, cl_mem_ops,
+                                                 IS_CUSTOMER_ACTIVE, &kernel_variant, probed_blocks, &profiling_report,
+                                                                      PARALLEL_RESULTS_TABLE_FILE_PATH);
+#else
+    opencl_hash_equijoin_probe(&queue, &program, &kernel, tables_list, cl_mem_ops, IS_CUSTOMER_ACTIVE,
+                                                  &kernel_variant, probed_blocks, &profiling_report);
+#endif
+    end_counted_phase(&hardware_counters, &hardware_counters_report,
+                        STREAM_RESULTS_READBACK ? "opencl probe + write" : "opencl probe", purchases_window.num_records);
+    record_trace_span(TRACE_CATEGORY_PROBE, STREAM_RESULTS_READBACK ? "opencl probe + write" : "opencl probe",
+                        trace_start);
+    record_opencl_profiling_trace(&profiling_report, &device_clock);
+    record_opencl_roofline_phases(&roofline_report, &profiling_report);
 
     // Get time of when parallelized hash equijoin probing finishes executing
-    timespec_get(&current_time, TIME_UTC);
-    equijoin_end_time = (double) current_time.tv_sec + ((double) current_time.tv_nsec) / NANOSECS_IN_SEC;
+    equijoin_end_time = monotonic_clock_secs();
 
     /* 
      * Give back to the system main memory and device memory space used for OpenCL as
@@ -195,11 +844,21 @@ int main(int argc, char* argv[]) {
     clReleaseCommandQueue(queue);
     clReleaseContext(context);
     clReleaseProgram(program);
+    release_predicate_program_cache(&predicate_program_cache);
     clReleaseKernel(kernel);
     clReleaseMemObject(*(cl_mem_ops.hashed_customer_table_buffer));
     clReleaseMemObject(*(cl_mem_ops.purchases_table_buffer));
     clReleaseMemObject(*(cl_mem_ops.joined_results_table_buffer));
 
+#if (PRINT_OPENCL_PROFILING_REPORT)
+    // Break down time spent on the OpenCL device per phase of probing
+    print_opencl_profiling_report(&profiling_report);
+    write_opencl_profiling_report_to_json_file(&profiling_report, OPENCL_PROFILING_REPORT_FILE_PATH);
+#endif
+
+#endif
+
+#if (MULTI_DEVICE_MODE || !STREAM_RESULTS_READBACK)
     // Report to user time spent on parallelized hash equijoin probing in OpenCL
     printf(EQUIJOIN_PARALLEL_MESSAGE,
                  tables_list.hashed_customer_table->num_records,
@@ -207,7 +866,48 @@ int main(int argc, char* argv[]) {
                    equijoin_end_time - equijoin_start_time);
     
     // Write result of parallelized hash equijoin to disk
-    write_results_table_to_csv_file(tables_list.results_table, PARALLEL_RESULTS_TABLE_FILE_PATH);
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    roofline_start_time = monotonic_clock_secs();
+    write_results_table_to_csv_file_parallel(tables_list.results_table, PARALLEL_RESULTS_TABLE_FILE_PATH,
+                                               RESULTS_WRITER_THREADS);
+    record_roofline_phase(&roofline_report, "write parallel",
+                            (double) tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)),
+                            monotonic_clock_secs() - roofline_start_time, BANDWIDTH_PEAK_HOST_COPY);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write parallel", trace_start);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "write parallel",
+                        tables_list.results_table->num_records);
+#else
+    // Result of parallelized hash equijoin was already written to disk while being read back
+    printf(EQUIJOIN_PARALLEL_STREAMED_MESSAGE,
+                 tables_list.hashed_customer_table->num_records,
+                 tables_list.purchases_table->num_records,
+                   equijoin_end_time - equijoin_start_time);
+#endif
+
+#if (WRITE_ARROW_RESULTS)
+    // Write the same result in a columnar binary format as well
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    roofline_start_time = monotonic_clock_secs();
+    write_results_table_to_arrow_file(tables_list.results_table, PARALLEL_RESULTS_ARROW_FILE_PATH);
+    record_roofline_phase(&roofline_report, "write arrow",
+                            (double) tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)),
+                            monotonic_clock_secs() - roofline_start_time, BANDWIDTH_PEAK_HOST_COPY);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write arrow", trace_start);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "write arrow",
+                        tables_list.results_table->num_records);
+#endif
+
+#if (VERIFY_RESULTS_BY_DIGEST && !VERIFY_RESULTS_IN_ANY_ORDER)
+    // Keep the digest of the parallelized result, as its table doesn't outlive serial probing
+    trace_start = trace_clock_nanosecs();
+    const struct Results_Table_Digest parallel_results_digest =
+                        compute_results_table_digest(tables_list.results_table, RESULTS_DIGEST_THREADS);
+    record_trace_span(TRACE_CATEGORY_VERIFY, "digest opencl results", trace_start);
+    printf(RESULTS_DIGEST_MSG, PARALLEL_RESULTS_DIGEST_DESCRIPTION, parallel_results_digest.digest,
+                                 parallel_results_digest.num_rows);
+#endif
 
     /*
      * Reset equijoin results table so that serial hash
@@ -216,34 +916,104 @@ int main(int argc, char* argv[]) {
      */
     free(results_table->table);
     free(results_table);
-    // Re-initialize results table according to how many rows "purchases_table" has.
-    initialize_results_table(&results_table, purchases_table->num_records);
+    // Re-initialize results table according to how many rows of "purchases_table" are probed.
+    initialize_results_table(&results_table, purchases_window.num_records);
     tables_list.results_table = results_table;
 
     // Get time of when serial hash equijoin probing starts executing
-    timespec_get(&current_time, TIME_UTC);
-    equijoin_start_time = (double) current_time.tv_sec + ((double) current_time.tv_nsec) / NANOSECS_IN_SEC;
+    equijoin_start_time = monotonic_clock_secs();
 
-    serial_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE);
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    if (is_hot_customer_mode && probed_blocks == NULL) {
+        hot_cached_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate, &hot_customer_table);
+        end_counted_phase(&hardware_counters, &hardware_counters_report, "hot cached probe",
+                            purchases_window.num_records);
+        record_trace_span(TRACE_CATEGORY_PROBE, "hot cached probe", trace_start);
+    } else {
+        serial_hash_equijoin_probe(tables_list, IS_CUSTOMER_ACTIVE, pushed_down_predicate, probed_blocks);
+        end_counted_phase(&hardware_counters, &hardware_counters_report, "serial probe",
+                            purchases_window.num_records);
+        record_trace_span(TRACE_CATEGORY_PROBE, "serial probe", trace_start);
+    }
 
     // Get time of when serial hash equijoin probing finishes executing
-    timespec_get(&current_time, TIME_UTC);
-    equijoin_end_time = (double) current_time.tv_sec + ((double) current_time.tv_nsec) / NANOSECS_IN_SEC;
+    equijoin_end_time = monotonic_clock_secs();
 
     // Report to user time spent on serial hash equijoin probing in OpenCL
     printf(EQUIJOIN_SERIAL_MESSAGE,
                  tables_list.hashed_customer_table->num_records,
                  tables_list.purchases_table->num_records,
                    equijoin_end_time - equijoin_start_time);
+    record_roofline_phase(&roofline_report, (is_hot_customer_mode && probed_blocks == NULL) ?
+                                              "hot cached probe" : "serial probe",
+                            (double) tables_list.purchases_table->num_records * PROBE_BYTES_PER_ROW,
+                            equijoin_end_time - equijoin_start_time, BANDWIDTH_PEAK_HOST_TRIAD);
 
     // Write result of serial hash equijoin to disk
-    write_results_table_to_csv_file(tables_list.results_table, SERIAL_RESULTS_TABLE_FILE_PATH);
+    begin_counted_phase(&hardware_counters);
+    trace_start = trace_clock_nanosecs();
+    roofline_start_time = monotonic_clock_secs();
+    write_results_table_to_csv_file_parallel(tables_list.results_table, SERIAL_RESULTS_TABLE_FILE_PATH,
+                                               RESULTS_WRITER_THREADS);
+    record_roofline_phase(&roofline_report, "write serial",
+                            (double) tables_list.results_table->num_records * sizeof(*(tables_list.results_table->table)),
+                            monotonic_clock_secs() - roofline_start_time, BANDWIDTH_PEAK_HOST_COPY);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write serial", trace_start);
+    end_counted_phase(&hardware_counters, &hardware_counters_report, "write serial",
+                        tables_list.results_table->num_records);
+
+    finish_hardware_counters(&hardware_counters, &hardware_counters_report);
+    finish_roofline(is_roofline_mode, &roofline_report, &bandwidth_calibration);
 
-    // Check output result of each equijoin against known correct result.
-    printf(CHECK_RESULTS_MESSAGE, PARALLEL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
-    assert_equijoin_results_tables_equality(PARALLEL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
-    printf(CHECK_RESULTS_MESSAGE, SERIAL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
-    assert_equijoin_results_tables_equality(SERIAL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
+    // Verifying the results is the last phase traced
+    trace_start = trace_clock_nanosecs();
+#if (VERIFY_RESULTS_BY_DIGEST && !VERIFY_RESULTS_IN_ANY_ORDER)
+    const struct Results_Table_Digest serial_results_digest =
+                        compute_results_table_digest(tables_list.results_table, RESULTS_DIGEST_THREADS);
+    printf(RESULTS_DIGEST_MSG, SERIAL_RESULTS_DIGEST_DESCRIPTION, serial_results_digest.digest,
+                                 serial_results_digest.num_rows);
+
+    if (pushed_down_predicate == NULL) {
+        // Check digest of each equijoin result against digest of known correct result.
+        const struct Results_Table_Digest ref_results_digest =
+                        get_reference_results_digest(RESULTS_REF_TABLE_FILE_PATH, RESULTS_REF_DIGEST_FILE_PATH,
+                                                       CUSTOMER_TABLE_FILE_PATH, PURCHASES_TABLE_FILE_PATH);
+        const bool is_parallel_result_correct =
+                        compare_results_digests(parallel_results_digest, PARALLEL_RESULTS_DIGEST_DESCRIPTION,
+                                                  ref_results_digest, REF_RESULTS_DIGEST_DESCRIPTION);
+        assert(is_parallel_result_correct);
+        const bool is_serial_result_correct =
+                        compare_results_digests(serial_results_digest, SERIAL_RESULTS_DIGEST_DESCRIPTION,
+                                                  ref_results_digest, REF_RESULTS_DIGEST_DESCRIPTION);
+        assert(is_serial_result_correct);
+    } else {
+        // Known correct result is of the unfiltered join; both engines filtered, so they must agree
+        printf(CHECK_PREDICATE_RESULTS_MESSAGE, RESULTS_REF_TABLE_FILE_PATH);
+        const bool are_results_equal =
+                        compare_results_digests(parallel_results_digest, PARALLEL_RESULTS_DIGEST_DESCRIPTION,
+                                                  serial_results_digest, SERIAL_RESULTS_DIGEST_DESCRIPTION);
+        assert(are_results_equal);
+    }
+#else
+    if (pushed_down_predicate == NULL) {
+        // Check output result of each equijoin against known correct result.
+        printf(CHECK_RESULTS_MESSAGE, PARALLEL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
+        assert_equijoin_results_tables_equality(PARALLEL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH,
+                                                  VERIFY_RESULTS_IN_ANY_ORDER);
+        printf(CHECK_RESULTS_MESSAGE, SERIAL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH);
+        assert_equijoin_results_tables_equality(SERIAL_RESULTS_TABLE_FILE_PATH, RESULTS_REF_TABLE_FILE_PATH,
+                                                  VERIFY_RESULTS_IN_ANY_ORDER);
+    } else {
+        // Known correct result is of the unfiltered join; both engines filtered, so they must agree
+        printf(CHECK_PREDICATE_RESULTS_MESSAGE, RESULTS_REF_TABLE_FILE_PATH);
+        printf(CHECK_RESULTS_MESSAGE, PARALLEL_RESULTS_TABLE_FILE_PATH, SERIAL_RESULTS_TABLE_FILE_PATH);
+        assert_equijoin_results_tables_equality(PARALLEL_RESULTS_TABLE_FILE_PATH, SERIAL_RESULTS_TABLE_FILE_PATH,
+                                                  VERIFY_RESULTS_IN_ANY_ORDER);
+    }
+#endif
+    record_trace_span(TRACE_CATEGORY_VERIFY, "verify results", trace_start);
+    finish_trace(trace_file_location);
 
     // Empty main memory of all data stored
     free(hashed_customer_table->table);
@@ -252,6 +1022,12 @@ int main(int argc, char* argv[]) {
     free(purchases_table);
     free(results_table->table);
     free(results_table);
+#if (SKIP_BLOCKS_BY_ZONE_MAP)
+    if (probed_blocks != NULL) {
+        free_purchases_block_selection(&block_selection);
+    }
+    free_purchases_zone_map(&zone_map);
+#endif
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,535 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for the out-of-core (Grace) hash equijoin:
+// partitioning both tables into spill files, joining every pair of partitions in memory, and
+// merging the joined records back into purchases table order.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <bsd/string.h>
+#include "table_utilities.h"
+#include "equijoin_serial.h"
+#include "equijoin_grace.h"
+#include "trace_events.h"
+#include "monotonic_clock.h"
+
+// Partition recorded for purchases of customers the customer table doesn't have; never joined
+#define GRACE_NO_PARTITION UINT16_MAX
+// Number of entries of the partition map read from disk at a time while merging
+#define GRACE_PARTITION_MAP_READ_ENTRIES (64 * 1024)
+// Number of bytes in a megabyte, as the memory budget is shown to the user
+#define GRACE_BYTES_IN_MB (1024ul * 1024ul)
+
+/*
+ * Joined record spilled by a partition, along with which of the partition's purchases it joined
+ * (counting from 0, in purchases table order).
+ */
+struct Grace_Spilled_Result {
+    unsigned long partition_row;
+    struct Joined_Results_Table_Row row;
+};
+
+/*
+ * Everything shared by the threads joining partitions.
+ *   - spill_directory --- directory the spill files are in
+ *   - num_partitions --- number of partitions both tables were split into
+ *   - spill_buffer_size --- size of the buffer of each spill file being read or written
+ *   - num_customer_rows --- number of rows of the hashed customer table of each partition
+ *   - num_chunk_rows --- number of purchases each thread probes at a time
+ *   - is_customer_active, purchase_predicate --- what to join
+ *   - next_partition, next_partition_lock --- first partition no thread has started joining yet
+ */
+struct Grace_Join {
+    char spill_directory[PATH_MAX];
+    unsigned int num_partitions;
+    size_t spill_buffer_size;
+    unsigned long num_customer_rows;
+    unsigned long num_chunk_rows;
+    char is_customer_active;
+    const struct Purchase_Predicate* purchase_predicate;
+    unsigned int next_partition;
+    pthread_mutex_t next_partition_lock;
+};
+
+/*
+ * Thread joining partitions, with the tables it joins each of them in and the buffers of the
+ * GRACE_WORKER_SPILL_FILES spill files it has open at once; allocated once, at their full size,
+ * so that a thread never holds more than its part of the memory budget.
+ */
+struct Grace_Worker {
+    pthread_t thread;
+    struct Grace_Join* join;
+    struct Hashed_Customer_Table customer_table;
+    struct Purchases_Table purchases_chunk;
+    struct Joined_Results_Table results_chunk;
+    char* spill_buffers;
+};
+
+// =================================================================================================
+
+/*
+ * Stores the location of the spill file named by "format" and "partition" within "spill_directory"
+ * in "spill_file_location" (of PATH_MAX bytes); aborts if the location doesn't fit.
+ */
+static void format_grace_spill_file_location(char* spill_file_location, const char* spill_directory,
+                                               const char* format, unsigned int partition) {
+
+    const int location_len = snprintf(spill_file_location, PATH_MAX, format, spill_directory, partition);
+    if (location_len < 0 || location_len >= PATH_MAX) {
+        fprintf(stderr, GRACE_SPILL_LOCATION_TOO_LONG_MSG, spill_directory);
+        exit(EXIT_FAILURE);
+    }
+
+}
+
+/*
+ * Opens the spill file named by "format" and "partition" within the spill directory of "join" with
+ * "fopen" mode "mode", buffered with "spill_buffer" (of the join's spill buffer size, and not to be
+ * used for anything else until the file is closed); aborts if it can't be opened.
+ */
+static FILE* open_grace_spill_file(const struct Grace_Join* join, const char* format, unsigned int partition,
+                                     const char* mode, char* spill_buffer) {
+
+    char spill_file_location[PATH_MAX];
+    format_grace_spill_file_location(spill_file_location, join->spill_directory, format, partition);
+    FILE* spill_file = fopen(spill_file_location, mode);
+    // Inform user if file didn't open correctly and abort program
+    if (spill_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", spill_file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    int func_status = setvbuf(spill_file, spill_buffer, _IOFBF, join->spill_buffer_size);
+    assert(func_status == EXIT_SUCCESS);
+    return spill_file;
+
+}
+
+// Deletes the spill file named by "format" and "partition" within "spill_directory"
+static void remove_grace_spill_file(const char* spill_directory, const char* format, unsigned int partition) {
+
+    char spill_file_location[PATH_MAX];
+    format_grace_spill_file_location(spill_file_location, spill_directory, format, partition);
+    unlink(spill_file_location);
+
+}
+
+/*
+ * Reads the customer table at "file_location" once, returning its highest customer ID (every
+ * customer ID of the table is at most that) and storing its number of customers in "num_customers".
+ */
+static unsigned long find_max_customer_id(const char* file_location, unsigned long* num_customers) {
+
+    struct Table_File_Reader reader;
+    struct Hashed_Customer_Table_Row customer_row;
+    unsigned long max_customer_id = NULL_CUSTOMER_ID;
+    *num_customers = 0;
+    open_customer_table_file_reader(file_location, &reader);
+    while (read_next_customer_table_row(&reader, &customer_row)) {
+        // Rows of binary files no customer was hashed into are left out
+        if (customer_row.customer_id == NULL_CUSTOMER_ID) {
+            continue;
+        }
+        ++(*num_customers);
+        if (customer_row.customer_id > max_customer_id) {
+            max_customer_id = customer_row.customer_id;
+        }
+    }
+    close_table_file_reader(&reader);
+    return max_customer_id;
+
+}
+
+/*
+ * Splits the customer table at "customer_table_file_location" and the purchases table at
+ * "purchases_table_file_location" into the partitions of "join", storing every row with the
+ * customer ID it has within its partition; records which partition each purchase went to in
+ * the partition map, and returns the number of purchases read.
+ */
+static unsigned long partition_grace_tables(const struct Grace_Join* join, const char* customer_table_file_location,
+                                              const char* purchases_table_file_location,
+                                              unsigned long max_customer_id) {
+
+    struct Table_File_Reader reader;
+    FILE** spill_files = malloc(join->num_partitions * sizeof(*spill_files));
+    // One spill buffer for each partition's file, and one more for the partition map
+    char* spill_buffers = malloc((join->num_partitions + 1) * join->spill_buffer_size);
+    assert(spill_files != NULL && spill_buffers != NULL);
+
+    // Every customer goes to the partition its customer ID hashes to
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        spill_files[partition] = open_grace_spill_file(join, GRACE_CUSTOMER_SPILL_FILE_FORMAT,
+                                                         partition, FOPEN_OVERWRITE_ONLY_MODE,
+                                                         spill_buffers + partition * join->spill_buffer_size);
+    }
+    struct Hashed_Customer_Table_Row customer_row;
+    open_customer_table_file_reader(customer_table_file_location, &reader);
+    while (read_next_customer_table_row(&reader, &customer_row)) {
+        if (customer_row.customer_id == NULL_CUSTOMER_ID) {
+            continue;
+        }
+        const unsigned int partition = customer_id_to_grace_partition(customer_row.customer_id, join->num_partitions);
+        customer_row.customer_id = customer_id_to_grace_local_id(customer_row.customer_id, join->num_partitions);
+        size_t num_rows_written = fwrite(&customer_row, sizeof(customer_row), 1, spill_files[partition]);
+        assert(num_rows_written == 1);
+    }
+    close_table_file_reader(&reader);
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        fclose(spill_files[partition]);
+    }
+
+    // Every purchase goes to its customer's partition, in purchases table order
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        spill_files[partition] = open_grace_spill_file(join, GRACE_PURCHASES_SPILL_FILE_FORMAT,
+                                                         partition, FOPEN_OVERWRITE_ONLY_MODE,
+                                                         spill_buffers + partition * join->spill_buffer_size);
+    }
+    FILE* partition_map_file = open_grace_spill_file(join, GRACE_PARTITION_MAP_FILE_FORMAT, 0,
+                                                       FOPEN_OVERWRITE_ONLY_MODE,
+                                                       spill_buffers + join->num_partitions * join->spill_buffer_size);
+    unsigned long num_purchases = 0;
+    struct Purchases_Table_Row purchases_row;
+    open_purchases_table_file_reader(purchases_table_file_location, &reader);
+    while (read_next_purchases_table_row(&reader, &purchases_row)) {
+        uint16_t partition = GRACE_NO_PARTITION;
+        // Purchases of customers the customer table doesn't have can't join; they're only kept in order
+        if (purchases_row.customer_id != NULL_CUSTOMER_ID && purchases_row.customer_id <= max_customer_id) {
+            partition = (uint16_t) customer_id_to_grace_partition(purchases_row.customer_id, join->num_partitions);
+            purchases_row.customer_id = customer_id_to_grace_local_id(purchases_row.customer_id, join->num_partitions);
+            size_t num_rows_written = fwrite(&purchases_row, sizeof(purchases_row), 1, spill_files[partition]);
+            assert(num_rows_written == 1);
+        }
+        size_t num_entries_written = fwrite(&partition, sizeof(partition), 1, partition_map_file);
+        assert(num_entries_written == 1);
+        ++num_purchases;
+    }
+    close_table_file_reader(&reader);
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        fclose(spill_files[partition]);
+    }
+    fclose(partition_map_file);
+
+    free(spill_files);
+    free(spill_buffers);
+    return num_purchases;
+
+}
+
+/*
+ * Joins partition "partition" with the tables of "worker": reads the partition's customers into
+ * its hashed customer table, probes its purchases a chunk at a time with the serial probe engine,
+ * and spills every joined record (with its customer ID restored) to the partition's results file.
+ */
+static void join_grace_partition(struct Grace_Worker* worker, unsigned int partition) {
+
+    const struct Grace_Join* join = worker->join;
+
+    // Customers missing from the partition are NULL rows, never joined
+    memset(worker->customer_table.table, 0, join->num_customer_rows * sizeof(*(worker->customer_table.table)));
+    FILE* spill_file = open_grace_spill_file(join, GRACE_CUSTOMER_SPILL_FILE_FORMAT, partition,
+                                               FOPEN_READ_ONLY_MODE, worker->spill_buffers);
+    struct Hashed_Customer_Table_Row customer_row;
+    while (fread(&customer_row, sizeof(customer_row), 1, spill_file) == 1) {
+        worker->customer_table.table[customer_id_to_row_index(customer_row.customer_id)] = customer_row;
+    }
+    fclose(spill_file);
+    remove_grace_spill_file(join->spill_directory, GRACE_CUSTOMER_SPILL_FILE_FORMAT, partition);
+
+    spill_file = open_grace_spill_file(join, GRACE_PURCHASES_SPILL_FILE_FORMAT, partition,
+                                         FOPEN_READ_ONLY_MODE, worker->spill_buffers);
+    FILE* results_file = open_grace_spill_file(join, GRACE_RESULTS_SPILL_FILE_FORMAT, partition,
+                                                 FOPEN_OVERWRITE_ONLY_MODE,
+                                                 worker->spill_buffers + join->spill_buffer_size);
+    unsigned long first_partition_row = 0;
+    while (true) {
+
+        const size_t num_chunk_rows = fread(worker->purchases_chunk.table, sizeof(*(worker->purchases_chunk.table)),
+                                              join->num_chunk_rows, spill_file);
+        if (num_chunk_rows == 0) {
+            break;
+        }
+        struct Purchases_Table purchases_chunk = { worker->purchases_chunk.table, num_chunk_rows };
+        struct Joined_Results_Table results_chunk = { worker->results_chunk.table, num_chunk_rows };
+        struct List_Of_Tables tables_list = { &(worker->customer_table), &purchases_chunk, &results_chunk };
+        serial_hash_equijoin_probe_rows(tables_list, join->is_customer_active, join->purchase_predicate,
+                                          0, num_chunk_rows);
+
+        for (unsigned long chunk_row = 0; chunk_row < num_chunk_rows; ++chunk_row) {
+            if (results_chunk.table[chunk_row].customer_id_customer == NULL_CUSTOMER_ID) {
+                continue;
+            }
+            struct Grace_Spilled_Result spilled_result = { first_partition_row + chunk_row,
+                                                           results_chunk.table[chunk_row] };
+            spilled_result.row.customer_id_customer =
+                        grace_local_id_to_customer_id(spilled_result.row.customer_id_customer, partition,
+                                                        join->num_partitions);
+            size_t num_results_written = fwrite(&spilled_result, sizeof(spilled_result), 1, results_file);
+            assert(num_results_written == 1);
+        }
+        first_partition_row += num_chunk_rows;
+
+    }
+    fclose(spill_file);
+    fclose(results_file);
+    remove_grace_spill_file(join->spill_directory, GRACE_PURCHASES_SPILL_FILE_FORMAT, partition);
+
+}
+
+// Joins partitions until none is left for "worker_arg"'s thread to start on
+static void* join_grace_partitions(void* worker_arg) {
+
+    struct Grace_Worker* worker = (struct Grace_Worker*) worker_arg;
+    while (true) {
+        pthread_mutex_lock(&(worker->join->next_partition_lock));
+        const unsigned int partition = worker->join->next_partition++;
+        pthread_mutex_unlock(&(worker->join->next_partition_lock));
+        if (partition >= worker->join->num_partitions) {
+            break;
+        }
+        const unsigned long trace_start = trace_clock_nanosecs();
+        join_grace_partition(worker, partition);
+        record_trace_span(TRACE_CATEGORY_PROBE, "join partition", trace_start);
+    }
+    return NULL;
+
+}
+
+/*
+ * Writes the joined records of every partition of "join" to "results_file_location" in purchases
+ * table order: the partition map tells which partition each purchase went to, and each
+ * partition's joined records are in the order of its purchases.  Returns the number written.
+ */
+static unsigned long merge_grace_results(const struct Grace_Join* join, const char* results_file_location) {
+
+    FILE** results_files = malloc(join->num_partitions * sizeof(*results_files));
+    struct Grace_Spilled_Result* next_results = malloc(join->num_partitions * sizeof(*next_results));
+    bool* has_next_result = malloc(join->num_partitions * sizeof(*has_next_result));
+    unsigned long* num_partition_rows = calloc(join->num_partitions, sizeof(*num_partition_rows));
+    uint16_t* partition_map = malloc(GRACE_PARTITION_MAP_READ_ENTRIES * sizeof(*partition_map));
+    struct Joined_Results_Table merged_results = { malloc(GRACE_MERGE_BATCH_ROWS * sizeof(*(merged_results.table))), 0 };
+    // One spill buffer for each partition's results file, and one more for the partition map
+    char* spill_buffers = malloc((join->num_partitions + 1) * join->spill_buffer_size);
+    assert(results_files != NULL && next_results != NULL && has_next_result != NULL && spill_buffers != NULL);
+    assert(num_partition_rows != NULL && partition_map != NULL && merged_results.table != NULL);
+
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        results_files[partition] = open_grace_spill_file(join, GRACE_RESULTS_SPILL_FILE_FORMAT,
+                                                           partition, FOPEN_READ_ONLY_MODE,
+                                                           spill_buffers + partition * join->spill_buffer_size);
+        has_next_result[partition] = fread(&(next_results[partition]), sizeof(next_results[partition]), 1,
+                                             results_files[partition]) == 1;
+    }
+    FILE* partition_map_file = open_grace_spill_file(join, GRACE_PARTITION_MAP_FILE_FORMAT, 0,
+                                                       FOPEN_READ_ONLY_MODE,
+                                                       spill_buffers + join->num_partitions * join->spill_buffer_size);
+    struct Results_Csv_File* results_csv_file = open_results_table_csv_file(results_file_location);
+
+    unsigned long num_joined_records = 0;
+    size_t num_map_entries;
+    while ((num_map_entries = fread(partition_map, sizeof(*partition_map), GRACE_PARTITION_MAP_READ_ENTRIES,
+                                      partition_map_file)) > 0) {
+        for (size_t map_entry = 0; map_entry < num_map_entries; ++map_entry) {
+
+            const uint16_t partition = partition_map[map_entry];
+            if (partition == GRACE_NO_PARTITION) {
+                continue;
+            }
+            // Purchase is the next one of its partition; it was joined if the partition's next record is of it
+            const unsigned long partition_row = num_partition_rows[partition]++;
+            if (!has_next_result[partition] || next_results[partition].partition_row != partition_row) {
+                continue;
+            }
+            merged_results.table[merged_results.num_records++] = next_results[partition].row;
+            has_next_result[partition] = fread(&(next_results[partition]), sizeof(next_results[partition]), 1,
+                                                 results_files[partition]) == 1;
+            if (merged_results.num_records == GRACE_MERGE_BATCH_ROWS) {
+                write_results_table_rows_to_csv_file(results_csv_file, &merged_results, 0, merged_results.num_records);
+                num_joined_records += merged_results.num_records;
+                merged_results.num_records = 0;
+            }
+
+        }
+    }
+    if (merged_results.num_records > 0) {
+        write_results_table_rows_to_csv_file(results_csv_file, &merged_results, 0, merged_results.num_records);
+        num_joined_records += merged_results.num_records;
+    }
+    close_results_table_csv_file(results_csv_file);
+
+    fclose(partition_map_file);
+    remove_grace_spill_file(join->spill_directory, GRACE_PARTITION_MAP_FILE_FORMAT, 0);
+    for (unsigned int partition = 0; partition < join->num_partitions; ++partition) {
+        // Every joined record of every partition was merged
+        assert(!has_next_result[partition]);
+        fclose(results_files[partition]);
+        remove_grace_spill_file(join->spill_directory, GRACE_RESULTS_SPILL_FILE_FORMAT, partition);
+    }
+    free(results_files);
+    free(next_results);
+    free(has_next_result);
+    free(num_partition_rows);
+    free(partition_map);
+    free(merged_results.table);
+    free(spill_buffers);
+    return num_joined_records;
+
+}
+
+void grace_hash_equijoin_to_csv(const char* customer_table_file_location, const char* purchases_table_file_location,
+                                  const char* results_file_location, const char is_customer_active,
+                                  const struct Purchase_Predicate* purchase_predicate,
+                                  unsigned long memory_budget_bytes, unsigned int num_threads) {
+
+    // No null pointers allowed
+    assert(customer_table_file_location != NULL);
+    assert(purchases_table_file_location != NULL);
+    assert(results_file_location != NULL);
+    // Check that "is_customer_active" is of valid value
+    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG ||
+                    is_customer_active == CUSTOMER_INACTIVE_FLAG);
+    assert(memory_budget_bytes > 0);
+
+    num_threads = resolve_num_threads(num_threads);
+
+    // Customer table HAS to have at least 1 customer
+    unsigned long num_customers;
+    const unsigned long max_customer_id = find_max_customer_id(customer_table_file_location, &num_customers);
+    assert(max_customer_id != NULL_CUSTOMER_ID);
+
+    /*
+     * Enough partitions for each thread's partition of the customer table to fit in its share of
+     * its part of the budget, and at least one partition per thread.
+     */
+    const unsigned long thread_budget_bytes = memory_budget_bytes / num_threads;
+    const unsigned long customer_budget_bytes = thread_budget_bytes / 100 * GRACE_CUSTOMER_BUDGET_PERCENT;
+    const unsigned long customer_table_bytes = max_customer_id * sizeof(struct Hashed_Customer_Table_Row);
+    const unsigned long min_num_partitions = (customer_budget_bytes > 0) ?
+                (customer_table_bytes + customer_budget_bytes - 1) / customer_budget_bytes : ULONG_MAX;
+    if (min_num_partitions > MAX_GRACE_PARTITIONS) {
+        fprintf(stderr, GRACE_BUDGET_TOO_SMALL_MSG, memory_budget_bytes / GRACE_BYTES_IN_MB, num_customers,
+                  num_threads, (min_num_partitions < UINT_MAX) ? (unsigned int) min_num_partitions : UINT_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    struct Grace_Join join;
+    join.num_partitions = (min_num_partitions > num_threads) ? (unsigned int) min_num_partitions : num_threads;
+    if (join.num_partitions > MAX_GRACE_PARTITIONS) {
+        join.num_partitions = MAX_GRACE_PARTITIONS;
+    }
+    if (num_threads > join.num_partitions) {
+        num_threads = join.num_partitions;
+    }
+    /*
+     * Every partition's spill file, and the partition map, are open at once while tables are partitioned
+     * and while joined records are merged; their buffers shrink so as to fit in their share of the budget.
+     */
+    join.spill_buffer_size = memory_budget_bytes / 100 * GRACE_SPILL_BUDGET_PERCENT / (join.num_partitions + 1);
+    if (join.spill_buffer_size > GRACE_SPILL_BUFFER_SIZE) {
+        join.spill_buffer_size = GRACE_SPILL_BUFFER_SIZE;
+    }
+    if (join.spill_buffer_size < MIN_GRACE_SPILL_BUFFER_SIZE) {
+        fprintf(stderr, GRACE_BUDGET_TOO_SMALL_MSG, memory_budget_bytes / GRACE_BYTES_IN_MB, num_customers,
+                  num_threads, join.num_partitions);
+        exit(EXIT_FAILURE);
+    }
+    join.num_customer_rows = (max_customer_id + join.num_partitions - 1) / join.num_partitions;
+    const unsigned long customer_partition_bytes = join.num_customer_rows * sizeof(struct Hashed_Customer_Table_Row);
+    const unsigned long worker_spill_buffer_bytes = GRACE_WORKER_SPILL_FILES * join.spill_buffer_size;
+    /*
+     * The rest of each thread's part of the budget, past the buffers of its spill files, holds the
+     * purchases it probes at a time and their results
+     */
+    join.num_chunk_rows = (thread_budget_bytes > customer_partition_bytes + worker_spill_buffer_bytes) ?
+                            (thread_budget_bytes - customer_partition_bytes - worker_spill_buffer_bytes) /
+                              (sizeof(struct Purchases_Table_Row) + sizeof(struct Joined_Results_Table_Row)) : 0;
+    if (join.num_chunk_rows == 0) {
+        join.num_chunk_rows = 1;
+    }
+    join.is_customer_active = is_customer_active;
+    join.purchase_predicate = purchase_predicate;
+    join.next_partition = 0;
+    int func_status = pthread_mutex_init(&(join.next_partition_lock), NULL);
+    assert(func_status == 0);
+    printf(GRACE_PLAN_MSG, memory_budget_bytes / GRACE_BYTES_IN_MB, join.num_partitions, num_threads,
+             join.num_chunk_rows);
+
+    strlcpy(join.spill_directory, GRACE_SPILL_DIRECTORY_TEMPLATE, sizeof(join.spill_directory));
+    if (mkdtemp(join.spill_directory) == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error creating %s: %s.\n", GRACE_SPILL_DIRECTORY_TEMPLATE, strerror(global_err_num));
+        exit(global_err_num);
+    }
+
+    // Partition both tables into spill files
+    double start_time = monotonic_clock_secs();
+    unsigned long trace_start = trace_clock_nanosecs();
+    const unsigned long num_purchases = partition_grace_tables(&join, customer_table_file_location,
+                                                                 purchases_table_file_location, max_customer_id);
+    record_trace_span(TRACE_CATEGORY_PARSE, "partition tables", trace_start);
+    printf(GRACE_PARTITIONED_MSG, num_customers, num_purchases, join.spill_directory,
+             monotonic_clock_secs() - start_time);
+
+    // Join partitions, as many at a time as there are threads
+    start_time = monotonic_clock_secs();
+    struct Grace_Worker* workers = malloc(num_threads * sizeof(*workers));
+    assert(workers != NULL);
+    for (unsigned int worker_index = 0; worker_index < num_threads; ++worker_index) {
+        struct Grace_Worker* worker = &(workers[worker_index]);
+        worker->join = &join;
+        worker->customer_table.num_records = join.num_customer_rows;
+        worker->customer_table.table = malloc(join.num_customer_rows * sizeof(*(worker->customer_table.table)));
+        worker->purchases_chunk.num_records = join.num_chunk_rows;
+        worker->purchases_chunk.table = malloc(join.num_chunk_rows * sizeof(*(worker->purchases_chunk.table)));
+        worker->results_chunk.num_records = join.num_chunk_rows;
+        worker->results_chunk.table = malloc(join.num_chunk_rows * sizeof(*(worker->results_chunk.table)));
+        worker->spill_buffers = malloc(GRACE_WORKER_SPILL_FILES * join.spill_buffer_size);
+        assert(worker->customer_table.table != NULL);
+        assert(worker->purchases_chunk.table != NULL);
+        assert(worker->results_chunk.table != NULL);
+        assert(worker->spill_buffers != NULL);
+        func_status = pthread_create(&(worker->thread), NULL, join_grace_partitions, worker);
+        assert(func_status == 0);
+    }
+    for (unsigned int worker_index = 0; worker_index < num_threads; ++worker_index) {
+        func_status = pthread_join(workers[worker_index].thread, NULL);
+        assert(func_status == 0);
+        free(workers[worker_index].customer_table.table);
+        free(workers[worker_index].purchases_chunk.table);
+        free(workers[worker_index].results_chunk.table);
+        free(workers[worker_index].spill_buffers);
+    }
+    free(workers);
+    pthread_mutex_destroy(&(join.next_partition_lock));
+    printf(GRACE_JOINED_MSG, monotonic_clock_secs() - start_time);
+
+    // Put joined records back in purchases table order
+    start_time = monotonic_clock_secs();
+    trace_start = trace_clock_nanosecs();
+    const unsigned long num_joined_records = merge_grace_results(&join, results_file_location);
+    record_trace_span(TRACE_CATEGORY_WRITE, "merge results", trace_start);
+    printf(GRACE_MERGED_MSG, num_joined_records, monotonic_clock_secs() - start_time);
+
+    rmdir(join.spill_directory);
+
+}
+
+// =================================================================================================
@@ -0,0 +1,199 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for finding the hot customers of the purchases
+// table and for skew-aware hash equijoin probing on the CPU.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <bsd/string.h>
+#include "equijoin_hot_customers.h"
+
+/*
+ * Number of sampled purchases of one customer.
+ *   - customer_id --- customer the purchases belong to; NULL_CUSTOMER_ID in empty slots
+ *   - num_purchases --- number of its sampled purchases
+ */
+struct Sampled_Customer {
+    unsigned long customer_id;
+    unsigned long num_purchases;
+};
+
+// =================================================================================================
+
+// Orders sampled customers from most to fewest purchases, and by customer ID among equals
+static int compare_sampled_customers(const void* first_customer, const void* second_customer) {
+
+    const struct Sampled_Customer* first = first_customer;
+    const struct Sampled_Customer* second = second_customer;
+    if (first->num_purchases != second->num_purchases) {
+        return (first->num_purchases < second->num_purchases) ? 1 : -1;
+    }
+    return (first->customer_id > second->customer_id) - (first->customer_id < second->customer_id);
+
+}
+
+void build_hot_customer_table(const struct Hashed_Customer_Table* hashed_customer_table,
+                                const struct Purchases_Table* purchases_table,
+                                  struct Hot_Customer_Table* hot_customer_table) {
+
+    // No null pointers allowed
+    assert(hashed_customer_table != NULL);
+    assert(hashed_customer_table->table != NULL);
+    assert(purchases_table != NULL);
+    assert(purchases_table->table != NULL);
+    assert(hot_customer_table != NULL);
+    // Purchases table HAS to have at least 1 row
+    assert(purchases_table->num_records >= 1);
+
+    memset(hot_customer_table, 0, sizeof(*hot_customer_table));
+    const unsigned long num_sampled_rows = (purchases_table->num_records < HOT_CUSTOMER_SAMPLE_ROWS) ?
+                                             purchases_table->num_records : HOT_CUSTOMER_SAMPLE_ROWS;
+
+    // Count sampled purchases per customer in a hash table at most half full
+    unsigned long num_count_slots = 1;
+    while (num_count_slots < 2 * num_sampled_rows) {
+        num_count_slots *= 2;
+    }
+    struct Sampled_Customer* sampled_customers = calloc(num_count_slots, sizeof(*sampled_customers));
+    assert(sampled_customers != NULL);
+    for (unsigned long sample_index = 0; sample_index < num_sampled_rows; ++sample_index) {
+        /*
+         * Stretches tile the whole table, the longer ones taking up the rows left over from
+         * dividing it evenly; the row of each stretch sampled is spread by hashing the
+         * stretch's index, so that the same rows are always sampled.
+         */
+        const unsigned long stretch_first_row = sample_index * purchases_table->num_records / num_sampled_rows;
+        const unsigned long stretch_end_row = (sample_index + 1) * purchases_table->num_records / num_sampled_rows;
+        const unsigned long row_index = stretch_first_row +
+                                          aggregation_key_to_slot(sample_index + 1) % (stretch_end_row - stretch_first_row);
+        const unsigned long customer_id = purchases_table->table[row_index].customer_id;
+        unsigned long slot = aggregation_key_to_slot(customer_id) & (num_count_slots - 1);
+        while (sampled_customers[slot].customer_id != NULL_CUSTOMER_ID &&
+               sampled_customers[slot].customer_id != customer_id) {
+            slot = (slot + 1) & (num_count_slots - 1);
+        }
+        sampled_customers[slot].customer_id = customer_id;
+        ++(sampled_customers[slot].num_purchases);
+    }
+
+    // Keep only customers skewed enough to be hot, packed at the start of the array
+    const double even_num_purchases = (double) num_sampled_rows / (double) hashed_customer_table->num_records;
+    unsigned long num_candidates = 0;
+    for (unsigned long slot = 0; slot < num_count_slots; ++slot) {
+        const struct Sampled_Customer candidate = sampled_customers[slot];
+        if (candidate.customer_id != NULL_CUSTOMER_ID &&
+            candidate.num_purchases >= HOT_CUSTOMER_MIN_SAMPLED_PURCHASES &&
+            candidate.num_purchases >= HOT_CUSTOMER_MIN_SKEW * even_num_purchases &&
+            candidate.customer_id <= hashed_customer_table->num_records) {
+            sampled_customers[num_candidates++] = candidate;
+        }
+    }
+    qsort(sampled_customers, num_candidates, sizeof(*sampled_customers), compare_sampled_customers);
+
+    // Hottest customers go into the hot customer table, each at the first free slot from its hash on
+    for (unsigned long candidate_index = 0; candidate_index < num_candidates &&
+                                              candidate_index < MAX_HOT_CUSTOMERS; ++candidate_index) {
+        const unsigned long customer_id = sampled_customers[candidate_index].customer_id;
+        unsigned int slot = hot_customer_id_to_slot(customer_id);
+        while (hot_customer_table->slots[slot].customer_id != NULL_CUSTOMER_ID) {
+            slot = (slot + 1) & (HOT_CUSTOMER_TABLE_SLOTS - 1);
+        }
+        hot_customer_table->slots[slot] = hashed_customer_table->table[customer_id_to_row_index(customer_id)];
+        ++(hot_customer_table->num_hot_customers);
+        hot_customer_table->num_sampled_hot_purchases += sampled_customers[candidate_index].num_purchases;
+    }
+    hot_customer_table->num_sampled_purchases = num_sampled_rows;
+    free(sampled_customers);
+
+    printf(HOT_CUSTOMERS_FOUND_MSG, hot_customer_table->num_hot_customers,
+             100.0 * hot_customer_table->num_sampled_hot_purchases / hot_customer_table->num_sampled_purchases,
+             hot_customer_table->num_sampled_purchases);
+
+}
+
+int find_hot_customer_slot(const struct Hot_Customer_Table* hot_customer_table, unsigned long customer_id) {
+
+    unsigned int slot = hot_customer_id_to_slot(customer_id);
+    for (unsigned int num_probes = 0; num_probes < HOT_CUSTOMER_TABLE_SLOTS; ++num_probes) {
+        const unsigned long slot_customer_id = hot_customer_table->slots[slot].customer_id;
+        if (slot_customer_id == customer_id) {
+            return (int) slot;
+        }
+        if (slot_customer_id == NULL_CUSTOMER_ID) {
+            break;
+        }
+        slot = (slot + 1) & (HOT_CUSTOMER_TABLE_SLOTS - 1);
+    }
+    return -1;
+
+}
+
+void hot_cached_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                      const struct Purchase_Predicate* purchase_predicate,
+                                        const struct Hot_Customer_Table* hot_customer_table) {
+
+    // No table included within the "List_Of_Tables" parameter shall refer to a NULL value
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    assert(hot_customer_table != NULL);
+    // Row count of each table MUST be greater than zero
+    assert(tables_list.purchases_table->num_records > 0);
+    assert(tables_list.results_table->num_records >= tables_list.purchases_table->num_records);
+    // Check that "is_customer_active" is of valid value
+    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG ||
+                    is_customer_active == CUSTOMER_INACTIVE_FLAG);
+
+    // Notify user hash join probing is about to start
+    printf(NOTIFY_USER_HOT_CACHED_HASH_JOIN_OP, hot_customer_table->num_hot_customers);
+
+    for (unsigned long result_table_row = 0; result_table_row < tables_list.purchases_table->num_records;
+                                                                                      ++result_table_row) {
+
+        const struct Purchases_Table_Row* purchases_row = &(tables_list.purchases_table->table[result_table_row]);
+        struct Joined_Results_Table_Row* results_row = &(tables_list.results_table->table[result_table_row]);
+
+        // Filtered out records never touch either customer table, as in "serial_hash_equijoin_probe"
+        if (!evaluate_purchase_predicate(purchase_predicate, purchases_row)) {
+            results_row->customer_id_customer = NULL_CUSTOMER_ID;
+            results_row->first_name_customer[NULL_CHARACTER_POS] = NULL_CUSTOMER_NAME;
+            continue;
+        }
+
+        const int hot_slot = find_hot_customer_slot(hot_customer_table, purchases_row->customer_id);
+        const struct Hashed_Customer_Table_Row* customer_row = (hot_slot >= 0) ?
+                    &(hot_customer_table->slots[hot_slot]) :
+                    &(tables_list.hashed_customer_table->table[customer_id_to_row_index(purchases_row->customer_id)]);
+
+        if (customer_row->active_customer == is_customer_active) {
+            results_row->time_of_purchase = purchases_row->time_of_purchase;
+            results_row->customer_id_customer = customer_row->customer_id;
+            results_row->quantity_purchased = purchases_row->quantity_purchased;
+            strlcpy(results_row->first_name_customer, customer_row->first_name, FIRST_NAME_MAX_LEN);
+            strlcpy(results_row->ean13, purchases_row->ean13, EAN13_MAX_CHARS);
+        } else {
+            results_row->customer_id_customer = NULL_CUSTOMER_ID;
+            results_row->first_name_customer[NULL_CHARACTER_POS] = NULL_CUSTOMER_NAME;
+        }
+
+    }
+
+}
+
+// =================================================================================================
@@ -0,0 +1,372 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for splitting hash equijoin probing across every
+// available OpenCL device; each device is driven by its own host thread so that all devices probe
+// their range of the purchases table concurrently.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "equijoin_multi_device.h"
+#include "opencl_profiling.h"
+#include "monotonic_clock.h"
+
+// =================================================================================================
+
+unsigned int enumerate_all_opencl_devices(cl_device_id* devices, unsigned int max_devices) {
+
+    // No null pointers allowed
+    assert(devices != NULL);
+
+    cl_platform_id platforms[MAX_MULTI_DEVICE_PLATFORMS];
+    cl_uint num_platforms = 0;
+    unsigned int num_devices_found = 0;
+
+    clGetPlatformIDs(MAX_MULTI_DEVICE_PLATFORMS, platforms, &num_platforms);
+    if (num_platforms > MAX_MULTI_DEVICE_PLATFORMS) {
+        num_platforms = MAX_MULTI_DEVICE_PLATFORMS;
+    }
+
+    for (cl_uint platform_index = 0; platform_index < num_platforms; ++platform_index) {
+
+        cl_uint num_platform_devices = 0;
+        if (clGetDeviceIDs(platforms[platform_index], CL_DEVICE_TYPE_ALL, 0,
+                                   NULL, &num_platform_devices) != CL_SUCCESS) {
+            // Platform without any devices; nothing to use here
+            continue;
+        }
+        cl_device_id* platform_devices = malloc(sizeof(*platform_devices) * num_platform_devices);
+        assert(platform_devices != NULL);
+        clGetDeviceIDs(platforms[platform_index], CL_DEVICE_TYPE_ALL, num_platform_devices,
+                                                                   platform_devices, NULL);
+
+        for (cl_uint device_index = 0; device_index < num_platform_devices &&
+                                           num_devices_found < max_devices; ++device_index) {
+
+            cl_device_type device_type;
+            cl_uint num_compute_units = 0;
+            cl_uint num_sub_devices = 0;
+            clGetDeviceInfo(platform_devices[device_index], CL_DEVICE_TYPE,
+                                        sizeof(device_type), &device_type, NULL);
+            clGetDeviceInfo(platform_devices[device_index], CL_DEVICE_MAX_COMPUTE_UNITS,
+                                        sizeof(num_compute_units), &num_compute_units, NULL);
+
+            /*
+             * Partition CPU devices equally so that each group of CPU cores behaves like
+             * an independent device with its own queue; fall back to using the whole
+             * device if the OpenCL runtime doesn't support partitioning it.
+             */
+            const cl_device_partition_property partition_properties[] = {
+                                    CL_DEVICE_PARTITION_EQUALLY, CPU_SUB_DEVICE_COMPUTE_UNITS,
+                                    CL_DEVICE_PARTITION_BY_COUNTS_LIST_END };
+            if ((device_type & CL_DEVICE_TYPE_CPU) &&
+                       num_compute_units > CPU_SUB_DEVICE_COMPUTE_UNITS &&
+                       clCreateSubDevices(platform_devices[device_index], partition_properties,
+                                                   0, NULL, &num_sub_devices) == CL_SUCCESS &&
+                       num_sub_devices > 1) {
+
+                cl_device_id* sub_devices = malloc(sizeof(*sub_devices) * num_sub_devices);
+                assert(sub_devices != NULL);
+                clCreateSubDevices(platform_devices[device_index], partition_properties,
+                                                     num_sub_devices, sub_devices, NULL);
+                for (cl_uint sub_device_index = 0; sub_device_index < num_sub_devices; ++sub_device_index) {
+                    if (num_devices_found < max_devices) {
+                        devices[num_devices_found++] = sub_devices[sub_device_index];
+                    } else {
+                        // No more room for sub-devices; give them back to the runtime
+                        clReleaseDevice(sub_devices[sub_device_index]);
+                    }
+                }
+                free(sub_devices);
+
+            } else {
+                devices[num_devices_found++] = platform_devices[device_index];
+            }
+
+        }
+
+        free(platform_devices);
+
+    }
+
+    return num_devices_found;
+
+}
+
+/*
+ * Creates the context, command queue and program for the device of "worker",
+ * and then copies the whole hashed customer table into the device's memory.
+ */
+static void setup_opencl_device_worker(struct Opencl_Device_Worker* worker,
+                                         const char* opencl_program_string) {
+
+    cl_int func_error_code;
+    cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+    struct Hashed_Customer_Table* hashed_customer_table = worker->tables_list.hashed_customer_table;
+
+    clGetDeviceInfo(worker->device, CL_DEVICE_NAME, MAX_LEN, worker->device_name, NULL);
+    printf(MULTI_DEVICE_FOUND_MSG, worker->device_index, worker->device_name);
+
+    worker->context = clCreateContext(NULL, NUM_CL_DEVICES, &(worker->device), NULL, NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    worker->queue = clCreateCommandQueueWithProperties(worker->context, worker->device,
+                                                            queue_properties, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    select_probe_kernel_variant(worker->device, &(worker->kernel_variant));
+    worker->program = build_opencl_program(worker->context, worker->device,
+                                             opencl_program_string, worker->kernel_variant.compiler_options);
+
+    // Each device holds its own copy of the whole hashed customer table
+    worker->hashed_customer_table_buffer = clCreateBuffer(worker->context, CL_MEM_READ_ONLY,
+                                                   hashed_customer_table->num_records *
+                                                        sizeof(*(hashed_customer_table->table)),
+                                                                         NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clEnqueueWriteBuffer(worker->queue, worker->hashed_customer_table_buffer,
+                                              CL_BLOCKING, CL_BUFFER_OFFSET,
+                                              hashed_customer_table->num_records *
+                                                   sizeof(*(hashed_customer_table->table)),
+                                              hashed_customer_table->table, 0, NULL, NULL);
+    assert(func_error_code == CL_SUCCESS);
+
+    worker->purchases_table_buffer = NULL;
+    worker->joined_results_table_buffer = NULL;
+
+}
+
+/*
+ * Copies rows ["first_row", "first_row" + "num_rows") of the purchases table into
+ * the device memory of "worker", and then probes those rows on the device; the
+ * joined rows are read back into the same rows of the full results table.  Every
+ * OpenCL command is recorded in "profiling_report" unless it is NULL.
+ */
+static void probe_purchases_range_on_device(struct Opencl_Device_Worker* worker,
+                                              unsigned long first_row, unsigned long num_rows,
+                                                struct Opencl_Profiling_Report* profiling_report) {
+
+    cl_int func_error_code;
+    cl_event write_event;
+
+    // Point the "views" of the purchases and results tables at the requested range
+    worker->purchases_view.table = worker->tables_list.purchases_table->table + first_row;
+    worker->purchases_view.num_records = num_rows;
+    worker->results_view.table = worker->tables_list.results_table->table + first_row;
+    worker->results_view.num_records = num_rows;
+
+    // Buffers from any previous range are of the wrong size; give them back first
+    if (worker->purchases_table_buffer != NULL) {
+        clReleaseMemObject(worker->purchases_table_buffer);
+    }
+    if (worker->joined_results_table_buffer != NULL) {
+        clReleaseMemObject(worker->joined_results_table_buffer);
+    }
+    worker->purchases_table_buffer = clCreateBuffer(worker->context, CL_MEM_READ_ONLY,
+                                                        num_rows * sizeof(*(worker->purchases_view.table)),
+                                                                               NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    worker->joined_results_table_buffer = clCreateBuffer(worker->context, CL_MEM_WRITE_ONLY,
+                                                        num_rows * sizeof(*(worker->results_view.table)),
+                                                                               NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clEnqueueWriteBuffer(worker->queue, worker->purchases_table_buffer,
+                                              CL_BLOCKING, CL_BUFFER_OFFSET,
+                                              num_rows * sizeof(*(worker->purchases_view.table)),
+                                              worker->purchases_view.table, 0, NULL, &write_event);
+    assert(func_error_code == CL_SUCCESS);
+    record_opencl_command_profile(profiling_report, write_event, PROFILING_PHASE_UPLOAD, "purchases_table",
+                                    num_rows * sizeof(*(worker->purchases_view.table)), num_rows);
+    clReleaseEvent(write_event);
+
+    struct List_Of_Tables range_tables_list = {
+                                                worker->tables_list.hashed_customer_table,
+                                                &(worker->purchases_view),
+                                                &(worker->results_view)
+                                              };
+    struct Cl_Mem_Operands_List cl_mem_ops = {
+                                               &(worker->hashed_customer_table_buffer),
+                                               &(worker->purchases_table_buffer),
+                                               &(worker->joined_results_table_buffer)
+                                             };
+
+    opencl_hash_equijoin_probe(&(worker->queue), &(worker->program), &(worker->kernel),
+                                    range_tables_list, cl_mem_ops, worker->is_customer_active,
+                                                               &(worker->kernel_variant), NULL,
+                                                                              profiling_report);
+    clReleaseKernel(worker->kernel);
+
+}
+
+/*
+ * Entry point of each host thread driving one OpenCL device; probes the
+ * range of the purchases table assigned to the device and times it.
+ */
+static void* opencl_device_worker_thread(void* worker_arg) {
+
+    struct Opencl_Device_Worker* worker = worker_arg;
+
+    double start_time = monotonic_clock_secs();
+    reset_opencl_profiling_report(&(worker->profiling_report));
+    probe_purchases_range_on_device(worker, worker->first_row, worker->num_rows,
+                                                  &(worker->profiling_report));
+    worker->probe_seconds = monotonic_clock_secs() - start_time;
+
+    return NULL;
+
+}
+
+/*
+ * Splits the purchases table into one contiguous range per worker, where the
+ * size of each range is proportional to the calibrated throughput of the worker's
+ * device.  Ranges are whole multiples of NUM_THREADS_IN_BLOCK rows, except that
+ * any blocks left over from rounding down, as well as any rows not making up a
+ * whole block, go to the fastest device.
+ */
+static void split_purchases_table_by_throughput(struct Opencl_Device_Worker* workers,
+                                                  unsigned int num_workers,
+                                                  unsigned long num_purchases_rows) {
+
+    const unsigned long total_blocks = num_purchases_rows / NUM_THREADS_IN_BLOCK;
+    unsigned long blocks_assigned = 0;
+    unsigned int fastest_worker = 0;
+    double total_rows_per_second = 0.0;
+
+    for (unsigned int worker_index = 0; worker_index < num_workers; ++worker_index) {
+        total_rows_per_second += workers[worker_index].rows_per_second;
+        if (workers[worker_index].rows_per_second > workers[fastest_worker].rows_per_second) {
+            fastest_worker = worker_index;
+        }
+    }
+
+    for (unsigned int worker_index = 0; worker_index < num_workers; ++worker_index) {
+        unsigned long worker_blocks = (unsigned long) ((double) total_blocks *
+                                           (workers[worker_index].rows_per_second / total_rows_per_second));
+        workers[worker_index].num_rows = worker_blocks * NUM_THREADS_IN_BLOCK;
+        blocks_assigned += worker_blocks;
+    }
+    workers[fastest_worker].num_rows += (total_blocks - blocks_assigned) * NUM_THREADS_IN_BLOCK +
+                                          num_purchases_rows % NUM_THREADS_IN_BLOCK;
+
+    // Ranges are laid out back to back in device order
+    unsigned long next_first_row = 0;
+    for (unsigned int worker_index = 0; worker_index < num_workers; ++worker_index) {
+        workers[worker_index].first_row = next_first_row;
+        next_first_row += workers[worker_index].num_rows;
+    }
+
+}
+
+void multi_device_hash_equijoin_probe(struct List_Of_Tables tables_list, char is_customer_active,
+                                        const struct Purchase_Predicate* purchase_predicate) {
+
+    // No null pointers allowed
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    // Each table HAS to have at least 1 row
+    assert(tables_list.hashed_customer_table->num_records >= 1);
+    assert(tables_list.purchases_table->num_records >= 1);
+    assert(tables_list.results_table->num_records >= 1);
+
+    cl_device_id devices[MAX_MULTI_DEVICES];
+    unsigned int num_devices = enumerate_all_opencl_devices(devices, MAX_MULTI_DEVICES);
+    // Can't do anything without at least one OpenCL device
+    assert(num_devices >= 1);
+
+    struct Opencl_Device_Worker* workers = calloc(num_devices, sizeof(*workers));
+    assert(workers != NULL);
+    char* opencl_program_string = get_opencl_program_code(PROGRAM_FILE);
+
+    if (purchase_predicate != NULL) {
+        // Every device compiles the program once anyway; put the predicate in front of it for all of them
+        char predicate_source[MAX_PREDICATE_SOURCE_LEN];
+        purchase_predicate_to_opencl_c(purchase_predicate, predicate_source, sizeof(predicate_source));
+        const size_t program_string_len = strlen(predicate_source) + strlen(opencl_program_string) + 1;
+        char* predicate_program_string = malloc(program_string_len);
+        assert(predicate_program_string != NULL);
+        snprintf(predicate_program_string, program_string_len, "%s%s", predicate_source, opencl_program_string);
+        free(opencl_program_string);
+        opencl_program_string = predicate_program_string;
+    }
+
+    const unsigned long num_calibration_rows =
+                 (tables_list.purchases_table->num_records < CALIBRATION_PURCHASES_ROWS) ?
+                        tables_list.purchases_table->num_records : CALIBRATION_PURCHASES_ROWS;
+
+    /*
+     * Set up and calibrate one device at a time so that the throughput measured
+     * for each device isn't disturbed by the other devices.
+     */
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+
+        workers[device_index].device = devices[device_index];
+        workers[device_index].device_index = device_index;
+        workers[device_index].tables_list = tables_list;
+        workers[device_index].is_customer_active = is_customer_active;
+        setup_opencl_device_worker(&(workers[device_index]), opencl_program_string);
+
+        double start_time = monotonic_clock_secs();
+        probe_purchases_range_on_device(&(workers[device_index]), 0, num_calibration_rows, NULL);
+        workers[device_index].rows_per_second = (double) num_calibration_rows /
+                                                  (monotonic_clock_secs() - start_time);
+        printf(MULTI_DEVICE_CALIBRATION_MSG, device_index, workers[device_index].device_name,
+                                                          workers[device_index].rows_per_second);
+
+    }
+    free(opencl_program_string);
+
+    split_purchases_table_by_throughput(workers, num_devices, tables_list.purchases_table->num_records);
+
+    // Probe every range concurrently, one host thread per device
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        if (workers[device_index].num_rows > 0) {
+            int func_status = pthread_create(&(workers[device_index].thread), NULL,
+                                               opencl_device_worker_thread, &(workers[device_index]));
+            assert(func_status == 0);
+        }
+    }
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        if (workers[device_index].num_rows > 0) {
+            pthread_join(workers[device_index].thread, NULL);
+            printf(MULTI_DEVICE_SPLIT_MSG, device_index, workers[device_index].device_name,
+                     workers[device_index].first_row,
+                     workers[device_index].first_row + workers[device_index].num_rows,
+                     100.0 * (double) workers[device_index].num_rows /
+                                (double) tables_list.purchases_table->num_records,
+                     workers[device_index].probe_seconds);
+            print_opencl_profiling_report(&(workers[device_index].profiling_report));
+        }
+    }
+
+    /*
+     * Give back to the system main memory and device memory space used
+     * by every device as the devices are no longer used after this point.
+     */
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        clReleaseMemObject(workers[device_index].hashed_customer_table_buffer);
+        clReleaseMemObject(workers[device_index].purchases_table_buffer);
+        clReleaseMemObject(workers[device_index].joined_results_table_buffer);
+        clReleaseProgram(workers[device_index].program);
+        clReleaseCommandQueue(workers[device_index].queue);
+        clReleaseContext(workers[device_index].context);
+        clReleaseDevice(workers[device_index].device);
+    }
+    free(workers);
+
+}
+
+// =================================================================================================
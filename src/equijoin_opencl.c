@@ -18,13 +18,53 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 #include "equijoin_opencl.h"
+#include "opencl_profiling.h"
+#include "purchases_zone_map.h"
+#include "equijoin_hot_customers.h"
 
 // =================================================================================================
 
+void select_probe_kernel_variant(cl_device_id device, struct Probe_Kernel_Variant* variant) {
+
+    // No null pointers allowed
+    assert(variant != NULL);
+
+    cl_device_type device_type = CL_DEVICE_TYPE_DEFAULT;
+    clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(device_type), &device_type, NULL);
+
+    if (USE_COARSENED_PROBE_KERNEL) {
+        variant->kernel_func_name = COARSENED_KERNEL_FUNC_NAME;
+        variant->rows_per_work_item = (device_type & CL_DEVICE_TYPE_CPU) ?
+                                          CPU_ROWS_PER_WORK_ITEM : GPU_ROWS_PER_WORK_ITEM;
+    } else {
+        variant->kernel_func_name = KERNEL_FUNC_NAME;
+        variant->rows_per_work_item = 1;
+    }
+    snprintf(variant->compiler_options, MAX_COMPILER_OPTIONS_LEN,
+               OPENCL_COMPILER_OPTIONS ROWS_PER_WORK_ITEM_COMPILER_OPTION, variant->rows_per_work_item);
+    variant->work_group_size = NUM_THREADS_IN_BLOCK;
+    variant->hot_customer_table = NULL;
+
+}
+
+size_t probe_kernel_global_size(const struct Probe_Kernel_Variant* variant, unsigned long num_rows) {
+
+    // The naive kernel has one work-item per row, and no check for rows past the end of the table
+    if (variant == NULL || strcmp(variant->kernel_func_name, KERNEL_FUNC_NAME) == 0) {
+        return num_rows;
+    }
+
+    const size_t num_work_items = (num_rows + variant->rows_per_work_item - 1) / variant->rows_per_work_item;
+    return ((num_work_items + variant->work_group_size - 1) / variant->work_group_size) * variant->work_group_size;
+
+}
+
 void load_tables_hash_equijoin_probe(cl_context *context, cl_command_queue* queue,
                                               struct List_Of_Tables tables_list,
-                                                 struct Cl_Mem_Operands_List cl_operands) {     
+                                                 struct Cl_Mem_Operands_List cl_operands,
+                                                   struct Opencl_Profiling_Report* profiling_report) {
     // No null pointers allowed
     assert(context != NULL);
     assert(queue != NULL);
@@ -102,52 +142,83 @@ void load_tables_hash_equijoin_probe(cl_context *context, cl_command_queue* queu
 
     // Wait for all write commands to finish executing
     func_error_code = clWaitForEvents(num_of_write_events, write_events);
+    // Record how long each table took to be written to OpenCL device memory
+    record_opencl_command_profile(profiling_report, write_events[hashed_customer_table_write_index],
+                                    PROFILING_PHASE_UPLOAD, "hashed_customer_table",
+                                    (tables_list.hashed_customer_table->num_records) *
+                                        sizeof(*(tables_list.hashed_customer_table->table)),
+                                    tables_list.hashed_customer_table->num_records);
+    record_opencl_command_profile(profiling_report, write_events[purchases_table_write_index],
+                                    PROFILING_PHASE_UPLOAD, "purchases_table",
+                                    (tables_list.purchases_table->num_records) *
+                                        sizeof(*(tables_list.purchases_table->table)),
+                                    tables_list.purchases_table->num_records);
+    record_opencl_command_profile(profiling_report, write_events[results_table_write_index],
+                                    PROFILING_PHASE_UPLOAD, "results_table",
+                                    (tables_list.results_table->num_records) *
+                                        sizeof(*(tables_list.results_table->table)),
+                                    tables_list.results_table->num_records);
     // Writing to OpenCL device memory finished; free memory storing list of write command events.
+    for (int event_index = 0; event_index < num_of_write_events; ++event_index) {
+        clReleaseEvent(write_events[event_index]);
+    }
     free(write_events);
 
 }
 
-void opencl_hash_equijoin_probe(cl_command_queue *queue, cl_program *program,
-                                      cl_kernel* kernel, struct List_Of_Tables tables_list,
-                                        struct Cl_Mem_Operands_List cl_operands, char is_customer_active) {
+const char* enqueue_hash_equijoin_probe_kernel(cl_command_queue *queue, cl_program *program,
+                                                 cl_kernel* kernel, struct List_Of_Tables tables_list,
+                                                   struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                                     const struct Probe_Kernel_Variant* kernel_variant,
+                                                       const struct Purchases_Block_Selection* block_selection,
+                                                         cl_event* kernel_event, cl_event* remainder_kernel_event) {
     // No null pointers allowed
     assert(program != NULL);
     assert(queue != NULL);
     assert(kernel != NULL);
-    assert(tables_list.hashed_customer_table != NULL);
-    assert(tables_list.hashed_customer_table->table != NULL);
-    assert(tables_list.hashed_customer_table->table->first_name != NULL);
+    assert(kernel_event != NULL);
+    assert(remainder_kernel_event != NULL);
     assert(tables_list.purchases_table != NULL);
-    assert(tables_list.purchases_table->table != NULL);
-    assert(tables_list.purchases_table->table->ean13 != NULL);
     assert(tables_list.results_table != NULL);
-    assert(tables_list.results_table->table != NULL);
-    assert(tables_list.results_table->table->ean13 != NULL);
-    assert(tables_list.results_table->table->first_name_customer != NULL);
     assert(cl_operands.hashed_customer_table_buffer != NULL);
     assert(cl_operands.joined_results_table_buffer != NULL);
     assert(cl_operands.purchases_table_buffer != NULL);
-    // Each table HAS to have at least 1 row
-    assert(tables_list.hashed_customer_table->num_records >= 1);
-    assert(tables_list.purchases_table->num_records >= 1);
-    assert(tables_list.results_table->num_records >= 1);
 
-    // The last event to be performed in the command queue on the OpenCL device
-    cl_event event;
     cl_int func_error_code;
 
     // Generate the kernel runtime from the compiled OpenCL program.
-    *kernel = clCreateKernel(*program, KERNEL_FUNC_NAME, &func_error_code);
+    const bool is_hot_cached = block_selection == NULL && kernel_variant != NULL &&
+                                 kernel_variant->hot_customer_table != NULL;
+    const char* kernel_func_name = (block_selection != NULL) ? ZONE_MAPPED_KERNEL_FUNC_NAME :
+                                   is_hot_cached ? HOT_CACHED_KERNEL_FUNC_NAME :
+                                   (kernel_variant != NULL) ? kernel_variant->kernel_func_name :
+                                                                 KERNEL_FUNC_NAME;
+    *kernel = clCreateKernel(*program, kernel_func_name, &func_error_code);
 
     /* 
      * Specify size of each thread block and size of result output table
      * for the kernel to be executed
      */
-    const size_t local[OPERAND_DIMS] = { NUM_THREADS_IN_BLOCK };
-    const size_t global[OPERAND_DIMS] = { tables_list.results_table->num_records };
+    const size_t work_group_size = (kernel_variant != NULL) ? kernel_variant->work_group_size : NUM_THREADS_IN_BLOCK;
+    const unsigned int rows_per_work_item = (kernel_variant != NULL) ? kernel_variant->rows_per_work_item : 1;
+    const size_t local[OPERAND_DIMS] = { work_group_size };
+    size_t global[OPERAND_DIMS] = { probe_kernel_global_size(kernel_variant,
+                                                             tables_list.results_table->num_records) };
+    if (block_selection != NULL) {
+        // Only as many work-items as the blocks left to probe need
+        const size_t num_work_items = block_selection->num_blocks * (ZONE_MAP_BLOCK_ROWS / rows_per_work_item);
+        global[0] = ((num_work_items + work_group_size - 1) / work_group_size) * work_group_size;
+    } else if (is_hot_cached) {
+        // Whole work-groups copy the hot customer table, whichever kernel the variant has otherwise
+        const size_t num_work_items = (tables_list.results_table->num_records + rows_per_work_item - 1) /
+                                        rows_per_work_item;
+        global[0] = ((num_work_items + work_group_size - 1) / work_group_size) * work_group_size;
+    }
 
     // Notify user hash join probing starts now
-    printf(NOTIFY_USER_HASH_JOIN_OP, NUM_THREADS_IN_BLOCK);
+    printf(NOTIFY_USER_HASH_JOIN_OP, (int) work_group_size);
+    printf(NOTIFY_USER_KERNEL_VARIANT, kernel_func_name,
+             (kernel_variant != NULL) ? kernel_variant->rows_per_work_item : 1);
 
     // Set arguments for equijoin kernel
     func_error_code = clSetKernelArg(*kernel, 0, sizeof(*(cl_operands.hashed_customer_table_buffer)),
@@ -157,18 +228,162 @@ void opencl_hash_equijoin_probe(cl_command_queue *queue, cl_program *program,
     func_error_code = clSetKernelArg(*kernel, 2, sizeof(*(cl_operands.joined_results_table_buffer)),
                                                         (void*)cl_operands.joined_results_table_buffer);
     func_error_code = clSetKernelArg(*kernel, 3, sizeof(is_customer_active), (void*)&is_customer_active);
+    // Only the thread-coarsened kernels need to know where the purchases table ends
+    if (strcmp(kernel_func_name, KERNEL_FUNC_NAME) != 0) {
+        func_error_code = clSetKernelArg(*kernel, 4, sizeof(tables_list.purchases_table->num_records),
+                                                   (void*)&(tables_list.purchases_table->num_records));
+    }
+    cl_mem probed_blocks_buffer = NULL;
+    if (block_selection != NULL) {
+        // Hand the zone-mapped kernel the blocks left to probe
+        cl_context context;
+        func_error_code = clGetCommandQueueInfo(*queue, CL_QUEUE_CONTEXT, sizeof(context), &context, NULL);
+        assert(func_error_code == CL_SUCCESS);
+        probed_blocks_buffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                                block_selection->num_blocks * sizeof(*(block_selection->blocks)),
+                                                block_selection->blocks, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        func_error_code = clSetKernelArg(*kernel, 5, sizeof(probed_blocks_buffer), (void*)&probed_blocks_buffer);
+        func_error_code = clSetKernelArg(*kernel, 6, sizeof(block_selection->num_blocks),
+                                                   (void*)&(block_selection->num_blocks));
+    }
+    cl_mem hot_customer_table_buffer = NULL;
+    if (is_hot_cached) {
+        // Hand the hot-cached kernel the hot customer table, which each work-group copies to local memory
+        cl_context context;
+        func_error_code = clGetCommandQueueInfo(*queue, CL_QUEUE_CONTEXT, sizeof(context), &context, NULL);
+        assert(func_error_code == CL_SUCCESS);
+        hot_customer_table_buffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                                     sizeof(kernel_variant->hot_customer_table->slots),
+                                                     (void*) kernel_variant->hot_customer_table->slots,
+                                                     &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        func_error_code = clSetKernelArg(*kernel, 5, sizeof(hot_customer_table_buffer),
+                                                   (void*)&hot_customer_table_buffer);
+    }
     
-    // Enqueue equijoin task to command queue to execute the equijoin.
-    func_error_code = clEnqueueNDRangeKernel(*queue, *kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, &event);
+    /*
+     * The naive kernel has no check for rows past the end of the table, so only the rows
+     * making up whole work-groups are probed with "local" work-groups; any remaining rows are
+     * probed by a launch starting at the first remaining row, with the work-group size left
+     * up to the OpenCL runtime.  The queue executes commands in order, so the remainder is
+     * enqueued first and the event of the last launch covers both; each launch is profiled on its own.
+     */
+    const size_t remainder_offset[OPERAND_DIMS] = { (global[0] / work_group_size) * work_group_size };
+    const size_t remainder_global[OPERAND_DIMS] = { global[0] - remainder_offset[0] };
+    *remainder_kernel_event = NULL;
+    if (remainder_global[0] > 0 && remainder_offset[0] == 0) {
+        // Not even one whole work-group; the remainder launch is the only one
+        func_error_code = clEnqueueNDRangeKernel(*queue, *kernel, OPERAND_DIMS, NULL, remainder_global, NULL,
+                                                                                    0, NULL, kernel_event);
+        assert(func_error_code == CL_SUCCESS);
+    } else {
+        if (remainder_global[0] > 0) {
+            func_error_code = clEnqueueNDRangeKernel(*queue, *kernel, OPERAND_DIMS, remainder_offset,
+                                                          remainder_global, NULL, 0, NULL, remainder_kernel_event);
+            assert(func_error_code == CL_SUCCESS);
+            global[0] = remainder_offset[0];
+        }
+        // Enqueue equijoin task to command queue to execute the equijoin.
+        func_error_code = clEnqueueNDRangeKernel(*queue, *kernel, OPERAND_DIMS, NULL, global, local, 0, NULL,
+                                                                                              kernel_event);
+        assert(func_error_code == CL_SUCCESS);
+    }
+    if (probed_blocks_buffer != NULL) {
+        // Buffer is only actually released once the kernel using it has finished
+        clReleaseMemObject(probed_blocks_buffer);
+    }
+    if (hot_customer_table_buffer != NULL) {
+        clReleaseMemObject(hot_customer_table_buffer);
+    }
+
+    return kernel_func_name;
+
+}
+
+void record_hash_equijoin_probe_kernel_profiles(struct Opencl_Profiling_Report* profiling_report,
+                                                  const char* kernel_func_name, struct List_Of_Tables tables_list,
+                                                  const struct Probe_Kernel_Variant* kernel_variant,
+                                                  cl_event kernel_event, cl_event remainder_kernel_event) {
+
+    const size_t work_group_size = (kernel_variant != NULL) ? kernel_variant->work_group_size : NUM_THREADS_IN_BLOCK;
+    const size_t row_bytes = sizeof(*(tables_list.purchases_table->table)) + sizeof(*(tables_list.results_table->table));
+    // Only the rows past the last whole work-group are ever probed by a launch of their own
+    const unsigned long num_remainder_rows = (remainder_kernel_event != NULL) ?
+                                               tables_list.results_table->num_records % work_group_size : 0;
+    const unsigned long num_kernel_rows = tables_list.results_table->num_records - num_remainder_rows;
+
+    record_opencl_command_profile(profiling_report, kernel_event, PROFILING_PHASE_KERNEL, kernel_func_name,
+                                    num_kernel_rows * row_bytes, num_kernel_rows);
+    clReleaseEvent(kernel_event);
+    if (remainder_kernel_event != NULL) {
+        record_opencl_command_profile(profiling_report, remainder_kernel_event, PROFILING_PHASE_KERNEL,
+                                        KERNEL_FUNC_NAME " (remainder)", num_remainder_rows * row_bytes,
+                                        num_remainder_rows);
+        clReleaseEvent(remainder_kernel_event);
+    }
+
+}
+
+void opencl_hash_equijoin_probe(cl_command_queue *queue, cl_program *program,
+                                      cl_kernel* kernel, struct List_Of_Tables tables_list,
+                                        struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                          const struct Probe_Kernel_Variant* kernel_variant,
+                                            const struct Purchases_Block_Selection* block_selection,
+                                              struct Opencl_Profiling_Report* profiling_report) {
+    // No null pointers allowed
+    assert(program != NULL);
+    assert(queue != NULL);
+    assert(kernel != NULL);
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.hashed_customer_table->table->first_name != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    assert(tables_list.purchases_table->table->ean13 != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    assert(tables_list.results_table->table->ean13 != NULL);
+    assert(tables_list.results_table->table->first_name_customer != NULL);
+    assert(cl_operands.hashed_customer_table_buffer != NULL);
+    assert(cl_operands.joined_results_table_buffer != NULL);
+    assert(cl_operands.purchases_table_buffer != NULL);
+    // Each table HAS to have at least 1 row
+    assert(tables_list.hashed_customer_table->num_records >= 1);
+    assert(tables_list.purchases_table->num_records >= 1);
+    assert(tables_list.results_table->num_records >= 1);
+
+    // The last event to be performed in the command queue on the OpenCL device
+    cl_event event;
+    // The event of the launch probing the rows which don't fill a whole work-group, if any
+    cl_event remainder_event;
+    // The event of copying the result of the table join back to main memory
+    cl_event read_event;
+    cl_int func_error_code;
+
+    const char* kernel_func_name = enqueue_hash_equijoin_probe_kernel(queue, program, kernel, tables_list,
+                                                                        cl_operands, is_customer_active,
+                                                                        kernel_variant, block_selection, &event,
+                                                                        &remainder_event);
 
     // Wait for table equijoining to be finished
     func_error_code = clWaitForEvents(1, &event);
+    assert(func_error_code == CL_SUCCESS);
+    record_hash_equijoin_probe_kernel_profiles(profiling_report, kernel_func_name, tables_list, kernel_variant,
+                                                 event, remainder_event);
 
     // Copy the result of the table join back to main memory
     func_error_code = clEnqueueReadBuffer(*queue, *(cl_operands.joined_results_table_buffer), CL_BLOCKING,
                                                     CL_BUFFER_OFFSET, tables_list.results_table->num_records *
                                                                       sizeof(*(tables_list.results_table->table)),
-                                                                    tables_list.results_table->table, 0, NULL, NULL);
+                                                                    tables_list.results_table->table, 0, NULL,
+                                                                                                  &read_event);
+    assert(func_error_code == CL_SUCCESS);
+    record_opencl_command_profile(profiling_report, read_event, PROFILING_PHASE_READBACK, "results_table",
+                                    tables_list.results_table->num_records *
+                                        sizeof(*(tables_list.results_table->table)),
+                                    tables_list.results_table->num_records);
+    clReleaseEvent(read_event);
     
 }
 
@@ -1,6 +1,16 @@
 
 #include "/home/bkupuntu/personal_sandboxes/c_sandbox/opencl_basics/work/opencl_equijoin_demo/include/data_structures_opencl.h"
 
+/*
+ * Predicate every purchases table row has to satisfy to be joined at all; rows which don't
+ * satisfy it are stored as NULL rows without ever looking up their customer.  The host
+ * pushes predicates down by putting its own "#define PURCHASE_PREDICATE(purchase_row) ..."
+ * (with every constant inlined) in front of this file; by default every row satisfies it.
+ */
+#ifndef PURCHASE_PREDICATE
+    #define PURCHASE_PREDICATE(purchase_row) (1)
+#endif
+
 /*
  * Hash join probing kernel operating on global memory in OpenCL.
  * 
@@ -66,11 +76,14 @@ __kernel void naive_hash_equijoin_probe(__global struct Hashed_Customer_Table_Ro
                     customer_id_to_row_index(purchases_table[result_table_row].customer_id);
    
    /*
-    * If the customer table record's active_customer flag and the is_customer_active
-    * parameter both indicate the same thing on whether or not customer is active, then
-    * join the customer table record and the matching purchase table record together. 
+    * If the purchases table record satisfies the purchases predicate, and the customer
+    * table record's active_customer flag and the is_customer_active parameter both indicate
+    * the same thing on whether or not customer is active, then join the customer table record
+    * and the matching purchase table record together.  The predicate is checked first so
+    * that filtered out records never touch the customer table.
     */
-    if (hashed_customer_table[hashed_customer_table_row].active_customer == is_customer_active) {
+    if (PURCHASE_PREDICATE(purchases_table[result_table_row]) &&
+          hashed_customer_table[hashed_customer_table_row].active_customer == is_customer_active) {
            
           results_table[result_table_row].time_of_purchase =
                         purchases_table[result_table_row].time_of_purchase;
@@ -96,8 +109,9 @@ __kernel void naive_hash_equijoin_probe(__global struct Hashed_Customer_Table_Ro
     } else {
 
           /*
-           * If customer status indicated by the "active_customer" field and the "is_customer_active"
-           * parameter don't agree, then (as defined in the included header file) insert NULL_CUSTOMER_ID
+           * If the purchases table record doesn't satisfy the purchases predicate, or customer status
+           * indicated by the "active_customer" field and the "is_customer_active" parameter don't agree,
+           * then (as defined in the included header file) insert NULL_CUSTOMER_ID
            * into each customer id attribute (as stored in the "customer_id_customer" field in each
            * "Joined_Results_Table_Row" struct/row) and insert NULL_CUSTOMER_NAME into the customer
            * first name attribute (as stored in the "first_name_customer" field in each "Joined_Results_Table_Row"
@@ -111,3 +125,675 @@ __kernel void naive_hash_equijoin_probe(__global struct Hashed_Customer_Table_Ro
 
 }
 
+
+
+/*
+ * Number of consecutive purchases table rows each work-item of the thread-coarsened
+ * probe kernel joins; the host passes the value best suited to each OpenCL device
+ * as a "-D ROWS_PER_WORK_ITEM=..." compiler option.
+ */
+#ifndef ROWS_PER_WORK_ITEM
+    #define ROWS_PER_WORK_ITEM 1
+#endif
+
+/*
+ * Copy a customer first name using the widest vector loads and stores which fit into
+ * FIRST_NAME_MAX_LEN characters (16 + 4 + 1 characters for the default length), instead
+ * of one character at a time.
+ */
+void vector_copy_first_name(__global char* destination, const __global char* source)
+{
+#if (FIRST_NAME_MAX_LEN == 21)
+    vstore16(vload16(0, source), 0, destination);
+    vstore4(vload4(0, source + 16), 0, destination + 16);
+    destination[20] = source[20];
+#else
+    for (unsigned int char_index = 0; char_index < FIRST_NAME_MAX_LEN; ++char_index) {
+          destination[char_index] = source[char_index];
+    }
+#endif
+}
+
+/*
+ * Copy an EAN13 barcode using the widest vector loads and stores which fit into
+ * EAN13_MAX_CHARS characters (8 + 4 + 2 characters for the default length), instead
+ * of one character at a time.
+ */
+void vector_copy_ean13(__global char* destination, const __global char* source)
+{
+#if (EAN13_MAX_CHARS == 14)
+    vstore8(vload8(0, source), 0, destination);
+    vstore4(vload4(0, source + 8), 0, destination + 8);
+    vstore2(vload2(0, source + 12), 0, destination + 12);
+#else
+    for (unsigned int char_index = 0; char_index < EAN13_MAX_CHARS; ++char_index) {
+          destination[char_index] = source[char_index];
+    }
+#endif
+}
+
+/*
+ * Joins row "result_table_row" of the purchases table with its customer, storing the joined
+ * record (or NULL values) at the same row of the results table exactly like the
+ * "naive_hash_equijoin_probe" kernel, but copying string fields with vector loads and stores.
+ */
+void vector_join_purchases_row(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                 __global struct Purchases_Table_Row* purchases_table,
+                                 __global struct Joined_Results_Table_Row* results_table,
+                                 const char is_customer_active, const unsigned long result_table_row)
+{
+   // Retrieve row index of matching record from hashed customer table using hash function macro.
+   const unsigned long hashed_customer_table_row =
+                    customer_id_to_row_index(purchases_table[result_table_row].customer_id);
+
+   // Filtered out records never touch the customer table, as in "naive_hash_equijoin_probe"
+   if (PURCHASE_PREDICATE(purchases_table[result_table_row]) &&
+         hashed_customer_table[hashed_customer_table_row].active_customer == is_customer_active) {
+
+         results_table[result_table_row].time_of_purchase =
+                       purchases_table[result_table_row].time_of_purchase;
+         results_table[result_table_row].customer_id_customer =
+                       hashed_customer_table[hashed_customer_table_row].customer_id;
+         results_table[result_table_row].quantity_purchased =
+                       purchases_table[result_table_row].quantity_purchased;
+         vector_copy_first_name(results_table[result_table_row].first_name_customer,
+                                  hashed_customer_table[hashed_customer_table_row].first_name);
+         vector_copy_ean13(results_table[result_table_row].ean13,
+                             purchases_table[result_table_row].ean13);
+
+   } else {
+
+         // Filtered out or customer status doesn't match; store NULL values as "naive_hash_equijoin_probe" does.
+         results_table[result_table_row].customer_id_customer = NULL_CUSTOMER_ID;
+         results_table[result_table_row].first_name_customer[NULL_CHARACTER_POS] =
+                                                                     NULL_CUSTOMER_NAME;
+
+   }
+}
+
+/*
+ * Thread-coarsened variant of the "naive_hash_equijoin_probe" kernel above.
+ *
+ * Each instance of the kernel joins ROWS_PER_WORK_ITEM consecutive records from the
+ * purchases table (instead of just one record), and copies the string fields of each
+ * joined record using vector loads and stores.  Fewer, fatter work-items suit CPU
+ * OpenCL runtimes, which otherwise pay scheduling overhead for every work-item, as
+ * well as wide-SIMD GPUs, which move wider chunks of memory per instruction.
+ *
+ * Results are stored at the same row index as each record had appeared in the
+ * purchases table, with NULL_CUSTOMER_ID and NULL_CUSTOMER_NAME inserted for records
+ * of customers whose status doesn't match "is_customer_active", exactly like the
+ * "naive_hash_equijoin_probe" kernel.
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table, results_table, is_customer_active: same as
+ *                            for the "naive_hash_equijoin_probe" kernel.
+ *   - num_purchases_rows: number of rows in the purchases table; as the number of work-items
+ *                         is rounded up to a whole number of work-groups, work-items past
+ *                         the last row of the purchases table do nothing.
+ */
+__kernel void coarsened_hash_equijoin_probe(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                         __global struct Purchases_Table_Row* purchases_table,
+                                                        __global struct Joined_Results_Table_Row* results_table,
+                                                                                   const char is_customer_active,
+                                                                           const unsigned long num_purchases_rows)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   // First row of the purchases table (and of the results table) joined by this work-item
+   const unsigned long first_result_table_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+
+   #pragma unroll
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+
+        const unsigned long result_table_row = first_result_table_row + row_offset;
+        if (result_table_row >= num_purchases_rows) {
+              // Past the last row of the purchases table; nothing left to join
+              break;
+        }
+
+        vector_join_purchases_row(hashed_customer_table, purchases_table, results_table, is_customer_active,
+                                    result_table_row);
+
+   }
+
+}
+
+/*
+ * Variant of the "coarsened_hash_equijoin_probe" kernel above which only joins the rows of the
+ * blocks of ZONE_MAP_BLOCK_ROWS rows the host's zone map couldn't rule out (see
+ * "purchases_zone_map.h"); work-items are handed out to those blocks only, one after the other,
+ * so the kernel costs as much as the blocks probed rather than the whole purchases table.
+ * Results of blocks not probed are left as they are (i.e. as the NULL rows the host uploaded).
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table, results_table, is_customer_active, num_purchases_rows:
+ *                            same as for the "coarsened_hash_equijoin_probe" kernel.
+ *   - probed_blocks: index of each block to probe.
+ *   - num_probed_blocks: number of blocks to probe; work-items past the last of them do nothing.
+ */
+__kernel void zone_mapped_hash_equijoin_probe(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                           __global struct Purchases_Table_Row* purchases_table,
+                                                          __global struct Joined_Results_Table_Row* results_table,
+                                                                                     const char is_customer_active,
+                                                                             const unsigned long num_purchases_rows,
+                                                                     __global const unsigned long* probed_blocks,
+                                                                              const unsigned long num_probed_blocks)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   // A work-item's rows never straddle two blocks, as blocks are a multiple of ROWS_PER_WORK_ITEM rows
+   const unsigned long first_probed_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+   const unsigned long probed_block_index = first_probed_row / ZONE_MAP_BLOCK_ROWS;
+   if (probed_block_index >= num_probed_blocks) {
+        return;
+   }
+   const unsigned long first_result_table_row = probed_blocks[probed_block_index] * ZONE_MAP_BLOCK_ROWS +
+                                                  first_probed_row % ZONE_MAP_BLOCK_ROWS;
+
+   #pragma unroll
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+
+        const unsigned long result_table_row = first_result_table_row + row_offset;
+        if (result_table_row >= num_purchases_rows) {
+              // Past the last row of the purchases table; nothing left to join
+              break;
+        }
+
+        vector_join_purchases_row(hashed_customer_table, purchases_table, results_table, is_customer_active,
+                                    result_table_row);
+
+   }
+
+}
+
+/*
+ * Returns the slot of customer "customer_id" in the hot customer table "hot_customer_table", or -1
+ * if the customer isn't hot; slots are tried from "hot_customer_id_to_slot" on until the customer
+ * or an empty slot (of NULL_CUSTOMER_ID) is found.
+ */
+int find_hot_customer_slot(__local const struct Hashed_Customer_Table_Row* hot_customer_table,
+                             const unsigned long customer_id)
+{
+   unsigned int slot = hot_customer_id_to_slot(customer_id);
+   for (unsigned int num_probes = 0; num_probes < HOT_CUSTOMER_TABLE_SLOTS; ++num_probes) {
+        const unsigned long slot_customer_id = hot_customer_table[slot].customer_id;
+        if (slot_customer_id == customer_id) {
+              return (int) slot;
+        }
+        if (slot_customer_id == NULL_CUSTOMER_ID) {
+              break;
+        }
+        slot = (slot + 1) & (HOT_CUSTOMER_TABLE_SLOTS - 1);
+   }
+   return -1;
+}
+
+/*
+ * Variant of the "coarsened_hash_equijoin_probe" kernel above for skewed purchases, where a few
+ * hot customers make most of the purchases: each work-group first copies the host's hot customer
+ * table into local memory, and each purchase looks its customer up there before falling back on
+ * the hashed customer table in global memory, so hot customer rows are fetched from global
+ * memory once per work-group instead of once per purchase.  Results are the very same as those
+ * of the "coarsened_hash_equijoin_probe" kernel.
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table, results_table, is_customer_active, num_purchases_rows:
+ *                            same as for the "coarsened_hash_equijoin_probe" kernel.
+ *   - hot_customer_table: HOT_CUSTOMER_TABLE_SLOTS slots of hot customer rows, each stored at the
+ *                         slot "find_hot_customer_slot" finds it at; empty slots are NULL rows.
+ */
+__kernel void hot_cached_hash_equijoin_probe(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                          __global struct Purchases_Table_Row* purchases_table,
+                                                         __global struct Joined_Results_Table_Row* results_table,
+                                                                                    const char is_customer_active,
+                                                                            const unsigned long num_purchases_rows,
+                                                   __global const struct Hashed_Customer_Table_Row* hot_customer_table)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   // Whole work-group copies the hot customer table before any work-item looks a customer up
+   __local struct Hashed_Customer_Table_Row local_hot_customer_table[HOT_CUSTOMER_TABLE_SLOTS];
+   for (unsigned int slot = get_local_id(first_dimension_num); slot < HOT_CUSTOMER_TABLE_SLOTS;
+        slot += get_local_size(first_dimension_num)) {
+        local_hot_customer_table[slot] = hot_customer_table[slot];
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   // First row of the purchases table (and of the results table) joined by this work-item
+   const unsigned long first_result_table_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+
+   #pragma unroll
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+
+        const unsigned long result_table_row = first_result_table_row + row_offset;
+        if (result_table_row >= num_purchases_rows) {
+              // Past the last row of the purchases table; nothing left to join
+              break;
+        }
+
+        const int hot_slot = find_hot_customer_slot(local_hot_customer_table,
+                                                      purchases_table[result_table_row].customer_id);
+        if (hot_slot < 0) {
+              // Cold customer; join from global memory exactly like "coarsened_hash_equijoin_probe"
+              vector_join_purchases_row(hashed_customer_table, purchases_table, results_table, is_customer_active,
+                                          result_table_row);
+        } else if (PURCHASE_PREDICATE(purchases_table[result_table_row]) &&
+                     local_hot_customer_table[hot_slot].active_customer == is_customer_active) {
+              results_table[result_table_row].time_of_purchase = purchases_table[result_table_row].time_of_purchase;
+              results_table[result_table_row].customer_id_customer = local_hot_customer_table[hot_slot].customer_id;
+              results_table[result_table_row].quantity_purchased =
+                            purchases_table[result_table_row].quantity_purchased;
+              #pragma unroll
+              for (unsigned int char_index = 0; char_index < FIRST_NAME_MAX_LEN; ++char_index) {
+                    results_table[result_table_row].first_name_customer[char_index] =
+                                local_hot_customer_table[hot_slot].first_name[char_index];
+              }
+              vector_copy_ean13(results_table[result_table_row].ean13, purchases_table[result_table_row].ean13);
+        } else {
+              // Filtered out or customer status doesn't match; store NULL values as "naive_hash_equijoin_probe" does.
+              results_table[result_table_row].customer_id_customer = NULL_CUSTOMER_ID;
+              results_table[result_table_row].first_name_customer[NULL_CHARACTER_POS] = NULL_CUSTOMER_NAME;
+        }
+
+   }
+
+}
+
+/*
+ * Shared-scan probing of a batch of queries, each with its own purchases predicate, customer
+ * status and projection.  The host puts the following in front of this file for each batch:
+ *   - NUM_BATCH_QUERIES: number of queries in the batch (at most MAX_BATCH_QUERIES).
+ *   - BATCH_QUERY_PURCHASE_MASK(purchase_row): bitmask of the queries whose purchases predicate
+ *                                             "purchase_row" satisfies (bit q for query q).
+ *   - BATCH_QUERY_ACTIVE_MASK: bitmask of the queries joining active customers; the other
+ *                              queries join inactive customers.
+ *   - BATCH_QUERY_PROJECTIONS: initializer of an array holding each query's PROJECT_* columns.
+ * Programs without them don't get the batch kernels at all.
+ */
+#ifdef NUM_BATCH_QUERIES
+
+__constant unsigned int batch_query_projections[NUM_BATCH_QUERIES] = BATCH_QUERY_PROJECTIONS;
+
+/*
+ * Returns the bitmask of the queries which join row "purchases_table_row" of the purchases table;
+ * the customer table is only looked up (once, for every query) if some predicate holds.
+ */
+unsigned int batch_query_match_mask(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                      __global struct Purchases_Table_Row* purchases_table,
+                                      const unsigned long purchases_table_row)
+{
+   const unsigned int purchase_mask = BATCH_QUERY_PURCHASE_MASK(purchases_table[purchases_table_row]);
+   if (purchase_mask == 0) {
+        return 0;
+   }
+   const unsigned long hashed_customer_table_row =
+                    customer_id_to_row_index(purchases_table[purchases_table_row].customer_id);
+   return purchase_mask &
+            ((hashed_customer_table[hashed_customer_table_row].active_customer == CUSTOMER_ACTIVE_FLAG) ?
+               (unsigned int) BATCH_QUERY_ACTIVE_MASK : ~((unsigned int) BATCH_QUERY_ACTIVE_MASK));
+}
+
+/*
+ * Returns the exclusive prefix sum of "value" over the work-items of the work-group (in order of
+ * their local ID), computed in "scan_scratch"; every work-item of the work-group MUST call it.
+ */
+unsigned int work_group_exclusive_scan(__local unsigned int* scan_scratch, const unsigned int value)
+{
+   const unsigned int first_dimension_num = 0;
+   const unsigned int local_id = get_local_id(first_dimension_num);
+   const unsigned int local_size = get_local_size(first_dimension_num);
+
+   scan_scratch[local_id] = value;
+   barrier(CLK_LOCAL_MEM_FENCE);
+   // Hillis-Steele scan; each step adds the partial sum "stride" work-items back
+   for (unsigned int stride = 1; stride < local_size; stride <<= 1) {
+        const unsigned int partial_sum = (local_id >= stride) ? scan_scratch[local_id - stride] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        scan_scratch[local_id] += partial_sum;
+        barrier(CLK_LOCAL_MEM_FENCE);
+   }
+   const unsigned int inclusive_sum = scan_scratch[local_id];
+   // Scratch is reused by the next scan; nobody may overwrite it before everyone has read it
+   barrier(CLK_LOCAL_MEM_FENCE);
+   return inclusive_sum - value;
+}
+
+/*
+ * First pass of probing a batch of queries: each instance of the kernel works out which queries
+ * join each of its ROWS_PER_WORK_ITEM consecutive purchases table rows, and each work-group counts
+ * how many rows it contributes to each query's results.
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table: same as for the "naive_hash_equijoin_probe" kernel.
+ *   - match_masks: where to store the bitmask of the queries joining each purchases table row.
+ *   - group_match_counts: where to store, for work-group g and query q, the number of rows of
+ *                         the work-group query q joins at index g * NUM_BATCH_QUERIES + q.
+ *   - num_purchases_rows: number of rows in the purchases table.
+ */
+__kernel void count_batch_query_matches(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                     __global struct Purchases_Table_Row* purchases_table,
+                                                                   __global unsigned int* match_masks,
+                                                                   __global unsigned int* group_match_counts,
+                                                                   const unsigned long num_purchases_rows)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   __local unsigned int local_match_counts[NUM_BATCH_QUERIES];
+   for (unsigned int query = get_local_id(first_dimension_num); query < NUM_BATCH_QUERIES;
+                                                               query += get_local_size(first_dimension_num)) {
+        local_match_counts[query] = 0;
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   const unsigned long first_purchases_table_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+
+        const unsigned long purchases_table_row = first_purchases_table_row + row_offset;
+        if (purchases_table_row >= num_purchases_rows) {
+              // Past the last row of the purchases table; nothing left to join
+              break;
+        }
+
+        const unsigned int match_mask = batch_query_match_mask(hashed_customer_table, purchases_table,
+                                                                 purchases_table_row);
+        match_masks[purchases_table_row] = match_mask;
+        for (unsigned int query = 0; query < NUM_BATCH_QUERIES; ++query) {
+              if ((match_mask >> query) & 1u) {
+                    atomic_inc(&(local_match_counts[query]));
+              }
+        }
+
+   }
+
+   barrier(CLK_LOCAL_MEM_FENCE);
+   for (unsigned int query = get_local_id(first_dimension_num); query < NUM_BATCH_QUERIES;
+                                                               query += get_local_size(first_dimension_num)) {
+        group_match_counts[get_group_id(first_dimension_num) * NUM_BATCH_QUERIES + query] =
+                                                                               local_match_counts[query];
+   }
+}
+
+/*
+ * Stores row "purchases_table_row" of the purchases table joined with its customer in
+ * "result_row", keeping only the columns in "projection" and zeroing out the others.
+ */
+void store_projected_joined_row(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                  __global struct Purchases_Table_Row* purchases_table,
+                                  __global struct Joined_Results_Table_Row* result_row,
+                                  const unsigned long purchases_table_row, const unsigned int projection)
+{
+   const unsigned long hashed_customer_table_row =
+                    customer_id_to_row_index(purchases_table[purchases_table_row].customer_id);
+
+   result_row->time_of_purchase = (projection & PROJECT_TIME_OF_PURCHASE) ?
+                                    purchases_table[purchases_table_row].time_of_purchase : 0;
+   result_row->customer_id_customer = (projection & PROJECT_CUSTOMER_ID) ?
+                                        hashed_customer_table[hashed_customer_table_row].customer_id : 0;
+   result_row->quantity_purchased = (projection & PROJECT_QUANTITY_PURCHASED) ?
+                                      purchases_table[purchases_table_row].quantity_purchased : 0;
+   if (projection & PROJECT_FIRST_NAME) {
+        vector_copy_first_name(result_row->first_name_customer,
+                                 hashed_customer_table[hashed_customer_table_row].first_name);
+   } else {
+        result_row->first_name_customer[NULL_CHARACTER_POS] = NULL_CUSTOMER_NAME;
+   }
+   if (projection & PROJECT_EAN13) {
+        vector_copy_ean13(result_row->ean13, purchases_table[purchases_table_row].ean13);
+   } else {
+        result_row->ean13[0] = '\0';
+   }
+}
+
+/*
+ * Second pass of probing a batch of queries: routes every joined record to the compacted results
+ * of each query joining it, in the same order as the rows appear in the purchases table.  Each
+ * work-group writes its rows of query q starting at the offset the host worked out from the
+ * "count_batch_query_matches" kernel's counts, and each work-item finds its own place within
+ * them with a prefix sum over the work-group.
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table, match_masks, num_purchases_rows: same as for the
+ *                            "count_batch_query_matches" kernel, which MUST have filled
+ *                            "match_masks" in with the same number of work-items per work-group.
+ *   - group_result_offsets: row of "batch_results" at which work-group g stores its first row of
+ *                           query q, at index g * NUM_BATCH_QUERIES + q.
+ *   - batch_results: compacted results of every query, one query after the other.
+ */
+__kernel void write_batch_query_results(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                     __global struct Purchases_Table_Row* purchases_table,
+                                                             __global const unsigned int* match_masks,
+                                                             __global const unsigned long* group_result_offsets,
+                                                    __global struct Joined_Results_Table_Row* batch_results,
+                                                                   const unsigned long num_purchases_rows)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   __local unsigned int scan_scratch[MAX_BATCH_WORK_GROUP_SIZE];
+
+   const unsigned long first_purchases_table_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+   unsigned int row_match_masks[ROWS_PER_WORK_ITEM];
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+        const unsigned long purchases_table_row = first_purchases_table_row + row_offset;
+        row_match_masks[row_offset] = (purchases_table_row < num_purchases_rows) ?
+                                        match_masks[purchases_table_row] : 0;
+   }
+
+   // Every work-item takes part in every query's prefix sum, rows past the table's end or not
+   for (unsigned int query = 0; query < NUM_BATCH_QUERIES; ++query) {
+
+        unsigned int num_matches = 0;
+        for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+              num_matches += (row_match_masks[row_offset] >> query) & 1u;
+        }
+
+        unsigned long result_row = group_result_offsets[get_group_id(first_dimension_num) * NUM_BATCH_QUERIES + query]
+                                     + work_group_exclusive_scan(scan_scratch, num_matches);
+        for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+              if ((row_match_masks[row_offset] >> query) & 1u) {
+                    store_projected_joined_row(hashed_customer_table, purchases_table, &(batch_results[result_row]),
+                                                 first_purchases_table_row + row_offset,
+                                                 batch_query_projections[query]);
+                    ++result_row;
+              }
+        }
+
+   }
+}
+
+#endif // NUM_BATCH_QUERIES
+
+/*
+ * Aggregating joined records needs 64-bit atomics; devices without them don't get the
+ * "aggregate_hash_equijoin_probe" kernel at all, and the host aggregates on the CPU instead.
+ */
+#ifdef cl_khr_int64_base_atomics
+#pragma OPENCL EXTENSION cl_khr_int64_base_atomics : enable
+
+/*
+ * Number of slots (a power of two) in the hash table of partial aggregates each
+ * work-group keeps in local memory, and how many slots are probed for a key before
+ * giving up on the local hash table and aggregating straight into global memory.
+ */
+#ifndef LOCAL_AGGREGATION_SLOTS
+    #define LOCAL_AGGREGATION_SLOTS 512
+#endif
+#define LOCAL_AGGREGATION_MAX_PROBES 8
+
+/*
+ * Adds "num_purchases" purchases of "quantity" items in total to the aggregate of "key" in the
+ * global hash table of aggregates; the table is sized so that it never fills up.
+ */
+void global_aggregate(__global unsigned long* aggregate_keys, __global unsigned long* aggregate_counts,
+                        __global unsigned long* aggregate_quantities, const unsigned long aggregate_slot_mask,
+                          const unsigned long key, const unsigned long num_purchases, const unsigned long quantity)
+{
+   unsigned long slot = aggregation_key_to_slot(key) & aggregate_slot_mask;
+   while (true) {
+        // Claim the slot if it's empty; either way, it's this key's slot if it now holds this key
+        const unsigned long slot_key = atom_cmpxchg(&(aggregate_keys[slot]), EMPTY_AGGREGATION_KEY, key);
+        if (slot_key == EMPTY_AGGREGATION_KEY || slot_key == key) {
+             atom_add(&(aggregate_counts[slot]), num_purchases);
+             atom_add(&(aggregate_quantities[slot]), quantity);
+             return;
+        }
+        slot = (slot + 1) & aggregate_slot_mask;
+   }
+}
+
+/*
+ * Adds one purchase of "quantity" items to the aggregate of "key" in the work-group's hash table
+ * of partial aggregates; returns false (without adding anything) if the key has no slot within
+ * LOCAL_AGGREGATION_MAX_PROBES slots of where it hashes to.
+ */
+bool local_aggregate(__local unsigned long* local_keys, __local unsigned long* local_counts,
+                       __local unsigned long* local_quantities, const unsigned long key, const unsigned long quantity)
+{
+   unsigned long slot = aggregation_key_to_slot(key) & (LOCAL_AGGREGATION_SLOTS - 1);
+   for (unsigned int probe = 0; probe < LOCAL_AGGREGATION_MAX_PROBES; ++probe) {
+        const unsigned long slot_key = atom_cmpxchg(&(local_keys[slot]), EMPTY_AGGREGATION_KEY, key);
+        if (slot_key == EMPTY_AGGREGATION_KEY || slot_key == key) {
+             atom_add(&(local_counts[slot]), 1ul);
+             atom_add(&(local_quantities[slot]), quantity);
+             return true;
+        }
+        slot = (slot + 1) & (LOCAL_AGGREGATION_SLOTS - 1);
+   }
+   return false;
+}
+
+/*
+ * Hash join probing kernel fused with a group-by aggregation of the joined records.
+ *
+ * Each instance of the kernel joins ROWS_PER_WORK_ITEM consecutive records from the purchases
+ * table like "coarsened_hash_equijoin_probe", but instead of storing each joined record, counts
+ * it and adds its quantity to the aggregate of its key (customer ID or EAN13 barcode).  Each
+ * work-group first aggregates into a hash table of partial aggregates in local memory; once every
+ * work-item of the work-group is done joining, the partial aggregates are merged into the global
+ * hash table of aggregates with atomics, so only keys the local hash table has no room for hit
+ * global memory once per record.
+ *
+ * Parameter details:
+ *   - hashed_customer_table, purchases_table, is_customer_active: same as for the
+ *                            "naive_hash_equijoin_probe" kernel.
+ *   - aggregate_keys, aggregate_counts, aggregate_quantities: global hash table of aggregates, of
+ *                            "aggregate_slot_mask" + 1 (a power of two) slots; each slot holds a key
+ *                            (EMPTY_AGGREGATION_KEY if none yet), the number of joined records with
+ *                            that key, and the sum of their quantities.  Keys MUST be filled with
+ *                            EMPTY_AGGREGATION_KEY and counts and quantities with 0 beforehand.
+ *   - aggregate_slot_mask: number of slots in the global hash table of aggregates minus one.
+ *   - num_purchases_rows: number of rows in the purchases table.
+ *   - is_keyed_by_ean13: whether to aggregate by EAN13 barcode (1) or by customer ID (0).
+ */
+__kernel void aggregate_hash_equijoin_probe(__global struct Hashed_Customer_Table_Row* hashed_customer_table,
+                                                         __global struct Purchases_Table_Row* purchases_table,
+                                                                  __global unsigned long* aggregate_keys,
+                                                                  __global unsigned long* aggregate_counts,
+                                                                  __global unsigned long* aggregate_quantities,
+                                                                  const unsigned long aggregate_slot_mask,
+                                                                  const char is_customer_active,
+                                                                  const unsigned long num_purchases_rows,
+                                                                  const char is_keyed_by_ean13)
+{
+   // Tables are one-dimensional arrays of structs; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+
+   __local unsigned long local_keys[LOCAL_AGGREGATION_SLOTS];
+   __local unsigned long local_counts[LOCAL_AGGREGATION_SLOTS];
+   __local unsigned long local_quantities[LOCAL_AGGREGATION_SLOTS];
+
+   // Every work-item of the work-group empties its share of the local hash table
+   for (unsigned int slot = get_local_id(first_dimension_num); slot < LOCAL_AGGREGATION_SLOTS;
+                                                               slot += get_local_size(first_dimension_num)) {
+        local_keys[slot] = EMPTY_AGGREGATION_KEY;
+        local_counts[slot] = 0;
+        local_quantities[slot] = 0;
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   // First row of the purchases table joined by this work-item
+   const unsigned long first_purchases_table_row = get_global_id(first_dimension_num) * ROWS_PER_WORK_ITEM;
+
+   for (unsigned int row_offset = 0; row_offset < ROWS_PER_WORK_ITEM; ++row_offset) {
+
+        const unsigned long purchases_table_row = first_purchases_table_row + row_offset;
+        if (purchases_table_row >= num_purchases_rows) {
+              // Past the last row of the purchases table; nothing left to join
+              break;
+        }
+
+        // Retrieve row index of matching record from hashed customer table using hash function macro.
+        const unsigned long hashed_customer_table_row =
+                         customer_id_to_row_index(purchases_table[purchases_table_row].customer_id);
+
+        // Filtered out records never touch the customer table, as in "naive_hash_equijoin_probe"
+        if (PURCHASE_PREDICATE(purchases_table[purchases_table_row]) &&
+              hashed_customer_table[hashed_customer_table_row].active_customer == is_customer_active) {
+
+              unsigned long key;
+              if (is_keyed_by_ean13) {
+                    char ean13[EAN13_MAX_CHARS];
+                    for (unsigned int char_index = 0; char_index < EAN13_MAX_CHARS; ++char_index) {
+                          ean13[char_index] = purchases_table[purchases_table_row].ean13[char_index];
+                    }
+                    key = ean13_to_aggregation_key(ean13);
+              } else {
+                    key = hashed_customer_table[hashed_customer_table_row].customer_id;
+              }
+              const unsigned long quantity = purchases_table[purchases_table_row].quantity_purchased;
+
+              if (!local_aggregate(local_keys, local_counts, local_quantities, key, quantity)) {
+                    global_aggregate(aggregate_keys, aggregate_counts, aggregate_quantities,
+                                       aggregate_slot_mask, key, 1, quantity);
+              }
+
+        }
+
+   }
+
+   // Merge the work-group's partial aggregates into the global hash table
+   barrier(CLK_LOCAL_MEM_FENCE);
+   for (unsigned int slot = get_local_id(first_dimension_num); slot < LOCAL_AGGREGATION_SLOTS;
+                                                               slot += get_local_size(first_dimension_num)) {
+        if (local_keys[slot] != EMPTY_AGGREGATION_KEY) {
+              global_aggregate(aggregate_keys, aggregate_counts, aggregate_quantities, aggregate_slot_mask,
+                                 local_keys[slot], local_counts[slot], local_quantities[slot]);
+        }
+   }
+
+}
+
+
+/*
+ * Compacts the global hash table of aggregates filled in by "aggregate_hash_equijoin_probe" into
+ * consecutive rows of three values each (key, count, quantity), in no particular order, so that
+ * only slots actually holding a key have to be read back.
+ *
+ * Parameter details:
+ *   - aggregate_keys, aggregate_counts, aggregate_quantities: global hash table of aggregates.
+ *   - num_aggregate_slots: number of slots in the global hash table of aggregates.
+ *   - aggregated_rows: where to store each slot holding a key, as three consecutive values.
+ *   - num_aggregated_rows: number of rows stored so far; MUST be 0 beforehand.
+ */
+__kernel void compact_aggregates(__global unsigned long* aggregate_keys, __global unsigned long* aggregate_counts,
+                                   __global unsigned long* aggregate_quantities, const unsigned long num_aggregate_slots,
+                                     __global unsigned long* aggregated_rows, __global unsigned int* num_aggregated_rows)
+{
+   // Hash table is a one-dimensional array; only the first work-item dimension is used.
+   const unsigned int first_dimension_num = 0;
+   const unsigned long slot = get_global_id(first_dimension_num);
+
+   if (slot < num_aggregate_slots && aggregate_keys[slot] != EMPTY_AGGREGATION_KEY) {
+        const unsigned int row = atomic_inc(num_aggregated_rows);
+        aggregated_rows[3 * row] = aggregate_keys[slot];
+        aggregated_rows[3 * row + 1] = aggregate_counts[slot];
+        aggregated_rows[3 * row + 2] = aggregate_quantities[slot];
+   }
+}
+
+#endif // cl_khr_int64_base_atomics
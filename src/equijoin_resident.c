@@ -0,0 +1,296 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for probing batches of purchases against a hashed
+// customer table kept resident in OpenCL device memory.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "equijoin_resident.h"
+
+// Index of each argument of the probe kernel
+#define KERNEL_ARG_HASHED_CUSTOMER_TABLE 0
+#define KERNEL_ARG_PURCHASES_TABLE 1
+#define KERNEL_ARG_RESULTS_TABLE 2
+#define KERNEL_ARG_IS_CUSTOMER_ACTIVE 3
+#define KERNEL_ARG_NUM_PURCHASES_ROWS 4
+
+// =================================================================================================
+
+struct Resident_Probe_Session* create_resident_probe_session(struct Hashed_Customer_Table* hashed_customer_table,
+                                                                char is_customer_active) {
+
+    // No null pointers allowed
+    assert(hashed_customer_table != NULL);
+    assert(hashed_customer_table->table != NULL);
+    // Customer table HAS to have at least 1 row
+    assert(hashed_customer_table->num_records >= 1);
+
+    cl_int func_error_code;
+    struct Resident_Probe_Session* session = calloc(1, sizeof(*session));
+    assert(session != NULL);
+
+    configure_opencl_env(&(session->context), &(session->queue), &(session->program),
+                                                       &(session->kernel_variant));
+    session->kernel = clCreateKernel(session->program, session->kernel_variant.kernel_func_name,
+                                                                             &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    session->is_customer_active = is_customer_active;
+    init_predicate_program_cache(&(session->predicate_program_cache), session->context);
+
+    // The customer status argument never changes during a session; set it only once per kernel
+    func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_IS_CUSTOMER_ACTIVE,
+                                        sizeof(session->is_customer_active),
+                                        (void*)&(session->is_customer_active));
+    assert(func_error_code == CL_SUCCESS);
+
+    update_resident_customer_table(session, hashed_customer_table);
+
+    return session;
+
+}
+
+void update_resident_customer_table(struct Resident_Probe_Session* session,
+                                      struct Hashed_Customer_Table* hashed_customer_table) {
+
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(hashed_customer_table != NULL);
+    assert(hashed_customer_table->table != NULL);
+    // Customer table HAS to have at least 1 row
+    assert(hashed_customer_table->num_records >= 1);
+
+    cl_int func_error_code;
+
+    // Only reallocate the device buffer if the new customer table doesn't fit into it
+    if (hashed_customer_table->num_records > session->customer_buffer_rows) {
+        if (session->hashed_customer_table_buffer != NULL) {
+            clReleaseMemObject(session->hashed_customer_table_buffer);
+        }
+        session->hashed_customer_table_buffer = clCreateBuffer(session->context, CL_MEM_READ_ONLY,
+                                                       hashed_customer_table->num_records *
+                                                            sizeof(*(hashed_customer_table->table)),
+                                                                             NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        session->customer_buffer_rows = hashed_customer_table->num_records;
+        func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_HASHED_CUSTOMER_TABLE,
+                                            sizeof(session->hashed_customer_table_buffer),
+                                            (void*)&(session->hashed_customer_table_buffer));
+        assert(func_error_code == CL_SUCCESS);
+    }
+
+    func_error_code = clEnqueueWriteBuffer(session->queue, session->hashed_customer_table_buffer,
+                                              CL_BLOCKING, CL_BUFFER_OFFSET,
+                                              hashed_customer_table->num_records *
+                                                   sizeof(*(hashed_customer_table->table)),
+                                              hashed_customer_table->table, 0, NULL, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    session->hashed_customer_table = hashed_customer_table;
+
+}
+
+/*
+ * Makes sure the batch buffers of "session" can hold at least "num_rows" rows;
+ * they are only ever grown, so that the buffers end up sized to the largest
+ * batch ever probed and later batches don't reallocate anything.
+ */
+static void reserve_resident_batch_buffers(struct Resident_Probe_Session* session, unsigned long num_rows) {
+
+    cl_int func_error_code;
+
+    if (num_rows <= session->batch_buffer_rows) {
+        return;
+    }
+    if (session->purchases_table_buffer != NULL) {
+        clReleaseMemObject(session->purchases_table_buffer);
+    }
+    if (session->joined_results_table_buffer != NULL) {
+        clReleaseMemObject(session->joined_results_table_buffer);
+    }
+
+    session->purchases_table_buffer = clCreateBuffer(session->context, CL_MEM_READ_ONLY,
+                                                        num_rows * sizeof(struct Purchases_Table_Row),
+                                                                               NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    session->joined_results_table_buffer = clCreateBuffer(session->context, CL_MEM_WRITE_ONLY,
+                                                        num_rows * sizeof(struct Joined_Results_Table_Row),
+                                                                               NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    session->batch_buffer_rows = num_rows;
+
+    func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_PURCHASES_TABLE,
+                                        sizeof(session->purchases_table_buffer),
+                                        (void*)&(session->purchases_table_buffer));
+    func_error_code |= clSetKernelArg(session->kernel, KERNEL_ARG_RESULTS_TABLE,
+                                        sizeof(session->joined_results_table_buffer),
+                                        (void*)&(session->joined_results_table_buffer));
+    assert(func_error_code == CL_SUCCESS);
+
+}
+
+void set_resident_purchase_predicate(struct Resident_Probe_Session* session,
+                                       const struct Purchase_Predicate* purchase_predicate) {
+
+    // No null pointers allowed
+    assert(session != NULL);
+
+    cl_int func_error_code;
+    // Without a predicate the program built when the session was created is used
+    cl_program program = (purchase_predicate == NULL) ? session->program :
+                            get_predicate_program(&(session->predicate_program_cache), purchase_predicate,
+                                                    &(session->kernel_variant));
+
+    clReleaseKernel(session->kernel);
+    session->kernel = clCreateKernel(program, session->kernel_variant.kernel_func_name, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    // A new kernel has none of its arguments set; set every argument already known
+    func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_IS_CUSTOMER_ACTIVE,
+                                        sizeof(session->is_customer_active),
+                                        (void*)&(session->is_customer_active));
+    func_error_code |= clSetKernelArg(session->kernel, KERNEL_ARG_HASHED_CUSTOMER_TABLE,
+                                        sizeof(session->hashed_customer_table_buffer),
+                                        (void*)&(session->hashed_customer_table_buffer));
+    assert(func_error_code == CL_SUCCESS);
+    if (session->batch_buffer_rows > 0) {
+        func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_PURCHASES_TABLE,
+                                            sizeof(session->purchases_table_buffer),
+                                            (void*)&(session->purchases_table_buffer));
+        func_error_code |= clSetKernelArg(session->kernel, KERNEL_ARG_RESULTS_TABLE,
+                                            sizeof(session->joined_results_table_buffer),
+                                            (void*)&(session->joined_results_table_buffer));
+        assert(func_error_code == CL_SUCCESS);
+    }
+
+}
+
+void probe_batch(struct Resident_Probe_Session* session, struct Purchases_Table* purchases_batch,
+                   struct Joined_Results_Table* results_batch, struct Opencl_Profiling_Report* profiling_report) {
+
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(purchases_batch != NULL);
+    assert(purchases_batch->table != NULL);
+    assert(results_batch != NULL);
+    assert(results_batch->table != NULL);
+    // Batch HAS to have at least 1 row, and there must be room for every joined row
+    assert(purchases_batch->num_records >= 1);
+    assert(results_batch->num_records == purchases_batch->num_records);
+
+    cl_int func_error_code;
+    cl_event write_event, kernel_event, remainder_kernel_event = NULL, read_event;
+    const unsigned long num_rows = purchases_batch->num_records;
+
+    reserve_resident_batch_buffers(session, num_rows);
+
+    /*
+     * The queue executes commands in order, so the upload, the probe and the readback
+     * can all be enqueued at once and only the readback needs to be waited on.
+     */
+    func_error_code = clEnqueueWriteBuffer(session->queue, session->purchases_table_buffer,
+                                              CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                                              num_rows * sizeof(*(purchases_batch->table)),
+                                              purchases_batch->table, 0, NULL, &write_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    const size_t work_group_size = session->kernel_variant.work_group_size;
+    const size_t local[OPERAND_DIMS] = { work_group_size };
+    size_t global[OPERAND_DIMS];
+    size_t remainder_offset[OPERAND_DIMS] = { 0 };
+    size_t remainder_global[OPERAND_DIMS] = { 0 };
+    if (strcmp(session->kernel_variant.kernel_func_name, COARSENED_KERNEL_FUNC_NAME) == 0) {
+        /*
+         * The thread-coarsened kernel skips rows past the end of the batch by itself,
+         * so one launch rounded up to whole work-groups covers every row.
+         */
+        global[0] = probe_kernel_global_size(&(session->kernel_variant), num_rows);
+        func_error_code = clSetKernelArg(session->kernel, KERNEL_ARG_NUM_PURCHASES_ROWS,
+                                            sizeof(num_rows), (void*)&num_rows);
+        assert(func_error_code == CL_SUCCESS);
+    } else {
+        /*
+         * Rows making up whole work-groups are probed with the variant's work-group size;
+         * any remaining rows are probed by a second launch starting at the first remaining
+         * row, with the work-group size left up to the OpenCL runtime.
+         */
+        global[0] = (num_rows / work_group_size) * work_group_size;
+        remainder_offset[0] = global[0];
+        remainder_global[0] = num_rows - global[0];
+    }
+    if (global[0] > 0) {
+        func_error_code = clEnqueueNDRangeKernel(session->queue, session->kernel, OPERAND_DIMS, NULL,
+                                                      global, local, 0, NULL, &kernel_event);
+        assert(func_error_code == CL_SUCCESS);
+    }
+    if (remainder_global[0] > 0) {
+        func_error_code = clEnqueueNDRangeKernel(session->queue, session->kernel, OPERAND_DIMS, remainder_offset,
+                                                      remainder_global, NULL, 0, NULL, &remainder_kernel_event);
+        assert(func_error_code == CL_SUCCESS);
+    }
+
+    func_error_code = clEnqueueReadBuffer(session->queue, session->joined_results_table_buffer, CL_BLOCKING,
+                                             CL_BUFFER_OFFSET, num_rows * sizeof(*(results_batch->table)),
+                                             results_batch->table, 0, NULL, &read_event);
+    assert(func_error_code == CL_SUCCESS);
+
+    record_opencl_command_profile(profiling_report, write_event, PROFILING_PHASE_UPLOAD, "purchases_batch",
+                                    num_rows * sizeof(*(purchases_batch->table)), num_rows);
+    clReleaseEvent(write_event);
+    if (global[0] > 0) {
+        const unsigned long num_kernel_rows = num_rows - remainder_global[0];
+        record_opencl_command_profile(profiling_report, kernel_event, PROFILING_PHASE_KERNEL,
+                                        session->kernel_variant.kernel_func_name,
+                                        num_kernel_rows * (sizeof(*(purchases_batch->table)) +
+                                                             sizeof(*(results_batch->table))), num_kernel_rows);
+        clReleaseEvent(kernel_event);
+    }
+    if (remainder_kernel_event != NULL) {
+        record_opencl_command_profile(profiling_report, remainder_kernel_event, PROFILING_PHASE_KERNEL,
+                                        KERNEL_FUNC_NAME " (remainder)",
+                                        remainder_global[0] * (sizeof(*(purchases_batch->table)) +
+                                                                 sizeof(*(results_batch->table))),
+                                        remainder_global[0]);
+        clReleaseEvent(remainder_kernel_event);
+    }
+    record_opencl_command_profile(profiling_report, read_event, PROFILING_PHASE_READBACK, "results_batch",
+                                    num_rows * sizeof(*(results_batch->table)), num_rows);
+    clReleaseEvent(read_event);
+
+    ++(session->num_batches_probed);
+
+}
+
+void destroy_resident_probe_session(struct Resident_Probe_Session* session) {
+
+    // No null pointers allowed
+    assert(session != NULL);
+
+    if (session->purchases_table_buffer != NULL) {
+        clReleaseMemObject(session->purchases_table_buffer);
+    }
+    if (session->joined_results_table_buffer != NULL) {
+        clReleaseMemObject(session->joined_results_table_buffer);
+    }
+    clReleaseMemObject(session->hashed_customer_table_buffer);
+    clReleaseKernel(session->kernel);
+    release_predicate_program_cache(&(session->predicate_program_cache));
+    clReleaseProgram(session->program);
+    clReleaseCommandQueue(session->queue);
+    clReleaseContext(session->context);
+    free(session);
+
+}
+
+// =================================================================================================
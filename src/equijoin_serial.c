@@ -6,41 +6,34 @@
 
 #include "equijoin_serial.h"
 #include "data_structures_opencl.h"
+#include "purchases_zone_map.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
 #include <bsd/string.h>
+#include <pthread.h>
 
-void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active) {
-
-    // No table included within the "List_Of_Tables" parameter shall refer to a NULL value
-    assert(tables_list.hashed_customer_table != NULL);
-    assert(tables_list.purchases_table != NULL);
-    assert(tables_list.results_table != NULL);
-    assert(tables_list.hashed_customer_table->table != NULL);
-    assert(tables_list.purchases_table->table != NULL);
-    assert(tables_list.results_table->table != NULL);
-    // Row count of each table MUST be greater than zero
-    assert(tables_list.hashed_customer_table->num_records > 0);
-    assert(tables_list.purchases_table->num_records > 0);
-    assert(tables_list.results_table->num_records > 0);
-    // Check that "is_customer_active" is of valid value
-    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG ||
-                    is_customer_active == CUSTOMER_INACTIVE_FLAG);
+/*
+ * Slice of the purchases table probed by one thread of "threaded_hash_equijoin_probe".
+ *   - thread --- thread probing the slice
+ *   - tables_list, is_customer_active, purchase_predicate --- what to join and how
+ *   - first_row, end_row --- rows of the slice, "end_row" excluded
+ */
+struct Probe_Slice {
+    pthread_t thread;
+    struct List_Of_Tables tables_list;
+    char is_customer_active;
+    const struct Purchase_Predicate* purchase_predicate;
+    unsigned long first_row;
+    unsigned long end_row;
+};
 
-    // Notify user hash join probing is about to start
-    printf(NOTIFY_USER_SERIAL_HASH_JOIN_OP);
+void serial_hash_equijoin_probe_rows(struct List_Of_Tables tables_list, const char is_customer_active,
+                                       const struct Purchase_Predicate* purchase_predicate,
+                                         unsigned long first_row, unsigned long end_row) {
 
-    /*
-     * Scan each row of the purchases table, and join with the appropriate row
-     * from the customers table by probing the hashed customers table; current
-     * row index of results table is also equal to current row index of purchases
-     * table.
-     */
-    for (unsigned long result_table_row = 0;
-         result_table_row < tables_list.purchases_table->num_records;
-                                                     ++result_table_row) {
-    
+    for (unsigned long result_table_row = first_row; result_table_row < end_row; ++result_table_row) {
+  
       /*
        * Retrieve row index of matching record from hashed customer
        * table using hash function macro.
@@ -50,11 +43,15 @@ void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is
                                           table[result_table_row].customer_id);
 
       /*
-       * If the customer table record's active_customer flag and the is_customer_active
-       * parameter both indicate the same thing on whether or not customer is active, then
-       * join the customer table record and the matching purchase table record together.
+       * If the purchases table record satisfies the purchases predicate, and the customer
+       * table record's active_customer flag and the is_customer_active parameter both indicate
+       * the same thing on whether or not customer is active, then join the customer table
+       * record and the matching purchase table record together.  The predicate is checked
+       * first so that filtered out records never touch the customer table.
        */
-      if (tables_list.hashed_customer_table->
+      if (evaluate_purchase_predicate(purchase_predicate,
+                                        &(tables_list.purchases_table->table[result_table_row])) &&
+          tables_list.hashed_customer_table->
                        table[hashed_customer_table_row].active_customer ==
                                                           is_customer_active) {
 
@@ -72,9 +69,10 @@ void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is
                                                               EAN13_MAX_CHARS);
 
       } else {
-      
+    
           /*
-           * If customer status indicated by the "active_customer" field and the
+           * If the purchases table record doesn't satisfy the purchases predicate, or
+           * customer status indicated by the "active_customer" field and the
            * "is_customer_active" parameter don't agree, then (as defined in the
            * included header file) insert NULL_CUSTOMER_ID into each customer id
            * attribute (as stored in the "customer_id_customer" field in each
@@ -92,6 +90,105 @@ void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is
 
     }
 
+}
+
+void serial_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                   const struct Purchase_Predicate* purchase_predicate,
+                                     const struct Purchases_Block_Selection* block_selection) {
 
+    // No table included within the "List_Of_Tables" parameter shall refer to a NULL value
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    // Row count of each table MUST be greater than zero
+    assert(tables_list.hashed_customer_table->num_records > 0);
+    assert(tables_list.purchases_table->num_records > 0);
+    assert(tables_list.results_table->num_records > 0);
+    // Check that "is_customer_active" is of valid value
+    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG ||
+                    is_customer_active == CUSTOMER_INACTIVE_FLAG);
+
+    // Notify user hash join probing is about to start
+    printf(NOTIFY_USER_SERIAL_HASH_JOIN_OP);
+
+    /*
+     * Scan each row of the purchases table, and join with the appropriate row
+     * from the customers table by probing the hashed customers table; current
+     * row index of results table is also equal to current row index of purchases
+     * table.
+     */
+    const unsigned long num_probed_ranges = (block_selection != NULL) ? block_selection->num_blocks : 1;
+    for (unsigned long range_index = 0; range_index < num_probed_ranges; ++range_index) {
+
+      // Every row, or only the rows of each block the zone map left to probe
+      const unsigned long first_row = (block_selection != NULL) ?
+                                        block_selection->blocks[range_index] * ZONE_MAP_BLOCK_ROWS : 0;
+      unsigned long end_row = (block_selection != NULL) ? first_row + ZONE_MAP_BLOCK_ROWS :
+                                                          tables_list.purchases_table->num_records;
+      if (end_row > tables_list.purchases_table->num_records) {
+          end_row = tables_list.purchases_table->num_records;
+      }
+
+      serial_hash_equijoin_probe_rows(tables_list, is_customer_active, purchase_predicate, first_row, end_row);
+    }
 }
 
+// Probes the slice of the purchases table handed to one thread
+static void* probe_slice(void* slice_arg) {
+
+    struct Probe_Slice* slice = (struct Probe_Slice*) slice_arg;
+    serial_hash_equijoin_probe_rows(slice->tables_list, slice->is_customer_active, slice->purchase_predicate,
+                                      slice->first_row, slice->end_row);
+    return NULL;
+
+}
+
+void threaded_hash_equijoin_probe(struct List_Of_Tables tables_list, const char is_customer_active,
+                                    const struct Purchase_Predicate* purchase_predicate, unsigned int num_threads) {
+
+    // No table included within the "List_Of_Tables" parameter shall refer to a NULL value
+    assert(tables_list.hashed_customer_table != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.hashed_customer_table->table != NULL);
+    assert(tables_list.purchases_table->table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    // Row count of each table MUST be greater than zero
+    assert(tables_list.purchases_table->num_records > 0);
+    assert(tables_list.results_table->num_records >= tables_list.purchases_table->num_records);
+    // Check that "is_customer_active" is of valid value
+    assert(is_customer_active == CUSTOMER_ACTIVE_FLAG ||
+                    is_customer_active == CUSTOMER_INACTIVE_FLAG);
+
+    num_threads = resolve_num_threads(num_threads);
+    const unsigned long num_purchases_rows = tables_list.purchases_table->num_records;
+    if (num_threads > num_purchases_rows) {
+        num_threads = (unsigned int) num_purchases_rows;
+    }
+    printf(NOTIFY_USER_THREADED_HASH_JOIN_OP, num_threads);
+
+    struct Probe_Slice* slices = malloc(num_threads * sizeof(*slices));
+    assert(slices != NULL);
+    int thread_status;
+
+    unsigned long first_row = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].tables_list = tables_list;
+        slices[slice_index].is_customer_active = is_customer_active;
+        slices[slice_index].purchase_predicate = purchase_predicate;
+        slices[slice_index].first_row = first_row;
+        first_row += slice_num_rows(num_purchases_rows, num_threads, slice_index);
+        slices[slice_index].end_row = first_row;
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, probe_slice, &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+    }
+    free(slices);
+
+}
@@ -0,0 +1,177 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for hash equijoin probing whose joined results are
+// read back in chunks and written out to disk by a writer thread as each chunk arrives.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include "table_utilities.h"
+#include "equijoin_streamed_readback.h"
+#include "trace_events.h"
+
+/*
+ * What the OpenCL runtime hands to the callback of each chunk's read command.
+ *   - writer --- state shared with the writer thread
+ *   - chunk_index --- which chunk the read command reads back
+ */
+struct Readback_Chunk_Callback_Data {
+    struct Streamed_Results_Writer* writer;
+    unsigned int chunk_index;
+};
+
+// =================================================================================================
+
+/*
+ * Called by the OpenCL runtime (on a thread of its own) once the read command of a chunk
+ * completes or fails; marks the chunk as read and wakes up the writer thread.
+ */
+static void CL_CALLBACK readback_chunk_complete(cl_event read_event, cl_int execution_status, void* callback_data) {
+
+    (void)read_event;
+    struct Readback_Chunk_Callback_Data* chunk = (struct Readback_Chunk_Callback_Data*) callback_data;
+    struct Streamed_Results_Writer* writer = chunk->writer;
+
+    pthread_mutex_lock(&(writer->lock));
+    writer->chunk_status[chunk->chunk_index] = execution_status;
+    writer->is_chunk_read[chunk->chunk_index] = true;
+    pthread_cond_broadcast(&(writer->chunk_read_cond));
+    pthread_mutex_unlock(&(writer->lock));
+
+}
+
+/*
+ * Body of the writer thread; writes each chunk to disk as soon as it (and every chunk
+ * before it) has been read back, so that rows end up in the file in their original order.
+ */
+static void* streamed_results_writer_thread(void* writer_arg) {
+
+    struct Streamed_Results_Writer* writer = (struct Streamed_Results_Writer*) writer_arg;
+
+    for (unsigned int chunk_index = 0; chunk_index < writer->num_chunks; ++chunk_index) {
+
+        pthread_mutex_lock(&(writer->lock));
+        while (!(writer->is_chunk_read[chunk_index])) {
+            pthread_cond_wait(&(writer->chunk_read_cond), &(writer->lock));
+        }
+        const cl_int chunk_status = writer->chunk_status[chunk_index];
+        pthread_mutex_unlock(&(writer->lock));
+        // Chunk MUST have been read back successfully
+        assert(chunk_status == CL_COMPLETE);
+
+        const unsigned long first_row = chunk_index * writer->chunk_rows;
+        const unsigned long num_rows = (first_row + writer->chunk_rows <= writer->results_table->num_records) ?
+                                          writer->chunk_rows : writer->results_table->num_records - first_row;
+        const unsigned long trace_start = trace_clock_nanosecs();
+        write_results_table_rows_to_csv_file(writer->results_table_file, writer->results_table,
+                                               first_row, num_rows);
+        record_trace_span(TRACE_CATEGORY_WRITE, "write chunk", trace_start);
+
+    }
+
+    return NULL;
+
+}
+
+void opencl_hash_equijoin_probe_streamed_to_csv(cl_command_queue *queue, cl_program *program,
+                                                  cl_kernel* kernel, struct List_Of_Tables tables_list,
+                                                    struct Cl_Mem_Operands_List cl_operands, char is_customer_active,
+                                                      const struct Probe_Kernel_Variant* kernel_variant,
+                                                        const struct Purchases_Block_Selection* block_selection,
+                                                          struct Opencl_Profiling_Report* profiling_report,
+                                                                            const char* results_file_location) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(results_file_location != NULL);
+    assert(tables_list.purchases_table != NULL);
+    assert(tables_list.results_table != NULL);
+    assert(tables_list.results_table->table != NULL);
+    assert(cl_operands.joined_results_table_buffer != NULL);
+    // Each table HAS to have at least 1 row
+    assert(tables_list.purchases_table->num_records >= 1);
+    assert(tables_list.results_table->num_records >= 1);
+
+    cl_int func_error_code;
+    cl_event kernel_event, remainder_kernel_event;
+    cl_event read_events[NUM_READBACK_CHUNKS];
+    struct Readback_Chunk_Callback_Data callback_data[NUM_READBACK_CHUNKS];
+    struct Streamed_Results_Writer writer = { 0 };
+    pthread_t writer_thread;
+    const unsigned long num_rows = tables_list.results_table->num_records;
+
+    const char* kernel_func_name = enqueue_hash_equijoin_probe_kernel(queue, program, kernel, tables_list,
+                                                                        cl_operands, is_customer_active,
+                                                                        kernel_variant, block_selection,
+                                                                        &kernel_event, &remainder_kernel_event);
+
+    // Split results into at most NUM_READBACK_CHUNKS chunks, of which only the last may be shorter
+    writer.results_table = tables_list.results_table;
+    writer.chunk_rows = (num_rows + NUM_READBACK_CHUNKS - 1) / NUM_READBACK_CHUNKS;
+    writer.num_chunks = (unsigned int)((num_rows + writer.chunk_rows - 1) / writer.chunk_rows);
+    printf(NOTIFY_USER_STREAMED_READBACK, writer.num_chunks, writer.chunk_rows);
+
+    // Writer thread has to be waiting for chunks before the first callback can fire
+    writer.results_table_file = open_results_table_csv_file(results_file_location);
+    pthread_mutex_init(&(writer.lock), NULL);
+    pthread_cond_init(&(writer.chunk_read_cond), NULL);
+    int thread_status = pthread_create(&writer_thread, NULL, streamed_results_writer_thread, &writer);
+    assert(thread_status == 0);
+
+    // Enqueue every chunk's read right behind the kernel, without waiting for anything
+    for (unsigned int chunk_index = 0; chunk_index < writer.num_chunks; ++chunk_index) {
+
+        const unsigned long first_row = chunk_index * writer.chunk_rows;
+        const unsigned long chunk_num_rows = (first_row + writer.chunk_rows <= num_rows) ?
+                                                writer.chunk_rows : num_rows - first_row;
+
+        func_error_code = clEnqueueReadBuffer(*queue, *(cl_operands.joined_results_table_buffer), CL_NON_BLOCKING,
+                                                 first_row * sizeof(*(tables_list.results_table->table)),
+                                                 chunk_num_rows * sizeof(*(tables_list.results_table->table)),
+                                                 &(tables_list.results_table->table[first_row]), 1, &kernel_event,
+                                                 &(read_events[chunk_index]));
+        assert(func_error_code == CL_SUCCESS);
+
+        callback_data[chunk_index].writer = &writer;
+        callback_data[chunk_index].chunk_index = chunk_index;
+        func_error_code = clSetEventCallback(read_events[chunk_index], CL_COMPLETE, readback_chunk_complete,
+                                                &(callback_data[chunk_index]));
+        assert(func_error_code == CL_SUCCESS);
+
+    }
+    // Make sure the device starts on everything enqueued, as nothing here blocks on the queue
+    func_error_code = clFlush(*queue);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Every chunk has been read back and written once the writer thread is done
+    thread_status = pthread_join(writer_thread, NULL);
+    assert(thread_status == 0);
+    close_results_table_csv_file(writer.results_table_file);
+    pthread_cond_destroy(&(writer.chunk_read_cond));
+    pthread_mutex_destroy(&(writer.lock));
+
+    record_hash_equijoin_probe_kernel_profiles(profiling_report, kernel_func_name, tables_list, kernel_variant,
+                                                 kernel_event, remainder_kernel_event);
+    for (unsigned int chunk_index = 0; chunk_index < writer.num_chunks; ++chunk_index) {
+        const unsigned long first_row = chunk_index * writer.chunk_rows;
+        const unsigned long chunk_num_rows = (first_row + writer.chunk_rows <= num_rows) ?
+                                                writer.chunk_rows : num_rows - first_row;
+        record_opencl_command_profile(profiling_report, read_events[chunk_index], PROFILING_PHASE_READBACK,
+                                        "results_chunk", chunk_num_rows * sizeof(*(tables_list.results_table->table)),
+                                        chunk_num_rows);
+        clReleaseEvent(read_events[chunk_index]);
+    }
+
+}
+
+// =================================================================================================
@@ -0,0 +1,263 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for counting hardware events of each phase of the
+// host program and for reporting them per phase and per table row.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <bsd/string.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "hardware_counters.h"
+
+// Name of each counter, indexed by "enum Hardware_Counter"
+static const char* const hardware_counter_names[NUM_HARDWARE_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses"
+};
+
+// "perf_event_open" type and config of each counter, indexed by "enum Hardware_Counter"
+#define CACHE_READ_MISS_CONFIG(cache) \
+            ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+static const unsigned int hardware_counter_types[NUM_HARDWARE_COUNTERS] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HARDWARE
+};
+static const unsigned long hardware_counter_configs[NUM_HARDWARE_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, CACHE_READ_MISS_CONFIG(PERF_COUNT_HW_CACHE_L1D),
+    CACHE_READ_MISS_CONFIG(PERF_COUNT_HW_CACHE_LL), CACHE_READ_MISS_CONFIG(PERF_COUNT_HW_CACHE_DTLB),
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// =================================================================================================
+
+/*
+ * Returns the number of events counted so far by the counter of file descriptor "descriptor",
+ * scaled up by how much of the time it was enabled the kernel actually had it counting; the kernel
+ * takes turns counting when more counters are open than the CPU has.
+ */
+static double read_hardware_counter(int descriptor) {
+
+    // Value, time enabled and time running, as asked for by the counter's "read_format"
+    unsigned long read_values[3];
+    if (read(descriptor, read_values, sizeof(read_values)) != (ssize_t) sizeof(read_values) ||
+        read_values[2] == 0) {
+        return 0.0;
+    }
+    return (double) read_values[0] * ((double) read_values[1] / (double) read_values[2]);
+
+}
+
+void init_hardware_counters(struct Hardware_Counters* counters) {
+
+    // No null pointers allowed
+    assert(counters != NULL);
+
+    for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+        counters->descriptors[counter] = -1;
+        counters->phase_start_values[counter] = 0.0;
+    }
+
+}
+
+bool open_hardware_counters(struct Hardware_Counters* counters) {
+
+    init_hardware_counters(counters);
+
+    bool is_any_counter_open = false;
+    for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+
+        struct perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = hardware_counter_types[counter];
+        attributes.config = hardware_counter_configs[counter];
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Threads started from now on (probing and writing threads) are counted along with this one
+        attributes.inherit = 1;
+        // Only user space is counted, which unprivileged processes are allowed to by default
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        // Count this process on whichever CPU it runs
+        const long descriptor = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        if (descriptor < 0) {
+            // Containers and virtual machines often don't allow (or don't have) some or all counters
+            printf(HARDWARE_COUNTER_UNAVAILABLE_MSG, hardware_counter_names[counter], strerror(errno));
+            continue;
+        }
+        counters->descriptors[counter] = (int) descriptor;
+        is_any_counter_open = true;
+
+    }
+
+    if (!is_any_counter_open) {
+        printf(NO_HARDWARE_COUNTERS_MSG);
+    }
+    return is_any_counter_open;
+
+}
+
+void close_hardware_counters(struct Hardware_Counters* counters) {
+
+    // No null pointers allowed
+    assert(counters != NULL);
+
+    for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+        if (counters->descriptors[counter] >= 0) {
+            close(counters->descriptors[counter]);
+            counters->descriptors[counter] = -1;
+        }
+    }
+
+}
+
+void reset_hardware_counters_report(struct Hardware_Counters_Report* report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+
+    report->num_phases = 0;
+
+}
+
+void begin_counted_phase(struct Hardware_Counters* counters) {
+
+    // No null pointers allowed
+    assert(counters != NULL);
+
+    for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+        if (counters->descriptors[counter] >= 0) {
+            counters->phase_start_values[counter] = read_hardware_counter(counters->descriptors[counter]);
+        }
+    }
+
+}
+
+void end_counted_phase(struct Hardware_Counters* counters, struct Hardware_Counters_Report* report,
+                         const char* label, unsigned long num_rows) {
+
+    // No null pointers allowed
+    assert(counters != NULL);
+    assert(label != NULL);
+
+    if (report == NULL) {
+        return;
+    }
+    // Report HAS to have room left for another phase
+    assert(report->num_phases < MAX_COUNTED_PHASES);
+
+    struct Counted_Phase* phase = &(report->phases[report->num_phases]);
+    strlcpy(phase->label, label, COUNTED_PHASE_LABEL_MAX_LEN);
+    phase->num_rows = num_rows;
+    for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+        phase->is_counted[counter] = counters->descriptors[counter] >= 0;
+        phase->values[counter] = phase->is_counted[counter] ?
+                    read_hardware_counter(counters->descriptors[counter]) - counters->phase_start_values[counter] :
+                    -1.0;
+    }
+    ++(report->num_phases);
+
+}
+
+/*
+ * Returns "value" of "phase" per table row, or -1 if its counter was unavailable (or the phase
+ * worked on no rows).
+ */
+static inline double per_row(const struct Counted_Phase* phase, enum Hardware_Counter counter) {
+    return (phase->is_counted[counter] && phase->num_rows > 0) ?
+                phase->values[counter] / (double) phase->num_rows : -1.0;
+}
+
+/*
+ * Returns instructions per cycle of "phase", or -1 if either counter was unavailable.
+ */
+static inline double instructions_per_cycle(const struct Counted_Phase* phase) {
+    return (phase->is_counted[HARDWARE_COUNTER_CYCLES] && phase->is_counted[HARDWARE_COUNTER_INSTRUCTIONS] &&
+            phase->values[HARDWARE_COUNTER_CYCLES] > 0.0) ?
+                phase->values[HARDWARE_COUNTER_INSTRUCTIONS] / phase->values[HARDWARE_COUNTER_CYCLES] : -1.0;
+}
+
+void print_hardware_counters_report(const struct Hardware_Counters_Report* report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+
+    printf(HARDWARE_COUNTERS_REPORT_HEADER, "phase", "rows", "cycles", "instructions", "IPC", "L1D misses",
+             "LLC misses", "dTLB misses", "branch misses");
+    for (unsigned int phase_index = 0; phase_index < report->num_phases; ++phase_index) {
+        const struct Counted_Phase* phase = &(report->phases[phase_index]);
+        printf(HARDWARE_COUNTERS_REPORT_ROW_FORMAT, phase->label, phase->num_rows,
+                 phase->values[HARDWARE_COUNTER_CYCLES], phase->values[HARDWARE_COUNTER_INSTRUCTIONS],
+                 instructions_per_cycle(phase), phase->values[HARDWARE_COUNTER_L1D_MISSES],
+                 phase->values[HARDWARE_COUNTER_LLC_MISSES], phase->values[HARDWARE_COUNTER_DTLB_MISSES],
+                 phase->values[HARDWARE_COUNTER_BRANCH_MISSES]);
+        printf(HARDWARE_COUNTERS_REPORT_PER_ROW_FORMAT, "  per row", "",
+                 per_row(phase, HARDWARE_COUNTER_CYCLES), per_row(phase, HARDWARE_COUNTER_INSTRUCTIONS), "",
+                 per_row(phase, HARDWARE_COUNTER_L1D_MISSES), per_row(phase, HARDWARE_COUNTER_LLC_MISSES),
+                 per_row(phase, HARDWARE_COUNTER_DTLB_MISSES), per_row(phase, HARDWARE_COUNTER_BRANCH_MISSES));
+    }
+
+}
+
+void write_hardware_counters_report_to_json_file(const struct Hardware_Counters_Report* report,
+                                                   const char* file_location) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(file_location != NULL);
+
+    FILE * report_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (report_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    printf(HARDWARE_COUNTERS_REPORT_JSON_MSG, file_location);
+
+    fprintf(report_file, "{\n  \"phases\": [\n");
+    for (unsigned int phase_index = 0; phase_index < report->num_phases; ++phase_index) {
+
+        const struct Counted_Phase* phase = &(report->phases[phase_index]);
+        fprintf(report_file, "    {\"label\": \"%s\", \"rows\": %lu", phase->label, phase->num_rows);
+        for (unsigned int counter = 0; counter < NUM_HARDWARE_COUNTERS; ++counter) {
+            if (phase->is_counted[counter]) {
+                fprintf(report_file, ", \"%s\": %.0lf, \"%s_per_row\": %.6lf", hardware_counter_names[counter],
+                          phase->values[counter], hardware_counter_names[counter],
+                          per_row(phase, (enum Hardware_Counter) counter));
+            } else {
+                fprintf(report_file, ", \"%s\": null, \"%s_per_row\": null", hardware_counter_names[counter],
+                          hardware_counter_names[counter]);
+            }
+        }
+        const double ipc = instructions_per_cycle(phase);
+        if (ipc >= 0.0) {
+            fprintf(report_file, ", \"ipc\": %.4lf}%s\n", ipc, (phase_index + 1 < report->num_phases) ? "," : "");
+        } else {
+            fprintf(report_file, ", \"ipc\": null}%s\n", (phase_index + 1 < report->num_phases) ? "," : "");
+        }
+
+    }
+    fprintf(report_file, "  ]\n}\n");
+
+    // Done writing to file; close it
+    fclose(report_file);
+
+}
+
+// =================================================================================================
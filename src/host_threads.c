@@ -0,0 +1,37 @@
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for sizing and slicing the work of host threads.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <assert.h>
+#include <unistd.h>
+#include "host_threads.h"
+
+// =================================================================================================
+
+unsigned int resolve_num_threads(unsigned int num_threads) {
+
+    if (num_threads > 0) {
+        return num_threads;
+    }
+    long num_online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_online_cpus > 0) ? (unsigned int) num_online_cpus : 1;
+
+}
+
+unsigned long slice_num_rows(unsigned long num_rows, unsigned int num_slices, unsigned int slice_index) {
+
+    assert(num_slices > 0);
+    assert(slice_index < num_slices);
+    return num_rows / num_slices + ((slice_index < num_rows % num_slices) ? 1 : 0);
+
+}
@@ -0,0 +1,35 @@
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for reading the monotonic clock phases are timed with.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <time.h>
+#include "monotonic_clock.h"
+
+// =================================================================================================
+
+unsigned long monotonic_clock_nanosecs(void) {
+
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (unsigned long) current_time.tv_sec * MONOTONIC_CLOCK_NANOSECS_IN_SEC +
+           (unsigned long) current_time.tv_nsec;
+
+}
+
+double monotonic_clock_secs(void) {
+
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double) current_time.tv_sec + ((double) current_time.tv_nsec) / MONOTONIC_CLOCK_NANOSECS_IN_SEC;
+
+}
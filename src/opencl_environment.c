@@ -0,0 +1,127 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for setting up the OpenCL execution environment
+// shared by every OpenCL hash equijoin probe engine in this program.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include "opencl_environment.h"
+
+// =================================================================================================
+
+char* get_opencl_program_code(char* opencl_program_file_location) {
+
+      // No null pointers allowed
+      assert(opencl_program_file_location != NULL);
+
+      char *source_code_content = NULL;
+      const char *file_read_mode = "r";
+      const char *file_open_error_msg = "Error opening %s: %s.\n";
+      const char *file_io_error_msg = "Error reading %s: %s\n";
+      FILE *opencl_prog_file = fopen(opencl_program_file_location, file_read_mode);
+
+      if (opencl_prog_file == NULL) {
+         int global_err_num = errno;
+         fprintf(stderr, file_open_error_msg, opencl_program_file_location,
+                                                       strerror(global_err_num));
+         exit(global_err_num);
+      } else {
+            size_t init_buffer_size = 0;
+            ssize_t num_bytes_read = getdelim(&source_code_content, &init_buffer_size,
+                                                      TEXT_FILE_DELIM, opencl_prog_file);
+            if (num_bytes_read < 0) {
+                   int global_err_num = errno;
+                   fprintf(stderr, file_io_error_msg, opencl_program_file_location,
+                                                                strerror(global_err_num));
+                   exit(global_err_num);
+            }
+            fclose(opencl_prog_file);
+      }
+
+      return source_code_content;
+
+}
+
+cl_program build_opencl_program(cl_context context, cl_device_id device,
+                                  const char* opencl_program_string, const char* compiler_options) {
+
+    // No null pointers allowed
+    assert(opencl_program_string != NULL);
+    assert(compiler_options != NULL);
+
+    // Compile the opencl_program
+    cl_program program = clCreateProgramWithSource(context, OPENCL_PROGS, &opencl_program_string, NULL, NULL);
+    clBuildProgram(program, NUM_CL_DEVICES, &device, compiler_options, NULL, NULL);
+
+    // Get info generated by compiler and output any compiler-generated messages to user
+    size_t logSize;
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+    char* messages = (char*)malloc((1+logSize)*sizeof(char));
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, logSize, messages, NULL);
+    messages[logSize] = TEXT_FILE_DELIM;
+    printf(">>> OpenCL program compiler result message: - %s\n\n", messages);
+    free(messages);
+
+    return program;
+
+}
+
+void configure_opencl_env(cl_context *context, cl_command_queue* queue,
+                            cl_program *program, struct Probe_Kernel_Variant* kernel_variant) {
+
+    // No null pointers allowed
+    assert(context != NULL);
+    assert(queue != NULL);
+    assert(program != NULL);
+
+    cl_device_id device;
+    char deviceName[MAX_LEN];
+    struct Probe_Kernel_Variant selected_variant;
+    cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+    cl_platform_id *platforms = malloc(sizeof(*platforms) * NUM_CL_PLATFORMS);
+
+    clGetPlatformIDs(NUM_CL_PLATFORMS, platforms, NULL);
+    clGetDeviceIDs(platforms[DESIRED_PLATFORM_INDEX], CL_DEVICE_TYPE_DEFAULT, NUM_CL_DEVICES, &device, NULL);
+    *context = clCreateContext(NULL, NUM_CL_DEVICES, &device, NULL, NULL, NULL);
+    *queue = clCreateCommandQueueWithProperties(*context, device, queue_properties, NULL);
+
+    // read OpenCL program file into string
+    char* opencl_program_string = get_opencl_program_code(PROGRAM_FILE);
+
+    clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_LEN, deviceName, NULL);
+
+
+    if (opencl_program_string != NULL) {
+
+        // Compile the opencl_program
+        select_probe_kernel_variant(device, &selected_variant);
+        *program = build_opencl_program(*context, device, opencl_program_string,
+                                                       selected_variant.compiler_options);
+        free(opencl_program_string);
+
+    }
+
+    if (kernel_variant != NULL) {
+        *kernel_variant = selected_variant;
+    }
+
+    // Platforms already acquired; free malloc'ed memory
+    free(platforms);
+
+}
+
+// =================================================================================================
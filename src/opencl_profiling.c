@@ -0,0 +1,199 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for recording the profiling information of OpenCL
+// commands and for reporting that information per phase of hash equijoin probing.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <bsd/string.h>
+#include "opencl_profiling.h"
+
+// Human-readable name of each phase of probing, indexed by "enum Opencl_Profiling_Phase"
+static const char* const profiling_phase_names[NUM_PROFILING_PHASES] = { "upload", "kernel", "readback" };
+
+// =================================================================================================
+
+/*
+ * Returns the number of milliseconds between two device timestamps in nanoseconds.
+ */
+static inline double nanosecs_to_millisecs(cl_ulong from, cl_ulong to) {
+    return (to >= from) ? (double) (to - from) / (PROFILING_NANOSECS_IN_SEC / 1000.0) : 0.0;
+}
+
+/*
+ * Returns "amount" per second given that it took "nanosecs" nanoseconds; zero-length
+ * commands are reported as moving nothing rather than dividing by zero.
+ */
+static inline double per_second(double amount, cl_ulong nanosecs) {
+    return (nanosecs > 0) ? amount / ((double) nanosecs / PROFILING_NANOSECS_IN_SEC) : 0.0;
+}
+
+/*
+ * Aggregate numbers over every command of a report; "phase_nanosecs" and "phase_bytes" are
+ * indexed by "enum Opencl_Profiling_Phase".
+ */
+struct Opencl_Profiling_Totals {
+    cl_ulong phase_nanosecs[NUM_PROFILING_PHASES];
+    size_t phase_bytes[NUM_PROFILING_PHASES];
+    cl_ulong queueing_nanosecs;
+    cl_ulong first_queued;
+    cl_ulong last_ended;
+};
+
+static void compute_opencl_profiling_totals(const struct Opencl_Profiling_Report* report,
+                                              struct Opencl_Profiling_Totals* totals) {
+
+    memset(totals, 0, sizeof(*totals));
+    for (unsigned int command_index = 0; command_index < report->num_commands; ++command_index) {
+
+        const struct Opencl_Command_Profile* command = &(report->commands[command_index]);
+        totals->phase_nanosecs[command->phase] += command->ended - command->started;
+        totals->phase_bytes[command->phase] += command->num_bytes;
+        // Time spent between being enqueued and actually starting to execute on the device
+        totals->queueing_nanosecs += command->started - command->queued;
+        if (command_index == 0 || command->queued < totals->first_queued) {
+            totals->first_queued = command->queued;
+        }
+        if (command->ended > totals->last_ended) {
+            totals->last_ended = command->ended;
+        }
+
+    }
+
+}
+
+void reset_opencl_profiling_report(struct Opencl_Profiling_Report* report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    report->num_commands = 0;
+
+}
+
+void record_opencl_command_profile(struct Opencl_Profiling_Report* report, cl_event event,
+                                     enum Opencl_Profiling_Phase phase, const char* label,
+                                     size_t num_bytes, unsigned long num_rows) {
+
+    // Recording is optional
+    if (report == NULL) {
+        return;
+    }
+    assert(label != NULL);
+    assert(phase < NUM_PROFILING_PHASES);
+    assert(report->num_commands < MAX_PROFILED_COMMANDS);
+
+    struct Opencl_Command_Profile* command = &(report->commands[report->num_commands]);
+    strlcpy(command->label, label, PROFILED_COMMAND_LABEL_MAX_LEN);
+    command->phase = phase;
+    command->num_bytes = num_bytes;
+    command->num_rows = num_rows;
+
+    cl_int func_error_code = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_QUEUED,
+                                                       sizeof(command->queued), &(command->queued), NULL);
+    func_error_code |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                                 sizeof(command->submitted), &(command->submitted), NULL);
+    func_error_code |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                                                 sizeof(command->started), &(command->started), NULL);
+    func_error_code |= clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                                 sizeof(command->ended), &(command->ended), NULL);
+    // Profiling info is only available for finished commands on profiling-enabled queues
+    assert(func_error_code == CL_SUCCESS);
+
+    ++(report->num_commands);
+
+}
+
+void print_opencl_profiling_report(const struct Opencl_Profiling_Report* report) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+
+    struct Opencl_Profiling_Totals totals;
+    compute_opencl_profiling_totals(report, &totals);
+
+    printf(PROFILING_REPORT_HEADER, "phase", "command", "queued", "submitted", "executing", "GB/s", "rows/s");
+    for (unsigned int command_index = 0; command_index < report->num_commands; ++command_index) {
+        const struct Opencl_Command_Profile* command = &(report->commands[command_index]);
+        printf(PROFILING_REPORT_ROW_FORMAT, profiling_phase_names[command->phase], command->label,
+                 nanosecs_to_millisecs(command->queued, command->submitted),
+                 nanosecs_to_millisecs(command->submitted, command->started),
+                 nanosecs_to_millisecs(command->started, command->ended),
+                 per_second((double) command->num_bytes, command->ended - command->started) / PROFILING_BYTES_IN_GB,
+                 per_second((double) command->num_rows, command->ended - command->started));
+    }
+    for (unsigned int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+        printf(PROFILING_REPORT_PHASE_FORMAT, profiling_phase_names[phase],
+                 nanosecs_to_millisecs(0, totals.phase_nanosecs[phase]),
+                 per_second((double) totals.phase_bytes[phase], totals.phase_nanosecs[phase]) / PROFILING_BYTES_IN_GB);
+    }
+    printf(PROFILING_REPORT_SUMMARY_FORMAT, nanosecs_to_millisecs(0, totals.queueing_nanosecs),
+                                             nanosecs_to_millisecs(totals.first_queued, totals.last_ended));
+
+}
+
+void write_opencl_profiling_report_to_json_file(const struct Opencl_Profiling_Report* report,
+                                                  const char* file_location) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(file_location != NULL);
+
+    FILE * report_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (report_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    printf(PROFILING_REPORT_JSON_MSG, file_location);
+
+    struct Opencl_Profiling_Totals totals;
+    compute_opencl_profiling_totals(report, &totals);
+
+    fprintf(report_file, "{\n  \"commands\": [\n");
+    for (unsigned int command_index = 0; command_index < report->num_commands; ++command_index) {
+        const struct Opencl_Command_Profile* command = &(report->commands[command_index]);
+        fprintf(report_file, "    {\"phase\": \"%s\", \"label\": \"%s\", \"queued_ns\": %lu, "
+                             "\"submit_ns\": %lu, \"start_ns\": %lu, \"end_ns\": %lu, \"bytes\": %zu, "
+                             "\"rows\": %lu, \"gb_per_s\": %.6lf, \"rows_per_s\": %.1lf}%s\n",
+                  profiling_phase_names[command->phase], command->label,
+                  (unsigned long) command->queued, (unsigned long) command->submitted,
+                  (unsigned long) command->started, (unsigned long) command->ended,
+                  command->num_bytes, command->num_rows,
+                  per_second((double) command->num_bytes, command->ended - command->started) / PROFILING_BYTES_IN_GB,
+                  per_second((double) command->num_rows, command->ended - command->started),
+                  (command_index + 1 < report->num_commands) ? "," : "");
+    }
+    fprintf(report_file, "  ],\n  \"phases\": {\n");
+    for (unsigned int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+        fprintf(report_file, "    \"%s\": {\"device_ns\": %lu, \"bytes\": %zu, \"gb_per_s\": %.6lf}%s\n",
+                  profiling_phase_names[phase], (unsigned long) totals.phase_nanosecs[phase],
+                  totals.phase_bytes[phase],
+                  per_second((double) totals.phase_bytes[phase], totals.phase_nanosecs[phase]) / PROFILING_BYTES_IN_GB,
+                  (phase + 1 < NUM_PROFILING_PHASES) ? "," : "");
+    }
+    fprintf(report_file, "  },\n  \"queueing_overhead_ns\": %lu,\n  \"total_span_ns\": %lu\n}\n",
+              (unsigned long) totals.queueing_nanosecs,
+              (unsigned long) ((totals.last_ended >= totals.first_queued) ?
+                                   totals.last_ended - totals.first_queued : 0));
+
+    // Done writing to file; close it
+    fclose(report_file);
+
+}
+
+// =================================================================================================
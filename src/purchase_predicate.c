@@ -0,0 +1,329 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for building purchases table predicates, evaluating
+// them on the host, generating OpenCL C for them, and caching programs compiled per predicate.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <bsd/string.h>
+#include "opencl_environment.h"
+#include "purchase_predicate.h"
+
+// Separates the generated predicate source from the compiler options in each cache key
+#define CACHE_KEY_SEPARATOR "\n"
+
+// =================================================================================================
+
+void init_purchase_predicate(struct Purchase_Predicate* predicate) {
+
+    // No null pointers allowed
+    assert(predicate != NULL);
+
+    predicate->num_terms = 0;
+
+}
+
+void add_purchase_predicate_term(struct Purchase_Predicate* predicate, enum Purchase_Predicate_Column column,
+                                   enum Purchase_Predicate_Operator op, unsigned long value) {
+
+    // No null pointers allowed
+    assert(predicate != NULL);
+    assert(predicate->num_terms < MAX_PREDICATE_TERMS);
+    // Only numeric columns can be compared to a number
+    assert(column != PREDICATE_COLUMN_EAN13);
+    assert(op != PREDICATE_OP_PREFIX);
+
+    struct Purchase_Predicate_Term* term = &(predicate->terms[predicate->num_terms++]);
+    term->column = column;
+    term->op = op;
+    term->value = value;
+    term->ean13_prefix[NULL_CHARACTER_POS] = NULL_CUSTOMER_NAME;
+
+}
+
+void add_purchase_predicate_ean13_prefix(struct Purchase_Predicate* predicate, const char* ean13_prefix) {
+
+    // No null pointers allowed
+    assert(predicate != NULL);
+    assert(ean13_prefix != NULL);
+    assert(predicate->num_terms < MAX_PREDICATE_TERMS);
+    // Prefix can be no longer than an EAN13 barcode, and can only consist of digits
+    assert(strlen(ean13_prefix) < EAN13_MAX_CHARS);
+    for (const char* prefix_char = ean13_prefix; *prefix_char != '\0'; ++prefix_char) {
+        assert(isdigit((unsigned char)*prefix_char));
+    }
+
+    struct Purchase_Predicate_Term* term = &(predicate->terms[predicate->num_terms++]);
+    term->column = PREDICATE_COLUMN_EAN13;
+    term->op = PREDICATE_OP_PREFIX;
+    term->value = 0;
+    strlcpy(term->ean13_prefix, ean13_prefix, EAN13_MAX_CHARS);
+
+}
+
+/*
+ * Returns the value of the numeric column "column" of "purchases_table_row".
+ */
+static unsigned long purchase_column_value(const struct Purchases_Table_Row* purchases_table_row,
+                                              enum Purchase_Predicate_Column column) {
+
+    switch (column) {
+        case PREDICATE_COLUMN_TIME_OF_PURCHASE:
+            return purchases_table_row->time_of_purchase;
+        case PREDICATE_COLUMN_CUSTOMER_ID:
+            return purchases_table_row->customer_id;
+        case PREDICATE_COLUMN_QUANTITY_PURCHASED:
+            return purchases_table_row->quantity_purchased;
+        default:
+            // EAN13 barcodes aren't numeric
+            assert(0);
+            return 0;
+    }
+
+}
+
+bool evaluate_purchase_predicate(const struct Purchase_Predicate* predicate,
+                                   const struct Purchases_Table_Row* purchases_table_row) {
+
+    // No null pointers allowed
+    assert(purchases_table_row != NULL);
+
+    if (predicate == NULL) {
+        return true;
+    }
+
+    for (unsigned int term_index = 0; term_index < predicate->num_terms; ++term_index) {
+
+        const struct Purchase_Predicate_Term* term = &(predicate->terms[term_index]);
+        bool is_term_satisfied;
+
+        if (term->op == PREDICATE_OP_PREFIX) {
+            is_term_satisfied = strncmp(purchases_table_row->ean13, term->ean13_prefix,
+                                          strlen(term->ean13_prefix)) == 0;
+        } else {
+            const unsigned long column_value = purchase_column_value(purchases_table_row, term->column);
+            switch (term->op) {
+                case PREDICATE_OP_EQ: is_term_satisfied = column_value == term->value; break;
+                case PREDICATE_OP_NE: is_term_satisfied = column_value != term->value; break;
+                case PREDICATE_OP_LT: is_term_satisfied = column_value < term->value; break;
+                case PREDICATE_OP_LE: is_term_satisfied = column_value <= term->value; break;
+                case PREDICATE_OP_GT: is_term_satisfied = column_value > term->value; break;
+                case PREDICATE_OP_GE: is_term_satisfied = column_value >= term->value; break;
+                default: assert(0); is_term_satisfied = false; break;
+            }
+        }
+
+        // Terms are AND'ed together; no need to look at the rest once one fails
+        if (!is_term_satisfied) {
+            return false;
+        }
+
+    }
+
+    return true;
+
+}
+
+/*
+ * Name of the "Purchases_Table_Row" field holding "column".
+ */
+static const char* purchase_column_field_name(enum Purchase_Predicate_Column column) {
+
+    switch (column) {
+        case PREDICATE_COLUMN_TIME_OF_PURCHASE: return "time_of_purchase";
+        case PREDICATE_COLUMN_CUSTOMER_ID: return "customer_id";
+        case PREDICATE_COLUMN_QUANTITY_PURCHASED: return "quantity_purchased";
+        case PREDICATE_COLUMN_EAN13: return "ean13";
+        default: assert(0); return NULL;
+    }
+
+}
+
+/*
+ * OpenCL C spelling of the numeric comparison "op".
+ */
+static const char* predicate_operator_symbol(enum Purchase_Predicate_Operator op) {
+
+    switch (op) {
+        case PREDICATE_OP_EQ: return "==";
+        case PREDICATE_OP_NE: return "!=";
+        case PREDICATE_OP_LT: return "<";
+        case PREDICATE_OP_LE: return "<=";
+        case PREDICATE_OP_GT: return ">";
+        case PREDICATE_OP_GE: return ">=";
+        default: assert(0); return NULL;
+    }
+
+}
+
+/*
+ * Appends the text formatted from "format" to the "source_len" bytes long "source",
+ * of which "*source_used" bytes are already in use; asserts the text fits.
+ */
+static void append_predicate_source(char* source, size_t source_len, size_t* source_used,
+                                      const char* format, ...) {
+
+    va_list format_args;
+    va_start(format_args, format);
+    int num_chars = vsnprintf(source + *source_used, source_len - *source_used, format, format_args);
+    va_end(format_args);
+
+    // Generated source MUST fit into "source"
+    assert(num_chars >= 0 && (size_t)num_chars < source_len - *source_used);
+    *source_used += (size_t)num_chars;
+
+}
+
+void purchase_predicate_to_opencl_c(const struct Purchase_Predicate* predicate, char* source, size_t source_len) {
+
+    purchase_predicate_to_opencl_c_macro(predicate, PURCHASE_PREDICATE_MACRO_NAME, source, source_len);
+
+}
+
+void purchase_predicate_to_opencl_c_macro(const struct Purchase_Predicate* predicate, const char* macro_name,
+                                            char* source, size_t source_len) {
+
+    // No null pointers allowed
+    assert(predicate != NULL);
+    assert(macro_name != NULL);
+    assert(source != NULL);
+    assert(source_len > 0);
+
+    size_t source_used = 0;
+    source[0] = '\0';
+
+    append_predicate_source(source, source_len, &source_used, "#define %s(purchase_row) (1", macro_name);
+
+    for (unsigned int term_index = 0; term_index < predicate->num_terms; ++term_index) {
+
+        const struct Purchase_Predicate_Term* term = &(predicate->terms[term_index]);
+
+        if (term->op == PREDICATE_OP_PREFIX) {
+            // Compare the prefix one character at a time, each character inlined as a constant
+            for (size_t char_index = 0; term->ean13_prefix[char_index] != '\0'; ++char_index) {
+                append_predicate_source(source, source_len, &source_used, " && ((purchase_row).%s[%zu] == %d)",
+                                          purchase_column_field_name(term->column), char_index,
+                                          (int)term->ean13_prefix[char_index]);
+            }
+        } else {
+            append_predicate_source(source, source_len, &source_used, " && ((purchase_row).%s %s %luUL)",
+                                      purchase_column_field_name(term->column),
+                                      predicate_operator_symbol(term->op), term->value);
+        }
+
+    }
+
+    append_predicate_source(source, source_len, &source_used, ")\n");
+
+}
+
+void init_predicate_program_cache(struct Predicate_Program_Cache* cache, cl_context context) {
+
+    // No null pointers allowed
+    assert(cache != NULL);
+
+    cl_int func_error_code;
+    cl_uint num_context_devices;
+
+    func_error_code = clGetContextInfo(context, CL_CONTEXT_NUM_DEVICES, sizeof(num_context_devices),
+                                          &num_context_devices, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    // Every program is compiled for exactly one device
+    assert(num_context_devices == NUM_CL_DEVICES);
+    func_error_code = clGetContextInfo(context, CL_CONTEXT_DEVICES, sizeof(cache->device), &(cache->device), NULL);
+    assert(func_error_code == CL_SUCCESS);
+
+    cache->context = context;
+    cache->base_program_string = get_opencl_program_code(PROGRAM_FILE);
+    assert(cache->base_program_string != NULL);
+    cache->num_programs = 0;
+
+}
+
+cl_program get_predicate_program(struct Predicate_Program_Cache* cache, const struct Purchase_Predicate* predicate,
+                                   const struct Probe_Kernel_Variant* kernel_variant) {
+
+    // No null pointers allowed
+    assert(cache != NULL);
+    assert(predicate != NULL);
+    assert(kernel_variant != NULL);
+
+    char predicate_source[MAX_PREDICATE_SOURCE_LEN];
+    purchase_predicate_to_opencl_c(predicate, predicate_source, sizeof(predicate_source));
+
+    return get_program_with_source_prefix(cache, predicate_source, kernel_variant);
+
+}
+
+cl_program get_program_with_source_prefix(struct Predicate_Program_Cache* cache, const char* source_prefix,
+                                            const struct Probe_Kernel_Variant* kernel_variant) {
+
+    // No null pointers allowed
+    assert(cache != NULL);
+    assert(source_prefix != NULL);
+    assert(kernel_variant != NULL);
+
+    // Key identifying the program is the generated source plus the compiler options
+    const size_t key_len = strlen(source_prefix) + strlen(CACHE_KEY_SEPARATOR) +
+                             strlen(kernel_variant->compiler_options) + 1;
+    char* key = malloc(key_len);
+    assert(key != NULL);
+    snprintf(key, key_len, "%s" CACHE_KEY_SEPARATOR "%s", source_prefix, kernel_variant->compiler_options);
+
+    for (unsigned int program_index = 0; program_index < cache->num_programs; ++program_index) {
+        if (strcmp(cache->keys[program_index], key) == 0) {
+            free(key);
+            return cache->programs[program_index];
+        }
+    }
+
+    // Not compiled yet; the generated "#define"s go in front of the rest of the program
+    assert(cache->num_programs < MAX_CACHED_PREDICATE_PROGRAMS);
+    const size_t program_string_len = strlen(source_prefix) + strlen(cache->base_program_string) + 1;
+    char* program_string = malloc(program_string_len);
+    assert(program_string != NULL);
+    snprintf(program_string, program_string_len, "%s%s", source_prefix, cache->base_program_string);
+
+    cl_program program = build_opencl_program(cache->context, cache->device, program_string,
+                                                kernel_variant->compiler_options);
+    free(program_string);
+
+    cache->keys[cache->num_programs] = key;
+    cache->programs[cache->num_programs] = program;
+    ++(cache->num_programs);
+
+    return program;
+
+}
+
+void release_predicate_program_cache(struct Predicate_Program_Cache* cache) {
+
+    // No null pointers allowed
+    assert(cache != NULL);
+
+    for (unsigned int program_index = 0; program_index < cache->num_programs; ++program_index) {
+        clReleaseProgram(cache->programs[program_index]);
+        free(cache->keys[program_index]);
+    }
+    cache->num_programs = 0;
+    free(cache->base_program_string);
+    cache->base_program_string = NULL;
+
+}
+
+// =================================================================================================
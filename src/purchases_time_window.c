@@ -0,0 +1,147 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for finding the rows of a purchases table sorted by
+// time of purchase which lie inside the time window of a purchases predicate.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <assert.h>
+#include <limits.h>
+#include "purchases_time_window.h"
+
+// =================================================================================================
+
+bool is_purchases_table_sorted_by_time(const struct Purchases_Table* purchases_table) {
+
+    // No null pointers allowed
+    assert(purchases_table != NULL);
+    assert(purchases_table->table != NULL);
+
+    for (unsigned long row = 1; row < purchases_table->num_records; ++row) {
+        if (purchases_table->table[row].time_of_purchase < purchases_table->table[row - 1].time_of_purchase) {
+            return false;
+        }
+    }
+    return true;
+
+}
+
+bool get_purchase_predicate_time_window(const struct Purchase_Predicate* purchase_predicate,
+                                          unsigned long* min_time, unsigned long* max_time) {
+
+    // No null pointers allowed
+    assert(min_time != NULL);
+    assert(max_time != NULL);
+
+    *min_time = 0;
+    *max_time = ULONG_MAX;
+    if (purchase_predicate == NULL) {
+        return false;
+    }
+
+    bool is_time_bounded = false;
+    for (unsigned int term_index = 0; term_index < purchase_predicate->num_terms; ++term_index) {
+        const struct Purchase_Predicate_Term* term = &(purchase_predicate->terms[term_index]);
+        if (term->column != PREDICATE_COLUMN_TIME_OF_PURCHASE) {
+            continue;
+        }
+
+        // Tighten the window by each term; terms that can't hold empty it (min_time > max_time)
+        switch (term->op) {
+            case PREDICATE_OP_EQ:
+                *min_time = (term->value > *min_time) ? term->value : *min_time;
+                *max_time = (term->value < *max_time) ? term->value : *max_time;
+                break;
+            case PREDICATE_OP_GE:
+                *min_time = (term->value > *min_time) ? term->value : *min_time;
+                break;
+            case PREDICATE_OP_GT:
+                if (term->value == ULONG_MAX) {
+                    *min_time = ULONG_MAX;
+                    *max_time = 0;
+                } else if (term->value + 1 > *min_time) {
+                    *min_time = term->value + 1;
+                }
+                break;
+            case PREDICATE_OP_LE:
+                *max_time = (term->value < *max_time) ? term->value : *max_time;
+                break;
+            case PREDICATE_OP_LT:
+                if (term->value == 0) {
+                    *min_time = ULONG_MAX;
+                    *max_time = 0;
+                } else if (term->value - 1 < *max_time) {
+                    *max_time = term->value - 1;
+                }
+                break;
+            default:
+                // "!=" only ever cuts a hole into the window, which doesn't narrow it down
+                continue;
+        }
+        is_time_bounded = true;
+    }
+
+    return is_time_bounded;
+
+}
+
+/*
+ * Returns the index of the first row of "purchases_table" (sorted by time of purchase) purchased
+ * after "time" if "is_after" is true, or at or after "time" otherwise; returns the number of rows
+ * if there is no such row.
+ */
+static unsigned long find_first_row_purchased_from(const struct Purchases_Table* purchases_table,
+                                                     unsigned long time, bool is_after) {
+
+    unsigned long low_row = 0, high_row = purchases_table->num_records;
+    while (low_row < high_row) {
+        const unsigned long middle_row = low_row + (high_row - low_row) / 2;
+        const unsigned long middle_time = purchases_table->table[middle_row].time_of_purchase;
+        if (middle_time < time || (is_after && middle_time == time)) {
+            low_row = middle_row + 1;
+        } else {
+            high_row = middle_row;
+        }
+    }
+    return low_row;
+
+}
+
+struct Purchases_Row_Range find_purchases_time_window_rows(const struct Purchases_Table* purchases_table,
+                                                             unsigned long min_time, unsigned long max_time) {
+
+    // No null pointers allowed
+    assert(purchases_table != NULL);
+    assert(purchases_table->table != NULL);
+    // Table HAS to have at least 1 row
+    assert(purchases_table->num_records >= 1);
+
+    struct Purchases_Row_Range row_range;
+    row_range.first_row = find_first_row_purchased_from(purchases_table, min_time, false);
+    const unsigned long end_row = (min_time <= max_time) ?
+                                     find_first_row_purchased_from(purchases_table, max_time, true) :
+                                     row_range.first_row;
+
+    if (end_row > row_range.first_row) {
+        row_range.num_rows = end_row - row_range.first_row;
+    } else {
+        // No row inside the window; hand over one row the predicate filters out anyway
+        if (row_range.first_row == purchases_table->num_records) {
+            --(row_range.first_row);
+        }
+        row_range.num_rows = 1;
+    }
+    return row_range;
+
+}
+
+// =================================================================================================
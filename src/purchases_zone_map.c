@@ -0,0 +1,246 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for building, persisting and consulting zone maps of
+// the purchases table.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "purchases_zone_map.h"
+#include "table_utilities.h"
+
+/*
+ * Header of files zone maps are persisted in, followed by the zones themselves.
+ *   - magic --- ZONE_MAP_FILE_MAGIC, without its terminating null character
+ *   - block_rows --- ZONE_MAP_BLOCK_ROWS the zone map was built with
+ *   - num_rows, num_zones --- same as in "Purchases_Zone_Map"
+ *   - table_file_size, table_file_mtime --- size and modification time (in nanoseconds) of the
+ *                                           purchases table file the zone map was built for
+ */
+struct Zone_Map_File_Header {
+    char magic[sizeof(ZONE_MAP_FILE_MAGIC) - 1];
+    unsigned long block_rows;
+    unsigned long num_rows;
+    unsigned long num_zones;
+    long table_file_size;
+    long table_file_mtime;
+};
+
+// =================================================================================================
+
+// Builds the zone map of "purchases_table" in a single pass over it
+static void build_purchases_zone_map(const struct Purchases_Table* purchases_table,
+                                       struct Purchases_Zone_Map* zone_map) {
+
+    for (unsigned long zone_index = 0; zone_index < zone_map->num_zones; ++zone_index) {
+        const unsigned long first_row = zone_index * ZONE_MAP_BLOCK_ROWS;
+        const unsigned long end_row = (first_row + ZONE_MAP_BLOCK_ROWS < purchases_table->num_records) ?
+                                         first_row + ZONE_MAP_BLOCK_ROWS : purchases_table->num_records;
+        const struct Purchases_Table_Row* row = &(purchases_table->table[first_row]);
+        struct Purchases_Zone zone = {
+            row->time_of_purchase, row->time_of_purchase,
+            row->customer_id, row->customer_id,
+            row->quantity_purchased, row->quantity_purchased
+        };
+        for (unsigned long row_index = first_row + 1; row_index < end_row; ++row_index) {
+            row = &(purchases_table->table[row_index]);
+            if (row->time_of_purchase < zone.min_time_of_purchase) zone.min_time_of_purchase = row->time_of_purchase;
+            if (row->time_of_purchase > zone.max_time_of_purchase) zone.max_time_of_purchase = row->time_of_purchase;
+            if (row->customer_id < zone.min_customer_id) zone.min_customer_id = row->customer_id;
+            if (row->customer_id > zone.max_customer_id) zone.max_customer_id = row->customer_id;
+            if (row->quantity_purchased < zone.min_quantity_purchased) zone.min_quantity_purchased = row->quantity_purchased;
+            if (row->quantity_purchased > zone.max_quantity_purchased) zone.max_quantity_purchased = row->quantity_purchased;
+        }
+        zone_map->zones[zone_index] = zone;
+    }
+
+}
+
+void get_purchases_zone_map(const struct Purchases_Table* purchases_table, const char* purchases_table_file_location,
+                              const char* zone_map_file_location, struct Purchases_Zone_Map* zone_map) {
+
+    // No null pointers allowed
+    assert(purchases_table != NULL);
+    assert(purchases_table->table != NULL);
+    assert(purchases_table_file_location != NULL);
+    assert(zone_map_file_location != NULL);
+    assert(zone_map != NULL);
+
+    zone_map->num_rows = purchases_table->num_records;
+    zone_map->num_zones = (purchases_table->num_records + ZONE_MAP_BLOCK_ROWS - 1) / ZONE_MAP_BLOCK_ROWS;
+    zone_map->zones = malloc((zone_map->num_zones > 0 ? zone_map->num_zones : 1) * sizeof(*(zone_map->zones)));
+    assert(zone_map->zones != NULL);
+
+    // Persisted zone map is only valid for the very purchases table file it was built for
+    struct Zone_Map_File_Header expected_header;
+    memcpy(expected_header.magic, ZONE_MAP_FILE_MAGIC, sizeof(expected_header.magic));
+    expected_header.block_rows = ZONE_MAP_BLOCK_ROWS;
+    expected_header.num_rows = zone_map->num_rows;
+    expected_header.num_zones = zone_map->num_zones;
+    get_file_signature(purchases_table_file_location, &(expected_header.table_file_size),
+                                                        &(expected_header.table_file_mtime));
+
+    FILE* zone_map_file = fopen(zone_map_file_location, "rb");
+    if (zone_map_file != NULL) {
+        struct Zone_Map_File_Header header;
+        const bool is_up_to_date = fread(&header, sizeof(header), 1, zone_map_file) == 1 &&
+                                     memcmp(header.magic, expected_header.magic, sizeof(header.magic)) == 0 &&
+                                     header.block_rows == expected_header.block_rows &&
+                                     header.num_rows == expected_header.num_rows &&
+                                     header.num_zones == expected_header.num_zones &&
+                                     header.table_file_size == expected_header.table_file_size &&
+                                     header.table_file_mtime == expected_header.table_file_mtime &&
+                                     fread(zone_map->zones, sizeof(*(zone_map->zones)), zone_map->num_zones,
+                                             zone_map_file) == zone_map->num_zones;
+        fclose(zone_map_file);
+        if (is_up_to_date) {
+            printf(ZONE_MAP_LOADED_MSG, zone_map->num_zones, zone_map_file_location);
+            return;
+        }
+    }
+
+    // Zone map is missing or stale; build it and persist it for next time
+    build_purchases_zone_map(purchases_table, zone_map);
+    zone_map_file = fopen(zone_map_file_location, "wb");
+    // Not being able to persist the zone map only costs time on the next run
+    if (zone_map_file != NULL) {
+        const bool is_written = fwrite(&expected_header, sizeof(expected_header), 1, zone_map_file) == 1 &&
+                                  fwrite(zone_map->zones, sizeof(*(zone_map->zones)), zone_map->num_zones,
+                                           zone_map_file) == zone_map->num_zones;
+        if (fclose(zone_map_file) != 0 || !is_written) {
+            remove(zone_map_file_location);
+        } else {
+            printf(ZONE_MAP_BUILT_MSG, zone_map->num_zones, zone_map_file_location);
+        }
+    }
+
+}
+
+/*
+ * Returns whether a block with the smallest value "min_value" and the largest value "max_value" in
+ * a column can hold a value "value" compares to with "op" as it should.
+ */
+static bool can_zone_satisfy(unsigned long min_value, unsigned long max_value,
+                               enum Purchase_Predicate_Operator op, unsigned long value) {
+
+    switch (op) {
+        case PREDICATE_OP_EQ: return min_value <= value && value <= max_value;
+        case PREDICATE_OP_NE: return min_value != value || max_value != value;
+        case PREDICATE_OP_LT: return min_value < value;
+        case PREDICATE_OP_LE: return min_value <= value;
+        case PREDICATE_OP_GT: return max_value > value;
+        case PREDICATE_OP_GE: return max_value >= value;
+        default: return true;
+    }
+
+}
+
+// Returns whether any row of the block of "zone" can satisfy every term of "purchase_predicate"
+static bool can_zone_satisfy_predicate(const struct Purchases_Zone* zone,
+                                         const struct Purchase_Predicate* purchase_predicate) {
+
+    for (unsigned int term_index = 0; term_index < purchase_predicate->num_terms; ++term_index) {
+        const struct Purchase_Predicate_Term* term = &(purchase_predicate->terms[term_index]);
+        bool is_satisfiable;
+        switch (term->column) {
+            case PREDICATE_COLUMN_TIME_OF_PURCHASE:
+                is_satisfiable = can_zone_satisfy(zone->min_time_of_purchase, zone->max_time_of_purchase,
+                                                    term->op, term->value);
+                break;
+            case PREDICATE_COLUMN_CUSTOMER_ID:
+                is_satisfiable = can_zone_satisfy(zone->min_customer_id, zone->max_customer_id,
+                                                    term->op, term->value);
+                break;
+            case PREDICATE_COLUMN_QUANTITY_PURCHASED:
+                is_satisfiable = can_zone_satisfy(zone->min_quantity_purchased, zone->max_quantity_purchased,
+                                                    term->op, term->value);
+                break;
+            default:
+                // EAN13 barcodes have no zones
+                is_satisfiable = true;
+        }
+        if (!is_satisfiable) {
+            return false;
+        }
+    }
+    return true;
+
+}
+
+bool select_purchases_blocks(const struct Purchases_Zone_Map* zone_map, unsigned long first_row,
+                               unsigned long num_rows, const struct Purchase_Predicate* purchase_predicate,
+                                 struct Purchases_Block_Selection* block_selection) {
+
+    // No null pointers allowed
+    assert(zone_map != NULL);
+    assert(zone_map->zones != NULL);
+    assert(block_selection != NULL);
+    // Rows probed HAVE to be rows of the table the zone map was built for
+    assert(first_row + num_rows <= zone_map->num_rows);
+
+    if (purchase_predicate == NULL || purchase_predicate->num_terms == 0 || num_rows == 0) {
+        return false;
+    }
+
+    const unsigned long num_blocks = (num_rows + ZONE_MAP_BLOCK_ROWS - 1) / ZONE_MAP_BLOCK_ROWS;
+    block_selection->blocks = malloc(num_blocks * sizeof(*(block_selection->blocks)));
+    assert(block_selection->blocks != NULL);
+    block_selection->num_blocks = 0;
+
+    for (unsigned long block = 0; block < num_blocks; ++block) {
+        // Blocks counted from "first_row" overlap up to two zones when "first_row" isn't at a zone boundary
+        const unsigned long block_first_row = first_row + block * ZONE_MAP_BLOCK_ROWS;
+        const unsigned long block_last_row = ((block + 1) * ZONE_MAP_BLOCK_ROWS < num_rows) ?
+                                                block_first_row + ZONE_MAP_BLOCK_ROWS - 1 : first_row + num_rows - 1;
+        for (unsigned long zone_index = block_first_row / ZONE_MAP_BLOCK_ROWS;
+             zone_index <= block_last_row / ZONE_MAP_BLOCK_ROWS; ++zone_index) {
+            if (can_zone_satisfy_predicate(&(zone_map->zones[zone_index]), purchase_predicate)) {
+                block_selection->blocks[(block_selection->num_blocks)++] = block;
+                break;
+            }
+        }
+    }
+
+    printf(ZONE_MAP_SELECTION_MSG, block_selection->num_blocks, num_blocks, ZONE_MAP_BLOCK_ROWS);
+    if (block_selection->num_blocks == 0) {
+        // Engines need at least one row to probe; the predicate filters out every row of it anyway
+        block_selection->blocks[(block_selection->num_blocks)++] = 0;
+    }
+    if (block_selection->num_blocks == num_blocks) {
+        // Nothing ruled out; probing every row is cheaper than looking up blocks
+        free(block_selection->blocks);
+        return false;
+    }
+    return true;
+
+}
+
+void free_purchases_zone_map(struct Purchases_Zone_Map* zone_map) {
+
+    assert(zone_map != NULL);
+    free(zone_map->zones);
+    zone_map->zones = NULL;
+
+}
+
+void free_purchases_block_selection(struct Purchases_Block_Selection* block_selection) {
+
+    assert(block_selection != NULL);
+    free(block_selection->blocks);
+    block_selection->blocks = NULL;
+
+}
+
+// =================================================================================================
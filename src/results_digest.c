@@ -0,0 +1,388 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for computing order-aware digests of equijoin
+// results tables, in memory or on disk, and for comparing them.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Necessary libraries and headers for functions
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "data_structures_opencl.h"
+#include "results_digest.h"
+#include "table_utilities.h"
+#include "trace_events.h"
+#include "host_threads.h"
+
+/*
+ * Row hashes are combined as the digits of a number in base DIGEST_POLYNOMIAL_BASE,
+ * modulo the Mersenne prime DIGEST_MODULUS; unlike a sum or an XOR of row hashes,
+ * that depends on the order of the rows, yet digests of consecutive slices of a table
+ * can still be computed in parallel and combined afterwards.
+ */
+#define DIGEST_MODULUS ((1ull << 61) - 1)
+#define DIGEST_POLYNOMIAL_BASE 0x1b873593cc9e2d51ull
+// Format of the single line of a reference digest cache file, as written and as read back
+#define DIGEST_CACHE_PRINT_FORMAT "%" PRIx64 " %lu %ld %ld %ld %ld\n"
+#define DIGEST_CACHE_SCAN_FORMAT "%" SCNx64 " %lu %ld %ld %ld %ld\n"
+// Number of values on the single line of a reference digest cache file
+#define DIGEST_CACHE_NUM_VALUES 6
+// Largest length of a field of a results CSV file (digits of a long, sign included)
+#define MAX_RESULTS_CSV_FIELD_LEN 24
+
+/*
+ * Digest of a slice of a results table, computed by one thread.
+ *   - thread --- thread computing the digest
+ *   - results_table, first_row, num_rows --- slice of the table to compute the digest of
+ *   - polynomial --- row hashes of the slice, combined in order
+ *   - base_power --- DIGEST_POLYNOMIAL_BASE to the power of "num_digested_rows"
+ *   - num_digested_rows --- number of rows of the slice not consisting of NULL values
+ */
+struct Results_Digest_Slice {
+    pthread_t thread;
+    const struct Joined_Results_Table* results_table;
+    unsigned long first_row;
+    unsigned long num_rows;
+    uint64_t polynomial;
+    uint64_t base_power;
+    unsigned long num_digested_rows;
+};
+
+// =================================================================================================
+
+// Final mixing step of MurmurHash3, spreading every input bit over every output bit
+static inline uint64_t mix_bits(uint64_t value) {
+
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+
+}
+
+// Product of two values modulo DIGEST_MODULUS
+static inline uint64_t multiply_modulo(uint64_t first, uint64_t second) {
+
+    const unsigned __int128 product = (unsigned __int128) first * second;
+    uint64_t result = (uint64_t)(product & DIGEST_MODULUS) + (uint64_t)(product >> 61);
+    return (result >= DIGEST_MODULUS) ? result - DIGEST_MODULUS : result;
+
+}
+
+// Sum of two values (each less than DIGEST_MODULUS) modulo DIGEST_MODULUS
+static inline uint64_t add_modulo(uint64_t first, uint64_t second) {
+
+    const uint64_t result = first + second;
+    return (result >= DIGEST_MODULUS) ? result - DIGEST_MODULUS : result;
+
+}
+
+// Mixes "num_bytes" bytes of "bytes" into "hash" (FNV-1a), then marks where they end
+static inline uint64_t hash_string_field(uint64_t hash, const char* bytes, size_t num_bytes) {
+
+    for (size_t byte_index = 0; byte_index < num_bytes; ++byte_index) {
+        hash = (hash ^ (unsigned char) bytes[byte_index]) * 0x100000001b3ull;
+    }
+    // So that e.g. names "ab" + barcode "c" hash differently from names "a" + barcode "bc"
+    return (hash ^ num_bytes) * 0x100000001b3ull;
+
+}
+
+/*
+ * Hash of a single results table row, given its fields; reduced modulo DIGEST_MODULUS
+ * so that it can be used as a digit of the digest.
+ */
+static uint64_t hash_results_row(unsigned long time_of_purchase, unsigned long customer_id,
+                                   const char* first_name, size_t first_name_len,
+                                     const char* ean13, size_t ean13_len, unsigned long quantity_purchased) {
+
+    uint64_t hash = mix_bits(time_of_purchase ^ 0x9e3779b97f4a7c15ull);
+    hash = mix_bits(hash ^ customer_id);
+    hash = mix_bits(hash ^ quantity_purchased);
+    hash = hash_string_field(hash, first_name, first_name_len);
+    hash = hash_string_field(hash, ean13, ean13_len);
+    return mix_bits(hash) % DIGEST_MODULUS;
+
+}
+
+// Final digest of "num_rows" rows whose row hashes combined into "polynomial"
+static inline struct Results_Table_Digest finish_digest(uint64_t polynomial, unsigned long num_rows) {
+
+    struct Results_Table_Digest digest = { mix_bits(polynomial ^ mix_bits(num_rows)), num_rows };
+    return digest;
+
+}
+
+// Computes the digest of a slice of a results table
+static void* digest_results_table_slice(void* slice_arg) {
+
+    struct Results_Digest_Slice* slice = (struct Results_Digest_Slice*) slice_arg;
+    const unsigned long trace_start = trace_clock_nanosecs();
+    uint64_t polynomial = 0, base_power = 1;
+    unsigned long num_digested_rows = 0;
+
+    for (unsigned long row_index = slice->first_row; row_index < slice->first_row + slice->num_rows; ++row_index) {
+
+        const struct Joined_Results_Table_Row* row = &(slice->results_table->table[row_index]);
+
+        // Skip over table records where customer id and customer name are null values
+        if (row->customer_id_customer == NULL_CUSTOMER_ID &&
+            row->first_name_customer[NULL_CHARACTER_POS] == NULL_CUSTOMER_NAME) {
+            continue;
+        }
+
+        const uint64_t row_hash = hash_results_row(row->time_of_purchase, row->customer_id_customer,
+                                                     row->first_name_customer,
+                                                     strnlen(row->first_name_customer, FIRST_NAME_MAX_LEN),
+                                                     row->ean13, strnlen(row->ean13, EAN13_MAX_CHARS),
+                                                     row->quantity_purchased);
+        polynomial = add_modulo(multiply_modulo(polynomial, DIGEST_POLYNOMIAL_BASE), row_hash);
+        base_power = multiply_modulo(base_power, DIGEST_POLYNOMIAL_BASE);
+        ++num_digested_rows;
+
+    }
+
+    slice->polynomial = polynomial;
+    slice->base_power = base_power;
+    slice->num_digested_rows = num_digested_rows;
+    record_trace_span(TRACE_CATEGORY_VERIFY, "digest slice", trace_start);
+    return NULL;
+
+}
+
+struct Results_Table_Digest compute_results_table_digest(const struct Joined_Results_Table* results_table,
+                                                           unsigned int num_threads) {
+
+    // No null pointers allowed
+    assert(results_table != NULL);
+    assert(results_table->table != NULL || results_table->num_records == 0);
+
+    num_threads = resolve_num_threads(num_threads);
+    // Threads digesting only a handful of rows cost more than they save
+    if (num_threads > results_table->num_records / MIN_DIGEST_ROWS_PER_THREAD) {
+        num_threads = (unsigned int)(results_table->num_records / MIN_DIGEST_ROWS_PER_THREAD);
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+
+    struct Results_Digest_Slice* slices = malloc(num_threads * sizeof(*slices));
+    assert(slices != NULL);
+    int thread_status;
+
+    unsigned long first_row = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].results_table = results_table;
+        slices[slice_index].first_row = first_row;
+        slices[slice_index].num_rows = slice_num_rows(results_table->num_records, num_threads, slice_index);
+        first_row += slices[slice_index].num_rows;
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, digest_results_table_slice,
+                                                                           &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+
+    // Shift the digest of all slices so far past the rows of the next slice, then add that slice's digest
+    uint64_t polynomial = 0;
+    unsigned long num_digested_rows = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+        polynomial = add_modulo(multiply_modulo(polynomial, slices[slice_index].base_power),
+                                  slices[slice_index].polynomial);
+        num_digested_rows += slices[slice_index].num_digested_rows;
+    }
+
+    free(slices);
+    return finish_digest(polynomial, num_digested_rows);
+
+}
+
+/*
+ * Reads the CSV field starting at "*line" (quoted or not) into "field", which can hold
+ * "field_size" characters including the null terminator, and moves "*line" past the field
+ * and the comma after it; returns the length of the field.
+ */
+static size_t read_csv_field(const char** line, char* field, size_t field_size) {
+
+    const char* position = *line;
+    size_t field_len = 0;
+
+    if (*position == '"') {
+        // Quoted field; two quotes in a row stand for one quote
+        for (++position; *position != '\0'; ++position) {
+            if (*position == '"') {
+                if (position[1] != '"') {
+                    ++position;
+                    break;
+                }
+                ++position;
+            }
+            if (field_len + 1 < field_size) {
+                field[field_len++] = *position;
+            }
+        }
+    } else {
+        for (; *position != '\0' && *position != ',' && *position != '\r' && *position != '\n'; ++position) {
+            if (field_len + 1 < field_size) {
+                field[field_len++] = *position;
+            }
+        }
+    }
+    field[field_len] = '\0';
+
+    *line = (*position == ',') ? position + 1 : position;
+    return field_len;
+
+}
+
+// Value of a numeric field of a results CSV file, which holds unsigned values printed as signed
+static inline unsigned long parse_csv_number(const char* field) {
+
+    return (field[0] == '-') ? (unsigned long) strtoll(field, NULL, 10) : strtoul(field, NULL, 10);
+
+}
+
+struct Results_Table_Digest compute_results_csv_file_digest(const char* file_location) {
+
+    // No null pointers allowed
+    assert(file_location != NULL);
+
+    FILE* results_file = fopen(file_location, "r");
+    // Inform user if file didn't open correctly and abort program
+    if (results_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+
+    char* line_read = NULL;
+    size_t line_buffer_size = 0;
+    uint64_t polynomial = 0;
+    unsigned long num_rows = 0;
+    char number_field[MAX_RESULTS_CSV_FIELD_LEN];
+    char first_name[FIRST_NAME_MAX_LEN];
+    char ean13[EAN13_MAX_CHARS];
+
+    // First line is the header
+    bool is_header = true;
+    while (getline(&line_read, &line_buffer_size, results_file) >= 0) {
+
+        if (is_header || line_read[0] == '\n' || line_read[0] == '\r') {
+            is_header = false;
+            continue;
+        }
+
+        const char* line = line_read;
+        read_csv_field(&line, number_field, sizeof(number_field));
+        const unsigned long time_of_purchase = parse_csv_number(number_field);
+        read_csv_field(&line, number_field, sizeof(number_field));
+        const unsigned long customer_id = parse_csv_number(number_field);
+        const size_t first_name_len = read_csv_field(&line, first_name, sizeof(first_name));
+        const size_t ean13_len = read_csv_field(&line, ean13, sizeof(ean13));
+        read_csv_field(&line, number_field, sizeof(number_field));
+        const unsigned long quantity_purchased = parse_csv_number(number_field);
+
+        const uint64_t row_hash = hash_results_row(time_of_purchase, customer_id, first_name, first_name_len,
+                                                     ean13, ean13_len, quantity_purchased);
+        polynomial = add_modulo(multiply_modulo(polynomial, DIGEST_POLYNOMIAL_BASE), row_hash);
+        ++num_rows;
+
+    }
+
+    free(line_read);
+    fclose(results_file);
+    return finish_digest(polynomial, num_rows);
+
+}
+
+struct Results_Table_Digest get_reference_results_digest(const char* reference_file_location,
+                                                            const char* digest_cache_location,
+                                                            const char* customer_table_file_location,
+                                                            const char* purchases_table_file_location) {
+
+    // No null pointers allowed
+    assert(reference_file_location != NULL);
+    assert(digest_cache_location != NULL);
+    assert(customer_table_file_location != NULL);
+    assert(purchases_table_file_location != NULL);
+
+    // Reference digest is only valid for the very input tables it was computed for
+    long customer_table_size, customer_table_mtime, purchases_table_size, purchases_table_mtime;
+    get_file_signature(customer_table_file_location, &customer_table_size, &customer_table_mtime);
+    get_file_signature(purchases_table_file_location, &purchases_table_size, &purchases_table_mtime);
+
+    // A known correct result regenerated since the digest was cached makes the cache stale
+    long reference_file_size, reference_file_mtime, digest_cache_size, digest_cache_mtime;
+    get_file_signature(reference_file_location, &reference_file_size, &reference_file_mtime);
+    get_file_signature(digest_cache_location, &digest_cache_size, &digest_cache_mtime);
+
+    struct Results_Table_Digest digest;
+    FILE* digest_cache_file = (reference_file_mtime <= digest_cache_mtime) ? fopen(digest_cache_location, "r") : NULL;
+    if (digest_cache_file != NULL) {
+        long cached_signature[4];
+        const int num_values_read = fscanf(digest_cache_file, DIGEST_CACHE_SCAN_FORMAT, &(digest.digest),
+                                             &(digest.num_rows), &(cached_signature[0]), &(cached_signature[1]),
+                                             &(cached_signature[2]), &(cached_signature[3]));
+        fclose(digest_cache_file);
+        if (num_values_read == DIGEST_CACHE_NUM_VALUES &&
+            cached_signature[0] == customer_table_size && cached_signature[1] == customer_table_mtime &&
+            cached_signature[2] == purchases_table_size && cached_signature[3] == purchases_table_mtime) {
+            printf(RESULTS_REF_DIGEST_CACHED_MSG, digest_cache_location);
+            return digest;
+        }
+    }
+
+    // Cache is missing or stale; bootstrap it from the known correct result
+    if (access(reference_file_location, R_OK) != 0) {
+        fprintf(stderr, RESULTS_REF_DIGEST_MISSING_MSG, digest_cache_location, reference_file_location);
+        exit(EXIT_FAILURE);
+    }
+    digest = compute_results_csv_file_digest(reference_file_location);
+
+    digest_cache_file = fopen(digest_cache_location, "w");
+    // Not being able to cache the digest only costs time on the next run
+    if (digest_cache_file != NULL) {
+        fprintf(digest_cache_file, DIGEST_CACHE_PRINT_FORMAT, digest.digest, digest.num_rows, customer_table_size,
+                  customer_table_mtime, purchases_table_size, purchases_table_mtime);
+        fclose(digest_cache_file);
+        printf(RESULTS_REF_DIGEST_COMPUTED_MSG, reference_file_location, digest_cache_location);
+    }
+
+    return digest;
+
+}
+
+bool compare_results_digests(struct Results_Table_Digest first_digest, const char* first_description,
+                               struct Results_Table_Digest second_digest, const char* second_description) {
+
+    // No null pointers allowed
+    assert(first_description != NULL);
+    assert(second_description != NULL);
+
+    if (first_digest.digest != second_digest.digest || first_digest.num_rows != second_digest.num_rows) {
+        fprintf(stderr, RESULTS_DIGEST_MISMATCH_MSG, first_description, first_digest.digest, first_digest.num_rows,
+                  second_description, second_digest.digest, second_digest.num_rows);
+        return false;
+    }
+
+    printf(RESULTS_DIGESTS_MATCH_MSG, first_description, second_description);
+    return true;
+
+}
@@ -0,0 +1,638 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for verifying that two equijoin results tables on
+// disk hold the same rows, comparing both memory-mapped CSV files in parallel.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Necessary libraries and headers for functions
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "data_structures_opencl.h"
+#include "host_threads.h"
+#include "results_verifier.h"
+
+// Message informing user two results tables in different CSV dialects hold the same rows
+#define RESULTS_FILES_SAME_ROWS_MSG "'%s' and '%s' hold the same %lu row(s) %s (%u thread(s))\n"
+// Column a difference was found in when a row is missing from one of the files altogether
+#define MISSING_ROW_COLUMN -1
+
+// Names of the columns of a results table, in the order of JOINED_RESULT_TABLE_HEADER
+static const char* const RESULTS_COLUMN_NAMES[JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT] = {
+    "epochTimePurchased", "customerID", "customerName", "purchaseEAN13", "purchaseQuantity"
+};
+
+/*
+ * A results table CSV file mapped into memory.
+ *   - location --- path of the file
+ *   - bytes, size --- contents of the file (NULL if the file is empty) and its size
+ *   - slice_newlines --- number of newlines before the start of each byte slice of the file
+ *                        (one slice per task, plus the total number of newlines at the end)
+ *   - num_rows --- number of rows in the file, header included
+ */
+struct Mapped_Results_File {
+    const char* location;
+    const char* bytes;
+    size_t size;
+    unsigned long* slice_newlines;
+    unsigned long num_rows;
+};
+
+/*
+ * Work of one thread comparing two results tables.
+ *   - thread --- thread doing the work
+ *   - files --- both files being compared
+ *   - task_index, num_tasks --- which of how many tasks this is; task "task_index" handles
+ *                               byte slice, row range and hash partition "task_index"
+ *   - is_equal --- whether the byte slice of both files is identical
+ *   - num_newlines --- number of newlines in the byte slice of each file
+ *   - mismatch_row, mismatch_column --- first row (and its column) within the row range that
+ *                                       differs between the files; ULONG_MAX if none does
+ *   - partition_counts --- number of rows of each file hashing to each partition, within the
+ *                          row range; filled in with where those rows go in "partitions" instead
+ *                          before rows are scattered
+ *   - partitions --- row hashes of each file, grouped by partition
+ *   - partition_offsets --- where each partition starts in "partitions" for each file
+ *   - num_unmatched --- number of rows of each file in this task's partition without a match
+ *   - unmatched_hash, unmatched_file --- hash of a row without a match, and which file it is from
+ */
+struct Verifier_Task {
+    pthread_t thread;
+    struct Mapped_Results_File* files;
+    unsigned int task_index;
+    unsigned int num_tasks;
+    bool is_equal;
+    unsigned long num_newlines[2];
+    unsigned long mismatch_row;
+    int mismatch_column;
+    unsigned long* partition_counts[2];
+    uint64_t** partitions;
+    unsigned long** partition_offsets;
+    unsigned long num_unmatched[2];
+    uint64_t unmatched_hash;
+    unsigned int unmatched_file;
+};
+
+// =================================================================================================
+
+static void map_results_file(struct Mapped_Results_File* file, const char* location) {
+
+    file->location = location;
+    file->bytes = NULL;
+    file->slice_newlines = NULL;
+
+    int file_descriptor = open(location, O_RDONLY);
+    // Inform user if file didn't open correctly and abort program
+    if (file_descriptor < 0) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    struct stat file_status;
+    int func_status = fstat(file_descriptor, &file_status);
+    assert(func_status == 0);
+    file->size = (size_t) file_status.st_size;
+
+    // Empty files can't be mapped
+    if (file->size > 0) {
+        void* mapping = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        assert(mapping != MAP_FAILED);
+        // Every byte gets read front to back exactly once (or twice, if the files differ)
+        madvise(mapping, file->size, MADV_SEQUENTIAL);
+        file->bytes = (const char*) mapping;
+    }
+    // Mapping stays valid after the file is closed
+    func_status = close(file_descriptor);
+    assert(func_status == 0);
+
+}
+
+static void unmap_results_file(struct Mapped_Results_File* file) {
+
+    if (file->bytes != NULL) {
+        int func_status = munmap((void*) file->bytes, file->size);
+        assert(func_status == 0);
+    }
+    free(file->slice_newlines);
+
+}
+
+// Start of byte slice "slice_index" of "num_slices" slices of "file"
+static inline size_t slice_start(const struct Mapped_Results_File* file, unsigned int slice_index,
+                                   unsigned int num_slices) {
+
+    return (size_t)((unsigned __int128) file->size * slice_index / num_slices);
+
+}
+
+// First row of row range "range_index" of "num_ranges" ranges splitting "num_rows" rows
+static inline unsigned long range_start(unsigned long num_rows, unsigned int range_index, unsigned int num_ranges) {
+
+    return (unsigned long)((unsigned __int128) num_rows * range_index / num_ranges);
+
+}
+
+/*
+ * Returns the start of row "row_index" of "file" (or the end of the file if it has no such row),
+ * found through the number of newlines before each of its "num_slices" byte slices.
+ */
+static const char* locate_row(const struct Mapped_Results_File* file, unsigned long row_index,
+                                unsigned int num_slices) {
+
+    if (row_index == 0 || row_index >= file->num_rows) {
+        return (row_index == 0) ? file->bytes : file->bytes + file->size;
+    }
+
+    // Row starts right after newline number "row_index - 1"; find which slice that newline is in
+    const unsigned long newline_index = row_index - 1;
+    unsigned int slice_index = 0;
+    while (file->slice_newlines[slice_index + 1] <= newline_index) {
+        ++slice_index;
+    }
+
+    const char* position = file->bytes + slice_start(file, slice_index, num_slices);
+    const char* file_end = file->bytes + file->size;
+    for (unsigned long newlines_left = newline_index - file->slice_newlines[slice_index]; ; --newlines_left) {
+        position = memchr(position, '\n', (size_t)(file_end - position));
+        assert(position != NULL);
+        if (newlines_left == 0) {
+            break;
+        }
+        ++position;
+    }
+
+    return position + 1;
+
+}
+
+// End of the row starting at "row_start" (its newline, or the end of the file)
+static inline const char* row_end(const struct Mapped_Results_File* file, const char* row_start) {
+
+    const char* file_end = file->bytes + file->size;
+    const char* newline = (row_start < file_end) ? memchr(row_start, '\n', (size_t)(file_end - row_start)) : NULL;
+    return (newline != NULL) ? newline : file_end;
+
+}
+
+// Whether a character is left out when comparing rows written in different CSV dialects
+static inline bool is_ignored_character(char character) {
+
+    return character == '"' || character == '\r';
+
+}
+
+/*
+ * Compares two rows with quotes and carriage returns ignored; returns the column (counted in
+ * the first row) of the first difference, or -2 if both rows are the same.
+ */
+static int compare_rows(const char* first_row, const char* first_row_end,
+                          const char* second_row, const char* second_row_end) {
+
+    int column = 0;
+    bool is_in_quotes = false;
+
+    while (true) {
+        while (first_row < first_row_end && is_ignored_character(*first_row)) {
+            is_in_quotes = is_in_quotes ^ (*first_row == '"');
+            ++first_row;
+        }
+        while (second_row < second_row_end && is_ignored_character(*second_row)) {
+            ++second_row;
+        }
+        if (first_row == first_row_end || second_row == second_row_end) {
+            return (first_row == first_row_end && second_row == second_row_end) ? -2 : column;
+        }
+        if (*first_row != *second_row) {
+            return column;
+        }
+        if (*first_row == ',' && !is_in_quotes) {
+            ++column;
+        }
+        ++first_row;
+        ++second_row;
+    }
+
+}
+
+// 64-bit hash of a row with quotes and carriage returns ignored (FNV-1a, then a final mix)
+static uint64_t hash_row(const char* row, const char* row_end) {
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (; row < row_end; ++row) {
+        if (!is_ignored_character(*row)) {
+            hash = (hash ^ (unsigned char) *row) * 0x100000001b3ull;
+        }
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+
+}
+
+// Partition a row hash belongs to
+static inline unsigned int hash_partition(uint64_t hash, unsigned int num_partitions) {
+
+    return (unsigned int)(((hash >> 32) * num_partitions) >> 32);
+
+}
+
+static int compare_hashes(const void* first_hash, const void* second_hash) {
+
+    const uint64_t first = *(const uint64_t*) first_hash, second = *(const uint64_t*) second_hash;
+    return (first > second) - (first < second);
+
+}
+
+// Compares a byte slice of both files, which are of the same size
+static void* compare_slice_bytes(void* task_arg) {
+
+    struct Verifier_Task* task = (struct Verifier_Task*) task_arg;
+    const size_t start = slice_start(&(task->files[0]), task->task_index, task->num_tasks);
+    const size_t end = slice_start(&(task->files[0]), task->task_index + 1, task->num_tasks);
+
+    task->is_equal = memcmp(task->files[0].bytes + start, task->files[1].bytes + start, end - start) == 0;
+    return NULL;
+
+}
+
+// Counts the newlines in a byte slice of each file
+static void* count_slice_newlines(void* task_arg) {
+
+    struct Verifier_Task* task = (struct Verifier_Task*) task_arg;
+
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        const struct Mapped_Results_File* file = &(task->files[file_index]);
+        const char* position = file->bytes + slice_start(file, task->task_index, task->num_tasks);
+        const char* end = file->bytes + slice_start(file, task->task_index + 1, task->num_tasks);
+        unsigned long num_newlines = 0;
+        while (position < end && (position = memchr(position, '\n', (size_t)(end - position))) != NULL) {
+            ++num_newlines;
+            ++position;
+        }
+        task->num_newlines[file_index] = num_newlines;
+    }
+
+    return NULL;
+
+}
+
+// Compares the rows of a row range of both files in order, stopping at the first difference
+static void* compare_range_rows(void* task_arg) {
+
+    struct Verifier_Task* task = (struct Verifier_Task*) task_arg;
+    const struct Mapped_Results_File* files = task->files;
+    const unsigned long num_rows = (files[0].num_rows > files[1].num_rows) ? files[0].num_rows : files[1].num_rows;
+    const unsigned long first_row = range_start(num_rows, task->task_index, task->num_tasks);
+    const unsigned long last_row = range_start(num_rows, task->task_index + 1, task->num_tasks);
+
+    task->mismatch_row = ULONG_MAX;
+    const char* first_file_row = locate_row(&(files[0]), first_row, task->num_tasks);
+    const char* second_file_row = locate_row(&(files[1]), first_row, task->num_tasks);
+
+    for (unsigned long row_index = first_row; row_index < last_row; ++row_index) {
+        if (row_index >= files[0].num_rows || row_index >= files[1].num_rows) {
+            task->mismatch_row = row_index;
+            task->mismatch_column = MISSING_ROW_COLUMN;
+            break;
+        }
+        const char* first_file_row_end = row_end(&(files[0]), first_file_row);
+        const char* second_file_row_end = row_end(&(files[1]), second_file_row);
+        const int mismatch_column = compare_rows(first_file_row, first_file_row_end,
+                                                   second_file_row, second_file_row_end);
+        if (mismatch_column >= 0) {
+            task->mismatch_row = row_index;
+            task->mismatch_column = mismatch_column;
+            break;
+        }
+        first_file_row = first_file_row_end + 1;
+        second_file_row = second_file_row_end + 1;
+    }
+
+    return NULL;
+
+}
+
+/*
+ * Hashes the rows of a row range of each file, counting how many rows of each file go to each
+ * partition; or, once "partition_counts" holds where those rows go instead, puts every row hash
+ * in its partition.
+ */
+static void* partition_range_rows(void* task_arg, bool is_scattering) {
+
+    struct Verifier_Task* task = (struct Verifier_Task*) task_arg;
+
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        const struct Mapped_Results_File* file = &(task->files[file_index]);
+        const unsigned long first_row = range_start(file->num_rows, task->task_index, task->num_tasks);
+        const unsigned long last_row = range_start(file->num_rows, task->task_index + 1, task->num_tasks);
+        unsigned long* partition_counts = task->partition_counts[file_index];
+        if (!is_scattering) {
+            memset(partition_counts, 0, task->num_tasks * sizeof(*partition_counts));
+        }
+
+        const char* row = locate_row(file, first_row, task->num_tasks);
+        for (unsigned long row_index = first_row; row_index < last_row; ++row_index) {
+            const char* end = row_end(file, row);
+            const uint64_t hash = hash_row(row, end);
+            const unsigned int partition = hash_partition(hash, task->num_tasks);
+            if (is_scattering) {
+                task->partitions[file_index][partition_counts[partition]] = hash;
+            }
+            ++partition_counts[partition];
+            row = end + 1;
+        }
+    }
+
+    return NULL;
+
+}
+
+static void* count_range_partitions(void* task_arg) {
+
+    return partition_range_rows(task_arg, false);
+
+}
+
+static void* scatter_range_partitions(void* task_arg) {
+
+    return partition_range_rows(task_arg, true);
+
+}
+
+// Sorts one partition of both files' row hashes, and counts the hashes without a match
+static void* compare_partition_hashes(void* task_arg) {
+
+    struct Verifier_Task* task = (struct Verifier_Task*) task_arg;
+    uint64_t* hashes[2];
+    unsigned long num_hashes[2];
+
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        const unsigned long start = task->partition_offsets[file_index][task->task_index];
+        hashes[file_index] = task->partitions[file_index] + start;
+        num_hashes[file_index] = task->partition_offsets[file_index][task->task_index + 1] - start;
+        qsort(hashes[file_index], num_hashes[file_index], sizeof(uint64_t), compare_hashes);
+        task->num_unmatched[file_index] = 0;
+    }
+
+    // Walk both sorted partitions side by side; equal hashes cancel each other out
+    unsigned long first_index = 0, second_index = 0;
+    while (first_index < num_hashes[0] || second_index < num_hashes[1]) {
+        unsigned int unmatched_file;
+        if (second_index == num_hashes[1] ||
+            (first_index < num_hashes[0] && hashes[0][first_index] < hashes[1][second_index])) {
+            unmatched_file = 0;
+        } else if (first_index == num_hashes[0] || hashes[1][second_index] < hashes[0][first_index]) {
+            unmatched_file = 1;
+        } else {
+            ++first_index;
+            ++second_index;
+            continue;
+        }
+        const uint64_t unmatched_hash = (unmatched_file == 0) ? hashes[0][first_index++] : hashes[1][second_index++];
+        if (task->num_unmatched[0] + task->num_unmatched[1] == 0) {
+            task->unmatched_hash = unmatched_hash;
+            task->unmatched_file = unmatched_file;
+        }
+        ++(task->num_unmatched[unmatched_file]);
+    }
+
+    return NULL;
+
+}
+
+// Runs "task_func" on every task in a thread of its own, and waits for all of them to finish
+static void run_verifier_tasks(struct Verifier_Task* tasks, unsigned int num_tasks, void* (*task_func)(void*)) {
+
+    int thread_status;
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        thread_status = pthread_create(&(tasks[task_index].thread), NULL, task_func, &(tasks[task_index]));
+        assert(thread_status == 0);
+    }
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        thread_status = pthread_join(tasks[task_index].thread, NULL);
+        assert(thread_status == 0);
+    }
+
+}
+
+// Prints row "row_index" of "file" as part of a difference report
+static void print_row_text(const struct Mapped_Results_File* file, unsigned long row_index, unsigned int num_slices) {
+
+    const char* row = locate_row(file, row_index, num_slices);
+    const char* end = row_end(file, row);
+    if (end > row && end[-1] == '\r') {
+        --end;
+    }
+    fprintf(stderr, RESULTS_FILES_ROW_TEXT_MSG, file->location, (int)(end - row), (row != NULL) ? row : "");
+
+}
+
+/*
+ * Compares the rows of both files in order; returns whether they're the same, after printing
+ * the first differing row otherwise.
+ */
+static bool compare_rows_in_order(struct Mapped_Results_File* files, struct Verifier_Task* tasks,
+                                    unsigned int num_tasks) {
+
+    run_verifier_tasks(tasks, num_tasks, compare_range_rows);
+
+    // Tasks cover ascending row ranges, so the first task to find a difference found the first one
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        const unsigned long mismatch_row = tasks[task_index].mismatch_row;
+        if (mismatch_row == ULONG_MAX) {
+            continue;
+        }
+        if (tasks[task_index].mismatch_column == MISSING_ROW_COLUMN) {
+            const unsigned int file_index = (mismatch_row < files[0].num_rows) ? 0 : 1;
+            fprintf(stderr, RESULTS_FILES_MISSING_ROW_MSG, mismatch_row, files[file_index].location);
+            print_row_text(&(files[file_index]), mismatch_row, num_tasks);
+        } else {
+            const int column = tasks[task_index].mismatch_column;
+            fprintf(stderr, RESULTS_FILES_ROW_MISMATCH_MSG, mismatch_row, column + 1,
+                      (column < JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT) ? RESULTS_COLUMN_NAMES[column] : "?");
+            print_row_text(&(files[0]), mismatch_row, num_tasks);
+            print_row_text(&(files[1]), mismatch_row, num_tasks);
+        }
+        return false;
+    }
+
+    return true;
+
+}
+
+/*
+ * Compares the rows of both files as multisets of row hashes; returns whether they're the same,
+ * after printing a row without a match otherwise.
+ */
+static bool compare_rows_in_any_order(struct Mapped_Results_File* files, struct Verifier_Task* tasks,
+                                        unsigned int num_tasks) {
+
+    uint64_t* partitions[2];
+    unsigned long* partition_offsets[2];
+    unsigned long* partition_counts = malloc(2 * num_tasks * num_tasks * sizeof(*partition_counts));
+    assert(partition_counts != NULL);
+
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        partitions[file_index] = malloc((files[file_index].num_rows + 1) * sizeof(uint64_t));
+        partition_offsets[file_index] = malloc((num_tasks + 1) * sizeof(unsigned long));
+        assert(partitions[file_index] != NULL && partition_offsets[file_index] != NULL);
+    }
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        tasks[task_index].partitions = partitions;
+        tasks[task_index].partition_offsets = partition_offsets;
+        tasks[task_index].partition_counts[0] = partition_counts + (2 * task_index) * num_tasks;
+        tasks[task_index].partition_counts[1] = partition_counts + (2 * task_index + 1) * num_tasks;
+    }
+
+    run_verifier_tasks(tasks, num_tasks, count_range_partitions);
+
+    // Prefix sum over partitions, then tasks, gives where each task puts the rows of each partition
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        unsigned long offset = 0;
+        for (unsigned int partition = 0; partition < num_tasks; ++partition) {
+            partition_offsets[file_index][partition] = offset;
+            for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+                const unsigned long num_rows = tasks[task_index].partition_counts[file_index][partition];
+                tasks[task_index].partition_counts[file_index][partition] = offset;
+                offset += num_rows;
+            }
+        }
+        partition_offsets[file_index][num_tasks] = offset;
+    }
+
+    run_verifier_tasks(tasks, num_tasks, scatter_range_partitions);
+    run_verifier_tasks(tasks, num_tasks, compare_partition_hashes);
+
+    unsigned long num_unmatched[2] = { 0, 0 };
+    const struct Verifier_Task* example_task = NULL;
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        num_unmatched[0] += tasks[task_index].num_unmatched[0];
+        num_unmatched[1] += tasks[task_index].num_unmatched[1];
+        if (example_task == NULL && tasks[task_index].num_unmatched[0] + tasks[task_index].num_unmatched[1] > 0) {
+            example_task = &(tasks[task_index]);
+        }
+    }
+
+    if (example_task != NULL) {
+        // Only the hash of the row was kept; look the row up again
+        const struct Mapped_Results_File* file = &(files[example_task->unmatched_file]);
+        const char* row = file->bytes;
+        unsigned long row_index = 0;
+        for (; row_index < file->num_rows; ++row_index) {
+            const char* end = row_end(file, row);
+            if (hash_row(row, end) == example_task->unmatched_hash) {
+                break;
+            }
+            row = end + 1;
+        }
+        fprintf(stderr, RESULTS_FILES_UNMATCHED_ROWS_MSG, num_unmatched[0], files[0].location,
+                  num_unmatched[1], files[1].location, row_index, file->location);
+        print_row_text(file, row_index, num_tasks);
+    }
+
+    free(partition_counts);
+    for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+        free(partitions[file_index]);
+        free(partition_offsets[file_index]);
+    }
+    return example_task == NULL;
+
+}
+
+bool compare_results_table_files(const char* first_results_file, const char* second_results_file,
+                                   bool is_order_insensitive, unsigned int num_threads) {
+
+    // No null pointers allowed
+    assert(first_results_file != NULL);
+    assert(second_results_file != NULL);
+
+    struct Mapped_Results_File files[2];
+    map_results_file(&(files[0]), first_results_file);
+    map_results_file(&(files[1]), second_results_file);
+
+    num_threads = resolve_num_threads(num_threads);
+    // Threads comparing tiny slices cost more than they save
+    const size_t larger_file_size = (files[0].size > files[1].size) ? files[0].size : files[1].size;
+    if (num_threads > larger_file_size / MIN_VERIFIER_BYTES_PER_THREAD) {
+        num_threads = (unsigned int)(larger_file_size / MIN_VERIFIER_BYTES_PER_THREAD);
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+
+    struct Verifier_Task* tasks = calloc(num_threads, sizeof(*tasks));
+    assert(tasks != NULL);
+    for (unsigned int task_index = 0; task_index < num_threads; ++task_index) {
+        tasks[task_index].files = files;
+        tasks[task_index].task_index = task_index;
+        tasks[task_index].num_tasks = num_threads;
+    }
+
+    // Files written by this program in the same order are byte-for-byte identical
+    bool is_equal = files[0].size == files[1].size;
+    if (is_equal) {
+        run_verifier_tasks(tasks, num_threads, compare_slice_bytes);
+        for (unsigned int task_index = 0; task_index < num_threads; ++task_index) {
+            is_equal = is_equal && tasks[task_index].is_equal;
+        }
+        if (is_equal) {
+            printf(RESULTS_FILES_BYTE_IDENTICAL_MSG, first_results_file, second_results_file, num_threads);
+        }
+    }
+
+    if (!is_equal) {
+
+        // Index rows of both files by the number of newlines in each byte slice
+        run_verifier_tasks(tasks, num_threads, count_slice_newlines);
+        for (unsigned int file_index = 0; file_index < 2; ++file_index) {
+            files[file_index].slice_newlines = malloc((num_threads + 1) * sizeof(unsigned long));
+            assert(files[file_index].slice_newlines != NULL);
+            files[file_index].slice_newlines[0] = 0;
+            for (unsigned int task_index = 0; task_index < num_threads; ++task_index) {
+                files[file_index].slice_newlines[task_index + 1] =
+                    files[file_index].slice_newlines[task_index] + tasks[task_index].num_newlines[file_index];
+            }
+            // Last row doesn't have to end with a newline
+            files[file_index].num_rows = files[file_index].slice_newlines[num_threads] +
+                ((files[file_index].size > 0 && files[file_index].bytes[files[file_index].size - 1] != '\n') ? 1 : 0);
+        }
+
+        if (files[0].num_rows != files[1].num_rows) {
+            fprintf(stderr, RESULTS_FILES_ROW_COUNT_MISMATCH_MSG, first_results_file, files[0].num_rows,
+                      second_results_file, files[1].num_rows);
+        }
+        is_equal = is_order_insensitive ? compare_rows_in_any_order(files, tasks, num_threads) :
+                                          compare_rows_in_order(files, tasks, num_threads);
+        if (is_equal) {
+            printf(RESULTS_FILES_SAME_ROWS_MSG, first_results_file, second_results_file, files[0].num_rows,
+                     is_order_insensitive ? "in some order" : "in the same order", num_threads);
+        }
+
+    }
+
+    free(tasks);
+    unmap_results_file(&(files[0]));
+    unmap_results_file(&(files[1]));
+    return is_equal;
+
+}
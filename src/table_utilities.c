@@ -7,8 +7,15 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <bsd/string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "data_structures_opencl.h"
 #include "table_utilities.h"
+#include "results_verifier.h"
+#include "trace_events.h"
+#include "host_threads.h"
 
 
 /*
@@ -58,8 +65,8 @@ static inline FILE * open_file_read_only(const char * file_location, const size_
  *                                                             the word "hashed" within the parameter name
  *                                                             nor the function's name.
  */
-static inline void csv_file_line_to_customer_table_row(char* file_line,
-                                                        struct Hashed_Customer_Table_Row* customer_table_row) {
+void csv_file_line_to_customer_table_row(char* file_line,
+                                         struct Hashed_Customer_Table_Row* customer_table_row) {
     // Assert non-null pointers
     assert(file_line != NULL);
     assert(customer_table_row != NULL);
@@ -98,8 +105,8 @@ static inline void csv_file_line_to_customer_table_row(char* file_line,
  *                                                        will be stored after parsing the data
  *                                                        from the record. 
  */
-static inline void csv_file_line_to_purchases_table_row(char* file_line,
-                                                        struct Purchases_Table_Row* purchases_table_row) {
+void csv_file_line_to_purchases_table_row(char* file_line,
+                                          struct Purchases_Table_Row* purchases_table_row) {
     // Assert non-null pointers
     assert(file_line != NULL);
     assert(purchases_table_row != NULL);
@@ -152,9 +159,9 @@ static inline void csv_file_line_to_purchases_table_row(char* file_line,
  * on disk, hashes the record to calculate where to store the record in "hashed_customer_table",
  * and then stores it in "hashed_customer_table".
  */
-static inline void hash_and_store_record_in_hashed_customer_table(char* line_read,
-                                                                  size_t *current_table_row_count,
-                                                                  struct Hashed_Customer_Table** hashed_customer_table) {
+void hash_and_store_record_in_hashed_customer_table(char* line_read,
+                                                    size_t *current_table_row_count,
+                                                    struct Hashed_Customer_Table** hashed_customer_table) {
 
     /* 
      * Constant multiplier governing the factor used to increase
@@ -217,9 +224,9 @@ static inline void hash_and_store_record_in_hashed_customer_table(char* line_rea
  * This function takes the string representation of a record from the purchases data table
  * on disk and stores it in "purchases_table"
  */
-static inline void store_record_in_purchases_table(char* line_read,
-                                                   size_t *current_table_row_count,
-                                                   struct Purchases_Table** purchases_table) {
+void store_record_in_purchases_table(char* line_read,
+                                     size_t *current_table_row_count,
+                                     struct Purchases_Table** purchases_table) {
 
     /* 
      * Constant multiplier governing the factor used to increase
@@ -404,125 +411,691 @@ struct Purchases_Table* read_purchases_table_from_csv_file(const char* file_loca
 
 }
 
-void write_results_table_to_csv_file(struct Joined_Results_Table* results_table, const char* file_location) {
+/*
+ * Opens the binary table file at "file_location" and checks its header against "row_size";
+ * returns the file positioned at its first row and stores its number of rows in "num_records".
+ */
+static FILE * open_table_binary_file(const char * file_location, const size_t row_size, unsigned long * num_records) {
+
+    // Ideal buffer size for most SSD's and HDD's for doing file IO
+    const size_t buffer_size = 4096;
+    FILE * table_file = open_file_read_only(file_location, buffer_size);
+
+    // Inform user this program is beginning to load file from disk into memory
+    printf(FILE_BEING_READ_MSG, file_location);
+
+    struct Table_Binary_File_Header header;
+    if (fread(&header, sizeof(header), 1, table_file) != 1 ||
+        memcmp(header.magic, TABLE_BINARY_FILE_MAGIC, sizeof(header.magic)) != 0 || header.row_size != row_size) {
+        fprintf(stderr, "Error reading %s: not a binary table file of rows of %zu bytes.\n", file_location, row_size);
+        exit(EXIT_FAILURE);
+    }
+    *num_records = header.num_records;
+    return table_file;
+
+}
+
+struct Hashed_Customer_Table* read_hashed_customer_table_from_binary_file(const char* file_location) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
+
+    struct Hashed_Customer_Table* hashed_customer_table = malloc(sizeof(*hashed_customer_table));
+    assert(hashed_customer_table != NULL);
+    FILE * customer_table_file = open_table_binary_file(file_location, sizeof(*(hashed_customer_table->table)),
+                                                          &(hashed_customer_table->num_records));
+    // Rows are stored hashed already, so the whole table is read with a single call
+    hashed_customer_table->table = malloc((hashed_customer_table->num_records > 0 ?
+                                              hashed_customer_table->num_records : 1) *
+                                            sizeof(*(hashed_customer_table->table)));
+    assert(hashed_customer_table->table != NULL);
+    size_t num_rows_read = fread(hashed_customer_table->table, sizeof(*(hashed_customer_table->table)),
+                                   hashed_customer_table->num_records, customer_table_file);
+    assert(num_rows_read == hashed_customer_table->num_records);
+    // Done with file; close it
+    fclose(customer_table_file);
+
+    return hashed_customer_table;
+
+}
+
+struct Purchases_Table* read_purchases_table_from_binary_file(const char* file_location) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
+
+    struct Purchases_Table* purchases_table = malloc(sizeof(*purchases_table));
+    assert(purchases_table != NULL);
+    FILE * purchases_table_file = open_table_binary_file(file_location, sizeof(*(purchases_table->table)),
+                                                           &(purchases_table->num_records));
+    purchases_table->table = malloc((purchases_table->num_records > 0 ? purchases_table->num_records : 1) *
+                                      sizeof(*(purchases_table->table)));
+    assert(purchases_table->table != NULL);
+    size_t num_rows_read = fread(purchases_table->table, sizeof(*(purchases_table->table)),
+                                   purchases_table->num_records, purchases_table_file);
+    assert(num_rows_read == purchases_table->num_records);
+    // Done with file; close it
+    fclose(purchases_table_file);
+
+    return purchases_table;
+
+}
+
+// Returns whether "file_location" names a table stored in the binary format
+static bool is_table_binary_file(const char * file_location) {
+
+    const size_t location_len = strlen(file_location);
+    const size_t extension_len = strlen(TABLE_BINARY_FILE_EXTENSION);
+    return location_len >= extension_len &&
+             strcmp(file_location + location_len - extension_len, TABLE_BINARY_FILE_EXTENSION) == 0;
+
+}
+
+struct Hashed_Customer_Table* read_hashed_customer_table_from_file(const char* file_location) {
+
+    assert(file_location != NULL);
+    const unsigned long trace_start = trace_clock_nanosecs();
+    struct Hashed_Customer_Table* hashed_customer_table;
+    // Binary files are only read; CSV files are parsed line by line as they're read
+    if (is_table_binary_file(file_location)) {
+        hashed_customer_table = read_hashed_customer_table_from_binary_file(file_location);
+        record_trace_span(TRACE_CATEGORY_READ, "read customer table", trace_start);
+    } else {
+        hashed_customer_table = read_hashed_customer_table_from_csv_file(file_location);
+        record_trace_span(TRACE_CATEGORY_PARSE, "parse customer table", trace_start);
+    }
+    return hashed_customer_table;
+
+}
+
+struct Purchases_Table* read_purchases_table_from_file(const char* file_location) {
+
+    assert(file_location != NULL);
+    const unsigned long trace_start = trace_clock_nanosecs();
+    struct Purchases_Table* purchases_table;
+    if (is_table_binary_file(file_location)) {
+        purchases_table = read_purchases_table_from_binary_file(file_location);
+        record_trace_span(TRACE_CATEGORY_READ, "read purchases table", trace_start);
+    } else {
+        purchases_table = read_purchases_table_from_csv_file(file_location);
+        record_trace_span(TRACE_CATEGORY_PARSE, "parse purchases table", trace_start);
+    }
+    return purchases_table;
+
+}
+
+void get_file_signature(const char* file_location, long* file_size, long* mtime) {
+
+    struct stat file_status;
+    if (stat(file_location, &file_status) != 0) {
+        *file_size = -1;
+        *mtime = -1;
+        return;
+    }
+    *file_size = (long) file_status.st_size;
+    *mtime = (long) file_status.st_mtim.tv_sec * 1000000000l + (long) file_status.st_mtim.tv_nsec;
+
+}
+
+// Opens the table at "file_location" of rows of "row_size" bytes (if binary) for "reader"
+static void open_table_file_reader(const char* file_location, const size_t row_size,
+                                     struct Table_File_Reader* reader) {
 
     // Assert non-null pointers
     assert(file_location != NULL);
+    assert(reader != NULL);
+
+    reader->is_binary = is_table_binary_file(file_location);
+    reader->num_binary_rows_left = 0;
+    reader->line = NULL;
+    reader->line_buffer_size = 0;
+    if (reader->is_binary) {
+        reader->file = open_table_binary_file(file_location, row_size, &(reader->num_binary_rows_left));
+        int func_status = setvbuf(reader->file, NULL, _IOFBF, TABLE_FILE_READER_BUFFER_SIZE);
+        assert(func_status == EXIT_SUCCESS);
+    } else {
+        reader->file = open_file_read_only(file_location, TABLE_FILE_READER_BUFFER_SIZE);
+        printf(FILE_BEING_READ_MSG, file_location);
+        // Discard header from table being read
+        getline(&(reader->line), &(reader->line_buffer_size), reader->file);
+    }
+
+}
+
+void open_customer_table_file_reader(const char* file_location, struct Table_File_Reader* reader) {
+    open_table_file_reader(file_location, sizeof(struct Hashed_Customer_Table_Row), reader);
+}
+
+void open_purchases_table_file_reader(const char* file_location, struct Table_File_Reader* reader) {
+    open_table_file_reader(file_location, sizeof(struct Purchases_Table_Row), reader);
+}
+
+bool read_next_customer_table_row(struct Table_File_Reader* reader,
+                                    struct Hashed_Customer_Table_Row* customer_table_row) {
+
+    // Assert non-null pointers
+    assert(reader != NULL);
+    assert(customer_table_row != NULL);
+
+    if (reader->is_binary) {
+        if (reader->num_binary_rows_left == 0) {
+            return false;
+        }
+        --(reader->num_binary_rows_left);
+        size_t num_rows_read = fread(customer_table_row, sizeof(*customer_table_row), 1, reader->file);
+        assert(num_rows_read == 1);
+        return true;
+    }
+    if (getline(&(reader->line), &(reader->line_buffer_size), reader->file) < 0) {
+        // EOF reached
+        return false;
+    }
+    csv_file_line_to_customer_table_row(reader->line, customer_table_row);
+    return true;
+
+}
+
+bool read_next_purchases_table_row(struct Table_File_Reader* reader,
+                                     struct Purchases_Table_Row* purchases_table_row) {
+
+    // Assert non-null pointers
+    assert(reader != NULL);
+    assert(purchases_table_row != NULL);
+
+    if (reader->is_binary) {
+        if (reader->num_binary_rows_left == 0) {
+            return false;
+        }
+        --(reader->num_binary_rows_left);
+        size_t num_rows_read = fread(purchases_table_row, sizeof(*purchases_table_row), 1, reader->file);
+        assert(num_rows_read == 1);
+        return true;
+    }
+    if (getline(&(reader->line), &(reader->line_buffer_size), reader->file) < 0) {
+        // EOF reached
+        return false;
+    }
+    csv_file_line_to_purchases_table_row(reader->line, purchases_table_row);
+    return true;
+
+}
+
+void close_table_file_reader(struct Table_File_Reader* reader) {
+
+    // Assert non-null pointers
+    assert(reader != NULL);
+
+    fclose(reader->file);
+    free(reader->line);
+    reader->file = NULL;
+    reader->line = NULL;
+
+}
+
+/*
+ * Every pair of decimal digits from "00" to "99", so that integers may be converted
+ * to text two digits at a time.
+ */
+static const char DIGIT_PAIRS[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+/*
+ * Writes "value" out in decimal starting at "output", exactly like "%ld" would print the
+ * bits of "value" as a signed long; returns a pointer to just past the last character.
+ */
+static inline char* format_long_as_decimal(char* output, unsigned long value) {
+
+    // Enough room for every digit of the largest unsigned long
+    char digits[MAX_DECIMAL_DIGITS_IN_LONG];
+    char* first_digit = digits + sizeof(digits);
+
+    // "%ld" prints the value as signed
+    if ((long) value < 0) {
+        *output++ = '-';
+        value = 0ul - value;
+    }
+    // Convert two digits per step, starting from the least significant ones
+    while (value >= 100) {
+        const unsigned long digit_pair_index = (value % 100) * 2;
+        value /= 100;
+        first_digit -= 2;
+        first_digit[0] = DIGIT_PAIRS[digit_pair_index];
+        first_digit[1] = DIGIT_PAIRS[digit_pair_index + 1];
+    }
+    if (value >= 10) {
+        first_digit -= 2;
+        first_digit[0] = DIGIT_PAIRS[value * 2];
+        first_digit[1] = DIGIT_PAIRS[value * 2 + 1];
+    } else {
+        *--first_digit = (char)('0' + value);
+    }
+
+    const size_t num_digits = (size_t)(digits + sizeof(digits) - first_digit);
+    memcpy(output, first_digit, num_digits);
+    return output + num_digits;
+
+}
+
+/*
+ * Number of characters "format_long_as_decimal" writes out for "value".
+ */
+static inline size_t decimal_length_of_long(unsigned long value) {
+
+    size_t num_chars = 1;
+
+    if ((long) value < 0) {
+        ++num_chars;
+        value = 0ul - value;
+    }
+    while (value >= 10) {
+        value /= 10;
+        ++num_chars;
+    }
+    return num_chars;
+
+}
+
+/*
+ * Copies the whole "field_len" bytes of the string field "field" to "output" (one fixed-size
+ * copy instead of a byte-by-byte one), and returns a pointer to just past the end of the string
+ * within the copy; anything copied past the end of the string gets overwritten afterwards.
+ */
+static inline char* copy_string_field(char* output, const char* field, const size_t field_len) {
+
+    memcpy(output, field, field_len);
+    return output + strnlen(field, field_len);
+
+}
+
+size_t format_results_table_rows_as_csv(const struct Joined_Results_Table* results_table, unsigned long first_row,
+                                          unsigned long num_rows, char* output) {
+
+    // Assert non-null pointers
     assert(results_table != NULL);
     assert(results_table->table != NULL);
+    assert(output != NULL);
+    // Rows formatted MUST be within "results_table"
+    assert(first_row + num_rows <= results_table->num_records);
 
-    // Ideal buffer size for most SSD's and HDD's for doing file IO
-    const size_t buffer_size = 4096;
+    char* output_end = output;
+
+    for (unsigned long row_index = first_row; row_index < first_row + num_rows; ++row_index) {
+
+        const struct Joined_Results_Table_Row* row = &(results_table->table[row_index]);
+
+        // Skip over table records where customer id and customer name are null values
+        if (row->customer_id_customer == NULL_CUSTOMER_ID &&
+            row->first_name_customer[NULL_CHARACTER_POS] == NULL_CUSTOMER_NAME) {
+            continue;
+        }
+
+        // Same text as JOINED_RESULT_TABLE_ROW_FORMAT produces
+        output_end = format_long_as_decimal(output_end, row->time_of_purchase);
+        *output_end++ = ',';
+        output_end = format_long_as_decimal(output_end, row->customer_id_customer);
+        *output_end++ = ',';
+        *output_end++ = '"';
+        output_end = copy_string_field(output_end, row->first_name_customer, FIRST_NAME_MAX_LEN);
+        *output_end++ = '"';
+        *output_end++ = ',';
+        *output_end++ = '"';
+        output_end = copy_string_field(output_end, row->ean13, EAN13_MAX_CHARS);
+        *output_end++ = '"';
+        *output_end++ = ',';
+        output_end = format_long_as_decimal(output_end, row->quantity_purchased);
+        *output_end++ = '\n';
+
+    }
+
+    return (size_t)(output_end - output);
+
+}
+
+size_t results_table_rows_csv_length(const struct Joined_Results_Table* results_table, unsigned long first_row,
+                                       unsigned long num_rows) {
+
+    // Assert non-null pointers
+    assert(results_table != NULL);
+    assert(results_table->table != NULL);
+    // Rows measured MUST be within "results_table"
+    assert(first_row + num_rows <= results_table->num_records);
+
+    // Commas, quotes and newline of every row written
+    const size_t num_punctuation_chars = strlen(",,\"\",\"\",\n");
+    size_t num_bytes = 0;
+
+    for (unsigned long row_index = first_row; row_index < first_row + num_rows; ++row_index) {
+
+        const struct Joined_Results_Table_Row* row = &(results_table->table[row_index]);
+
+        // Rows with NULL values aren't written
+        if (row->customer_id_customer == NULL_CUSTOMER_ID &&
+            row->first_name_customer[NULL_CHARACTER_POS] == NULL_CUSTOMER_NAME) {
+            continue;
+        }
+
+        num_bytes += decimal_length_of_long(row->time_of_purchase) +
+                     decimal_length_of_long(row->customer_id_customer) +
+                     strnlen(row->first_name_customer, FIRST_NAME_MAX_LEN) +
+                     strnlen(row->ean13, EAN13_MAX_CHARS) +
+                     decimal_length_of_long(row->quantity_purchased) + num_punctuation_chars;
+
+    }
+
+    return num_bytes;
+
+}
+
+/*
+ * Writes all "num_bytes" bytes at "bytes" to "file_descriptor", retrying after partial writes
+ * and interrupted writes; aborts the program if writing fails.
+ */
+static void write_all_bytes(int file_descriptor, const char* bytes, size_t num_bytes) {
+
+    while (num_bytes > 0) {
+        ssize_t num_bytes_written = write(file_descriptor, bytes, num_bytes);
+        if (num_bytes_written < 0) {
+            int global_err_num = errno;
+            if (global_err_num == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Error writing results table: %s.\n", strerror(global_err_num));
+            exit(global_err_num);
+        }
+        bytes += num_bytes_written;
+        num_bytes -= (size_t)num_bytes_written;
+    }
+
+}
+
+/*
+ * Writes all "num_bytes" bytes at "bytes" to "file_descriptor" starting at "file_offset", retrying
+ * after partial writes and interrupted writes; aborts the program if writing fails.
+ */
+static void pwrite_all_bytes(int file_descriptor, const char* bytes, size_t num_bytes, off_t file_offset) {
+
+    while (num_bytes > 0) {
+        ssize_t num_bytes_written = pwrite(file_descriptor, bytes, num_bytes, file_offset);
+        if (num_bytes_written < 0) {
+            int global_err_num = errno;
+            if (global_err_num == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Error writing results table: %s.\n", strerror(global_err_num));
+            exit(global_err_num);
+        }
+        bytes += num_bytes_written;
+        num_bytes -= (size_t)num_bytes_written;
+        file_offset += num_bytes_written;
+    }
+
+}
+
+/*
+ * Writes out everything in the buffer of "results_csv_file" and empties the buffer.
+ */
+static void flush_results_table_csv_file(struct Results_Csv_File* results_csv_file) {
+
+    write_all_bytes(results_csv_file->file_descriptor, results_csv_file->buffer, results_csv_file->buffer_used);
+    results_csv_file->buffer_used = 0;
+
+}
+
+struct Results_Csv_File* open_results_table_csv_file(const char* file_location) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
 
     // Open up file for writing to only
-    FILE * results_table_file = fopen(file_location, FOPEN_OVERWRITE_ONLY_MODE);
+    int file_descriptor = open(file_location, O_WRONLY | O_CREAT | O_TRUNC, RESULTS_CSV_FILE_MODE);
     // Inform user if file didn't open correctly and abort program
-    if (results_table_file == NULL) {
+    if (file_descriptor < 0) {
        int global_err_num = errno;
        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
        exit(global_err_num);
     }
-    // Set buffer size for writing contents of "results_table" to file
-    int func_status = setvbuf(results_table_file, NULL, _IOFBF, buffer_size);
-    // Assert buffer resizing was done correctly.
-    assert(func_status == EXIT_SUCCESS);
+
+    struct Results_Csv_File* results_csv_file = malloc(sizeof(*results_csv_file));
+    assert(results_csv_file != NULL);
+    results_csv_file->file_descriptor = file_descriptor;
+    results_csv_file->buffer = malloc(RESULTS_CSV_WRITE_BUFFER_SIZE);
+    assert(results_csv_file->buffer != NULL);
+    results_csv_file->buffer_used = 0;
+
     // Inform user this program is beginning to write table contents to disk.
     printf(WRITING_TABLE_TO_FILE_MSG, file_location);
 
     // Write table header to disk first
-    fprintf(results_table_file, JOINED_RESULT_TABLE_HEADER);
+    memcpy(results_csv_file->buffer, JOINED_RESULT_TABLE_HEADER, strlen(JOINED_RESULT_TABLE_HEADER));
+    results_csv_file->buffer_used = strlen(JOINED_RESULT_TABLE_HEADER);
 
+    return results_csv_file;
 
-    // Write each row of equijoin results table to disk
-    for (unsigned long row_index = 0l; row_index < results_table->num_records; ++row_index) {
-      
-      // Skip over writing table records to file where customer id and customer name are null values
-      if (results_table->table[row_index].customer_id_customer != NULL_CUSTOMER_ID ||
-          results_table->table[row_index].first_name_customer[NULL_CHARACTER_POS] != NULL_CUSTOMER_NAME) {
-
-          int num_char_written = fprintf(results_table_file, JOINED_RESULT_TABLE_ROW_FORMAT,
-                                                             results_table->table[row_index].time_of_purchase,
-                                                             results_table->table[row_index].customer_id_customer,
-                                                             results_table->table[row_index].first_name_customer,
-                                                             results_table->table[row_index].ean13,
-                                                             results_table->table[row_index].quantity_purchased);
-          // Make sure there are no problems writing each row of results table to disk.
-          assert(num_char_written >= 0);
-      }
+}
 
-   }
+void write_results_table_rows_to_csv_file(struct Results_Csv_File* results_csv_file,
+                                            const struct Joined_Results_Table* results_table,
+                                            unsigned long first_row, unsigned long num_rows) {
+
+    // Assert non-null pointers
+    assert(results_csv_file != NULL);
+    assert(results_table != NULL);
+    assert(results_table->table != NULL);
+    // Rows written MUST be within "results_table"
+    assert(first_row + num_rows <= results_table->num_records);
+
+    // Number of rows guaranteed to fit into an entirely empty buffer
+    const unsigned long rows_per_buffer = RESULTS_CSV_WRITE_BUFFER_SIZE / MAX_JOINED_RESULT_ROW_CSV_LEN;
+    const unsigned long end_row = first_row + num_rows;
+
+    while (first_row < end_row) {
+
+        // Format as many rows as are guaranteed to fit into what's left of the buffer
+        unsigned long rows_that_fit = (RESULTS_CSV_WRITE_BUFFER_SIZE - results_csv_file->buffer_used) /
+                                         MAX_JOINED_RESULT_ROW_CSV_LEN;
+        if (rows_that_fit == 0) {
+            flush_results_table_csv_file(results_csv_file);
+            rows_that_fit = rows_per_buffer;
+        }
+        const unsigned long rows_formatted = (end_row - first_row < rows_that_fit) ?
+                                                end_row - first_row : rows_that_fit;
 
+        results_csv_file->buffer_used += format_results_table_rows_as_csv(results_table, first_row, rows_formatted,
+                                                   results_csv_file->buffer + results_csv_file->buffer_used);
+        first_row += rows_formatted;
+
+    }
+
+}
+
+void close_results_table_csv_file(struct Results_Csv_File* results_csv_file) {
+
+    // Assert non-null pointers
+    assert(results_csv_file != NULL);
+
+    flush_results_table_csv_file(results_csv_file);
+    // Done writing to file; close it
+    int func_status = close(results_csv_file->file_descriptor);
+    assert(func_status == 0);
+    free(results_csv_file->buffer);
+    free(results_csv_file);
+
+}
+
+void write_results_table_to_csv_file(struct Joined_Results_Table* results_table, const char* file_location) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
+    assert(results_table != NULL);
+    assert(results_table->table != NULL);
+
+    struct Results_Csv_File* results_csv_file = open_results_table_csv_file(file_location);
+
+    write_results_table_rows_to_csv_file(results_csv_file, results_table, 0l, results_table->num_records);
+
+    close_results_table_csv_file(results_csv_file);
+
+}
+
+
+/*
+ * A contiguous slice of the joined results table written out by one thread.
+ *   - results_table --- table the slice is part of
+ *   - file_descriptor --- file every slice is written to
+ *   - first_row, num_rows --- rows making up the slice
+ *   - num_bytes --- number of bytes the slice takes up in CSV form
+ *   - file_offset --- where in the file the slice starts
+ *   - thread --- thread handling the slice
+ */
+struct Results_Csv_Slice {
+    const struct Joined_Results_Table* results_table;
+    int file_descriptor;
+    unsigned long first_row;
+    unsigned long num_rows;
+    size_t num_bytes;
+    off_t file_offset;
+    pthread_t thread;
+};
+
+// Thread body measuring how many bytes a slice takes up in CSV form
+static void* measure_results_csv_slice(void* slice_arg) {
+
+    struct Results_Csv_Slice* slice = (struct Results_Csv_Slice*) slice_arg;
+    const unsigned long trace_start = trace_clock_nanosecs();
+    slice->num_bytes = results_table_rows_csv_length(slice->results_table, slice->first_row, slice->num_rows);
+    record_trace_span(TRACE_CATEGORY_WRITE, "measure slice", trace_start);
+    return NULL;
+
+}
+
+// Thread body formatting a slice piece by piece and writing each piece at its place in the file
+static void* write_results_csv_slice(void* slice_arg) {
+
+    struct Results_Csv_Slice* slice = (struct Results_Csv_Slice*) slice_arg;
+    const unsigned long trace_start = trace_clock_nanosecs();
+    const unsigned long rows_per_buffer = RESULTS_CSV_WRITE_BUFFER_SIZE / MAX_JOINED_RESULT_ROW_CSV_LEN;
+    char* buffer = malloc(RESULTS_CSV_WRITE_BUFFER_SIZE);
+    assert(buffer != NULL);
+    off_t file_offset = slice->file_offset;
+
+    for (unsigned long row_index = slice->first_row; row_index < slice->first_row + slice->num_rows;
+                                                                        row_index += rows_per_buffer) {
+        const unsigned long rows_left = slice->first_row + slice->num_rows - row_index;
+        const unsigned long rows_formatted = (rows_left < rows_per_buffer) ? rows_left : rows_per_buffer;
+        const size_t num_bytes = format_results_table_rows_as_csv(slice->results_table, row_index,
+                                                                    rows_formatted, buffer);
+        pwrite_all_bytes(slice->file_descriptor, buffer, num_bytes, file_offset);
+        file_offset += (off_t)num_bytes;
+    }
+
+    // What got written MUST be exactly what was measured
+    assert(file_offset == slice->file_offset + (off_t)slice->num_bytes);
+    free(buffer);
+    record_trace_span(TRACE_CATEGORY_WRITE, "write slice", trace_start);
+    return NULL;
+
+}
+
+void write_results_table_to_csv_file_parallel(struct Joined_Results_Table* results_table, const char* file_location,
+                                                unsigned int num_threads) {
+
+    // Assert non-null pointers
+    assert(file_location != NULL);
+    assert(results_table != NULL);
+    assert(results_table->table != NULL);
+
+    num_threads = resolve_num_threads(num_threads);
+    // No point in having threads without a single row to write
+    if (num_threads > results_table->num_records) {
+        num_threads = (unsigned int) results_table->num_records;
+    }
+    if (num_threads <= 1) {
+        write_results_table_to_csv_file(results_table, file_location);
+        return;
+    }
+
+    // Open up file for writing to only
+    int file_descriptor = open(file_location, O_WRONLY | O_CREAT | O_TRUNC, RESULTS_CSV_FILE_MODE);
+    // Inform user if file didn't open correctly and abort program
+    if (file_descriptor < 0) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    // Inform user this program is beginning to write table contents to disk.
+    printf(WRITING_TABLE_TO_FILE_IN_PARALLEL_MSG, file_location, num_threads);
+
+    struct Results_Csv_Slice* slices = malloc(num_threads * sizeof(*slices));
+    assert(slices != NULL);
+    int thread_status;
+
+    unsigned long first_row = 0;
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        slices[slice_index].results_table = results_table;
+        slices[slice_index].file_descriptor = file_descriptor;
+        slices[slice_index].first_row = first_row;
+        slices[slice_index].num_rows = slice_num_rows(results_table->num_records, num_threads, slice_index);
+        first_row += slices[slice_index].num_rows;
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, measure_results_csv_slice,
+                                                                          &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+
+    // Prefix sum over slice lengths gives where each slice starts, right after the header
+    off_t file_offset = (off_t) strlen(JOINED_RESULT_TABLE_HEADER);
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+        slices[slice_index].file_offset = file_offset;
+        file_offset += (off_t) slices[slice_index].num_bytes;
+    }
+
+    // Size the file up front so that the threads only ever fill in blocks already allocated
+    int func_status = ftruncate(file_descriptor, file_offset);
+    assert(func_status == 0);
+    pwrite_all_bytes(file_descriptor, JOINED_RESULT_TABLE_HEADER, strlen(JOINED_RESULT_TABLE_HEADER), 0);
+
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_create(&(slices[slice_index].thread), NULL, write_results_csv_slice,
+                                                                          &(slices[slice_index]));
+        assert(thread_status == 0);
+    }
+    for (unsigned int slice_index = 0; slice_index < num_threads; ++slice_index) {
+        thread_status = pthread_join(slices[slice_index].thread, NULL);
+        assert(thread_status == 0);
+    }
 
     // Done writing to file; close it
-    fclose(results_table_file);
+    free(slices);
+    func_status = close(file_descriptor);
+    assert(func_status == 0);
 
 }
 
 
 void assert_equijoin_results_tables_equality(const char* first_equijoin_result_table_file,
-                                              const char* second_equijoin_result_table_file) {
+                                              const char* second_equijoin_result_table_file,
+                                              bool is_order_insensitive) {
 
      assert(first_equijoin_result_table_file != NULL);
      assert(second_equijoin_result_table_file != NULL);
 
-     // Ideal buffer size for most SSD's and HDD's for doing file IO
-     const size_t buffer_size = 4096;
-     // Lines read from each file
-     char *line_read_first_file = NULL, *line_read_second_file = NULL;
-     // Sizes of buffer storing line read from each file
-     size_t line_buffer_size_first_file = 0, line_buffer_size_second_file = 0;
-     // Number of characters read per line for each file
-     ssize_t num_char_read_first_file = 0, num_char_read_second_file = 0;
      /*
-      * Pointers used by the "strtok_r" function to keep track of
-      * remaining unparsed data for each file being read.
+      * Compare both files in parallel; any difference found gets
+      * reported to user before the assertion fails.
       */
-     char *rest_of_string_first_file_line, *rest_of_string_second_file_line;
-    
-     // Open up files for reading only
-     FILE * first_equijoin_table_file = open_file_read_only(first_equijoin_result_table_file, buffer_size);
-     FILE * second_equijoin_table_file = open_file_read_only(second_equijoin_result_table_file, buffer_size);
-
-     /*
-      * Read each file line by line and compare if the two different
-      * lines between the two files at the same line number in each file
-      * are identical field for field.
-      */
-     while (true) {
-     
-        num_char_read_first_file = getline(&line_read_first_file, &line_buffer_size_first_file,
-                                                                        first_equijoin_table_file);
-        num_char_read_second_file = getline(&line_read_second_file, &line_buffer_size_second_file,
-                                                                        second_equijoin_table_file);
-
-        if (num_char_read_first_file < 0 && num_char_read_second_file < 0) {
-            // EOF reached for both files; exit loop
-            break;
-        } else {
-            /*
-             * Read tokens from each line read and assert that first
-             * token read from first file is the same as first token
-             * read from second file, second token read from first
-             * file is the same as second token read from second file,
-             * etc.
-             */
-            char* token_first_file = strtok_r(line_read_first_file, CSV_DELIMITERS,
-                                                     &rest_of_string_first_file_line);
-            char* token_second_file = strtok_r(line_read_second_file, CSV_DELIMITERS,
-                                                     &rest_of_string_second_file_line);
-            assert(strcmp(token_first_file, token_second_file) == 0);
-            for (int token_read_count = 1;
-                 token_read_count < JOINED_RESULTS_TABLE_ROW_FIELDS_COUNT;
-                                                         ++token_read_count) {
-                token_first_file = strtok_r(NULL, CSV_DELIMITERS,
-                                                     &rest_of_string_first_file_line);
-                token_second_file = strtok_r(NULL, CSV_DELIMITERS,
-                                                     &rest_of_string_second_file_line); 
-                assert(strcmp(token_first_file, token_second_file) == 0);
-            }
-        }
-
-     }
+     const bool are_files_equal = compare_results_table_files(first_equijoin_result_table_file,
+                                                                second_equijoin_result_table_file,
+                                                                is_order_insensitive, RESULTS_VERIFIER_THREADS);
+     assert(are_files_equal);
 
      /*
       * If this point has been reached successfully, print
@@ -532,10 +1105,6 @@ void assert_equijoin_results_tables_equality(const char* first_equijoin_result_t
       */
      printf(ASSERTION_PASSED_INFORM_USER);
 
-     // Done with files, close them
-     fclose(first_equijoin_table_file);
-     fclose(second_equijoin_table_file);
-
 }
 
 
@@ -0,0 +1,308 @@
+
+// =================================================================================================
+// File description:
+// Contains implementations of host functions for recording spans of host threads and OpenCL
+// commands on a single timeline and for writing them as a Chrome trace-event JSON document.
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by the functions in this file with custom headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <bsd/string.h>
+#include <sys/syscall.h>
+#include "monotonic_clock.h"
+#include "trace_events.h"
+
+// Name of each profiling phase, indexed by "enum Opencl_Profiling_Phase", as a device "thread" name
+static const char* const trace_device_phase_names[NUM_PROFILING_PHASES] = { "upload", "kernel", "readback" };
+
+/*
+ * A single span of the trace.
+ *   - name, category --- what the span did, and its TRACE_CATEGORY_*
+ *   - process_id, thread_id --- where trace viewers show the span (see TRACE_HOST_PROCESS_ID)
+ *   - started, ended --- host clock timestamps in nanoseconds
+ *   - is_opencl_command --- whether the span is an OpenCL command, with the arguments below
+ *   - queued_nanosecs --- nanoseconds the command waited between being queued and starting
+ *   - num_bytes, num_rows --- bytes moved and table rows worked on by the command
+ */
+struct Trace_Event {
+    char name[TRACE_EVENT_NAME_MAX_LEN];
+    const char* category;
+    unsigned int process_id;
+    long thread_id;
+    unsigned long started;
+    unsigned long ended;
+    bool is_opencl_command;
+    unsigned long queued_nanosecs;
+    size_t num_bytes;
+    unsigned long num_rows;
+};
+
+/*
+ * Every span recorded by any thread, guarded by "lock".
+ *   - events --- spans recorded so far (NULL until tracing starts)
+ *   - num_events --- number of spans recorded so far
+ *   - num_dropped_events --- spans that didn't fit into "events"
+ *   - origin --- host clock timestamp of when tracing started, which the trace counts from
+ */
+static struct {
+    pthread_mutex_t lock;
+    struct Trace_Event* events;
+    unsigned int num_events;
+    unsigned int num_dropped_events;
+    unsigned long origin;
+} trace = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0 };
+
+// =================================================================================================
+
+unsigned long trace_clock_nanosecs(void) {
+
+    return monotonic_clock_nanosecs();
+
+}
+
+void start_tracing(void) {
+
+    pthread_mutex_lock(&(trace.lock));
+    if (trace.events == NULL) {
+        trace.events = calloc(MAX_TRACE_EVENTS, sizeof(*(trace.events)));
+        assert(trace.events != NULL);
+        trace.origin = trace_clock_nanosecs();
+    }
+    pthread_mutex_unlock(&(trace.lock));
+
+}
+
+bool is_tracing(void) {
+
+    pthread_mutex_lock(&(trace.lock));
+    const bool is_started = trace.events != NULL;
+    pthread_mutex_unlock(&(trace.lock));
+    return is_started;
+
+}
+
+/*
+ * Returns where to record the next span, with "trace.lock" held, or NULL (with the lock released)
+ * if not tracing or if there's no room left; the caller fills it in and releases the lock.
+ */
+static struct Trace_Event* lock_next_trace_event(void) {
+
+    pthread_mutex_lock(&(trace.lock));
+    if (trace.events == NULL || trace.num_events == MAX_TRACE_EVENTS) {
+        if (trace.events != NULL) {
+            ++(trace.num_dropped_events);
+        }
+        pthread_mutex_unlock(&(trace.lock));
+        return NULL;
+    }
+    struct Trace_Event* event = &(trace.events[trace.num_events++]);
+    memset(event, 0, sizeof(*event));
+    return event;
+
+}
+
+void record_trace_span(const char* category, const char* name, unsigned long start_nanosecs) {
+
+    // No null pointers allowed
+    assert(category != NULL);
+    assert(name != NULL);
+
+    const unsigned long end_nanosecs = trace_clock_nanosecs();
+    struct Trace_Event* event = lock_next_trace_event();
+    if (event == NULL) {
+        return;
+    }
+    strlcpy(event->name, name, TRACE_EVENT_NAME_MAX_LEN);
+    event->category = category;
+    event->process_id = TRACE_HOST_PROCESS_ID;
+    event->thread_id = syscall(SYS_gettid);
+    event->started = start_nanosecs;
+    event->ended = end_nanosecs;
+    pthread_mutex_unlock(&(trace.lock));
+
+}
+
+void calibrate_trace_device_clock(cl_command_queue queue, struct Trace_Device_Clock* clock) {
+
+    // No null pointers allowed
+    assert(clock != NULL);
+
+    clock->offset_nanosecs = 0;
+    clock->is_calibrated = false;
+    if (!is_tracing()) {
+        return;
+    }
+
+    cl_device_id device;
+    cl_int func_error_code = clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL);
+    assert(func_error_code == CL_SUCCESS);
+
+    /*
+     * Device and host timer read at the same moment, and the host timer read again between two
+     * reads of the trace's clock, since the runtime's host timer needn't be the same clock
+     */
+    cl_ulong device_timestamp, host_timestamp, host_timer_timestamp;
+    if (clGetDeviceAndHostTimer(device, &device_timestamp, &host_timestamp) == CL_SUCCESS) {
+        const unsigned long before_nanosecs = trace_clock_nanosecs();
+        func_error_code = clGetHostTimer(device, &host_timer_timestamp);
+        const unsigned long after_nanosecs = trace_clock_nanosecs();
+        if (func_error_code == CL_SUCCESS) {
+            const long long host_timer_offset = (long long) (before_nanosecs + (after_nanosecs - before_nanosecs) / 2) -
+                                                (long long) host_timer_timestamp;
+            clock->offset_nanosecs = (long long) host_timestamp - (long long) device_timestamp + host_timer_offset;
+            clock->is_calibrated = true;
+            printf(TRACE_DEVICE_CLOCK_MSG, "clGetDeviceAndHostTimer", clock->offset_nanosecs);
+            return;
+        }
+    }
+
+    // Devices without a host timer (before OpenCL 2.1): the host sees a marker end a little after it did
+    cl_event marker_event;
+    cl_ulong marker_ended;
+    func_error_code = clEnqueueMarkerWithWaitList(queue, 0, NULL, &marker_event);
+    func_error_code |= clWaitForEvents(1, &marker_event);
+    const unsigned long marker_seen_nanosecs = trace_clock_nanosecs();
+    func_error_code |= clGetEventProfilingInfo(marker_event, CL_PROFILING_COMMAND_END, sizeof(marker_ended),
+                                                 &marker_ended, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    clReleaseEvent(marker_event);
+    clock->offset_nanosecs = (long long) marker_seen_nanosecs - (long long) marker_ended;
+    clock->is_calibrated = true;
+    printf(TRACE_DEVICE_CLOCK_MSG, "a marker command", clock->offset_nanosecs);
+
+}
+
+void record_opencl_profiling_trace(const struct Opencl_Profiling_Report* report,
+                                     const struct Trace_Device_Clock* clock) {
+
+    // No null pointers allowed
+    assert(report != NULL);
+    assert(clock != NULL);
+
+    if (!clock->is_calibrated) {
+        return;
+    }
+    for (unsigned int command_index = 0; command_index < report->num_commands; ++command_index) {
+        const struct Opencl_Command_Profile* command = &(report->commands[command_index]);
+        struct Trace_Event* event = lock_next_trace_event();
+        if (event == NULL) {
+            return;
+        }
+        strlcpy(event->name, command->label, TRACE_EVENT_NAME_MAX_LEN);
+        event->category = TRACE_CATEGORY_OPENCL;
+        event->process_id = TRACE_DEVICE_PROCESS_ID;
+        event->thread_id = (long) command->phase + 1;
+        event->started = (unsigned long) ((long long) command->started + clock->offset_nanosecs);
+        event->ended = (unsigned long) ((long long) command->ended + clock->offset_nanosecs);
+        event->is_opencl_command = true;
+        event->queued_nanosecs = (command->started >= command->queued) ? command->started - command->queued : 0;
+        event->num_bytes = command->num_bytes;
+        event->num_rows = command->num_rows;
+        pthread_mutex_unlock(&(trace.lock));
+    }
+
+}
+
+/*
+ * Returns the trace timestamp (microseconds since tracing started, which trace viewers expect) of
+ * host clock timestamp "nanosecs"; spans moved from a device clock may begin slightly before.
+ */
+static inline double trace_microsecs(unsigned long nanosecs) {
+    return ((double) nanosecs - (double) trace.origin) / 1000.0;
+}
+
+/*
+ * Writes a metadata event naming the "thread" of every distinct process and thread ID of the trace
+ * (host threads after their ID, the process's own thread "main") and naming both processes.
+ */
+static void write_trace_metadata_events(FILE* trace_file) {
+
+    fprintf(trace_file, "    {\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %u, \"tid\": 0,"
+                          " \"args\": {\"name\": \"host\"}},\n", TRACE_HOST_PROCESS_ID);
+    fprintf(trace_file, "    {\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %u, \"tid\": 0,"
+                          " \"args\": {\"name\": \"OpenCL device\"}}", TRACE_DEVICE_PROCESS_ID);
+
+    const long main_thread_id = (long) getpid();
+    for (unsigned int event_index = 0; event_index < trace.num_events; ++event_index) {
+        const struct Trace_Event* event = &(trace.events[event_index]);
+        bool is_first_of_thread = true;
+        for (unsigned int earlier_index = 0; earlier_index < event_index && is_first_of_thread; ++earlier_index) {
+            is_first_of_thread = trace.events[earlier_index].process_id != event->process_id ||
+                                 trace.events[earlier_index].thread_id != event->thread_id;
+        }
+        if (!is_first_of_thread) {
+            continue;
+        }
+        fprintf(trace_file, ",\n    {\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %u, \"tid\": %ld,"
+                              " \"args\": {\"name\": \"", event->process_id, event->thread_id);
+        if (event->process_id == TRACE_DEVICE_PROCESS_ID) {
+            fprintf(trace_file, "%s\"}}", trace_device_phase_names[event->thread_id - 1]);
+        } else if (event->thread_id == main_thread_id) {
+            fprintf(trace_file, "main\"}}");
+        } else {
+            fprintf(trace_file, "thread %ld\"}}", event->thread_id);
+        }
+    }
+
+}
+
+void write_trace_to_json_file(const char* file_location) {
+
+    // No null pointers allowed
+    assert(file_location != NULL);
+
+    if (!is_tracing()) {
+        return;
+    }
+    pthread_mutex_lock(&(trace.lock));
+
+    FILE * trace_file = fopen(file_location, "w");
+    // Inform user if file didn't open correctly and abort program
+    if (trace_file == NULL) {
+       int global_err_num = errno;
+       fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+       exit(global_err_num);
+    }
+    if (trace.num_dropped_events > 0) {
+        printf(TRACE_EVENTS_DROPPED_MSG, trace.num_dropped_events);
+    }
+    printf(TRACE_JSON_MSG, trace.num_events, file_location);
+
+    // Complete ("X") events; names are this program's own labels, which need no escaping
+    fprintf(trace_file, "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [\n");
+    write_trace_metadata_events(trace_file);
+    for (unsigned int event_index = 0; event_index < trace.num_events; ++event_index) {
+        const struct Trace_Event* event = &(trace.events[event_index]);
+        fprintf(trace_file, ",\n    {\"ph\": \"X\", \"name\": \"%s\", \"cat\": \"%s\", \"pid\": %u, \"tid\": %ld,"
+                              " \"ts\": %.3lf, \"dur\": %.3lf", event->name, event->category, event->process_id,
+                  event->thread_id, trace_microsecs(event->started),
+                  (event->ended >= event->started) ? (double) (event->ended - event->started) / 1000.0 : 0.0);
+        if (event->is_opencl_command) {
+            fprintf(trace_file, ", \"args\": {\"queued_us\": %.3lf, \"bytes\": %zu, \"rows\": %lu}",
+                      (double) event->queued_nanosecs / 1000.0, event->num_bytes, event->num_rows);
+        }
+        fprintf(trace_file, "}");
+    }
+    fprintf(trace_file, "\n  ]\n}\n");
+
+    // Done writing to file; close it
+    fclose(trace_file);
+    pthread_mutex_unlock(&(trace.lock));
+
+}
+
+// =================================================================================================
@@ -0,0 +1,603 @@
+
+// =================================================================================================
+// Project:
+// Native generator of customer and purchases tables; built with "make generator".
+//
+// Original file information:
+// Institution.... SURFsara <www.surfsara.nl>
+// Original Author......... Cedric Nugteren <cedric.nugteren@surfsara.nl>
+// "Remixing" programmer.. Ted Li
+// Changed at..... 2021-05-15
+// License........ MIT license
+//
+// =================================================================================================
+
+// Libraries used by this program with custom headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "data_structures_opencl.h"
+#include "table_utilities.h"
+#include "monotonic_clock.h"
+#include "host_threads.h"
+#include "equijoin_data_generator.h"
+
+// First names customers are given, all shorter than FIRST_NAME_MAX_LEN
+static const char* const GENERATOR_FIRST_NAMES[] = {
+    "James", "Mary", "Robert", "Patricia", "John", "Jennifer", "Michael", "Linda", "David", "Elizabeth",
+    "William", "Barbara", "Richard", "Susan", "Joseph", "Jessica", "Thomas", "Sarah", "Christopher", "Karen",
+    "Charles", "Lisa", "Daniel", "Nancy", "Matthew", "Betty", "Anthony", "Sandra", "Mark", "Margaret",
+    "Donald", "Ashley", "Steven", "Kimberly", "Andrew", "Emily", "Paul", "Donna", "Joshua", "Michelle",
+    "Kenneth", "Carol", "Kevin", "Amanda", "Brian", "Melissa", "George", "Deborah", "Timothy", "Stephanie",
+    "Ronald", "Dorothy", "Jason", "Rebecca", "Edward", "Sharon", "Jeffrey", "Laura", "Ryan", "Cynthia",
+    "Jacob", "Amy", "Gary", "Kathleen", "Nicholas", "Angela", "Eric", "Shirley", "Jonathan", "Brenda",
+    "Stephen", "Emma", "Larry", "Anna", "Justin", "Pamela", "Scott", "Nicole", "Brandon", "Samantha"
+};
+#define NUM_GENERATOR_FIRST_NAMES (sizeof(GENERATOR_FIRST_NAMES) / sizeof(GENERATOR_FIRST_NAMES[0]))
+
+// Tables and formats the generator writes
+enum Generated_Table {
+    GENERATED_CUSTOMER_TABLE = 0,
+    GENERATED_PURCHASES_TABLE
+};
+enum Generated_Format {
+    GENERATED_FORMAT_CSV = 0,
+    GENERATED_FORMAT_BINARY
+};
+
+/*
+ * Everything given on the command-line.
+ *   - num_customers, num_purchases --- number of rows of each table
+ *   - active_ratio --- fraction of customers who are active
+ *   - distribution, zipf_exponent --- distribution customer IDs of purchases are drawn from
+ *   - seed --- seed of every random value generated
+ *   - start_time --- "epochTimePurchased" timestamp of the first purchase
+ *   - num_threads --- threads generating rows (0 for one per online CPU)
+ *   - format --- whether to write CSV or binary files
+ *   - customer_file_location, purchases_file_location --- files tables are written to
+ */
+struct Generator_Options {
+    unsigned long num_customers;
+    unsigned long num_purchases;
+    double active_ratio;
+    enum Customer_Id_Distribution distribution;
+    double zipf_exponent;
+    unsigned long seed;
+    unsigned long start_time;
+    unsigned int num_threads;
+    enum Generated_Format format;
+    const char* customer_file_location;
+    const char* purchases_file_location;
+};
+
+/*
+ * One chunk of rows of a table for a thread to generate.
+ *   - options, zipf_sampler --- what to generate
+ *   - table --- table the rows belong to
+ *   - first_row, end_row --- rows of the chunk
+ *   - first_time_of_purchase --- timestamp of the chunk's first purchase
+ *   - buffer, length --- where the chunk's rows are written to, in the options' format, and how
+ *                        many bytes they take up
+ */
+struct Generator_Chunk {
+    const struct Generator_Options* options;
+    const struct Zipf_Sampler* zipf_sampler;
+    enum Generated_Table table;
+    unsigned long first_row;
+    unsigned long end_row;
+    unsigned long first_time_of_purchase;
+    char* buffer;
+    size_t length;
+};
+
+/*
+ * Range of chunks of the purchases table for a thread to add up the nanoseconds between the
+ * purchases of, storing the sum of each chunk in "chunk_ns_gaps".
+ */
+struct Generator_Gap_Range {
+    const struct Generator_Options* options;
+    unsigned long first_chunk;
+    unsigned long end_chunk;
+    unsigned long* chunk_ns_gaps;
+};
+
+// =================================================================================================
+
+// Finalizer of SplitMix64, which turns consecutive integers into well-mixed 64 bit values
+static inline unsigned long mix_bits(unsigned long value) {
+
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ul;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebul;
+    return value ^ (value >> 31);
+
+}
+
+unsigned long generator_random_bits(unsigned long seed, unsigned long stream, unsigned long counter) {
+
+    return mix_bits(mix_bits(seed ^ (stream * 0x9e3779b97f4a7c15ul)) + counter * 0xd1b54a32d192ed03ul);
+
+}
+
+// Uniform double in [0, 1) from the value "counter" of "stream"
+static inline double generator_random_unit(unsigned long seed, unsigned long stream, unsigned long counter) {
+
+    return (generator_random_bits(seed, stream, counter) >> 11) * (1.0 / (double) (1ul << 53));
+
+}
+
+// Uniform integer in ["min_value", "max_value"] from the value "counter" of "stream"
+static inline unsigned long generator_random_range(unsigned long seed, unsigned long stream, unsigned long counter,
+                                                     unsigned long min_value, unsigned long max_value) {
+
+    return min_value + generator_random_bits(seed, stream, counter) % (max_value - min_value + 1);
+
+}
+
+// log(1 + x) / x and (exp(x) - 1) / x, accurate for x close to 0
+static double zipf_helper1(double x) {
+
+    return (fabs(x) > 1e-8) ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+
+}
+
+static double zipf_helper2(double x) {
+
+    return (fabs(x) > 1e-8) ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+
+}
+
+// Unnormalized density h(x) = 1 / x^exponent, its integral H and the inverse of H
+static double zipf_h(double exponent, double x) {
+
+    return exp(-exponent * log(x));
+
+}
+
+static double zipf_h_integral(double exponent, double x) {
+
+    const double log_x = log(x);
+    return zipf_helper2((1.0 - exponent) * log_x) * log_x;
+
+}
+
+static double zipf_h_integral_inverse(double exponent, double x) {
+
+    double t = x * (1.0 - exponent);
+    if (t < -1.0) {
+        // Only happens through rounding errors
+        t = -1.0;
+    }
+    return exp(zipf_helper1(t) * x);
+
+}
+
+void init_zipf_sampler(struct Zipf_Sampler* sampler, unsigned long num_elements, double exponent) {
+
+    // No null pointers allowed
+    assert(sampler != NULL);
+    assert(num_elements >= 1);
+    assert(exponent > 0.0);
+
+    sampler->num_elements = num_elements;
+    sampler->exponent = exponent;
+    sampler->h_integral_x1 = zipf_h_integral(exponent, 1.5) - 1.0;
+    sampler->h_integral_num_elements = zipf_h_integral(exponent, num_elements + 0.5);
+    sampler->s = 2.0 - zipf_h_integral_inverse(exponent, zipf_h_integral(exponent, 2.5) - zipf_h(exponent, 2.0));
+
+}
+
+unsigned long sample_zipf(const struct Zipf_Sampler* sampler, unsigned long seed, unsigned long stream,
+                            unsigned long first_counter) {
+
+    for (unsigned long counter = first_counter; ; ++counter) {
+        const double u = sampler->h_integral_num_elements + generator_random_unit(seed, stream, counter) *
+                           (sampler->h_integral_x1 - sampler->h_integral_num_elements);
+        const double x = zipf_h_integral_inverse(sampler->exponent, u);
+        unsigned long k = (unsigned long) (x + 0.5);
+        if (k < 1) {
+            k = 1;
+        } else if (k > sampler->num_elements) {
+            k = sampler->num_elements;
+        }
+        // Accepted straight away most of the time; otherwise tried again with the next value
+        if (k - x <= sampler->s ||
+            u >= zipf_h_integral(sampler->exponent, k + 0.5) - zipf_h(sampler->exponent, (double) k)) {
+            return k;
+        }
+    }
+
+}
+
+// =================================================================================================
+
+// Nanoseconds between purchase "row_index" and the next one
+static inline unsigned long purchase_ns_gap(const struct Generator_Options* options, unsigned long row_index) {
+
+    return generator_random_range(options->seed, PURCHASES_TABLE_STREAM_BIT | row_index, PURCHASE_DRAW_NS_GAP,
+                                    GENERATOR_MIN_NS_GAP, GENERATOR_MAX_NS_GAP);
+
+}
+
+// Writes a valid EAN13 barcode (twelve random digits and their check digit) to "ean13"
+static void generate_ean13(unsigned long random_bits, char* ean13) {
+
+    unsigned long digits = random_bits % 1000000000000ul;
+    unsigned int check_sum = 0;
+    for (int digit_index = GENERATOR_EAN13_DATA_DIGITS - 1; digit_index >= 0; --digit_index) {
+        const unsigned int digit = (unsigned int) (digits % 10);
+        digits /= 10;
+        ean13[digit_index] = (char) ('0' + digit);
+        // Digits at odd positions (counting from 1) weigh 1, those at even positions 3
+        check_sum += (digit_index % 2 == 0) ? digit : 3 * digit;
+    }
+    ean13[GENERATOR_EAN13_DATA_DIGITS] = (char) ('0' + (10 - check_sum % 10) % 10);
+    ean13[GENERATOR_EAN13_DATA_DIGITS + 1] = '\0';
+
+}
+
+static void generate_customer_row(const struct Generator_Options* options, unsigned long row_index,
+                                    struct Hashed_Customer_Table_Row* row) {
+
+    memset(row, 0, sizeof(*row));
+    row->customer_id = row_index + 1;
+    strcpy(row->first_name, GENERATOR_FIRST_NAMES[generator_random_bits(options->seed, row_index,
+                                                    CUSTOMER_DRAW_FIRST_NAME) % NUM_GENERATOR_FIRST_NAMES]);
+    row->active_customer = (generator_random_unit(options->seed, row_index, CUSTOMER_DRAW_ACTIVE) <
+                              options->active_ratio) ? CUSTOMER_ACTIVE_FLAG : CUSTOMER_INACTIVE_FLAG;
+
+}
+
+static void generate_purchases_row(const struct Generator_Options* options, const struct Zipf_Sampler* zipf_sampler,
+                                     unsigned long row_index, unsigned long time_of_purchase,
+                                       struct Purchases_Table_Row* row) {
+
+    const unsigned long stream = PURCHASES_TABLE_STREAM_BIT | row_index;
+    memset(row, 0, sizeof(*row));
+    row->time_of_purchase = time_of_purchase;
+    row->customer_id = (options->distribution == CUSTOMER_ID_DISTRIBUTION_ZIPF) ?
+                         sample_zipf(zipf_sampler, options->seed, stream, PURCHASE_DRAW_CUSTOMER_ID) :
+                         generator_random_range(options->seed, stream, PURCHASE_DRAW_CUSTOMER_ID, 1,
+                                                  options->num_customers);
+    generate_ean13(generator_random_bits(options->seed, stream, PURCHASE_DRAW_EAN13), row->ean13);
+    row->quantity_purchased = generator_random_range(options->seed, stream, PURCHASE_DRAW_QUANTITY,
+                                                       GENERATOR_MIN_QUANTITY, GENERATOR_MAX_QUANTITY);
+
+}
+
+// Thread function generating the rows of a "Generator_Chunk" into its buffer
+static void* generate_chunk(void* chunk_arg) {
+
+    struct Generator_Chunk* chunk = chunk_arg;
+    const struct Generator_Options* options = chunk->options;
+    unsigned long time_of_purchase = chunk->first_time_of_purchase;
+    chunk->length = 0;
+
+    for (unsigned long row_index = chunk->first_row; row_index < chunk->end_row; ++row_index) {
+        char* row_text = chunk->buffer + chunk->length;
+        if (chunk->table == GENERATED_CUSTOMER_TABLE) {
+            struct Hashed_Customer_Table_Row row;
+            generate_customer_row(options, row_index, &row);
+            if (options->format == GENERATED_FORMAT_BINARY) {
+                memcpy(row_text, &row, sizeof(row));
+                chunk->length += sizeof(row);
+            } else {
+                chunk->length += (size_t) snprintf(row_text, GENERATOR_MAX_ROW_LEN, HASHED_CUSTOMER_TABLE_ROW_FORMAT,
+                                                     row.customer_id, row.first_name, row.active_customer);
+            }
+        } else {
+            struct Purchases_Table_Row row;
+            generate_purchases_row(options, chunk->zipf_sampler, row_index, time_of_purchase, &row);
+            time_of_purchase += purchase_ns_gap(options, row_index);
+            if (options->format == GENERATED_FORMAT_BINARY) {
+                memcpy(row_text, &row, sizeof(row));
+                chunk->length += sizeof(row);
+            } else {
+                chunk->length += (size_t) snprintf(row_text, GENERATOR_MAX_ROW_LEN, PURCHASES_TABLE_ROW_FORMAT,
+                                                     row.time_of_purchase, row.customer_id, row.ean13,
+                                                     row.quantity_purchased);
+            }
+        }
+    }
+    return NULL;
+
+}
+
+// Thread function adding up the nanoseconds between the purchases of each chunk of a "Generator_Gap_Range"
+static void* sum_chunk_ns_gaps(void* range_arg) {
+
+    struct Generator_Gap_Range* range = range_arg;
+    for (unsigned long chunk_index = range->first_chunk; chunk_index < range->end_chunk; ++chunk_index) {
+        const unsigned long first_row = chunk_index * GENERATOR_CHUNK_ROWS;
+        const unsigned long end_row = (first_row + GENERATOR_CHUNK_ROWS < range->options->num_purchases) ?
+                                         first_row + GENERATOR_CHUNK_ROWS : range->options->num_purchases;
+        unsigned long ns_gaps = 0;
+        for (unsigned long row_index = first_row; row_index < end_row; ++row_index) {
+            ns_gaps += purchase_ns_gap(range->options, row_index);
+        }
+        range->chunk_ns_gaps[chunk_index] = ns_gaps;
+    }
+    return NULL;
+
+}
+
+/*
+ * Returns the timestamp of the first purchase of each chunk of the purchases table; adding up
+ * the gaps of every chunk is spread over the threads, since each timestamp depends on every
+ * purchase before it.
+ */
+static unsigned long* get_chunk_first_times_of_purchase(const struct Generator_Options* options,
+                                                          unsigned long num_chunks) {
+
+    unsigned long* chunk_times = malloc((num_chunks > 0 ? num_chunks : 1) * sizeof(*chunk_times));
+    assert(chunk_times != NULL);
+    pthread_t* threads = malloc(options->num_threads * sizeof(*threads));
+    struct Generator_Gap_Range* ranges = malloc(options->num_threads * sizeof(*ranges));
+    assert(threads != NULL && ranges != NULL);
+
+    const unsigned long chunks_per_thread = (num_chunks + options->num_threads - 1) / options->num_threads;
+    for (unsigned int thread_index = 0; thread_index < options->num_threads; ++thread_index) {
+        const unsigned long first_chunk = thread_index * chunks_per_thread;
+        ranges[thread_index] = (struct Generator_Gap_Range) {
+            options, (first_chunk < num_chunks) ? first_chunk : num_chunks,
+            (first_chunk + chunks_per_thread < num_chunks) ? first_chunk + chunks_per_thread : num_chunks, chunk_times
+        };
+        int func_status = pthread_create(&(threads[thread_index]), NULL, sum_chunk_ns_gaps, &(ranges[thread_index]));
+        assert(func_status == 0);
+    }
+    for (unsigned int thread_index = 0; thread_index < options->num_threads; ++thread_index) {
+        pthread_join(threads[thread_index], NULL);
+    }
+
+    // Exclusive prefix sum of the gaps of every chunk turns them into the chunks' first timestamps
+    unsigned long time_of_purchase = options->start_time;
+    for (unsigned long chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
+        const unsigned long ns_gaps = chunk_times[chunk_index];
+        chunk_times[chunk_index] = time_of_purchase;
+        time_of_purchase += ns_gaps;
+    }
+
+    free(ranges);
+    free(threads);
+    return chunk_times;
+
+}
+
+/*
+ * Generates "table" into the file at "file_location", "num_threads" chunks at a time: each thread
+ * generates a chunk into its own buffer, and the buffers are written out in order.
+ */
+static void generate_table(const struct Generator_Options* options, const struct Zipf_Sampler* zipf_sampler,
+                             enum Generated_Table table, const char* file_location) {
+
+    const char* table_name = (table == GENERATED_CUSTOMER_TABLE) ? "Customer" : "Purchases";
+    const unsigned long num_rows = (table == GENERATED_CUSTOMER_TABLE) ? options->num_customers :
+                                                                         options->num_purchases;
+    printf(GENERATING_TABLE_MSG, num_rows, table_name, file_location, options->num_threads);
+    const double start_time = monotonic_clock_secs();
+
+    FILE* table_file = fopen(file_location, FOPEN_OVERWRITE_ONLY_MODE);
+    // Inform user if file didn't open correctly and abort program
+    if (table_file == NULL) {
+        int global_err_num = errno;
+        fprintf(stderr, "Error opening %s: %s.\n", file_location, strerror(global_err_num));
+        exit(global_err_num);
+    }
+    size_t num_items_written;
+    if (options->format == GENERATED_FORMAT_BINARY) {
+        struct Table_Binary_File_Header header = {
+            TABLE_BINARY_FILE_MAGIC,
+            (table == GENERATED_CUSTOMER_TABLE) ? sizeof(struct Hashed_Customer_Table_Row) :
+                                                  sizeof(struct Purchases_Table_Row),
+            num_rows
+        };
+        num_items_written = fwrite(&header, sizeof(header), 1, table_file);
+    } else {
+        const char* header = (table == GENERATED_CUSTOMER_TABLE) ? HASHED_CUSTOMER_TABLE_HEADER : PURCHASES_TABLE_HEADER;
+        num_items_written = fwrite(header, strlen(header), 1, table_file);
+    }
+    assert(num_items_written == 1);
+
+    const unsigned long num_chunks = (num_rows + GENERATOR_CHUNK_ROWS - 1) / GENERATOR_CHUNK_ROWS;
+    unsigned long* chunk_times = (table == GENERATED_PURCHASES_TABLE) ?
+                                   get_chunk_first_times_of_purchase(options, num_chunks) : NULL;
+    pthread_t* threads = malloc(options->num_threads * sizeof(*threads));
+    struct Generator_Chunk* chunks = malloc(options->num_threads * sizeof(*chunks));
+    assert(threads != NULL && chunks != NULL);
+    for (unsigned int thread_index = 0; thread_index < options->num_threads; ++thread_index) {
+        chunks[thread_index].buffer = malloc(GENERATOR_CHUNK_ROWS * GENERATOR_MAX_ROW_LEN);
+        assert(chunks[thread_index].buffer != NULL);
+    }
+
+    for (unsigned long first_chunk = 0; first_chunk < num_chunks; first_chunk += options->num_threads) {
+        const unsigned int num_round_chunks = (num_chunks - first_chunk < options->num_threads) ?
+                                                (unsigned int) (num_chunks - first_chunk) : options->num_threads;
+        for (unsigned int thread_index = 0; thread_index < num_round_chunks; ++thread_index) {
+            const unsigned long chunk_index = first_chunk + thread_index;
+            struct Generator_Chunk* chunk = &(chunks[thread_index]);
+            chunk->options = options;
+            chunk->zipf_sampler = zipf_sampler;
+            chunk->table = table;
+            chunk->first_row = chunk_index * GENERATOR_CHUNK_ROWS;
+            chunk->end_row = (chunk->first_row + GENERATOR_CHUNK_ROWS < num_rows) ?
+                               chunk->first_row + GENERATOR_CHUNK_ROWS : num_rows;
+            chunk->first_time_of_purchase = (chunk_times != NULL) ? chunk_times[chunk_index] : 0;
+            int func_status = pthread_create(&(threads[thread_index]), NULL, generate_chunk, chunk);
+            assert(func_status == 0);
+        }
+        for (unsigned int thread_index = 0; thread_index < num_round_chunks; ++thread_index) {
+            pthread_join(threads[thread_index], NULL);
+            num_items_written = fwrite(chunks[thread_index].buffer, chunks[thread_index].length, 1, table_file);
+            assert(num_items_written == 1);
+        }
+    }
+
+    // Done writing to file; close it
+    int func_status = fclose(table_file);
+    assert(func_status == 0);
+    printf(GENERATED_TABLE_MSG, table_name, file_location, monotonic_clock_secs() - start_time);
+
+    for (unsigned int thread_index = 0; thread_index < options->num_threads; ++thread_index) {
+        free(chunks[thread_index].buffer);
+    }
+    free(chunks);
+    free(threads);
+    free(chunk_times);
+
+}
+
+// =================================================================================================
+
+// Parses "option_value" of "option_name" as an unsigned number; exits if it can't be understood
+static unsigned long parse_unsigned_option(const char* option_name, const char* option_value) {
+
+    char* value_end;
+    errno = 0;
+    unsigned long value = strtoul(option_value, &value_end, 10);
+    if (errno != 0 || value_end == option_value || *value_end != '\0' || *option_value == '-') {
+        fprintf(stderr, GENERATOR_INVALID_OPTION_MESSAGE, option_value, option_name);
+        exit(EXIT_FAILURE);
+    }
+    return value;
+
+}
+
+// Parses "option_value" of "option_name" as a number from "min_value" to "max_value"
+static double parse_double_option(const char* option_name, const char* option_value, double min_value,
+                                    double max_value) {
+
+    char* value_end;
+    errno = 0;
+    double value = strtod(option_value, &value_end);
+    if (errno != 0 || value_end == option_value || *value_end != '\0' || !(value >= min_value && value <= max_value)) {
+        fprintf(stderr, GENERATOR_INVALID_OPTION_MESSAGE, option_value, option_name);
+        exit(EXIT_FAILURE);
+    }
+    return value;
+
+}
+
+static void parse_generator_options(int argc, char* argv[], struct Generator_Options* options) {
+
+    static const struct option long_options[] = {
+        {"customers", required_argument, NULL, 'c'},
+        {"purchases", required_argument, NULL, 'p'},
+        {"active-ratio", required_argument, NULL, 'a'},
+        {"distribution", required_argument, NULL, 'd'},
+        {"zipf-exponent", required_argument, NULL, 'z'},
+        {"seed", required_argument, NULL, 's'},
+        {"start-time", required_argument, NULL, 'T'},
+        {"threads", required_argument, NULL, 't'},
+        {"format", required_argument, NULL, 'f'},
+        {"customer-file", required_argument, NULL, 'C'},
+        {"purchases-file", required_argument, NULL, 'P'},
+        {NULL, 0, NULL, 0}
+    };
+
+    options->num_customers = 0;
+    options->num_purchases = 0;
+    options->active_ratio = DEFAULT_GENERATOR_ACTIVE_RATIO;
+    options->distribution = CUSTOMER_ID_DISTRIBUTION_UNIFORM;
+    options->zipf_exponent = DEFAULT_GENERATOR_ZIPF_EXPONENT;
+    options->seed = DEFAULT_GENERATOR_SEED;
+    options->start_time = DEFAULT_GENERATOR_START_TIME;
+    options->num_threads = 0;
+    options->format = GENERATED_FORMAT_CSV;
+    options->customer_file_location = NULL;
+    options->purchases_file_location = NULL;
+
+    int option_index = 0;
+    int option_char;
+    while ((option_char = getopt_long(argc, argv, "", long_options, &option_index)) != -1) {
+        const char* option_name = long_options[option_index].name;
+        switch (option_char) {
+            case 'c':
+                options->num_customers = parse_unsigned_option(option_name, optarg);
+                break;
+            case 'p':
+                options->num_purchases = parse_unsigned_option(option_name, optarg);
+                break;
+            case 'a':
+                options->active_ratio = parse_double_option(option_name, optarg, 0.0, 1.0);
+                break;
+            case 'd':
+                if (strcmp(optarg, "uniform") == 0) {
+                    options->distribution = CUSTOMER_ID_DISTRIBUTION_UNIFORM;
+                } else if (strcmp(optarg, "zipf") == 0) {
+                    options->distribution = CUSTOMER_ID_DISTRIBUTION_ZIPF;
+                } else {
+                    fprintf(stderr, GENERATOR_INVALID_OPTION_MESSAGE, optarg, option_name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'z':
+                options->zipf_exponent = parse_double_option(option_name, optarg, 1e-6, 1e6);
+                break;
+            case 's':
+                options->seed = parse_unsigned_option(option_name, optarg);
+                break;
+            case 'T':
+                options->start_time = parse_unsigned_option(option_name, optarg);
+                break;
+            case 't':
+                options->num_threads = (unsigned int) parse_unsigned_option(option_name, optarg);
+                break;
+            case 'f':
+                if (strcmp(optarg, "csv") == 0) {
+                    options->format = GENERATED_FORMAT_CSV;
+                } else if (strcmp(optarg, "binary") == 0) {
+                    options->format = GENERATED_FORMAT_BINARY;
+                } else {
+                    fprintf(stderr, GENERATOR_INVALID_OPTION_MESSAGE, optarg, option_name);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'C':
+                options->customer_file_location = optarg;
+                break;
+            case 'P':
+                options->purchases_file_location = optarg;
+                break;
+            default:
+                fprintf(stderr, GENERATOR_USAGE_MESSAGE, argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    // Both tables need at least one row, as in "generate_custom_data.py"
+    if (optind < argc || options->num_customers == 0 || options->num_purchases == 0) {
+        fprintf(stderr, GENERATOR_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    options->num_threads = resolve_num_threads(options->num_threads);
+    if (options->customer_file_location == NULL) {
+        options->customer_file_location = (options->format == GENERATED_FORMAT_BINARY) ?
+                                            GENERATOR_CUSTOMER_BINARY_FILE_PATH : GENERATOR_CUSTOMER_CSV_FILE_PATH;
+    }
+    if (options->purchases_file_location == NULL) {
+        options->purchases_file_location = (options->format == GENERATED_FORMAT_BINARY) ?
+                                             GENERATOR_PURCHASES_BINARY_FILE_PATH : GENERATOR_PURCHASES_CSV_FILE_PATH;
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+
+    struct Generator_Options options;
+    parse_generator_options(argc, argv, &options);
+
+    struct Zipf_Sampler zipf_sampler;
+    init_zipf_sampler(&zipf_sampler, options.num_customers, options.zipf_exponent);
+
+    generate_table(&options, &zipf_sampler, GENERATED_CUSTOMER_TABLE, options.customer_file_location);
+    generate_table(&options, &zipf_sampler, GENERATED_PURCHASES_TABLE, options.purchases_file_location);
+
+    return EXIT_SUCCESS;
+
+}
+
+// =================================================================================================